@@ -46,12 +46,14 @@
 #include "actions.h"
 #include "gpio.h"
 #include "toolbar.h"
+#include "voice_keyer.h"
 #include "iambic.h"
 #include "store.h"
 #include "equalizer_menu.h"
 #include "exit_menu.h"
 #include "message.h"
 #include "dxcluster.h"
+#include "dvr.h"
 #include "greyline.h"
 #include "rx_panadapter.h"
 
@@ -130,6 +132,8 @@ ACTION_TABLE ActionTable[] = {
   {DIV_PHASE_FINE,      "DIV Phase\nFine",      "DIVPF",        MIDI_WHEEL | CONTROLLER_ENCODER},
   {MENU_DIVERSITY,      "DIV\nMenu",            "DIV-M",        MIDI_KEY   | CONTROLLER_SWITCH},
   {DUPLEX,              "Duplex",               "DUP",          MIDI_KEY   | CONTROLLER_SWITCH},
+  {DVR_EXPORT,          "DVR\nExport",          "DVREXP",       MIDI_KEY   | CONTROLLER_SWITCH},
+  {DVR_REPLAY,          "DVR\nReplay",          "DVRPLAY",      MIDI_KEY   | CONTROLLER_SWITCH},
   {DXC_WIN,             "DXC\nWindow",          "DXC-WIN",      TYPE_NONE},
   {DXC_TEST,            "DXC\nTest",            "DXC-TEST",     TYPE_NONE},
   {FILTER_MINUS,        "Filter -",             "FL-",          MIDI_KEY   | CONTROLLER_SWITCH},
@@ -255,6 +259,11 @@ ACTION_TABLE ActionTable[] = {
   {VFO_STEP_PLUS,       "VFO Step +",           "STEP+",        MIDI_KEY   | CONTROLLER_SWITCH},
   {VFOA,                "VFO A",                "VFOA",         MIDI_WHEEL | CONTROLLER_ENCODER},
   {VFOB,                "VFO B",                "VFOB",         MIDI_WHEEL | CONTROLLER_ENCODER},
+  {VOICE_KEYER_1,       "Voice\nKey 1",         "VK1",          MIDI_KEY   | CONTROLLER_SWITCH},
+  {VOICE_KEYER_2,       "Voice\nKey 2",         "VK2",          MIDI_KEY   | CONTROLLER_SWITCH},
+  {VOICE_KEYER_3,       "Voice\nKey 3",         "VK3",          MIDI_KEY   | CONTROLLER_SWITCH},
+  {VOICE_KEYER_4,       "Voice\nKey 4",         "VK4",          MIDI_KEY   | CONTROLLER_SWITCH},
+  {VOICE_KEYER_STOP,    "Voice\nKey Stop",      "VKSTOP",       MIDI_KEY   | CONTROLLER_SWITCH},
   {VOX,                 "VOX\nOn/Off",          "VOX",          MIDI_KEY   | CONTROLLER_SWITCH},
   {VOXLEVEL,            "VOX\nLevel",           "VOXLEV",       MIDI_WHEEL | CONTROLLER_ENCODER},
   {WATERFALL_HIGH,      "Wfall\nHigh",          "WFALLH",       MIDI_WHEEL | CONTROLLER_ENCODER},
@@ -1033,6 +1042,29 @@ int process_action(void *data) {
 
     break;
 
+  case DVR_EXPORT:
+    if (a->mode == PRESSED) {
+      dvr_export_window(dvr_window);
+    }
+
+    break;
+
+  case DVR_REPLAY:
+
+    //
+    // Replay the last dvr_window seconds of the active receiver,
+    // pressing again stops the replay
+    //
+    if (a->mode == PRESSED) {
+      if (dvr_replay_active()) {
+        dvr_replay_stop();
+      } else {
+        dvr_replay(DVR_RX1 + active_receiver->id, dvr_window, dvr_window);
+      }
+    }
+
+    break;
+
   case FILTER_MINUS:
 
     // since the widest filters start at f=0, FILTER_MINUS actually
@@ -1292,6 +1324,15 @@ int process_action(void *data) {
 
   case MOX:
     if (a->mode == PRESSED) {
+      //
+      // MOX stops the voice keyer. If this releases the transmitter, we are done.
+      //
+      if (voice_keyer_busy()) {
+        voice_keyer_stop();
+
+        if (!radio_get_mox()) { break; }
+      }
+
       int state = radio_get_mox();
       radio_mox_update(!state);
       //t_print("MOX pressed; bool = %d\n", (int)!state);
@@ -1379,16 +1420,7 @@ int process_action(void *data) {
   case NR:
     if (a->mode == PRESSED) {
       int id = active_receiver->id;
-      active_receiver->nr++;
-#ifdef EXTNR
-
-      if (active_receiver->nr > 4) { active_receiver->nr = 0; }
-
-#else
-
-      if (active_receiver->nr > 2) { active_receiver->nr = 0; }
-
-#endif
+      active_receiver->nr = rx_next_nr(active_receiver->nr);
 
       if (id == 0) {
         int mode = vfo[id].mode;
@@ -2141,6 +2173,35 @@ int process_action(void *data) {
 
     break;
 
+  case VOICE_KEYER_1:
+  case VOICE_KEYER_2:
+  case VOICE_KEYER_3:
+  case VOICE_KEYER_4:
+    if (a->mode == PRESSED) {
+      //
+      // Pressing the key of the message being sent stops it
+      //
+      int slot = a->action - VOICE_KEYER_1;
+
+      if (voice_keyer_playing() == slot + 1) {
+        voice_keyer_stop();
+      } else {
+        voice_keyer_play(slot);
+      }
+
+      g_idle_add(ext_vfo_update, NULL);
+    }
+
+    break;
+
+  case VOICE_KEYER_STOP:
+    if (a->mode == PRESSED) {
+      voice_keyer_stop();
+      g_idle_add(ext_vfo_update, NULL);
+    }
+
+    break;
+
   case VOX:
     if (a->mode == PRESSED) {
       vox_enabled = !vox_enabled;
@@ -89,6 +89,8 @@ enum ACTION {
   DIV_PHASE_FINE,
   MENU_DIVERSITY,
   DUPLEX,
+  DVR_EXPORT,
+  DVR_REPLAY,
   DXC_WIN,
   DXC_TEST,
   FILTER_MINUS,
@@ -214,6 +216,11 @@ enum ACTION {
   VFO_STEP_PLUS,
   VFOA,
   VFOB,
+  VOICE_KEYER_1,
+  VOICE_KEYER_2,
+  VOICE_KEYER_3,
+  VOICE_KEYER_4,
+  VOICE_KEYER_STOP,
   VOX,
   VOXLEVEL,
   WATERFALL_HIGH,
@@ -0,0 +1,257 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Regression test for the WDSP synchronous AM demodulator (amd.c).
+ *
+ * xamd() in SAM mode uses a table NCO and runs the four all-pass networks
+ * of the sideband separation side by side. This program keeps a copy of
+ * the former SAM loop (cos/sin NCO, separate delay lines) as a reference
+ * and runs both on the same synthetic AM signal: a carrier 300 Hz off with
+ * slow drift, flat fading, a tone on the upper side and some noise, with
+ * the AM demodulator settings of RXA.c. For DSB, LSB and USB it checks
+ * that the audio of both agrees to within -maxdiff dB of the output
+ * (after the PLL has locked). The CPU time of both is printed for
+ * information only, since it depends on the machine and its load.
+ * The exit code is 0 if all checks pass.
+ *
+ * Build and run: make amd_test && ./amd_test
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comm.h"
+#include "test_util.h"
+
+#define AMD_RATE   48000
+#define AMD_SIZE   1024
+
+static double duration = 20.0;           // seconds of signal
+static double max_diff = -120.0;         // allowed difference relative to the output (dB)
+
+//
+// The former SAM loop of xamd(). The coefficients are taken from the
+// AMD instance under test, the state is kept here.
+//
+#define REF_OUT_IDX (3 * STAGES)
+
+typedef struct {
+  double phs;
+  double omega;
+  double fil_out;
+  double dc;
+  double dc_insert;
+  double dsI;
+  double dsQ;
+  double a[3 * STAGES + 3];
+  double b[3 * STAGES + 3];
+  double c[3 * STAGES + 3];
+  double d[3 * STAGES + 3];
+} REF;
+
+static void ref_xamd(REF *r, AMD p, double *in, double *out) {
+  double vco[2], corr[2];
+  double ai, bi, aq, bq;
+  double ai_ps = 0.0, bi_ps = 0.0, aq_ps = 0.0, bq_ps = 0.0;
+  double audio = 0.0, det, del_out;
+
+  for (int i = 0; i < p->buff_size; i++) {
+    vco[0] = cos(r->phs);
+    vco[1] = sin(r->phs);
+    ai = in[2 * i + 0] * vco[0];
+    bi = in[2 * i + 0] * vco[1];
+    aq = in[2 * i + 1] * vco[0];
+    bq = in[2 * i + 1] * vco[1];
+
+    if (p->sbmode != 0) {
+      r->a[0] = r->dsI;
+      r->b[0] = bi;
+      r->c[0] = r->dsQ;
+      r->d[0] = aq;
+      r->dsI = ai;
+      r->dsQ = bq;
+
+      for (int j = 0; j < STAGES; j++) {
+        int k = 3 * j;
+        r->a[k + 3] = p->c0[j] * (r->a[k] - r->a[k + 5]) + r->a[k + 2];
+        r->b[k + 3] = p->c1[j] * (r->b[k] - r->b[k + 5]) + r->b[k + 2];
+        r->c[k + 3] = p->c0[j] * (r->c[k] - r->c[k + 5]) + r->c[k + 2];
+        r->d[k + 3] = p->c1[j] * (r->d[k] - r->d[k + 5]) + r->d[k + 2];
+      }
+
+      ai_ps = r->a[REF_OUT_IDX];
+      bi_ps = r->b[REF_OUT_IDX];
+      bq_ps = r->c[REF_OUT_IDX];
+      aq_ps = r->d[REF_OUT_IDX];
+
+      for (int j = REF_OUT_IDX + 2; j > 0; j--) {
+        r->a[j] = r->a[j - 1];
+        r->b[j] = r->b[j - 1];
+        r->c[j] = r->c[j - 1];
+        r->d[j] = r->d[j - 1];
+      }
+    }
+
+    corr[0] = +ai + bq;
+    corr[1] = -bi + aq;
+
+    switch (p->sbmode) {
+    case 0:
+      audio = corr[0];
+      break;
+
+    case 1:
+      audio = (ai_ps - bi_ps) + (aq_ps + bq_ps);
+      break;
+
+    case 2:
+      audio = (ai_ps + bi_ps) - (aq_ps - bq_ps);
+      break;
+    }
+
+    if (p->levelfade) {
+      r->dc = p->mtauR * r->dc + p->onem_mtauR * audio;
+      r->dc_insert = p->mtauI * r->dc_insert + p->onem_mtauI * corr[0];
+      audio += r->dc_insert - r->dc;
+    }
+
+    out[2 * i + 0] = audio;
+    out[2 * i + 1] = audio;
+
+    if ((corr[0] == 0.0) && (corr[1] == 0.0)) { corr[0] = 1.0; }
+
+    det = atan2(corr[1], corr[0]);
+    del_out = r->fil_out;
+    r->omega += p->g2 * det;
+
+    if (r->omega < p->omega_min) { r->omega = p->omega_min; }
+
+    if (r->omega > p->omega_max) { r->omega = p->omega_max; }
+
+    r->fil_out = p->g1 * det + r->omega;
+    r->phs += del_out;
+
+    while (r->phs >= TWOPI) { r->phs -= TWOPI; }
+
+    while (r->phs < 0.0) { r->phs += TWOPI; }
+  }
+}
+
+//
+// Synthetic AM signal
+//
+static double gauss(unsigned int *seed) {
+  double u = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+  double v = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+  return sqrt(-2.0 * log(u)) * cos(TWOPI * v);
+}
+
+static double *make_signal(long n) {
+  double *iq = malloc(2 * n * sizeof(double));
+  unsigned int seed = 4711;
+
+  for (long k = 0; k < n; k++) {
+    double t = (double) k / AMD_RATE;
+    double m = 0.35 * sin(TWOPI * 430.0 * t) + 0.25 * sin(TWOPI * 1170.0 * t + 1.0) + 0.1 * sin(TWOPI * 2650.0 * t);
+    double fade = 1.0 + 0.8 * sin(TWOPI * 0.3 * t);
+    double ph = TWOPI * (300.0 + 3.0 * sin(TWOPI * 0.05 * t)) * t;
+    double amp = 0.01 * fade * (1.0 + m);
+    iq[2 * k + 0] = amp * cos(ph) + 0.003 * cos(TWOPI * 2300.0 * t) + 1.0e-4 * gauss(&seed);
+    iq[2 * k + 1] = amp * sin(ph) + 0.003 * sin(TWOPI * 2300.0 * t) + 1.0e-4 * gauss(&seed);
+  }
+
+  return iq;
+}
+
+static void run_sbmode(int sbmode, const double *iq, int nb) {
+  static const char *names[3] = { "DSB", "LSB", "USB" };
+  double *in = malloc(2 * AMD_SIZE * sizeof(double));
+  double *out = malloc(2 * AMD_SIZE * sizeof(double));
+  double *ref = malloc(2 * AMD_SIZE * sizeof(double));
+  double err = 0.0, sig = 0.0, t_new = 0.0, t_ref = 0.0, start, diff;
+  char what[128];
+  AMD p = create_amd(1, AMD_SIZE, in, out, 1, 1, sbmode, AMD_RATE, -2000.0, +2000.0, 1.0, 250.0, 0.02, 1.4);
+  REF r;
+  memset(&r, 0, sizeof(r));
+
+  for (int b = 0; b < nb; b++) {
+    memcpy(in, iq + 2 * AMD_SIZE * b, 2 * AMD_SIZE * sizeof(double));
+    start = now();
+    xamd(p);
+    t_new += now() - start;
+    start = now();
+    ref_xamd(&r, p, in, ref);
+    t_ref += now() - start;
+
+    //
+    // skip the first tenth, where the PLL locks
+    //
+    if (b > nb / 10) {
+      for (int k = 0; k < AMD_SIZE; k++) {
+        double e = out[2 * k] - ref[2 * k];
+        err += e * e;
+        sig += ref[2 * k] * ref[2 * k];
+      }
+    }
+  }
+
+  diff = 10.0 * log10((err + 1.0e-300) / sig);
+  snprintf(what, sizeof(what), "%s: output difference %.1f dB", names[sbmode], diff);
+  check(diff < max_diff, what);
+  snprintf(what, sizeof(what), "%s: CPU for %.0f s: %.1f ms, reference %.1f ms (x%.2f)",
+           names[sbmode], duration, 1.0e3 * t_new, 1.0e3 * t_ref, t_ref / t_new);
+  printf("%s\n", what);
+  destroy_amd(p);
+  free(in);
+  free(out);
+  free(ref);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-t <seconds>] [-maxdiff <dB>]\n", prog);
+  exit(8);
+}
+
+int main(int argc, char *argv[]) {
+  double *iq;
+  int nb;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-t")       && i < argc - 1) { duration = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-maxdiff") && i < argc - 1) { max_diff = atof(argv[++i]); continue; }
+
+    usage(argv[0]);
+  }
+
+  nb = (int)(duration * AMD_RATE / AMD_SIZE);
+
+  if (nb < 20) { usage(argv[0]); }
+
+  iq = make_signal((long) nb * AMD_SIZE);
+
+  for (int sbmode = 0; sbmode < 3; sbmode++) {
+    run_sbmode(sbmode, iq, nb);
+  }
+
+  free(iq);
+  return test_result();
+}
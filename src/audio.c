@@ -39,6 +39,10 @@ static const int out_cw_border = 1536;                // separates CW-TX from ot
 static const int cw_mid_water  = 1024;                // target buffer filling for CW
 static const int cw_low_water  =  896;                // low water mark for CW
 static const int cw_high_water = 1152;                // high water mark for CW
+static const int cw_ring_size  = 4800;                // CW side tone ring buffer (100 msec)
+
+static const int out_fill = out_cw_border + 2 * out_buffer_size; // target buffer filling for RX audio
+static const int out_match_latency = 20;              // target latency (ms) of the clock-drift compensation
 
 #include <gtk/gtk.h>
 #include <stdint.h>
@@ -59,6 +63,7 @@ static const int cw_high_water = 1152;                // high water mark for CW
 #include "receiver.h"
 #include "transmitter.h"
 #include "audio.h"
+#include "audio_mixer.h"
 #include "mode.h"
 #include "vfo.h"
 #include "message.h"
@@ -90,7 +95,7 @@ static gint running = 0;
 // TODO: include SND_PCM_FORMAT_IEC958_SUBFRAME_LE, such that ALSA
 //       can directly play on HDMI monitors. Implementation is not
 //       super-easy since this case must then also be considered in
-//       audio_write.
+//       audio_convert.
 //
 #define FORMATS 3
 static snd_pcm_format_t formats[3] = {
@@ -116,6 +121,189 @@ float  *mic_ring_buffer = NULL;
 volatile int mic_ring_read_pt = 0;
 volatile int mic_ring_write_pt = 0;
 
+//
+// Convert n stereo frames from float to the sound format of the device
+//
+static void audio_convert(snd_pcm_format_t format, void *dst, const float *src, int n) {
+  switch (format) {
+  case SND_PCM_FORMAT_S16_LE: {
+    int16_t *short_buffer = (int16_t *)dst;
+
+    for (int i = 0; i < 2 * n; i++) {
+      short_buffer[i] = (int16_t)(src[i] * 32767.0F);
+    }
+  }
+  break;
+
+  case SND_PCM_FORMAT_S32_LE: {
+    int32_t *long_buffer = (int32_t *)dst;
+
+    for (int i = 0; i < 2 * n; i++) {
+      long_buffer[i] = (int32_t)(src[i] * 2147483647.0F);
+    }
+  }
+  break;
+
+  case SND_PCM_FORMAT_FLOAT_LE:
+    memcpy(dst, src, 2 * n * sizeof(float));
+    break;
+
+  default:
+    break;
+  }
+}
+
+//
+// RX audio is not written to the device from the RX thread. It goes into
+// rx->audio_match, and this thread pulls it out at the pace of the sound card,
+// keeping the ALSA buffer at out_fill. The clock difference between radio and
+// sound card is thus absorbed by the rmatch resampler and not by
+// ALSA buffer under/overruns.
+//
+// The CW side tone goes the same way: cw_audio_write() puts it into a ring
+// buffer (rx->local_audio_buffer), and this thread moves it to the device.
+// So this is the only thread doing device I/O, and it decides under
+// local_audio_mutex which source it takes. While the side tone is active, the
+// ALSA buffer is kept at low filling, between cw_low_water and cw_high_water,
+// to keep the side tone latency low. The latency is adjusted in the silence
+// between the elements: after 16 zero samples in a row, one zero sample is
+// dropped if the buffer is too full, or an extra one is inserted if it
+// gets too empty.
+//
+static int cw_ring_read(RECEIVER *rx, float *buffer, int frames, long delay) {
+  static int count = 0;
+  int n = 0;
+
+  while (n < frames && rx->local_audio_buffer_outpt != rx->local_audio_buffer_inpt) {
+    float sample = rx->local_audio_buffer[rx->local_audio_buffer_outpt];
+
+    if (++rx->local_audio_buffer_outpt >= cw_ring_size) { rx->local_audio_buffer_outpt = 0; }
+
+    if (sample != 0.0) { count = 0; } // count upwards during silence
+
+    if (++count >= 16) {
+      count = 0;
+
+      if (delay + n > cw_high_water) { continue; }  // drop this zero sample
+
+      if (delay + n < cw_low_water && n < frames - 1) {
+        // insert another zero sample
+        buffer[2 * n] = buffer[2 * n + 1] = 0.0F;
+        n++;
+      }
+    }
+
+    buffer[2 * n] = buffer[2 * n + 1] = sample;
+    n++;
+  }
+
+  return n;
+}
+
+static gpointer audio_out_thread(gpointer arg) {
+  RECEIVER *rx = (RECEIVER *)arg;
+  float *buffer = g_new(float, 2 * out_buffer_size);
+  void *pcm_buffer = g_malloc(2 * out_buffer_size * sizeof(int32_t));  // large enough for all formats
+  void *silence = g_malloc0(2 * out_buflen * sizeof(int32_t));
+
+  while (g_atomic_int_get(&rx->local_audio_running)) {
+    snd_pcm_sframes_t delay;
+    int txmode = vfo_get_tx_mode();
+    int wait = 1000;
+    int frames = 0;
+
+    //
+    // It is guaranteed that rx->playback_handle, rx->audio_match and the
+    // CW ring buffer are not destroyed before this thread has terminated
+    // (and waited for via thread joining).
+    // local_audio_mutex is only held while the samples are taken out of the
+    // match or CW ring buffer, all device I/O is done without it, so an ALSA
+    // stall never blocks the RX thread in audio_write_buffer() or the TX thread
+    // in cw_audio_write().
+    //
+    if (snd_pcm_delay(rx->playback_handle, &delay) != 0) {
+      snd_pcm_prepare(rx->playback_handle);
+      delay = 0;
+    }
+
+    g_mutex_lock(&rx->local_audio_mutex);
+    int cw = rx->local_audio_cw || rx->local_audio_buffer_inpt != rx->local_audio_buffer_outpt;
+    g_mutex_unlock(&rx->local_audio_mutex);
+
+    if (cw) {
+      //
+      // CW side tone. When we come here for the first time after a RX/TX
+      // transition, rewind until we are at target filling for CW.
+      //
+      if (delay > out_cw_border) {
+        snd_pcm_rewind(rx->playback_handle, delay - cw_mid_water);
+        delay = cw_mid_water;
+      }
+
+      if (delay < cw_mid_water) {
+        g_mutex_lock(&rx->local_audio_mutex);
+        frames = cw_ring_read(rx, buffer, out_buffer_size, delay);
+        g_mutex_unlock(&rx->local_audio_mutex);
+      }
+    } else if (rx == audio_mixer_output(active_receiver) && radio_is_transmitting()
+               && (txmode == modeCWU || txmode == modeCWL)) {
+      //
+      // Going TX in CW, but the side tone has not yet started. audio_write_buffer()
+      // no longer feeds the match buffer, so just wait for the side tone.
+      //
+    } else {
+      if (delay < out_cw_border) {
+        //
+        // upon first occurence, after an underrun, or if we just come from CW TXing,
+        // the buffer is (nearly) empty.
+        // ACTION: fill buffer completely with silence to start output, then
+        //         rewind until target filling. Just filling up to out_fill does nothing,
+        //         ALSA just does not start playing until the buffer is nearly full.
+        //
+        snd_pcm_writei(rx->playback_handle, silence, out_buflen - delay);
+        snd_pcm_rewind(rx->playback_handle, out_buflen - out_fill);
+        delay = out_fill;
+      }
+
+      if (delay < out_fill + out_buffer_size) {
+        g_mutex_lock(&rx->local_audio_mutex);
+        audio_match_read(rx->audio_match, buffer, out_buffer_size);
+        g_mutex_unlock(&rx->local_audio_mutex);
+        frames = out_buffer_size;
+      } else {
+        //
+        // sleep until the buffer filling has dropped to the target
+        //
+        wait = (int)(1000 * (delay - out_fill) / 48);
+      }
+    }
+
+    if (frames > 0) {
+      long rc;
+      audio_convert(rx->local_audio_format, pcm_buffer, buffer, frames);
+
+      if ((rc = snd_pcm_writei (rx->playback_handle, pcm_buffer, frames)) != frames) {
+        if (rc == -EPIPE) {
+          snd_pcm_prepare (rx->playback_handle);
+        } else if (rc < 0) {
+          t_print("%s:  write error: %s\n", __FUNCTION__, snd_strerror(rc));
+          wait = 10000;
+        } else {
+          t_print("%s: short write lost=%d\n", __FUNCTION__, frames - (int) rc);
+        }
+      }
+    }
+
+    g_usleep(wait);
+  }
+
+  g_free(buffer);
+  g_free(pcm_buffer);
+  g_free(silence);
+  t_print("%s: exiting\n", __FUNCTION__);
+  return NULL;
+}
+
 int audio_open_output(RECEIVER *rx) {
   int err;
   unsigned int rate = 48000;
@@ -175,32 +363,15 @@ int audio_open_output(RECEIVER *rx) {
     return err;
   }
 
-  rx->local_audio_buffer_offset = 0;
-
-  switch (rx->local_audio_format) {
-  case SND_PCM_FORMAT_S16_LE:
-    t_print("%s: local_audio_buffer: size=%d sample=%ld\n", __FUNCTION__, out_buffer_size, sizeof(int16_t));
-    rx->local_audio_buffer = g_new(int16_t, 2 * out_buffer_size);
-    break;
-
-  case SND_PCM_FORMAT_S32_LE:
-    t_print("%s: local_audio_buffer: size=%d sample=%ld\n", __FUNCTION__, out_buffer_size, sizeof(int32_t));
-    rx->local_audio_buffer = g_new(int32_t, 2 * out_buffer_size);
-    break;
-
-  case SND_PCM_FORMAT_FLOAT_LE:
-    t_print("%s: local_audio_buffer: size=%d sample=%ld\n", __FUNCTION__, out_buffer_size, sizeof(float));
-    rx->local_audio_buffer = g_new(float, 2 * out_buffer_size);
-    break;
-
-  default:
-    t_print("%s: CATASTROPHIC ERROR: unknown sound format\n", __FUNCTION__);
-    rx->local_audio_buffer = NULL;
-    break;
-  }
-
+  rx->local_audio_buffer = g_new0(float, cw_ring_size);
+  rx->local_audio_buffer_inpt = 0;
+  rx->local_audio_buffer_outpt = 0;
+  rx->local_audio_cw = 0;
   t_print("%s: rx=%d audio_device=%d handle=%p buffer=%p size=%d\n", __FUNCTION__, rx->id, rx->audio_device,
           rx->playback_handle, rx->local_audio_buffer, out_buffer_size);
+  rx->audio_match = audio_match_new(out_buffer_size, rx->buffer_size, out_match_latency);
+  g_atomic_int_set(&rx->local_audio_running, 1);
+  rx->local_audio_thread = g_thread_new("RX audio out", audio_out_thread, rx);
   g_mutex_unlock(&rx->local_audio_mutex);
   return 0;
 }
@@ -334,8 +505,21 @@ int audio_open_input() {
 
 void audio_close_output(RECEIVER *rx) {
   t_print("%s: rx=%d handle=%p buffer=%p\n", __FUNCTION__, rx->id, rx->playback_handle, rx->local_audio_buffer);
+  // Do not join while holding local_audio_mutex; audio_out_thread locks it.
+  g_atomic_int_set(&rx->local_audio_running, 0);
+
+  if (rx->local_audio_thread != NULL) {
+    g_thread_join(rx->local_audio_thread);
+    rx->local_audio_thread = NULL;
+  }
+
   g_mutex_lock(&rx->local_audio_mutex);
 
+  if (rx->audio_match != NULL) {
+    audio_match_free(rx->audio_match);
+    rx->audio_match = NULL;
+  }
+
   if (rx->playback_handle != NULL) {
     snd_pcm_close (rx->playback_handle);
     rx->playback_handle = NULL;
@@ -388,140 +572,33 @@ void audio_close_input() {
 }
 
 //
-// This is for writing a CW side tone.
-// To keep sidetone latencies low, we keep the ALSA buffer
-// at low filling, between cw_low_water and cw_high_water.
+// This is for writing a CW side tone. The sample goes into the CW ring
+// buffer, audio_out_thread() sends it to the device (see there).
+// The first side tone sample after a RX/TX transition discards what is
+// left in the ring buffer.
 //
-// Note that when sending the buffer, delay "jumps" by the buffer size
-//
-
 int cw_audio_write(RECEIVER *rx, float sample) {
-  snd_pcm_sframes_t delay;
   g_mutex_lock(&rx->local_audio_mutex);
 
   if (rx->playback_handle != NULL && rx->local_audio_buffer != NULL) {
-    static int count = 0;
-
-    if (snd_pcm_delay(rx->playback_handle, &delay) == 0) {
-      if (delay > out_cw_border) {
-        //
-        // This happens when we come here for the first time after a
-        // RX/TX transision. Rewind until we are at target filling for CW
-        //
-        snd_pcm_rewind(rx->playback_handle, delay - cw_mid_water);
-        count = 0;
-      }
-    }
-
-    //
-    // Put sample into buffer
-    //
-    switch (rx->local_audio_format) {
-    case SND_PCM_FORMAT_S16_LE: {
-      int16_t *short_buffer = (int16_t *)rx->local_audio_buffer;
-      short_buffer[rx->local_audio_buffer_offset * 2] = (int16_t)(sample * 32767.0F);
-      short_buffer[(rx->local_audio_buffer_offset * 2) + 1] = (int16_t)(sample * 32767.0F);
-    }
-    break;
-
-    case SND_PCM_FORMAT_S32_LE: {
-      int32_t *long_buffer = (int32_t *)rx->local_audio_buffer;
-      long_buffer[rx->local_audio_buffer_offset * 2] = (int32_t)(sample * 2147483647.0F);
-      long_buffer[(rx->local_audio_buffer_offset * 2) + 1] = (int32_t)(sample * 2147483647.0F);
-    }
-    break;
+    int newpt;
 
-    case SND_PCM_FORMAT_FLOAT_LE: {
-      float *float_buffer = (float *)rx->local_audio_buffer;
-      float_buffer[rx->local_audio_buffer_offset * 2] = sample;
-      float_buffer[(rx->local_audio_buffer_offset * 2) + 1] =  sample;
+    if (!rx->local_audio_cw) {
+      rx->local_audio_buffer_inpt = rx->local_audio_buffer_outpt = 0;
+      rx->local_audio_cw = 1;
     }
-    break;
 
-    default:
-      t_print("%s: CATASTROPHIC ERROR: unknown sound format\n", __FUNCTION__);
-      break;
-    }
+    newpt = rx->local_audio_buffer_inpt + 1;
 
-    rx->local_audio_buffer_offset++;
-
-    if (sample != 0.0) { count = 0; } // count upwards during silence
-
-    if (++count >= 16) {
-      count = 0;
+    if (newpt >= cw_ring_size) { newpt = 0; }
 
+    if (newpt != rx->local_audio_buffer_outpt) {
       //
-      // We have just seen 16 zero samples, so this is the right place
-      // to adjust the buffer filling.
-      // If buffer gets too full   ==> skip the sample
-      // If buffer gets too empty ==> insert zero sample
+      // buffer space available. The side tone is mono, it is put into
+      // the left and right channel when it is sent to the device.
       //
-      if (snd_pcm_delay(rx->playback_handle, &delay) == 0) {
-        if (delay > cw_high_water && rx->local_audio_buffer_offset > 0) {
-          // delete the last sample
-          rx->local_audio_buffer_offset--;
-        }
-
-        if ((delay < cw_low_water) && (rx->local_audio_buffer_offset < out_buffer_size)) {
-          // insert another zero sample
-          switch (rx->local_audio_format) {
-          case SND_PCM_FORMAT_S16_LE: {
-            int16_t *short_buffer = (int16_t *)rx->local_audio_buffer;
-            short_buffer[rx->local_audio_buffer_offset * 2] = 0;
-            short_buffer[(rx->local_audio_buffer_offset * 2) + 1] = 0;
-          }
-          break;
-
-          case SND_PCM_FORMAT_S32_LE: {
-            int32_t* long_buffer = (int32_t *)rx->local_audio_buffer;
-            long_buffer[rx->local_audio_buffer_offset * 2] = 0;
-            long_buffer[(rx->local_audio_buffer_offset * 2) + 1] = 0;
-          }
-          break;
-
-          case SND_PCM_FORMAT_FLOAT_LE: {
-            float *float_buffer = (float *)rx->local_audio_buffer;
-            float_buffer[rx->local_audio_buffer_offset * 2] = 0.0;
-            float_buffer[(rx->local_audio_buffer_offset * 2) + 1] = 0.0;
-          }
-          break;
-
-          default:
-            t_print("%s: CATASTROPHIC ERROR: unknown sound format\n", __FUNCTION__);
-            break;
-          }
-
-          rx->local_audio_buffer_offset++;
-        }
-      }
-    }
-
-    if (rx->local_audio_buffer_offset >= out_buffer_size) {
-      long rc;
-
-      if ((rc = snd_pcm_writei (rx->playback_handle, rx->local_audio_buffer, out_buffer_size)) != out_buffer_size) {
-        if (rc < 0) {
-          switch (rc) {
-          case -EPIPE:
-            if ((rc = snd_pcm_prepare (rx->playback_handle)) < 0) {
-              t_print("%s: cannot prepare audio interface for use %ld (%s)\n", __FUNCTION__, rc, snd_strerror (rc));
-              rx->local_audio_buffer_offset = 0;
-              g_mutex_unlock(&rx->local_audio_mutex);
-              return rc;
-            }
-
-            break;
-
-          default:
-            t_print("%s:  write error: %s\n", __FUNCTION__, snd_strerror(rc));
-            break;
-          }
-        } else {
-          t_print("%s: short write lost=%d\n", __FUNCTION__, out_buffer_size - (int) rc);
-        }
-      }
-
-      rx->local_audio_buffer_offset = 0;
+      rx->local_audio_buffer[rx->local_audio_buffer_inpt] = sample;
+      rx->local_audio_buffer_inpt = newpt;
     }
   }
 
@@ -530,131 +607,38 @@ int cw_audio_write(RECEIVER *rx, float sample) {
 }
 
 //
-// if rx == active_receiver and while transmitting, DO NOTHING
+// if rx carries the audio of the active receiver and while transmitting, DO NOTHING
 // since cw_audio_write may be active
 //
 
-int audio_write(RECEIVER *rx, float left_sample, float right_sample) {
-  snd_pcm_sframes_t delay;
+int audio_write_buffer(RECEIVER *rx, const float *buffer, int frames) {
   int txmode = vfo_get_tx_mode();
 
   //
   // We have to stop the stream here if a CW side tone may occur.
-  // This might cause underflows, but we cannot use audio_write
-  // and cw_audio_write simultaneously on the same device.
-  // Instead, the side tone version will take over.
+  // The side tone then takes over the output of audio_out_thread.
   // If *not* doing CW, the stream continues because we might wish
   // to listen to this rx while transmitting.
   //
-  if (rx == active_receiver && radio_is_transmitting() && (txmode == modeCWU || txmode == modeCWL)) {
+  if (rx == audio_mixer_output(active_receiver) && radio_is_transmitting()
+      && (txmode == modeCWU || txmode == modeCWL)) {
     return 0;
   }
 
   // lock AFTER checking the "quick return" condition but BEFORE checking the pointers
   g_mutex_lock(&rx->local_audio_mutex);
+  //
+  // RX audio again: the side tone still in the ring buffer is played,
+  // then audio_out_thread switches back to the match buffer.
+  //
+  rx->local_audio_cw = 0;
 
-  if (rx->playback_handle != NULL && rx->local_audio_buffer != NULL) {
-    switch (rx->local_audio_format) {
-    case SND_PCM_FORMAT_S16_LE: {
-      int16_t *short_buffer = (int16_t *)rx->local_audio_buffer;
-      short_buffer[rx->local_audio_buffer_offset * 2] = (int16_t)(left_sample * 32767.0F);
-      short_buffer[(rx->local_audio_buffer_offset * 2) + 1] = (int16_t)(right_sample * 32767.0F);
-    }
-    break;
-
-    case SND_PCM_FORMAT_S32_LE: {
-      int32_t *long_buffer = (int32_t *)rx->local_audio_buffer;
-      long_buffer[rx->local_audio_buffer_offset * 2] = (int32_t)(left_sample * 2147483647.0F);
-      long_buffer[(rx->local_audio_buffer_offset * 2) + 1] = (int32_t)(right_sample * 2147483647.0F);
-    }
-    break;
-
-    case SND_PCM_FORMAT_FLOAT_LE: {
-      float *float_buffer = (float *)rx->local_audio_buffer;
-      float_buffer[rx->local_audio_buffer_offset * 2] = left_sample;
-      float_buffer[(rx->local_audio_buffer_offset * 2) + 1] = right_sample;
-    }
-    break;
-
-    default:
-      t_print("%s: CATASTROPHIC ERROR: unknown sound format\n", __FUNCTION__);
-      break;
-    }
-
-    rx->local_audio_buffer_offset++;
-
-    if (rx->local_audio_buffer_offset >= out_buffer_size) {
-      if (snd_pcm_delay(rx->playback_handle, &delay) == 0) {
-        if (delay < out_cw_border) {
-          //
-          // upon first occurence, or after a TX/RX transition, the buffer
-          // is empty (delay == 0), if we just come from CW TXing, delay is below
-          // out_cw_border as well.
-          // ACTION: fill buffer completely with silence to start output, then
-          //         rewind until half-filling. Just filling by half does nothing,
-          //         ALSA just does not start playing until the buffer is nearly full.
-          //
-          void *silence = NULL;
-          size_t len;
-          int num = (out_buflen - delay);
-
-          switch (rx->local_audio_format) {
-          case SND_PCM_FORMAT_S16_LE:
-            silence = g_new(int16_t, 2 * num);
-            len = 2 * num * sizeof(int16_t);
-            break;
-
-          case SND_PCM_FORMAT_S32_LE:
-            silence = g_new(int32_t, 2 * num);
-            len = 2 * num * sizeof(int32_t);
-            break;
-
-          case SND_PCM_FORMAT_FLOAT_LE:
-            silence = g_new(float, 2 * num);
-            len = 2 * num * sizeof(float);
-            break;
-
-          default:
-            t_print("%s: CATASTROPHIC ERROR: unknown sound format\n", __FUNCTION__);
-            silence = NULL;
-            len = 0;
-            break;
-          }
-
-          if (silence) {
-            memset(silence, 0, len);
-            snd_pcm_writei (rx->playback_handle, silence, num);
-            snd_pcm_rewind (rx->playback_handle, out_buflen / 2);
-            g_free(silence);
-          }
-        }
-      }
-
-      long rc;
-
-      if ((rc = snd_pcm_writei (rx->playback_handle, rx->local_audio_buffer, out_buffer_size)) != out_buffer_size) {
-        if (rc < 0) {
-          switch (rc) {
-          case -EPIPE:
-            if ((rc = snd_pcm_prepare (rx->playback_handle)) < 0) {
-              t_print("%s: cannot prepare audio interface for use %ld (%s)\n", __FUNCTION__, rc, snd_strerror (rc));
-              rx->local_audio_buffer_offset = 0;
-              g_mutex_unlock(&rx->local_audio_mutex);
-              return rc;
-            }
-
-            break;
-
-          default:
-            t_print("%s:  write error: %s\n", __FUNCTION__, snd_strerror(rc));
-            break;
-          }
-        } else {
-          t_print("%s: short write lost=%d\n", __FUNCTION__, out_buffer_size - (int) rc);
-        }
-      }
-
-      rx->local_audio_buffer_offset = 0;
+  if (rx->audio_match != NULL) {
+    //
+    // The samples are sent to the device by audio_out_thread
+    //
+    for (int i = 0; i < frames; i++) {
+      audio_match_write(rx->audio_match, buffer[2 * i], buffer[2 * i + 1]);
     }
   }
 
@@ -0,0 +1,131 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+
+#include <wdsp.h>
+
+#include "audio_match.h"
+#include "message.h"
+
+//
+// The RX engine delivers audio in bursts of rx->output_samples, while the sound card
+// consumes it in small blocks at its own (slightly different) 48 kHz clock.
+// The rmatch ring is steered to half filling, so the target filling must cover
+// half a burst plus one output block on either side, otherwise the ring
+// runs empty just before the next burst arrives.
+//
+// The rmatch control loop defaults are tuned for large Thetis VAC buffers and
+// oscillate with our small rings, hence the shorter proportional window and the
+// lower feedback gain.
+//
+static const int match_insize      = 256;     // producer block size
+static const int match_prop_min    = 256;     // proportional feedback moving average, min/max
+static const int match_prop_max    = 1024;    // MUST BE A POWER OF TWO
+static const double match_gain     = 1.0e-6;  // proportional feedback gain
+static const long match_report     = 48000L * 300L;  // report statistics every five minutes
+
+AUDIO_MATCH *audio_match_new(int outsize, int burst, int latency) {
+  AUDIO_MATCH *m = g_new0(AUDIO_MATCH, 1);
+  int min_target = burst / 2 + outsize + 128;
+  m->insize = match_insize;
+  m->outsize = outsize;
+  m->target = 48 * latency;
+
+  if (m->target < min_target) { m->target = min_target; }
+
+  m->inbuf = g_new0(double, 2 * m->insize);
+  m->outbuf = g_new0(double, 2 * m->outsize);
+  m->inpt = 0;
+  m->outpt = m->outsize;
+  m->report_count = 0;
+  m->rmatch = create_rmatchV(m->insize, m->outsize, 48000, 48000, 2 * m->target, 1.0);
+  setRMatchPropRingMin(m->rmatch, match_prop_min);
+  setRMatchPropRingMax(m->rmatch, match_prop_max);
+  setRMatchFeedbackGain(m->rmatch, match_gain);
+  t_print("%s: outsize=%d burst=%d target=%d (%0.1f ms)\n", __FUNCTION__, outsize, burst, m->target,
+          (double) m->target / 48.0);
+  return m;
+}
+
+void audio_match_free(AUDIO_MATCH *m) {
+  if (m == NULL) { return; }
+
+  destroy_rmatchV(m->rmatch);
+  g_free(m->inbuf);
+  g_free(m->outbuf);
+  g_free(m);
+}
+
+void audio_match_get_stats(AUDIO_MATCH *m, AUDIO_MATCH_STATS *stats) {
+  int ringsize;
+  getRMatchDiags(m->rmatch, &stats->underflows, &stats->overflows, &stats->var, &ringsize, &stats->fill);
+  getControlFlag(m->rmatch, &stats->control);
+  stats->ppm = (stats->var > 0.0) ? 1.0E6 * (1.0 / stats->var - 1.0) : 0.0;
+  stats->latency = (double) stats->fill / 48.0;
+  stats->target = (double) m->target / 48.0;
+}
+
+//
+// Producer side, called for each sample from the RX thread
+//
+void audio_match_write(AUDIO_MATCH *m, float left, float right) {
+  m->inbuf[2 * m->inpt] = left;
+  m->inbuf[2 * m->inpt + 1] = right;
+
+  if (++m->inpt < m->insize) { return; }
+
+  xrmatchIN(m->rmatch, m->inbuf);
+  m->inpt = 0;
+  m->report_count += m->insize;
+
+  if (m->report_count >= match_report) {
+    AUDIO_MATCH_STATS stats;
+    m->report_count = 0;
+    audio_match_get_stats(m, &stats);
+    t_print("%s: latency=%0.1f ms (target %0.1f ms) drift=%0.1f ppm underflows=%d overflows=%d\n",
+            __FUNCTION__, stats.latency, stats.target, stats.ppm, stats.underflows, stats.overflows);
+  }
+}
+
+//
+// Consumer side, called from the audio output thread or callback.
+// out receives frames interleaved stereo samples.
+//
+void audio_match_read(AUDIO_MATCH *m, float *out, int frames) {
+  while (frames > 0) {
+    int n;
+
+    if (m->outpt >= m->outsize) {
+      xrmatchOUT(m->rmatch, m->outbuf);
+      m->outpt = 0;
+    }
+
+    n = m->outsize - m->outpt;
+
+    if (n > frames) { n = frames; }
+
+    for (int i = 0; i < n; i++) {
+      *out++ = (float) m->outbuf[2 * m->outpt];
+      *out++ = (float) m->outbuf[2 * m->outpt + 1];
+      m->outpt++;
+    }
+
+    frames -= n;
+  }
+}
@@ -0,0 +1,59 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _AUDIO_MATCH_H
+#define _AUDIO_MATCH_H
+
+//
+// Clock-drift compensation between the radio's 48 kHz audio clock and the
+// clock of a local sound card, built on top of the WDSP rmatch (variable
+// resampler + ring buffer). There is exactly one producer (the RX thread
+// calling audio_match_write) and one consumer (the audio output thread or
+// callback calling audio_match_read).
+//
+
+typedef struct _audio_match {
+  void   *rmatch;        // WDSP rmatch instance
+  int     insize;        // producer block size (stereo frames)
+  int     outsize;       // consumer block size (stereo frames)
+  int     target;        // target ring filling (stereo frames)
+  double *inbuf;
+  int     inpt;
+  double *outbuf;
+  int     outpt;         // read position in outbuf, outsize means "empty"
+  long    report_count;  // samples written since the last statistics report
+} AUDIO_MATCH;
+
+typedef struct _audio_match_stats {
+  int    underflows;
+  int    overflows;
+  int    control;        // 1 if the control loop is active
+  double var;            // current resampling ratio (sound card / radio)
+  double ppm;            // estimated clock difference radio vs. sound card
+  int    fill;           // current ring filling (stereo frames)
+  double latency;        // current ring latency (ms)
+  double target;         // target ring latency (ms)
+} AUDIO_MATCH_STATS;
+
+extern AUDIO_MATCH *audio_match_new(int outsize, int burst, int latency);
+extern void audio_match_free(AUDIO_MATCH *m);
+extern void audio_match_write(AUDIO_MATCH *m, float left, float right);
+extern void audio_match_read(AUDIO_MATCH *m, float *out, int frames);
+extern void audio_match_get_stats(AUDIO_MATCH *m, AUDIO_MATCH_STATS *stats);
+
+#endif
@@ -0,0 +1,449 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <math.h>
+#include <string.h>
+
+#include "audio.h"
+#include "audio_mixer.h"
+#include "radio.h"
+#include "receiver.h"
+#include "transmitter.h"
+#include "vox.h"
+#include "message.h"
+
+//
+// Inputs 0 and 1 are RX1 and RX2, followed by the TX monitor and the
+// DVR playback. The last two always go to the output device of RX1.
+//
+#define MIXER_RX_INPUTS 2
+#define MIXER_MONITOR   MIXER_RX_INPUTS
+#define MIXER_PLAYBACK  (MIXER_RX_INPUTS + 1)
+#define MIXER_INPUTS    (MIXER_RX_INPUTS + 2)
+
+//
+// If one input has this many frames queued while another one has less than
+// a block, the other one is considered stalled and is mixed as silence.
+//
+#define MIXER_LAG       (MIXER_RING / 2)
+
+typedef struct _mixer_input {
+  float *ring;                   // 2 * MIXER_RING interleaved stereo samples
+  gint   wcount;                 // frames published by the producer (wraps)
+  gint   rcount;                 // frames consumed by the mixer (wraps)
+  gint   pending;                // producer-private: frames put but not yet published
+  gint   overflows;
+} MIXER_INPUT;
+
+static MIXER_INPUT inputs[MIXER_INPUTS];
+
+static GThread *mixer_thread_id = NULL;
+static gint     mixer_running = 0;
+static GMutex   mixer_mutex;
+static GCond    mixer_cond;
+
+static gsize mixer_inited = 0;
+
+static void audio_mixer_init_once(void) {
+  if (g_once_init_enter(&mixer_inited)) {
+    g_mutex_init(&mixer_mutex);
+    g_cond_init(&mixer_cond);
+
+    for (int i = 0; i < MIXER_INPUTS; i++) {
+      inputs[i].ring = g_new0(float, 2 * MIXER_RING);
+      inputs[i].wcount = 0;
+      inputs[i].rcount = 0;
+      inputs[i].pending = 0;
+      inputs[i].overflows = 0;
+    }
+
+    g_once_init_leave(&mixer_inited, 1);
+  }
+}
+
+static inline int input_avail(MIXER_INPUT *in) {
+  return (int)((guint)g_atomic_int_get(&in->wcount) - (guint)g_atomic_int_get(&in->rcount));
+}
+
+//
+// Producer side (RX thread or TX thread): samples are stored but only
+// published with the next commit, so the mixer sees whole bursts and
+// is woken up once per burst, not once per sample.
+//
+static void input_put(MIXER_INPUT *in, float left, float right) {
+  guint w = (guint)g_atomic_int_get(&in->wcount) + (guint)in->pending;
+
+  if ((int)(w - (guint)g_atomic_int_get(&in->rcount)) >= MIXER_RING) {
+    in->overflows++;
+    return;
+  }
+
+  w &= (MIXER_RING - 1);
+  in->ring[2 * w] = left;
+  in->ring[2 * w + 1] = right;
+  in->pending++;
+}
+
+static void input_commit(MIXER_INPUT *in) {
+  if (in->pending == 0) { return; }
+
+  g_atomic_int_add(&in->wcount, in->pending);
+  in->pending = 0;
+  g_mutex_lock(&mixer_mutex);
+  g_cond_signal(&mixer_cond);
+  g_mutex_unlock(&mixer_mutex);
+}
+
+void audio_mixer_put(const RECEIVER *rx, float left, float right) {
+  if (rx->id < 0 || rx->id >= MIXER_RX_INPUTS) { return; }
+
+  audio_mixer_init_once();
+  input_put(&inputs[rx->id], left, right);
+}
+
+void audio_mixer_commit(const RECEIVER *rx) {
+  if (rx->id < 0 || rx->id >= MIXER_RX_INPUTS) { return; }
+
+  audio_mixer_init_once();
+  input_commit(&inputs[rx->id]);
+}
+
+void audio_mixer_put_monitor(float left, float right) {
+  audio_mixer_init_once();
+  input_put(&inputs[MIXER_MONITOR], left, right);
+}
+
+void audio_mixer_commit_monitor() {
+  audio_mixer_init_once();
+  input_commit(&inputs[MIXER_MONITOR]);
+}
+
+void audio_mixer_put_playback(float left, float right) {
+  audio_mixer_init_once();
+  input_put(&inputs[MIXER_PLAYBACK], left, right);
+}
+
+void audio_mixer_commit_playback() {
+  audio_mixer_init_once();
+  input_commit(&inputs[MIXER_PLAYBACK]);
+}
+
+int audio_mixer_playback_queued() {
+  audio_mixer_init_once();
+  return input_avail(&inputs[MIXER_PLAYBACK]);
+}
+
+//
+// Routing: the receiver that has actually opened the output device
+// selected by rx. This is rx itself, unless another receiver has already
+// opened the same device, in which case rx is mixed into that stream.
+//
+RECEIVER *audio_mixer_output(RECEIVER *rx) {
+  if (rx == NULL || rx->audio_match != NULL) { return rx; }
+
+  for (int i = 0; i < RECEIVERS; i++) {
+    RECEIVER *r = receiver[i];
+
+    if (r != NULL && r != rx && r->local_audio && r->audio_match != NULL && !strcmp(r->audio_name, rx->audio_name)) {
+      return r;
+    }
+  }
+
+  return rx;
+}
+
+int audio_mixer_open_output(RECEIVER *rx) {
+  if (audio_mixer_output(rx) != rx) {
+    t_print("%s: RX%d shares the output device with RX%d\n", __FUNCTION__, rx->id + 1,
+            audio_mixer_output(rx)->id + 1);
+    return 0;
+  }
+
+  return audio_open_output(rx);
+}
+
+void audio_mixer_close_output(RECEIVER *rx) {
+  if (rx->audio_match == NULL) {
+    //
+    // rx was mixed into the stream of another receiver
+    //
+    return;
+  }
+
+  audio_close_output(rx);
+
+  //
+  // If another receiver was mixed into this stream, it now has to open the device itself
+  //
+  for (int i = 0; i < RECEIVERS; i++) {
+    RECEIVER *r = receiver[i];
+
+    if (r != NULL && r != rx && r->local_audio && r->audio_match == NULL && !strcmp(r->audio_name, rx->audio_name)) {
+      if (audio_open_output(r) < 0) {
+        r->local_audio = 0;
+      }
+
+      break;
+    }
+  }
+}
+
+//
+// Per-input gains, derived from the receiver settings.
+// Pan is a simple balance control: the far side is attenuated linearly,
+// the near side stays at full level, so the centre position is unity gain.
+//
+static void input_gains(const RECEIVER *rx, float *gl, float *gr) {
+  float g, pan;
+
+  if (rx->mute_radio || (rx != active_receiver && rx->mute_when_not_active)) {
+    *gl = *gr = 0.0F;
+    return;
+  }
+
+  g = (float) pow(10.0, 0.05 * rx->mixer_gain);
+  pan = (float) rx->mixer_pan;
+
+  if (pan < -1.0F) { pan = -1.0F; }
+
+  if (pan >  1.0F) { pan =  1.0F; }
+
+  *gl = (pan > 0.0F) ? g * (1.0F - pan) : g;
+  *gr = (pan < 0.0F) ? g * (1.0F + pan) : g;
+
+  switch (rx->audio_channel) {
+  case STEREO:
+    break;
+
+  case LEFT:
+    *gr = 0.0F;
+    break;
+
+  case RIGHT:
+    *gl = 0.0F;
+    break;
+  }
+}
+
+//
+// out += g * in, for interleaved stereo.
+// Kept free of branches and aliasing so that the compiler vectorises it.
+//
+static void mix_block(float * restrict out, const float * restrict in, int frames, float gl, float gr) {
+  for (int i = 0; i < frames; i++) {
+    out[2 * i]     += gl * in[2 * i];
+    out[2 * i + 1] += gr * in[2 * i + 1];
+  }
+}
+
+//
+// Copy one block out of an input queue into buf (zero-padded if fewer
+// frames are available) and consume it.
+//
+static void input_get(MIXER_INPUT *in, float *buf) {
+  int avail = input_avail(in);
+  guint r = (guint)g_atomic_int_get(&in->rcount);
+  int n = (avail < MIXER_BLOCK) ? avail : MIXER_BLOCK;
+  int pos = (int)(r & (MIXER_RING - 1));
+  int first = MIXER_RING - pos;
+
+  if (first > n) { first = n; }
+
+  memcpy(buf, &in->ring[2 * pos], 2 * first * sizeof(float));
+
+  if (n > first) {
+    memcpy(&buf[2 * first], in->ring, 2 * (n - first) * sizeof(float));
+  }
+
+  if (n < MIXER_BLOCK) {
+    memset(&buf[2 * n], 0, 2 * (MIXER_BLOCK - n) * sizeof(float));
+  }
+
+  g_atomic_int_add(&in->rcount, n);
+}
+
+//
+// An input takes part in mixing if it feeds an open output stream.
+// The monitor and the playback only take part while they deliver samples.
+//
+static int input_active(int i) {
+  RECEIVER *rx;
+
+  if (i == MIXER_MONITOR || i == MIXER_PLAYBACK) {
+    rx = receiver[0];
+    return rx != NULL && rx->local_audio && input_avail(&inputs[i]) > 0;
+  }
+
+  if (i >= RECEIVERS) { return 0; }
+
+  rx = receiver[i];
+  return rx != NULL && rx->local_audio;
+}
+
+//
+// A mixer cycle can run if all active inputs have a full block, or if one
+// input has queued so much that the others must be stalled.
+//
+static int mixer_ready(void) {
+  int any = 0;
+  int all = 1;
+  int lag = 0;
+
+  for (int i = 0; i < MIXER_INPUTS; i++) {
+    int avail = input_avail(&inputs[i]);
+
+    if (!input_active(i)) {
+      //
+      // Nobody listens: discard, so stale audio does not pop up later
+      //
+      if (avail > 0) { g_atomic_int_add(&inputs[i].rcount, avail); }
+
+      continue;
+    }
+
+    any = 1;
+
+    if (avail < MIXER_BLOCK) { all = 0; }
+
+    if (avail >= MIXER_LAG) { lag = 1; }
+  }
+
+  return any && (all || lag);
+}
+
+static gpointer mixer_thread(gpointer arg) {
+  float *in = g_new(float, 2 * MIXER_BLOCK);
+  float *out[MIXER_RX_INPUTS];
+  float gl[MIXER_INPUTS], gr[MIXER_INPUTS];
+
+  for (int s = 0; s < MIXER_RX_INPUTS; s++) {
+    out[s] = g_new(float, 2 * MIXER_BLOCK);
+  }
+
+  t_print("%s: started\n", __FUNCTION__);
+
+  while (g_atomic_int_get(&mixer_running)) {
+    RECEIVER *sink[MIXER_INPUTS];
+    g_mutex_lock(&mixer_mutex);
+
+    if (!mixer_ready()) {
+      gint64 end_time = g_get_monotonic_time() + 20 * G_TIME_SPAN_MILLISECOND;
+      g_cond_wait_until(&mixer_cond, &mixer_mutex, end_time);
+    }
+
+    g_mutex_unlock(&mixer_mutex);
+
+    if (!g_atomic_int_get(&mixer_running) || !mixer_ready()) { continue; }
+
+    //
+    // Routing matrix: which input goes to which output stream
+    //
+    for (int i = 0; i < MIXER_INPUTS; i++) {
+      sink[i] = NULL;
+
+      if (!input_active(i)) { continue; }
+
+      if (i == MIXER_MONITOR || i == MIXER_PLAYBACK) {
+        sink[i] = audio_mixer_output(receiver[0]);
+        gl[i] = gr[i] = 1.0F;
+      } else {
+        sink[i] = audio_mixer_output(receiver[i]);
+        input_gains(receiver[i], &gl[i], &gr[i]);
+      }
+    }
+
+    for (int s = 0; s < MIXER_RX_INPUTS; s++) {
+      memset(out[s], 0, 2 * MIXER_BLOCK * sizeof(float));
+    }
+
+    for (int i = 0; i < MIXER_INPUTS; i++) {
+      if (sink[i] == NULL) { continue; }
+
+      input_get(&inputs[i], in);
+
+      for (int s = 0; s < MIXER_RX_INPUTS && s < RECEIVERS; s++) {
+        if (sink[i] == receiver[s]) {
+          mix_block(out[s], in, MIXER_BLOCK, gl[i], gr[i]);
+        }
+      }
+    }
+
+    float *speaker = NULL;
+
+    for (int s = 0; s < MIXER_RX_INPUTS && s < RECEIVERS; s++) {
+      int used = 0;
+
+      for (int i = 0; i < MIXER_INPUTS; i++) {
+        if (sink[i] == receiver[s]) { used = 1; }
+      }
+
+      if (used && receiver[s]->audio_match != NULL) {
+        audio_write_buffer(receiver[s], out[s], MIXER_BLOCK);
+
+        if (speaker == NULL) {
+          speaker = out[s];
+        } else {
+          mix_block(speaker, out[s], MIXER_BLOCK, 1.0F, 1.0F);
+        }
+      }
+    }
+
+    //
+    // Whatever goes to the local speakers is the anti-VOX reference
+    //
+    if (speaker != NULL) {
+      vox_antivox_data(speaker);
+    }
+  }
+
+  g_free(in);
+
+  for (int s = 0; s < MIXER_RX_INPUTS; s++) {
+    g_free(out[s]);
+  }
+
+  t_print("%s: exiting\n", __FUNCTION__);
+  return NULL;
+}
+
+void audio_mixer_start() {
+  audio_mixer_init_once();
+
+  if (mixer_thread_id != NULL) { return; }
+
+  g_atomic_int_set(&mixer_running, 1);
+  mixer_thread_id = g_thread_new("audio mixer", mixer_thread, NULL);
+}
+
+void audio_mixer_stop() {
+  if (mixer_thread_id == NULL) { return; }
+
+  g_atomic_int_set(&mixer_running, 0);
+  g_mutex_lock(&mixer_mutex);
+  g_cond_signal(&mixer_cond);
+  g_mutex_unlock(&mixer_mutex);
+  g_thread_join(mixer_thread_id);
+  mixer_thread_id = NULL;
+
+  for (int i = 0; i < MIXER_INPUTS; i++) {
+    if (inputs[i].overflows > 0) {
+      t_print("%s: input %d: %d samples dropped\n", __FUNCTION__, i, inputs[i].overflows);
+    }
+  }
+}
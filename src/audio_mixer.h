@@ -0,0 +1,54 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _AUDIO_MIXER_H
+#define _AUDIO_MIXER_H
+
+#include "receiver.h"
+
+//
+// Central mixer for the local audio output.
+//
+// Each receiver (and the TX monitor and the DVR playback) puts its audio into its own
+// single-producer/single-consumer queue. A single mixer thread pulls
+// fixed-size blocks from all queues, applies gain, pan, channel assignment
+// and muting, sums all inputs routed to the same output device and hands
+// the result to the audio backend (audio_write_buffer).
+//
+// Receivers that select the same output device share one stream: only the
+// first one opens the device, the others are mixed into it.
+//
+#define MIXER_BLOCK    256     // stereo frames per mixer cycle
+#define MIXER_RING    8192     // stereo frames per input queue, MUST BE A POWER OF TWO
+
+extern void audio_mixer_start(void);
+extern void audio_mixer_stop(void);
+
+extern void audio_mixer_put(const RECEIVER *rx, float left, float right);
+extern void audio_mixer_put_monitor(float left, float right);
+extern void audio_mixer_commit(const RECEIVER *rx);
+extern void audio_mixer_commit_monitor(void);
+extern void audio_mixer_put_playback(float left, float right);
+extern void audio_mixer_commit_playback(void);
+extern int  audio_mixer_playback_queued(void);
+
+extern RECEIVER *audio_mixer_output(RECEIVER *rx);
+extern int  audio_mixer_open_output(RECEIVER *rx);
+extern void audio_mixer_close_output(RECEIVER *rx);
+
+#endif
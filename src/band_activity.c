@@ -0,0 +1,432 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <gtk/gtk.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "adc.h"
+#include "band.h"
+#include "band_activity.h"
+#include "message.h"
+#include "mode.h"
+#include "radio.h"
+#include "receiver.h"
+#include "vfo.h"
+
+#define BA_DIR          "activity"
+#define BA_MAGIC        0x41435431      // "ACT1"
+#define BA_VERSION      1
+#define BA_BINS         512             // frequency bins per band
+#define BA_LEVELS       32              // noise floor histogram classes
+#define BA_LEVEL_MIN    -150.0          // dBm, lower edge of the first class
+#define BA_LEVEL_STEP   3.0             // dB per class
+#define BA_RECEIVERS    8               // size of the receiver[] array
+#define BA_BUDGET       64              // bins updated per frame
+#define BA_SWEEP        1000000LL       // usec, min. time between two sweeps
+#define BA_SETTLE       5               // frames to wait after a frequency change
+#define BA_GUARD        0.02            // fraction of the spectrum ignored at each edge
+#define BA_SNR          10.0            // dB above the floor that count as activity
+#define BA_FLOOR_PIX    64              // pixels sampled for the floor of a sweep
+#define BA_MIN_SEEN     20              // observations before a bin is shown
+#define BA_NOISY        20.0            // dB above the band floor that count as fully "noisy"
+#define BA_STRIP        6               // height of the heat strip
+
+//
+// Layout of an activity file. The counters are halved whenever "seen"
+// saturates, so old observations fade out with a time constant of
+// about 18 hours of observation per bin.
+//
+typedef struct _ba_file {
+  uint32_t magic;
+  uint32_t version;
+  int64_t  low;                         // band edges the file was made for
+  int64_t  high;
+  uint32_t bins;
+  uint32_t levels;
+  uint16_t seen[BA_BINS];
+  uint16_t busy[BA_BINS];
+  uint16_t hist[BA_BINS][BA_LEVELS];
+} BA_FILE;
+
+typedef struct _ba_state {
+  int band;                             // band of the mapped file, -1 if none
+  BA_FILE *file;
+  float floor[BA_BINS];                 // median noise floor per bin (dBm), from hist
+  float band_floor;                     // median of floor[] over the bins with data
+  long long center;
+  double hz_per_pixel;
+  int settle;
+  int cursor;                           // next bin of the running sweep, -1 if idle
+  int last;                             // last bin of the running sweep
+  float sweep_floor;                    // floor of the running sweep (raw analyzer dB)
+  gint64 next_sweep;
+} BA_STATE;
+
+static BA_STATE ba_state[BA_RECEIVERS];
+static int ba_initialized = 0;
+
+static void ba_bin_floor(BA_STATE *s, int k) {
+  const uint16_t *h = s->file->hist[k];
+  int half = (s->file->seen[k] + 1) / 2;
+  int sum = 0;
+  int j;
+
+  for (j = 0; j < BA_LEVELS - 1; j++) {
+    sum += h[j];
+
+    if (sum >= half) { break; }
+  }
+
+  s->floor[k] = (float)(BA_LEVEL_MIN + (j + 0.5) * BA_LEVEL_STEP);
+}
+
+static int ba_compare(const void *a, const void *b) {
+  float fa = *(const float *)a;
+  float fb = *(const float *)b;
+  return (fa > fb) - (fa < fb);
+}
+
+static void ba_band_floor(BA_STATE *s) {
+  float tmp[BA_BINS];
+  int n = 0;
+
+  for (int k = 0; k < BA_BINS; k++) {
+    if (s->file->seen[k] >= BA_MIN_SEEN) { tmp[n++] = s->floor[k]; }
+  }
+
+  if (n > 0) {
+    qsort(tmp, n, sizeof(float), ba_compare);
+    s->band_floor = tmp[n / 2];
+  } else {
+    s->band_floor = (float) BA_LEVEL_MIN;
+  }
+}
+
+static void ba_unmap(BA_STATE *s) {
+  if (s->file != NULL) {
+    munmap(s->file, sizeof(BA_FILE));
+    s->file = NULL;
+  }
+
+  s->band = -1;
+}
+
+//
+// Map the activity file of band b, (re-)initializing it if it does not
+// match the current band edges
+//
+static void ba_map(BA_STATE *s, int b, const BAND *band) {
+  char path[64];
+  int fd;
+  void *p;
+  ba_unmap(s);
+
+  if (g_mkdir_with_parents(BA_DIR, 0700) != 0) {
+    t_print("%s: cannot create directory %s\n", __FUNCTION__, BA_DIR);
+    return;
+  }
+
+  snprintf(path, sizeof(path), "%s/band%02d.act", BA_DIR, b);
+  fd = open(path, O_RDWR | O_CREAT, 0600);
+
+  if (fd < 0) {
+    t_perror("band_activity open:");
+    return;
+  }
+
+  if (ftruncate(fd, sizeof(BA_FILE)) != 0) {
+    t_perror("band_activity ftruncate:");
+    close(fd);
+    return;
+  }
+
+  p = mmap(NULL, sizeof(BA_FILE), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (p == MAP_FAILED) {
+    t_perror("band_activity mmap:");
+    return;
+  }
+
+  BA_FILE *f = (BA_FILE *)p;
+
+  if (f->magic != BA_MAGIC || f->version != BA_VERSION || f->low != band->frequencyMin
+      || f->high != band->frequencyMax || f->bins != BA_BINS || f->levels != BA_LEVELS) {
+    t_print("%s: new activity file %s\n", __FUNCTION__, path);
+    memset(f, 0, sizeof(BA_FILE));
+    f->magic = BA_MAGIC;
+    f->version = BA_VERSION;
+    f->low = band->frequencyMin;
+    f->high = band->frequencyMax;
+    f->bins = BA_BINS;
+    f->levels = BA_LEVELS;
+  }
+
+  s->file = f;
+  s->band = b;
+
+  for (int k = 0; k < BA_BINS; k++) {
+    ba_bin_floor(s, k);
+  }
+
+  ba_band_floor(s);
+}
+
+//
+// Same corrections for attenuators and preamps as applied by the panadapter
+//
+static double ba_offset(const RECEIVER *rx, const BAND *band) {
+  double offset = (double)(rx_gain_calibration - band->gain) + (double)adc[rx->adc].attenuation - adc[rx->adc].gain;
+
+  if (filter_board == ALEX && rx->adc == 0) {
+    offset += (double)(10 * rx->alex_attenuation - 20 * rx->preamp);
+  }
+
+  if (filter_board == CHARLY25 && rx->adc == 0) {
+    offset += (double)(12 * rx->alex_attenuation - 18 * rx->preamp - 18 * rx->dither);
+  }
+
+  return offset;
+}
+
+//
+// Frequency of analyzer pixel 0. In CW, the spectrum is shifted by the side tone.
+//
+static long long ba_start(const RECEIVER *rx) {
+  long long frequency = vfo[rx->id].frequency;
+
+  if (vfo[rx->id].mode == modeCWU) {
+    frequency -= cw_keyer_sidetone_frequency;
+  } else if (vfo[rx->id].mode == modeCWL) {
+    frequency += cw_keyer_sidetone_frequency;
+  }
+
+  return frequency - rx->sample_rate / 2;
+}
+
+//
+// Low percentile of a few pixels spread over the visible part of the band:
+// the reference for "activity" in this sweep
+//
+static float ba_sweep_floor(const float *samples, int p0, int p1) {
+  float tmp[BA_FLOOR_PIX];
+  int n = 0;
+  int step = (p1 - p0) / BA_FLOOR_PIX;
+
+  if (step < 1) { step = 1; }
+
+  for (int p = p0; p < p1 && n < BA_FLOOR_PIX; p += step) {
+    tmp[n++] = samples[p];
+  }
+
+  qsort(tmp, n, sizeof(float), ba_compare);
+  return tmp[n / 5];
+}
+
+void band_activity_frame(RECEIVER *rx) {
+  if (!display_activity || rx->id < 0 || rx->id >= BA_RECEIVERS) { return; }
+
+  if (radio_is_transmitting()) { return; }
+
+  if (diversity_enabled && rx->id == 1) { return; }
+
+  if (!ba_initialized) {
+    for (int i = 0; i < BA_RECEIVERS; i++) {
+      ba_state[i].band = -1;
+      ba_state[i].cursor = -1;
+    }
+
+    ba_initialized = 1;
+  }
+
+  BA_STATE *s = &ba_state[rx->id];
+  int b = vfo[rx->id].band;
+  const BAND *band = band_get_band(b);
+
+  if (band->frequencyMax <= band->frequencyMin) { return; }
+
+  if (b != s->band) {
+    ba_map(s, b, band);
+    s->cursor = -1;
+  }
+
+  if (s->file == NULL) { return; }
+
+  //
+  // After a frequency or zoom change, the analyzer still delivers
+  // spectra of the old frequency for a few frames
+  //
+  long long start = ba_start(rx);
+  double hzpp = rx->hz_per_pixel;
+
+  if (start != s->center || hzpp != s->hz_per_pixel) {
+    s->center = start;
+    s->hz_per_pixel = hzpp;
+    s->settle = BA_SETTLE;
+    s->cursor = -1;
+  }
+
+  if (s->settle > 0) {
+    s->settle--;
+    return;
+  }
+
+  int pixels = rx->pixels;
+  int guard = (int)(BA_GUARD * pixels);
+  double bw = (double)(band->frequencyMax - band->frequencyMin) / BA_BINS;
+  const float *samples = rx->pixel_samples;
+
+  if (s->cursor < 0) {
+    gint64 now = g_get_monotonic_time();
+
+    if (now < s->next_sweep) { return; }
+
+    //
+    // Start a new sweep over the bins that are completely visible
+    //
+    double f_lo = (double)start + guard * hzpp;
+    double f_hi = (double)start + (pixels - guard) * hzpp;
+    int k0 = (int)ceil((f_lo - band->frequencyMin) / bw);
+    int k1 = (int)floor((f_hi - band->frequencyMin) / bw) - 1;
+
+    if (k0 < 0) { k0 = 0; }
+
+    if (k1 > BA_BINS - 1) { k1 = BA_BINS - 1; }
+
+    if (k1 < k0) { return; }
+
+    s->cursor = k0;
+    s->last = k1;
+    s->sweep_floor = ba_sweep_floor(samples, guard, pixels - guard);
+    s->next_sweep = now + BA_SWEEP;
+  }
+
+  double offset = ba_offset(rx, band);
+  BA_FILE *f = s->file;
+  int budget = BA_BUDGET;
+
+  while (budget-- > 0 && s->cursor <= s->last) {
+    int k = s->cursor++;
+    double f0 = band->frequencyMin + k * bw;
+    int p0 = (int)((f0 - start) / hzpp);
+    int p1 = (int)((f0 + bw - start) / hzpp);
+
+    if (p0 < 0) { p0 = 0; }
+
+    if (p1 <= p0) { p1 = p0 + 1; }
+
+    if (p1 > pixels) { p1 = pixels; }
+
+    float mn = samples[p0];
+    float mx = samples[p0];
+
+    for (int p = p0 + 1; p < p1; p++) {
+      if (samples[p] < mn) { mn = samples[p]; }
+
+      if (samples[p] > mx) { mx = samples[p]; }
+    }
+
+    int level = (int)((mn + offset - BA_LEVEL_MIN) / BA_LEVEL_STEP);
+
+    if (level < 0) { level = 0; }
+
+    if (level > BA_LEVELS - 1) { level = BA_LEVELS - 1; }
+
+    f->hist[k][level]++;
+
+    if (mx > s->sweep_floor + BA_SNR) { f->busy[k]++; }
+
+    if (++f->seen[k] == UINT16_MAX) {
+      f->seen[k] >>= 1;
+      f->busy[k] >>= 1;
+
+      for (int j = 0; j < BA_LEVELS; j++) {
+        f->hist[k][j] >>= 1;
+      }
+    }
+
+    ba_bin_floor(s, k);
+  }
+
+  if (s->cursor > s->last) {
+    s->cursor = -1;
+    ba_band_floor(s);
+  }
+}
+
+void band_activity_draw(cairo_t *cr, const RECEIVER *rx, long long min_display, double hz_per_pixel,
+                        int width, int height) {
+  if (!display_activity || !ba_initialized || rx->id < 0 || rx->id >= BA_RECEIVERS) { return; }
+
+  const BA_STATE *s = &ba_state[rx->id];
+  const BA_FILE *f = s->file;
+
+  if (f == NULL || s->band != vfo[rx->id].band) { return; }
+
+  double bw = (double)(f->high - f->low) / BA_BINS;
+  int x = 0;
+
+  //
+  // One rectangle per run of pixels that fall into the same bin
+  //
+  while (x < width) {
+    int k = (int)floor(((double)min_display + x * hz_per_pixel - f->low) / bw);
+    int x1 = width;
+
+    if (k >= 0 && k < BA_BINS) {
+      double fe = f->low + (k + 1) * bw;
+      x1 = (int)ceil((fe - (double)min_display) / hz_per_pixel);
+    } else if (k < 0) {
+      x1 = (int)ceil(((double)f->low - (double)min_display) / hz_per_pixel);
+    }
+
+    if (x1 <= x) { x1 = x + 1; }
+
+    if (x1 > width) { x1 = width; }
+
+    if (k >= 0 && k < BA_BINS && f->seen[k] >= BA_MIN_SEEN) {
+      double score = (double)f->busy[k] / (double)f->seen[k];
+      double noisy = (s->floor[k] - s->band_floor) / BA_NOISY;
+
+      if (noisy > score) { score = noisy; }
+
+      if (score > 1.0) { score = 1.0; }
+
+      if (score < 0.0) { score = 0.0; }
+
+      //
+      // green (quiet) -> yellow -> red (busy)
+      //
+      double r = score < 0.5 ? 2.0 * score : 1.0;
+      double g = score < 0.5 ? 1.0 : 2.0 * (1.0 - score);
+      cairo_set_source_rgba(cr, r, g, 0.0, 0.6);
+      cairo_rectangle(cr, x, height - BA_STRIP, x1 - x, BA_STRIP);
+      cairo_fill(cr);
+    }
+
+    x = x1;
+  }
+}
@@ -0,0 +1,43 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _BAND_ACTIVITY_H
+#define _BAND_ACTIVITY_H
+
+#include <gtk/gtk.h>
+#include "receiver.h"
+
+//
+// Band activity statistics: each band is divided into BA_BINS frequency
+// bins, and for each bin we keep a histogram of the noise floor and the
+// fraction of observations with a signal. The data of a band lives in a
+// small memory-mapped file (activity/bandNN.act), so it accumulates over
+// hours and sessions without explicit saving.
+//
+// band_activity_frame() samples the analyzer output of a receiver with a
+// fixed budget of bins per frame, one sweep over the visible part of the
+// band per second. band_activity_draw() paints the result as a heat strip
+// at the bottom of the panadapter: green is quiet, red is busy or noisy.
+//
+// Both are called by the display render thread only.
+//
+extern void band_activity_frame(RECEIVER *rx);
+extern void band_activity_draw(cairo_t *cr, const RECEIVER *rx, long long min_display, double hz_per_pixel,
+                               int width, int height);
+
+#endif
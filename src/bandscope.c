@@ -0,0 +1,293 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <gtk/gtk.h>
+#include <math.h>
+#include <string.h>
+#include <wdsp.h>
+
+#include "bandscope.h"
+#include "channel.h"
+#include "discovered.h"
+#include "message.h"
+#include "new_protocol.h"
+#include "old_protocol.h"
+#include "radio.h"
+
+#define BS_MAX_FRAME   (BS_P2_PACKETS * BS_PACKET_SAMPLES)
+#define BS_AVG_TIME    0.5             // sec, time constant of the log-recursive average
+#define BS_PEAK_DECAY  0.25            // dB per spectrum, 5 dB/sec at BS_INTERVAL
+
+int bandscope_enabled = 0;
+
+//
+// fill_buf is only touched by the receive thread, ready_buf only by the
+// worker. The pointers are exchanged under bs_mutex.
+//
+static short *fill_buf = NULL;
+static short *ready_buf = NULL;
+static double *spec_buf = NULL;
+static volatile int frame_size = 0;
+static int fill_count = 0;
+static int collecting = 0;
+static unsigned int last_seq = 0;
+static gint64 next_due = 0;
+
+static int ready_full = 0;
+static int worker_run = 0;
+static GMutex bs_mutex;
+static GCond bs_cond;
+static GThread *bs_thread_id = NULL;
+
+static int analyzer_created = 0;
+static int bs_pixels = 0;
+static float *peak_buf = NULL;
+
+int bandscope_available() {
+  switch (protocol) {
+  case ORIGINAL_PROTOCOL:
+    //
+    // OZY has no EP4 over USB, and the HermesLite gateware does not send it
+    //
+    return device != DEVICE_OZY && device != DEVICE_HERMES_LITE && device != DEVICE_HERMES_LITE2;
+
+  case NEW_PROTOCOL:
+    return !have_saturn_xdma;
+
+  default:
+    return 0;
+  }
+}
+
+static gpointer bs_thread(gpointer data) {
+  g_mutex_lock(&bs_mutex);
+
+  while (worker_run) {
+    if (!ready_full) {
+      g_cond_wait(&bs_cond, &bs_mutex);
+      continue;
+    }
+
+    int n = frame_size;
+    g_mutex_unlock(&bs_mutex);
+
+    //
+    // The analyzer takes real data from the "I" slot of each sample pair
+    //
+    for (int i = 0; i < n; i++) {
+      double s = (double)ready_buf[i] * (1.0 / 32768.0);
+      spec_buf[2 * i] = s;
+      spec_buf[2 * i + 1] = s;
+    }
+
+    g_mutex_lock(&bs_mutex);
+    ready_full = 0;
+    g_mutex_unlock(&bs_mutex);
+    Spectrum0(1, CHANNEL_BS, 0, 0, spec_buf);
+    g_mutex_lock(&bs_mutex);
+  }
+
+  g_mutex_unlock(&bs_mutex);
+  return NULL;
+}
+
+static void bs_set_analyzer(int size, int pixels) {
+  int flp[] = {0};
+  int rc;
+
+  if (!analyzer_created) {
+    XCreateAnalyzer(CHANNEL_BS, &rc, 262144, 1, 1, NULL);
+
+    if (rc != 0) {
+      t_print("%s: CreateAnalyzer failed\n", __FUNCTION__);
+      return;
+    }
+
+    analyzer_created = 1;
+  }
+
+  SetAnalyzer(CHANNEL_BS,
+              1,                // number of pixel outputs
+              1,                // number of LO frequencies
+              0,                // real input data
+              flp,
+              size,             // fft size: one frame
+              size,             // samples per Spectrum0() call
+              5,                // Kaiser window
+              14.0,             // PiAlpha
+              0,                // frames are not contiguous, so no overlap
+              0,                // no clipping
+              0.0,
+              0.0,
+              pixels,
+              1,                // no stitching
+              0,                // no calibration data
+              0.0,
+              0.0,
+              2 * size);
+  //
+  // Peak detection keeps narrow carriers visible when many bins map onto one pixel
+  //
+  SetDisplayDetectorMode(CHANNEL_BS, 0, DETECTOR_MODE_PEAK);
+  SetDisplayAvBackmult(CHANNEL_BS, 0, exp(-BS_INTERVAL * 0.001 / BS_AVG_TIME));
+  SetDisplayNumAverage(CHANNEL_BS, 0, (int)(BS_AVG_TIME * 1000.0 / BS_INTERVAL));
+  SetDisplayAverageMode(CHANNEL_BS, 0, AVERAGE_MODE_LOG_RECURSIVE);
+}
+
+static void bs_update_protocol() {
+  switch (protocol) {
+  case ORIGINAL_PROTOCOL:
+    old_protocol_bandscope();
+    break;
+
+  case NEW_PROTOCOL:
+    schedule_general();
+    break;
+  }
+}
+
+void bandscope_start(int pixels) {
+  if (bandscope_enabled || !bandscope_available()) { return; }
+
+  int size = BS_PACKET_SAMPLES * (protocol == NEW_PROTOCOL ? BS_P2_PACKETS : BS_P1_PACKETS);
+
+  if (fill_buf == NULL) {
+    //
+    // Allocated once with the largest frame and never freed, since a
+    // receive thread may still hold fill_buf while the scope is stopped
+    //
+    fill_buf = g_new0(short, BS_MAX_FRAME);
+    ready_buf = g_new0(short, BS_MAX_FRAME);
+    spec_buf = g_new0(double, 2 * BS_MAX_FRAME);
+  }
+
+  bs_set_analyzer(size, pixels);
+
+  if (!analyzer_created) { return; }
+
+  g_free(peak_buf);
+  peak_buf = g_new(float, pixels);
+
+  for (int i = 0; i < pixels; i++) {
+    peak_buf[i] = -200.0F;
+  }
+
+  bs_pixels = pixels;
+  frame_size = size;
+  collecting = 0;
+  ready_full = 0;
+  worker_run = 1;
+  bs_thread_id = g_thread_new("Bandscope", bs_thread, NULL);
+  t_print("%s: frame=%d pixels=%d\n", __FUNCTION__, size, pixels);
+  bandscope_enabled = 1;
+  bs_update_protocol();
+}
+
+void bandscope_stop() {
+  if (!bandscope_enabled) { return; }
+
+  bandscope_enabled = 0;
+  bs_update_protocol();
+  g_mutex_lock(&bs_mutex);
+  worker_run = 0;
+  g_cond_broadcast(&bs_cond);
+  g_mutex_unlock(&bs_mutex);
+  g_thread_join(bs_thread_id);
+  bs_thread_id = NULL;
+  t_print("%s\n", __FUNCTION__);
+}
+
+//
+// Called from the protocol receive threads for each wideband packet.
+// A frame starts with a packet whose sequence number is a multiple of
+// frame_packets, and is abandoned if a packet is lost.
+//
+void bandscope_add_packet(const unsigned char *data, int samples, unsigned int seq, int frame_packets,
+                          int big_endian) {
+  if (!bandscope_enabled || samples * frame_packets != frame_size) { return; }
+
+  if (collecting && seq != last_seq + 1) { collecting = 0; }
+
+  last_seq = seq;
+
+  if (!collecting) {
+    if (seq % frame_packets != 0 || g_get_monotonic_time() < next_due) { return; }
+
+    collecting = 1;
+    fill_count = 0;
+  }
+
+  short *p = fill_buf + fill_count;
+
+  if (big_endian) {
+    for (int i = 0; i < samples; i++) {
+      p[i] = (short)((data[2 * i] << 8) | data[2 * i + 1]);
+    }
+  } else {
+    for (int i = 0; i < samples; i++) {
+      p[i] = (short)((data[2 * i + 1] << 8) | data[2 * i]);
+    }
+  }
+
+  fill_count += samples;
+
+  if (fill_count < frame_size) { return; }
+
+  collecting = 0;
+  next_due = g_get_monotonic_time() + 1000 * BS_INTERVAL;
+  g_mutex_lock(&bs_mutex);
+
+  if (!ready_full) {
+    short *tmp = ready_buf;
+    ready_buf = fill_buf;
+    fill_buf = tmp;
+    ready_full = 1;
+    g_cond_signal(&bs_cond);
+  }
+
+  g_mutex_unlock(&bs_mutex);
+}
+
+//
+// GUI thread: fetch the averaged spectrum (dBFS per pixel) and update the
+// decaying peak hold. Returns 0 if no new spectrum is available.
+//
+int bandscope_get_pixels(float *avg, float *peak) {
+  int rc = 0;
+
+  if (!bandscope_enabled) { return 0; }
+
+  GetPixels(CHANNEL_BS, 0, avg, &rc);
+
+  if (!rc) { return 0; }
+
+  for (int i = 0; i < bs_pixels; i++) {
+    float p = peak_buf[i] - BS_PEAK_DECAY;
+    peak_buf[i] = avg[i] > p ? avg[i] : p;
+  }
+
+  memcpy(peak, peak_buf, bs_pixels * sizeof(float));
+  return 1;
+}
+
+void bandscope_reset_peak() {
+  for (int i = 0; i < bs_pixels; i++) {
+    peak_buf[i] = -200.0F;
+  }
+}
@@ -0,0 +1,48 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _BANDSCOPE_H
+#define _BANDSCOPE_H
+
+//
+// Wideband bandscope: raw 16-bit samples of ADC0, delivered by the radio
+// through EP4 (P1) or port 1027 (P2), are collected into frames of
+// contiguous samples. A worker thread converts complete frames and feeds
+// them to a WDSP analyzer (display id CHANNEL_BS), so the FFT, averaging
+// and pixel mapping run off the receive and GUI threads.
+//
+// The receive threads only copy samples; frames that arrive while the
+// worker is busy or before the next spectrum is due are dropped.
+//
+#define BS_PACKET_SAMPLES  512             // samples per EP4 / port 1027 packet
+#define BS_P1_PACKETS      8               // packets per frame, P1 (4096 samples)
+#define BS_P2_PACKETS      32              // packets per frame, P2 (16384 samples)
+#define BS_ADC_RATE        122880000.0     // ADC clock, the scope covers 0 ... BS_ADC_RATE/2
+#define BS_INTERVAL        50              // msec between spectra
+
+extern int  bandscope_enabled;
+
+extern int  bandscope_available(void);
+extern void bandscope_start(int pixels);
+extern void bandscope_stop(void);
+extern void bandscope_add_packet(const unsigned char *data, int samples, unsigned int seq, int frame_packets,
+                                 int big_endian);
+extern int  bandscope_get_pixels(float *avg, float *peak);
+extern void bandscope_reset_peak(void);
+
+#endif
@@ -0,0 +1,261 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "appearance.h"
+#include "bandscope.h"
+#include "bandscope_menu.h"
+#include "new_menu.h"
+#include "radio.h"
+#include "receiver.h"
+#include "vfo.h"
+
+#define BS_WIDTH    1024                 // pixels requested from the analyzer
+#define BS_HEIGHT   320
+#define BS_DB_HIGH  -20.0
+#define BS_DB_LOW   -140.0
+
+static GtkWidget *dialog = NULL;
+static GtkWidget *area = NULL;
+static guint update_timer = 0;
+static float avg[BS_WIDTH];
+static float peak[BS_WIDTH];
+static int have_data = 0;
+static double cursor_x = -1.0;
+
+static void cleanup() {
+  if (dialog != NULL) {
+    GtkWidget *tmp = dialog;
+    dialog = NULL;
+
+    if (update_timer > 0) {
+      g_source_remove(update_timer);
+      update_timer = 0;
+    }
+
+    bandscope_stop();
+    gtk_widget_destroy(tmp);
+    sub_menu = NULL;
+    active_menu  = NO_MENU;
+    radio_save_state();
+  }
+}
+
+static gboolean close_cb () {
+  cleanup();
+  return TRUE;
+}
+
+static gboolean clear_cb(GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  bandscope_reset_peak();
+  return TRUE;
+}
+
+static int update_cb(gpointer data) {
+  if (dialog == NULL) { return G_SOURCE_REMOVE; }
+
+  if (bandscope_get_pixels(avg, peak)) {
+    have_data = 1;
+    gtk_widget_queue_draw(area);
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static double x_to_freq(double x, int width) {
+  return x * 0.5 * BS_ADC_RATE / (double) width;
+}
+
+static double db_to_y(double db, int height) {
+  if (db > BS_DB_HIGH) { db = BS_DB_HIGH; }
+
+  if (db < BS_DB_LOW) { db = BS_DB_LOW; }
+
+  return (BS_DB_HIGH - db) * (double) height / (BS_DB_HIGH - BS_DB_LOW);
+}
+
+static void draw_trace(cairo_t *cr, const float *data, int width, int height) {
+  double xscale = (double) width / BS_WIDTH;
+  cairo_move_to(cr, 0.0, db_to_y(data[0], height));
+
+  for (int i = 1; i < BS_WIDTH; i++) {
+    cairo_line_to(cr, i * xscale, db_to_y(data[i], height));
+  }
+
+  cairo_stroke(cr);
+}
+
+static gboolean draw_cb(GtkWidget *widget, cairo_t *cr, gpointer data) {
+  int width = gtk_widget_get_allocated_width(widget);
+  int height = gtk_widget_get_allocated_height(widget);
+  double fmax = 0.5 * BS_ADC_RATE;
+  char text[64];
+  cairo_set_source_rgba(cr, COLOUR_PAN_BACKGND);
+  cairo_paint(cr);
+  cairo_select_font_face(cr, DISPLAY_FONT_BOLD, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+  cairo_set_font_size(cr, DISPLAY_FONT_SIZE2);
+  cairo_set_line_width(cr, PAN_LINE_THIN);
+
+  //
+  // Grid: 20 dB vertically, 5 MHz horizontally
+  //
+  for (double db = BS_DB_HIGH; db >= BS_DB_LOW; db -= 20.0) {
+    double y = db_to_y(db, height);
+    cairo_set_source_rgba(cr, COLOUR_PAN_LINE_WEAK);
+    cairo_move_to(cr, 0.0, y);
+    cairo_line_to(cr, width, y);
+    cairo_stroke(cr);
+    cairo_set_source_rgba(cr, COLOUR_PAN_TEXT);
+    snprintf(text, sizeof(text), "%d", (int) db);
+    cairo_move_to(cr, 3.0, y - 3.0);
+    cairo_show_text(cr, text);
+  }
+
+  for (double f = 5.0E6; f < fmax; f += 5.0E6) {
+    double x = f * width / fmax;
+    cairo_set_source_rgba(cr, COLOUR_PAN_LINE_WEAK);
+    cairo_move_to(cr, x, 0.0);
+    cairo_line_to(cr, x, height);
+    cairo_stroke(cr);
+    cairo_set_source_rgba(cr, COLOUR_PAN_TEXT);
+    snprintf(text, sizeof(text), "%d", (int)(f * 1.0E-6));
+    cairo_move_to(cr, x + 3.0, height - 4.0);
+    cairo_show_text(cr, text);
+  }
+
+  if (have_data) {
+    cairo_set_source_rgba(cr, COLOUR_SHADE);
+    draw_trace(cr, peak, width, height);
+    cairo_set_source_rgba(cr, COLOUR_PAN_LINE);
+    draw_trace(cr, avg, width, height);
+  } else {
+    cairo_set_source_rgba(cr, COLOUR_ATTN);
+    cairo_move_to(cr, width / 2 - 80, height / 2);
+    cairo_show_text(cr, "Waiting for wideband data");
+  }
+
+  //
+  // Mark the receivers, the active one in a different colour
+  //
+  for (int i = 0; i < receivers; i++) {
+    long long f = vfo[receiver[i]->id].frequency;
+
+    if (f < 0 || f >= fmax) { continue; }
+
+    double x = (double) f * width / fmax;
+
+    if (receiver[i] == active_receiver) {
+      cairo_set_source_rgba(cr, COLOUR_ALARM);
+    } else {
+      cairo_set_source_rgba(cr, COLOUR_ORANGE);
+    }
+
+    cairo_move_to(cr, x, 0.0);
+    cairo_line_to(cr, x, height);
+    cairo_stroke(cr);
+    snprintf(text, sizeof(text), "RX%d", receiver[i]->id + 1);
+    cairo_move_to(cr, x + 3.0, 14.0 + 14.0 * i);
+    cairo_show_text(cr, text);
+  }
+
+  if (cursor_x >= 0.0) {
+    cairo_set_source_rgba(cr, COLOUR_WHITE);
+    snprintf(text, sizeof(text), "%0.3f MHz", x_to_freq(cursor_x, width) * 1.0E-6);
+    cairo_move_to(cr, width - 100, 14.0);
+    cairo_show_text(cr, text);
+  }
+
+  return FALSE;
+}
+
+static gboolean motion_cb(GtkWidget *widget, GdkEventMotion *event, gpointer data) {
+  cursor_x = event->x;
+  gtk_widget_queue_draw(widget);
+  return TRUE;
+}
+
+static gboolean leave_cb(GtkWidget *widget, GdkEventCrossing *event, gpointer data) {
+  cursor_x = -1.0;
+  gtk_widget_queue_draw(widget);
+  return TRUE;
+}
+
+//
+// Click-to-tune: move the active receiver to the frequency under
+// the cursor, rounded to the nearest kHz
+//
+static gboolean press_cb(GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  if (event->button != 1) { return FALSE; }
+
+  double f = x_to_freq(event->x, gtk_widget_get_allocated_width(widget));
+  long long hz = 1000LL * (long long)(f * 0.001 + 0.5);
+
+  if (hz > 0) { vfo_set_frequency(active_receiver->id, hz); }
+
+  gtk_widget_queue_draw(widget);
+  return TRUE;
+}
+
+void bandscope_menu(GtkWidget *parent) {
+  dialog = gtk_dialog_new();
+  gtk_window_set_transient_for(GTK_WINDOW(dialog), GTK_WINDOW(parent));
+  win_set_bgcolor(dialog, &mwin_bgcolor);
+  GtkWidget *headerbar = gtk_header_bar_new();
+  gtk_window_set_titlebar(GTK_WINDOW(dialog), headerbar);
+  gtk_header_bar_set_show_close_button(GTK_HEADER_BAR(headerbar), TRUE);
+  char _title[32];
+  snprintf(_title, 32, "%s - Bandscope", PGNAME);
+  gtk_header_bar_set_title(GTK_HEADER_BAR(headerbar), _title);
+  g_signal_connect (dialog, "delete_event", G_CALLBACK (close_cb), NULL);
+  g_signal_connect (dialog, "destroy", G_CALLBACK (close_cb), NULL);
+  GtkWidget *content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+  GtkWidget *grid = gtk_grid_new();
+  gtk_grid_set_column_spacing (GTK_GRID(grid), 10);
+  gtk_grid_set_row_spacing (GTK_GRID(grid), 10);
+  GtkWidget *close_b = gtk_button_new_with_label("Close");
+  gtk_widget_set_name(close_b, "close_button");
+  g_signal_connect (close_b, "button-press-event", G_CALLBACK(close_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), close_b, 0, 0, 1, 1);
+  GtkWidget *clear_b = gtk_button_new_with_label("Clear Peak");
+  gtk_widget_set_tooltip_text(clear_b, "Restart the peak hold trace");
+  g_signal_connect (clear_b, "button-press-event", G_CALLBACK(clear_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), clear_b, 1, 0, 1, 1);
+  GtkWidget *info = gtk_label_new("ADC0, 0 - 61.44 MHz, dBFS. Click to tune the active receiver.");
+  gtk_widget_set_halign(info, GTK_ALIGN_START);
+  gtk_grid_attach(GTK_GRID(grid), info, 2, 0, 3, 1);
+  area = gtk_drawing_area_new();
+  gtk_widget_set_size_request(area, BS_WIDTH, BS_HEIGHT);
+  gtk_widget_set_events(area, gtk_widget_get_events(area) | GDK_BUTTON_PRESS_MASK | GDK_POINTER_MOTION_MASK
+                        | GDK_LEAVE_NOTIFY_MASK);
+  g_signal_connect (area, "draw", G_CALLBACK(draw_cb), NULL);
+  g_signal_connect (area, "motion-notify-event", G_CALLBACK(motion_cb), NULL);
+  g_signal_connect (area, "leave-notify-event", G_CALLBACK(leave_cb), NULL);
+  g_signal_connect (area, "button-press-event", G_CALLBACK(press_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), area, 0, 1, 5, 1);
+  gtk_container_add(GTK_CONTAINER(content), grid);
+  have_data = 0;
+  cursor_x = -1.0;
+  bandscope_start(BS_WIDTH);
+  update_timer = g_timeout_add((guint) BS_INTERVAL, update_cb, NULL);
+  sub_menu = dialog;
+  gtk_widget_show_all(dialog);
+}
@@ -0,0 +1,512 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <gtk/gtk.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wdsp.h>
+
+#include "carrier_notch.h"
+#include "message.h"
+#include "mode.h"
+#include "radio.h"
+#include "receiver.h"
+#include "vfo.h"
+
+#define CN_RECEIVERS     8            // size of the receiver[] array
+#define CN_FRAMES        12           // analyzer frames per evaluation (min-hold window)
+#define CN_TRACKS        16           // max. number of carrier candidates per receiver
+#define CN_NOTCHES       8            // max. number of notches per receiver
+#define CN_SNR           15.0         // dB, min. height of a carrier above the passband floor
+#define CN_WIDTH         100.0        // Hz, max. -10 dB width of a carrier
+#define CN_TOLERANCE     25.0         // Hz, min. frequency tolerance when following a carrier
+#define CN_MIN_NOTCH     40.0         // Hz, min. notch width
+#define CN_MAX_NOTCH     150.0        // Hz, max. notch width
+#define CN_ADD_HITS      3            // evaluations a carrier must be seen before it is notched
+#define CN_DROP_MISSES   4            // evaluations a notched carrier may be missing before it is released
+#define CN_REPORT        300000000LL  // usec, statistics every 5 minutes
+
+typedef struct _cn_notch {
+  double freq;          // Hz, absolute
+  double width;         // Hz
+} CN_NOTCH;
+
+typedef struct _cn_track {
+  double freq;          // Hz, absolute, last detected position
+  double notch_freq;    // Hz, absolute, position of the notch
+  int hits;
+  int misses;
+  int notched;
+} CN_TRACK;
+
+typedef struct _cn_state {
+  //
+  // owned by the display render thread
+  //
+  float *minhold;
+  float *sort;
+  int pixels;
+  int frames;
+  long long center;
+  double hz_per_pixel;
+  CN_TRACK track[CN_TRACKS];
+  int ntrack;
+  long long published_center;
+  gint64 report_time;
+  long evaluations;
+  long added;
+  long removed;
+  //
+  // shared, protected by mutex
+  //
+  GMutex mutex;
+  CN_NOTCH desired[CN_NOTCHES];
+  int ndesired;
+  int pending;
+  int reset;
+  //
+  // owned by the GTK thread
+  //
+  int id;
+  int enabled;
+  double tunefreq;
+  CN_NOTCH applied[CN_NOTCHES];
+  int napplied;
+} CN_STATE;
+
+static CN_STATE cn_state[CN_RECEIVERS];
+
+//
+// Absolute frequency of the analyzer (and WDSP baseband) center.
+// In CW, the radio is tuned off by the side tone frequency.
+//
+static long long cn_center(const RECEIVER *rx) {
+  long long frequency = vfo[rx->id].frequency;
+
+  if (vfo[rx->id].mode == modeCWU) {
+    frequency -= cw_keyer_sidetone_frequency;
+  } else if (vfo[rx->id].mode == modeCWL) {
+    frequency += cw_keyer_sidetone_frequency;
+  }
+
+  return frequency;
+}
+
+//
+// FM has no carriers to remove, and digital modes (FT8, RTTY, PSK idle)
+// contain steady tones that would be mistaken for carriers.
+//
+static int cn_mode_ok(int mode) {
+  switch (mode) {
+  case modeFMN:
+  case modeDIGU:
+  case modeDIGL:
+  case modeSPEC:
+  case modeDRM:
+    return 0;
+
+  default:
+    return 1;
+  }
+}
+
+//
+// The frequency estimate of a carrier is about as good as a fraction of
+// a pixel, so the notch width follows the analyzer resolution.
+//
+static double cn_notch_width(double hz_per_pixel) {
+  double width = 0.5 * hz_per_pixel;
+
+  if (width < CN_MIN_NOTCH) { width = CN_MIN_NOTCH; }
+
+  if (width > CN_MAX_NOTCH) { width = CN_MAX_NOTCH; }
+
+  return width;
+}
+
+static int cn_compare(const void *a, const void *b) {
+  float x = *(const float *)a;
+  float y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+//
+// GTK thread: bring the WDSP notch data base in line with the wanted
+// list. Notches that did not change keep their slot, since every
+// add/edit/delete re-designs the whole notched bandpass.
+//
+static void cn_set_notches(CN_STATE *s, const CN_NOTCH *want, int nwant) {
+  int used[CN_NOTCHES] = { 0 };
+  int todo[CN_NOTCHES];
+  int ntodo = 0;
+
+  for (int i = 0; i < nwant; i++) {
+    int j;
+
+    for (j = 0; j < s->napplied; j++) {
+      if (!used[j] && s->applied[j].freq == want[i].freq && s->applied[j].width == want[i].width) { break; }
+    }
+
+    if (j < s->napplied) {
+      used[j] = 1;
+    } else {
+      todo[ntodo++] = i;
+    }
+  }
+
+  //
+  // Re-use the slots of released notches, then append
+  //
+  for (int j = 0; j < s->napplied && ntodo > 0; j++) {
+    if (!used[j]) {
+      const CN_NOTCH *n = &want[todo[--ntodo]];
+      RXANBPEditNotch(s->id, j, n->freq, n->width, 1);
+      s->applied[j] = *n;
+      used[j] = 1;
+    }
+  }
+
+  while (ntodo > 0 && s->napplied < CN_NOTCHES) {
+    const CN_NOTCH *n = &want[todo[--ntodo]];
+    RXANBPAddNotch(s->id, s->napplied, n->freq, n->width, 1);
+    used[s->napplied] = 1;
+    s->applied[s->napplied++] = *n;
+  }
+
+  //
+  // Delete the remaining released slots, highest index first
+  //
+  for (int j = s->napplied - 1; j >= 0; j--) {
+    if (!used[j]) {
+      RXANBPDeleteNotch(s->id, j);
+      memmove(&s->applied[j], &s->applied[j + 1], (s->napplied - j - 1) * sizeof(CN_NOTCH));
+      s->napplied--;
+    }
+  }
+}
+
+static gboolean cn_apply(gpointer data) {
+  CN_STATE *s = (CN_STATE *)data;
+  CN_NOTCH want[CN_NOTCHES];
+  g_mutex_lock(&s->mutex);
+  int nwant = s->ndesired;
+  memcpy(want, s->desired, nwant * sizeof(CN_NOTCH));
+  s->pending = 0;
+  g_mutex_unlock(&s->mutex);
+
+  if (s->enabled && s->id < RECEIVERS && receiver[s->id]) {
+    carrier_notch_retune(receiver[s->id]);
+    cn_set_notches(s, want, nwant);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+//
+// Render thread: find narrow peaks in the min-hold spectrum within the
+// RX filter, follow them from evaluation to evaluation and publish the
+// list of notches.
+//
+static void cn_evaluate(const RECEIVER *rx, CN_STATE *s) {
+  int id = rx->id;
+  int mode = vfo[id].mode;
+  const float *mh = s->minhold;
+  double hz = s->hz_per_pixel;
+  double half = 0.5 * (double)s->pixels * hz;
+  double offset = (double)vfo[id].offset;
+  double low = (double)rx->filter_low + offset;
+  double high = (double)rx->filter_high + offset;
+  double tol = fmax(CN_TOLERANCE, hz);
+  double det[CN_TRACKS];
+  int ndet = 0;
+  s->evaluations++;
+
+  //
+  // Pixel k is at baseband frequency k*hz - half. The outermost pixels
+  // of the RX filter are skipped, they are on the filter slopes.
+  //
+  int klo = (int)ceil((low + half) / hz) + 1;
+  int khi = (int)floor((high + half) / hz) - 1;
+
+  if (klo < 1) { klo = 1; }
+
+  if (khi > s->pixels - 2) { khi = s->pixels - 2; }
+
+  if (cn_mode_ok(mode) && khi - klo >= 8) {
+    int n = khi - klo + 1;
+    memcpy(s->sort, &mh[klo], n * sizeof(float));
+    qsort(s->sort, n, sizeof(float), cn_compare);
+    float noise = s->sort[n / 2];
+    int am = (mode == modeAM || mode == modeSAM || mode == modeDSB);
+
+    for (int k = klo; k <= khi && ndet < CN_TRACKS; k++) {
+      float p = mh[k];
+
+      if (p - noise < CN_SNR || p < mh[k - 1] || p <= mh[k + 1]) { continue; }
+
+      int l = k;
+      int r = k;
+
+      while (l > 0 && mh[l - 1] > p - 10.0f) { l--; }
+
+      while (r < s->pixels - 1 && mh[r + 1] > p - 10.0f) { r++; }
+
+      if ((double)(r - l + 1) * hz > fmax(CN_WIDTH, 3.0 * hz)) { continue; }
+
+      //
+      // parabolic interpolation of the peak position
+      //
+      double a = mh[k - 1];
+      double c = mh[k + 1];
+      double d = a - 2.0 * p + c;
+      double delta = (d < 0.0) ? 0.5 * (a - c) / d : 0.0;
+      double f = ((double)k + delta) * hz - half;
+
+      //
+      // In AM, the carrier of the wanted signal must stay
+      //
+      if (am && fabs(f - offset) < fmax(CN_WIDTH, 2.0 * hz)) { continue; }
+
+      det[ndet++] = (double)s->center + f;
+      //
+      // A noisy carrier may show more than one maximum
+      //
+      k = r;
+    }
+  } else {
+    //
+    // Release all notches at once when switching to a mode without tracking
+    //
+    for (int t = 0; t < s->ntrack; t++) {
+      if (s->track[t].notched) { s->removed++; }
+    }
+
+    s->ntrack = 0;
+  }
+
+  //
+  // Follow the carriers
+  //
+  int matched[CN_TRACKS] = { 0 };
+
+  for (int i = 0; i < ndet; i++) {
+    int best = -1;
+
+    for (int t = 0; t < s->ntrack; t++) {
+      double dist = fabs(s->track[t].freq - det[i]);
+
+      if (!matched[t] && dist <= tol && (best < 0 || dist < fabs(s->track[best].freq - det[i]))) { best = t; }
+    }
+
+    if (best < 0 && s->ntrack < CN_TRACKS) {
+      best = s->ntrack++;
+      memset(&s->track[best], 0, sizeof(CN_TRACK));
+    }
+
+    if (best >= 0) {
+      s->track[best].freq = det[i];
+      s->track[best].hits++;
+      s->track[best].misses = 0;
+      matched[best] = 1;
+    }
+  }
+
+  int nnotch = 0;
+  int j = 0;
+
+  for (int t = 0; t < s->ntrack; t++) {
+    CN_TRACK *tr = &s->track[t];
+    double f = tr->freq - (double)s->center;
+
+    if (!matched[t]) { tr->misses++; }
+
+    if ((!tr->notched && tr->misses > 0) || tr->misses >= CN_DROP_MISSES || f < low || f > high) {
+      if (tr->notched) { s->removed++; }
+
+      continue;
+    }
+
+    if (tr->notched) { nnotch++; }
+
+    s->track[j++] = *tr;
+  }
+
+  s->ntrack = j;
+
+  for (int t = 0; t < s->ntrack; t++) {
+    CN_TRACK *tr = &s->track[t];
+
+    if (!tr->notched && tr->hits >= CN_ADD_HITS && nnotch < CN_NOTCHES) {
+      tr->notched = 1;
+      tr->notch_freq = tr->freq;
+      nnotch++;
+      s->added++;
+    }
+  }
+
+  //
+  // Publish the notch list. A notch only moves if the carrier has
+  // drifted by a substantial fraction of the notch width.
+  //
+  CN_NOTCH want[CN_NOTCHES];
+  double width = cn_notch_width(hz);
+  int nwant = 0;
+
+  for (int t = 0; t < s->ntrack; t++) {
+    CN_TRACK *tr = &s->track[t];
+
+    if (tr->notched) {
+      if (fabs(tr->freq - tr->notch_freq) > 0.25 * width) { tr->notch_freq = tr->freq; }
+
+      want[nwant].freq = tr->notch_freq;
+      want[nwant].width = width;
+      nwant++;
+    }
+  }
+
+  g_mutex_lock(&s->mutex);
+  int changed = (nwant != s->ndesired) || (s->center != s->published_center)
+                || memcmp(want, s->desired, nwant * sizeof(CN_NOTCH)) != 0;
+
+  if (changed) {
+    memcpy(s->desired, want, nwant * sizeof(CN_NOTCH));
+    s->ndesired = nwant;
+    s->published_center = s->center;
+  }
+
+  int queue = changed && !s->pending;
+
+  if (queue) { s->pending = 1; }
+
+  g_mutex_unlock(&s->mutex);
+
+  if (queue) { g_idle_add(cn_apply, s); }
+
+  gint64 now = g_get_monotonic_time();
+
+  if (s->report_time == 0) {
+    s->report_time = now;
+  } else if (now - s->report_time >= CN_REPORT) {
+    t_print("%s: RX%d: %ld evaluations, %d notches active, %ld added, %ld removed\n", __FUNCTION__,
+            id + 1, s->evaluations, nwant, s->added, s->removed);
+    s->evaluations = 0;
+    s->added = 0;
+    s->removed = 0;
+    s->report_time = now;
+  }
+}
+
+void carrier_notch_frame(RECEIVER *rx) {
+  if (rx->id < 0 || rx->id >= CN_RECEIVERS || !rx->carrier_notch) { return; }
+
+  CN_STATE *s = &cn_state[rx->id];
+  long long center = cn_center(rx);
+
+  if (g_atomic_int_get(&s->reset)) {
+    g_atomic_int_set(&s->reset, 0);
+    s->ntrack = 0;
+    s->frames = 0;
+  }
+
+  if (s->pixels != rx->pixels) {
+    g_free(s->minhold);
+    g_free(s->sort);
+    s->pixels = rx->pixels;
+    s->minhold = g_new(float, s->pixels);
+    s->sort = g_new(float, s->pixels);
+    s->frames = 0;
+  }
+
+  //
+  // A min-hold over a few frames removes everything that is not steady.
+  // If the VFO or the zoom has changed, start over.
+  //
+  if (s->frames > 0 && (center != s->center || rx->hz_per_pixel != s->hz_per_pixel)) {
+    s->frames = 0;
+  }
+
+  if (s->frames == 0) {
+    memcpy(s->minhold, rx->pixel_samples, s->pixels * sizeof(float));
+    s->center = center;
+    s->hz_per_pixel = rx->hz_per_pixel;
+  } else {
+    for (int i = 0; i < s->pixels; i++) {
+      if (rx->pixel_samples[i] < s->minhold[i]) { s->minhold[i] = rx->pixel_samples[i]; }
+    }
+  }
+
+  if (++s->frames >= CN_FRAMES) {
+    s->frames = 0;
+    cn_evaluate(rx, s);
+  }
+}
+
+void carrier_notch_retune(const RECEIVER *rx) {
+  if (rx->id < 0 || rx->id >= CN_RECEIVERS) { return; }
+
+  CN_STATE *s = &cn_state[rx->id];
+
+  if (s->enabled) {
+    double f = (double)cn_center(rx);
+
+    if (f != s->tunefreq) {
+      s->tunefreq = f;
+      RXANBPSetTuneFrequency(rx->id, f);
+    }
+  }
+}
+
+void carrier_notch_update(const RECEIVER *rx) {
+  if (rx->id < 0 || rx->id >= CN_RECEIVERS) { return; }
+
+  CN_STATE *s = &cn_state[rx->id];
+
+  if (rx->carrier_notch == s->enabled) { return; }
+
+  s->id = rx->id;
+
+  if (rx->carrier_notch) {
+    g_mutex_lock(&s->mutex);
+    s->ndesired = 0;
+    g_mutex_unlock(&s->mutex);
+    g_atomic_int_set(&s->reset, 1);
+    s->enabled = 1;
+    carrier_notch_retune(rx);
+    RXANBPSetNotchesRun(rx->id, 1);
+  } else {
+    cn_set_notches(s, NULL, 0);
+    RXANBPSetNotchesRun(rx->id, 0);
+    RXANBPSetTuneFrequency(rx->id, 0.0);
+    s->tunefreq = 0.0;
+    s->enabled = 0;
+  }
+}
+
+void carrier_notch_close(const RECEIVER *rx) {
+  if (rx->id < 0 || rx->id >= CN_RECEIVERS) { return; }
+
+  //
+  // The WDSP channel, and with it the notch data base, is destroyed
+  //
+  CN_STATE *s = &cn_state[rx->id];
+  s->enabled = 0;
+  s->napplied = 0;
+  s->tunefreq = 0.0;
+}
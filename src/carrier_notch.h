@@ -0,0 +1,37 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _CARRIER_NOTCH_H_
+#define _CARRIER_NOTCH_H_
+
+#include "receiver.h"
+
+//
+// Automatic carrier notch: stable narrow-band peaks inside the RX filter
+// are detected in the analyzer output and suppressed with WDSP NBP notches.
+//
+// carrier_notch_frame() is called by the display render thread for each
+// new analyzer frame (with rx->display_mutex held), all other functions
+// must be called from the GTK thread.
+//
+extern void carrier_notch_frame(RECEIVER *rx);
+extern void carrier_notch_update(const RECEIVER *rx);
+extern void carrier_notch_retune(const RECEIVER *rx);
+extern void carrier_notch_close(const RECEIVER *rx);
+
+#endif
@@ -587,6 +587,16 @@ void display_menu(GtkWidget *parent) {
   gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ChkBtn_wmap), display_wmap);
   gtk_grid_attach(GTK_GRID(general_grid), ChkBtn_wmap, col, row, 1, 1);
   g_signal_connect(ChkBtn_wmap, "toggled", G_CALLBACK(chkbtn_toggle_cb), &display_wmap);
+  col = 3;
+  GtkWidget *ChkBtn_activity = gtk_check_button_new_with_label("Activity Heatmap");
+  gtk_widget_set_name(ChkBtn_activity, "boldlabel_blue");
+  gtk_widget_set_tooltip_text(ChkBtn_activity,
+                              "Collect long-term occupancy and noise floor statistics per band\n"
+                              "and show them as a strip at the bottom of the RX panadapter\n"
+                              "(green: quiet, red: busy or noisy)");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ChkBtn_activity), display_activity);
+  gtk_grid_attach(GTK_GRID(general_grid), ChkBtn_activity, col, row, 1, 1);
+  g_signal_connect(ChkBtn_activity, "toggled", G_CALLBACK(chkbtn_toggle_cb), &display_activity);
   //--------------------------------------------------------------------------------------------------------------
   col = 2;
   row = 1;
@@ -0,0 +1,909 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_mixer.h"
+#include "dvr.h"
+#include "message.h"
+#include "mode.h"
+#include "radio.h"
+#include "receiver.h"
+#include "vfo.h"
+
+#define DVR_DIR        "dvr"
+#define DVR_RING_DIR   "dvr/ring"
+
+#define DVR_AUDIO_RING (1 << 17)   // frames per audio queue (2.7 sec at 48k), MUST BE A POWER OF TWO
+#define DVR_IQ_RING    (1 << 22)   // frames per IQ queue (2.7 sec at 1536k), MUST BE A POWER OF TWO
+#define DVR_CHUNK      4096        // frames converted and written at a time
+#define DVR_HEADER     44          // size of the (canonical) WAV header of a segment
+#define DVR_WAKEUP     100         // msec between two writer cycles
+
+typedef struct _dvr_segment {
+  char   *path;                  // the sidecar file has .meta instead of .wav
+  gint64  start;                 // UTC of the first frame (usec since the epoch)
+  int     rate;
+  long    frames;                // frames on disk
+} DVR_SEGMENT;
+
+//
+// Audio is stored as 16-bit PCM, IQ data as 32-bit float since the
+// dynamic range of the raw IQ samples exceeds 16 bits.
+//
+typedef struct _dvr_track {
+  const char *name;
+  int    channels;
+  int    bytes;                  // bytes per sample on disk
+  int    size;                   // frames in the queue
+  float *ring;                   // channels * size interleaved samples
+  gint   wcount;                 // frames published by the producer (wraps)
+  gint   rcount;                 // frames consumed by the writer (wraps)
+  gint   pending;                // producer-private: frames put but not yet published
+  gint   rate;                   // sample rate of the published frames
+  gint   overflows;
+  //
+  // writer-private
+  //
+  FILE  *fp;
+  FILE  *meta;
+  long long meta_freq;
+  int    meta_mode;
+  //
+  // protected by dvr_mutex, since export and replay read them
+  //
+  DVR_SEGMENT *seg;              // segment being written
+  GQueue segments;               // oldest first
+} DVR_TRACK;
+
+static DVR_TRACK tracks[DVR_TRACKS] = {
+  { .name = "rx1", .channels = 2, .bytes = 2, .size = DVR_AUDIO_RING },
+  { .name = "rx2", .channels = 2, .bytes = 2, .size = DVR_AUDIO_RING },
+  { .name = "mic", .channels = 1, .bytes = 2, .size = DVR_AUDIO_RING },
+  { .name = "iq1", .channels = 2, .bytes = 4, .size = DVR_IQ_RING },
+  { .name = "iq2", .channels = 2, .bytes = 4, .size = DVR_IQ_RING },
+};
+
+static GThread *dvr_thread_id = NULL;
+static gint     dvr_running = 0;
+static gint     dvr_iq_running = 0;
+static GMutex   dvr_mutex;
+static GCond    dvr_cond;
+static gsize    dvr_inited = 0;
+
+static GThread *replay_thread_id = NULL;
+static gint     replay_running = 0;
+
+static void dvr_init_once(void) {
+  if (g_once_init_enter(&dvr_inited)) {
+    g_mutex_init(&dvr_mutex);
+    g_cond_init(&dvr_cond);
+    g_once_init_leave(&dvr_inited, 1);
+  }
+}
+
+static char *dvr_utc_string(gint64 usec, const char *format) {
+  GDateTime *dt = g_date_time_new_from_unix_utc(usec / G_USEC_PER_SEC);
+  char *s = g_date_time_format(dt, format);
+  g_date_time_unref(dt);
+  return s;
+}
+
+static char *dvr_meta_path(const char *path) {
+  size_t len = strlen(path);
+  char *meta = g_malloc(len + 2);
+  memcpy(meta, path, len - 4);
+  strcpy(meta + len - 4, ".meta");
+  return meta;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+//
+// WAV files
+//
+//////////////////////////////////////////////////////////////////////////////////////
+
+static void put_le16(guint8 *p, guint16 v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+}
+
+static void put_le32(guint8 *p, guint32 v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = (v >> 24) & 0xFF;
+}
+
+static int info_size(const char *s) {
+  int len = strlen(s) + 1;
+  return 8 + len + (len & 1);
+}
+
+static guint8 *put_info(guint8 *p, const char *id, const char *s) {
+  int len = strlen(s) + 1;
+  memcpy(p, id, 4);
+  put_le32(p + 4, len);
+  memcpy(p + 8, s, len);
+
+  if (len & 1) { p[8 + len] = 0; }
+
+  return p + 8 + len + (len & 1);
+}
+
+//
+// Write a WAV header for data_bytes bytes of sample data. If date and comment
+// are given, a LIST/INFO chunk is inserted. Returns the size of the header.
+//
+static int wav_header(FILE *fp, int rate, int channels, int bytes, long data_bytes, const char *date,
+                      const char *comment) {
+  guint8 h[1024];
+  guint8 *p = h;
+  int list = 0;
+
+  if (date != NULL && comment != NULL) {
+    list = 12 + info_size(date) + info_size(comment);
+
+    if (list > (int)sizeof(h) - DVR_HEADER) { list = 0; }
+  }
+
+  memcpy(p, "RIFF", 4);
+  put_le32(p + 4, 36 + list + data_bytes);
+  memcpy(p + 8, "WAVE", 4);
+  memcpy(p + 12, "fmt ", 4);
+  put_le32(p + 16, 16);
+  put_le16(p + 20, bytes == 4 ? 3 : 1);     // IEEE float or PCM
+  put_le16(p + 22, channels);
+  put_le32(p + 24, rate);
+  put_le32(p + 28, rate * channels * bytes);
+  put_le16(p + 32, channels * bytes);
+  put_le16(p + 34, 8 * bytes);
+  p += 36;
+
+  if (list) {
+    memcpy(p, "LIST", 4);
+    put_le32(p + 4, list - 8);
+    memcpy(p + 8, "INFO", 4);
+    p = put_info(p + 12, "ICRD", date);
+    p = put_info(p, "ICMT", comment);
+  }
+
+  memcpy(p, "data", 4);
+  put_le32(p + 4, data_bytes);
+  p += 8;
+
+  if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(h, p - h, 1, fp) != 1) { return -1; }
+
+  return p - h;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+//
+// Producer side
+//
+//////////////////////////////////////////////////////////////////////////////////////
+
+static inline void track_put(DVR_TRACK *t, float a, float b) {
+  guint w = (guint)g_atomic_int_get(&t->wcount) + (guint)t->pending;
+
+  if ((int)(w - (guint)g_atomic_int_get(&t->rcount)) >= t->size) {
+    g_atomic_int_inc(&t->overflows);
+    return;
+  }
+
+  w = (w & (t->size - 1)) * t->channels;
+  t->ring[w] = a;
+
+  if (t->channels > 1) { t->ring[w + 1] = b; }
+
+  t->pending++;
+}
+
+static void track_commit(DVR_TRACK *t, int rate) {
+  if (t->pending == 0) { return; }
+
+  g_atomic_int_set(&t->rate, rate);
+  g_atomic_int_add(&t->wcount, t->pending);
+  t->pending = 0;
+}
+
+void dvr_put_rx(const RECEIVER *rx, float left, float right) {
+  if (!g_atomic_int_get(&dvr_running) || rx->id < 0 || rx->id > 1) { return; }
+
+  track_put(&tracks[DVR_RX1 + rx->id], left, right);
+}
+
+void dvr_commit_rx(const RECEIVER *rx) {
+  if (!g_atomic_int_get(&dvr_running) || rx->id < 0 || rx->id > 1) { return; }
+
+  track_commit(&tracks[DVR_RX1 + rx->id], 48000);
+}
+
+void dvr_put_iq(const RECEIVER *rx, double i_sample, double q_sample) {
+  if (!g_atomic_int_get(&dvr_iq_running) || rx->id < 0 || rx->id > 1) { return; }
+
+  track_put(&tracks[DVR_IQ1 + rx->id], (float)i_sample, (float)q_sample);
+}
+
+void dvr_commit_iq(const RECEIVER *rx) {
+  if (!g_atomic_int_get(&dvr_iq_running) || rx->id < 0 || rx->id > 1) { return; }
+
+  track_commit(&tracks[DVR_IQ1 + rx->id], rx->sample_rate);
+}
+
+void dvr_put_mic(float sample) {
+  if (!g_atomic_int_get(&dvr_running)) { return; }
+
+  track_put(&tracks[DVR_MIC], sample, sample);
+}
+
+void dvr_commit_mic() {
+  if (!g_atomic_int_get(&dvr_running)) { return; }
+
+  track_commit(&tracks[DVR_MIC], 48000);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+//
+// Writer thread
+//
+//////////////////////////////////////////////////////////////////////////////////////
+
+static void segment_free(DVR_SEGMENT *seg) {
+  g_free(seg->path);
+  g_free(seg);
+}
+
+static void segment_close(DVR_TRACK *t) {
+  if (t->fp != NULL) {
+    long frames;
+    int rate;
+    g_mutex_lock(&dvr_mutex);
+    frames = t->seg->frames;
+    rate = t->seg->rate;
+    t->seg = NULL;
+    g_mutex_unlock(&dvr_mutex);
+    wav_header(t->fp, rate, t->channels, t->bytes, frames * t->channels * t->bytes, NULL, NULL);
+    fclose(t->fp);
+    t->fp = NULL;
+  }
+
+  if (t->meta != NULL) {
+    fclose(t->meta);
+    t->meta = NULL;
+  }
+}
+
+//
+// Delete the segments that have completely fallen out of the last dvr_minutes.
+// Called with dvr_mutex held.
+//
+static void segment_prune(DVR_TRACK *t, gint64 now) {
+  gint64 limit = now - (gint64)dvr_minutes * 60 * G_USEC_PER_SEC;
+
+  while (g_queue_get_length(&t->segments) > 1) {
+    DVR_SEGMENT *old = g_queue_peek_head(&t->segments);
+
+    if (old->start + (gint64)old->frames * G_USEC_PER_SEC / old->rate > limit) { break; }
+
+    char *meta = dvr_meta_path(old->path);
+    g_unlink(old->path);
+    g_unlink(meta);
+    g_free(meta);
+    segment_free(g_queue_pop_head(&t->segments));
+  }
+}
+
+//
+// backlog is the number of frames already waiting in the queue, they have
+// been recorded before "now".
+//
+static int segment_open(DVR_TRACK *t, int rate, int backlog) {
+  gint64 now = g_get_real_time();
+  DVR_SEGMENT *seg = g_new0(DVR_SEGMENT, 1);
+  seg->start = now - (gint64)backlog * G_USEC_PER_SEC / rate;
+  seg->rate = rate;
+  char *stamp = dvr_utc_string(seg->start, "%Y%m%d-%H%M%S");
+  seg->path = g_strdup_printf("%s/%s-%s-%03d.wav", DVR_RING_DIR, t->name, stamp,
+                              (int)((seg->start / 1000) % 1000));
+  g_free(stamp);
+  t->fp = fopen(seg->path, "wb");
+
+  if (t->fp == NULL || wav_header(t->fp, rate, t->channels, t->bytes, 0, NULL, NULL) != DVR_HEADER) {
+    t_print("%s: cannot write %s\n", __FUNCTION__, seg->path);
+
+    if (t->fp != NULL) {
+      fclose(t->fp);
+      t->fp = NULL;
+    }
+
+    segment_free(seg);
+    return 0;
+  }
+
+  char *meta = dvr_meta_path(seg->path);
+  t->meta = fopen(meta, "w");
+  g_free(meta);
+  t->meta_freq = -1;
+  t->meta_mode = -1;
+  g_mutex_lock(&dvr_mutex);
+  t->seg = seg;
+  g_queue_push_tail(&t->segments, seg);
+  segment_prune(t, now);
+  g_mutex_unlock(&dvr_mutex);
+  return 1;
+}
+
+//
+// Log frequency and mode to the sidecar file whenever they change.
+// Each line is: frame offset, UTC, frequency (Hz), mode
+//
+static void track_meta(DVR_TRACK *t) {
+  long long freq;
+  int mode;
+  int id = (t == &tracks[DVR_RX2] || t == &tracks[DVR_IQ2]) ? 1 : 0;
+
+  if (t->meta == NULL) { return; }
+
+  if (t == &tracks[DVR_MIC]) {
+    freq = vfo_get_tx_freq();
+    mode = vfo_get_tx_mode();
+  } else if (t == &tracks[DVR_IQ1] || t == &tracks[DVR_IQ2]) {
+    freq = vfo[id].frequency;         // centre frequency of the IQ data
+    mode = vfo[id].mode;
+  } else {
+    freq = vfo[id].ctun ? vfo[id].ctun_frequency : vfo[id].frequency;
+    mode = vfo[id].mode;
+  }
+
+  if (freq == t->meta_freq && mode == t->meta_mode) { return; }
+
+  char *utc = dvr_utc_string(g_get_real_time(), "%Y-%m-%dT%H:%M:%SZ");
+  fprintf(t->meta, "%ld %s %lld %s\n", t->seg->frames, utc, freq,
+          (mode >= 0 && mode < MODES) ? mode_string[mode] : "?");
+  fflush(t->meta);
+  g_free(utc);
+  t->meta_freq = freq;
+  t->meta_mode = mode;
+}
+
+static void track_convert(const DVR_TRACK *t, guint8 *buf, guint r, int n) {
+  int samples = n * t->channels;
+  int pos = (int)(r & (t->size - 1)) * t->channels;
+  int wrap = t->size * t->channels;
+
+  for (int i = 0; i < samples; i++) {
+    float v = t->ring[pos];
+
+    if (++pos >= wrap) { pos = 0; }
+
+    if (t->bytes == 4) {
+      union { float f; guint32 u; } x;
+      x.f = v;
+      put_le32(buf + 4 * i, x.u);
+    } else {
+      if (v > 1.0F) { v = 1.0F; }
+
+      if (v < -1.0F) { v = -1.0F; }
+
+      put_le16(buf + 2 * i, (guint16)(gint16)(v * 32767.0F));
+    }
+  }
+}
+
+static void track_drain(DVR_TRACK *t, guint8 *buf) {
+  int avail = (int)((guint)g_atomic_int_get(&t->wcount) - (guint)g_atomic_int_get(&t->rcount));
+  int rate = g_atomic_int_get(&t->rate);
+
+  if (avail <= 0 || rate <= 0) { return; }
+
+  while (avail > 0) {
+    if (t->fp == NULL || t->seg->rate != rate || t->seg->frames >= (long)rate * DVR_SEGMENT_SECONDS) {
+      segment_close(t);
+
+      if (!segment_open(t, rate, avail)) {
+        g_atomic_int_add(&t->rcount, avail);
+        return;
+      }
+    }
+
+    track_meta(t);
+    long room = (long)rate * DVR_SEGMENT_SECONDS - t->seg->frames;
+    int n = avail;
+
+    if (n > DVR_CHUNK) { n = DVR_CHUNK; }
+
+    if (n > room) { n = (int)room; }
+
+    track_convert(t, buf, (guint)g_atomic_int_get(&t->rcount), n);
+    g_atomic_int_add(&t->rcount, n);
+    avail -= n;
+
+    //
+    // Flush after each chunk, so that export and replay find
+    // on disk whatever the segment claims to contain
+    //
+    if (fwrite(buf, t->channels * t->bytes, n, t->fp) != (size_t)n || fflush(t->fp) != 0) {
+      t_print("%s: %s: write error, dropping segment\n", __FUNCTION__, t->name);
+      segment_close(t);
+      g_atomic_int_add(&t->rcount, avail);
+      return;
+    }
+
+    g_mutex_lock(&dvr_mutex);
+    t->seg->frames += n;
+    g_mutex_unlock(&dvr_mutex);
+  }
+}
+
+static gpointer dvr_thread(gpointer data) {
+  guint8 *buf = g_malloc(DVR_CHUNK * 2 * sizeof(float));
+  t_print("%s: recording the last %d minutes (IQ %s)\n", __FUNCTION__, dvr_minutes,
+          g_atomic_int_get(&dvr_iq_running) ? "on" : "off");
+
+  for (;;) {
+    int running;
+    g_mutex_lock(&dvr_mutex);
+    running = g_atomic_int_get(&dvr_running);
+
+    if (running) {
+      g_cond_wait_until(&dvr_cond, &dvr_mutex, g_get_monotonic_time() + DVR_WAKEUP * G_TIME_SPAN_MILLISECOND);
+    }
+
+    g_mutex_unlock(&dvr_mutex);
+
+    //
+    // One more pass after stopping, for what is still queued
+    //
+    for (int i = 0; i < DVR_TRACKS; i++) {
+      if (tracks[i].ring != NULL) { track_drain(&tracks[i], buf); }
+    }
+
+    if (!running) { break; }
+  }
+
+  for (int i = 0; i < DVR_TRACKS; i++) {
+    segment_close(&tracks[i]);
+
+    if (g_atomic_int_get(&tracks[i].overflows) > 0) {
+      t_print("%s: %s: %d frames dropped\n", __FUNCTION__, tracks[i].name, g_atomic_int_get(&tracks[i].overflows));
+    }
+  }
+
+  g_free(buf);
+  t_print("%s: exiting\n", __FUNCTION__);
+  return NULL;
+}
+
+//
+// The ring only holds the recent past of the current session,
+// leftovers from an earlier session are removed.
+//
+static void dvr_clear_ring(void) {
+  GDir *dir = g_dir_open(DVR_RING_DIR, 0, NULL);
+
+  g_mutex_lock(&dvr_mutex);
+
+  for (int i = 0; i < DVR_TRACKS; i++) {
+    while (!g_queue_is_empty(&tracks[i].segments)) {
+      segment_free(g_queue_pop_head(&tracks[i].segments));
+    }
+  }
+
+  g_mutex_unlock(&dvr_mutex);
+
+  if (dir == NULL) { return; }
+
+  const char *name;
+
+  while ((name = g_dir_read_name(dir)) != NULL) {
+    if (g_str_has_suffix(name, ".wav") || g_str_has_suffix(name, ".meta")) {
+      char *path = g_build_filename(DVR_RING_DIR, name, NULL);
+      g_unlink(path);
+      g_free(path);
+    }
+  }
+
+  g_dir_close(dir);
+}
+
+void dvr_start() {
+  dvr_init_once();
+
+  if (dvr_thread_id != NULL || dvr_minutes <= 0) { return; }
+
+  if (g_mkdir_with_parents(DVR_RING_DIR, 0700) != 0) {
+    t_print("%s: cannot create %s\n", __FUNCTION__, DVR_RING_DIR);
+    return;
+  }
+
+  dvr_clear_ring();
+
+  for (int i = 0; i < DVR_TRACKS; i++) {
+    DVR_TRACK *t = &tracks[i];
+
+    if (t->ring == NULL && (t->bytes == 2 || dvr_iq)) {
+      t->ring = g_new0(float, (gsize)t->channels * t->size);
+    }
+
+    g_atomic_int_set(&t->wcount, 0);
+    g_atomic_int_set(&t->rcount, 0);
+    g_atomic_int_set(&t->rate, 0);
+    g_atomic_int_set(&t->overflows, 0);
+  }
+
+  g_atomic_int_set(&dvr_iq_running, dvr_iq);
+  g_atomic_int_set(&dvr_running, 1);
+  dvr_thread_id = g_thread_new("DVR writer", dvr_thread, NULL);
+}
+
+void dvr_stop() {
+  if (dvr_thread_id == NULL) { return; }
+
+  dvr_replay_stop();
+  g_mutex_lock(&dvr_mutex);
+  g_atomic_int_set(&dvr_iq_running, 0);
+  g_atomic_int_set(&dvr_running, 0);
+  g_cond_broadcast(&dvr_cond);
+  g_mutex_unlock(&dvr_mutex);
+  g_thread_join(dvr_thread_id);
+  dvr_thread_id = NULL;
+}
+
+void dvr_restart() {
+  dvr_stop();
+  dvr_start();
+}
+
+int dvr_is_running() {
+  return g_atomic_int_get(&dvr_running);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+//
+// Reading back: export and replay
+//
+//////////////////////////////////////////////////////////////////////////////////////
+
+//
+// A sink receives frames in the on-disk format. first is the frame index of
+// the first frame within seg. Returning zero stops reading.
+//
+typedef int (*DVR_SINK)(void *arg, const DVR_SEGMENT *seg, long first, const guint8 *data, int frames);
+
+double dvr_available(int track) {
+  double secs = 0.0;
+
+  if (track < 0 || track >= DVR_TRACKS) { return 0.0; }
+
+  dvr_init_once();
+  g_mutex_lock(&dvr_mutex);
+  const DVR_SEGMENT *first = g_queue_peek_head(&tracks[track].segments);
+  const DVR_SEGMENT *last = g_queue_peek_tail(&tracks[track].segments);
+
+  if (first != NULL) {
+    secs = (double)(last->start - first->start) * 1.0E-6 + (double)last->frames / last->rate;
+  }
+
+  g_mutex_unlock(&dvr_mutex);
+  return secs;
+}
+
+//
+// Deliver the frames of a track recorded in [start, end) (UTC, usec) to sink.
+// Reading stops at a sample rate change. Returns the number of frames delivered.
+//
+static long dvr_read(int track, gint64 start, gint64 end, DVR_SINK sink, void *arg) {
+  DVR_TRACK *t = &tracks[track];
+  int fb = t->channels * t->bytes;
+  int rate = 0;
+  long total = 0;
+  int nsegs;
+  DVR_SEGMENT *segs;
+  //
+  // Work on a snapshot, the writer must not wait for us
+  //
+  dvr_init_once();
+  g_mutex_lock(&dvr_mutex);
+  nsegs = g_queue_get_length(&t->segments);
+  segs = g_new(DVR_SEGMENT, nsegs > 0 ? nsegs : 1);
+
+  for (int i = 0; i < nsegs; i++) {
+    const DVR_SEGMENT *s = g_queue_peek_nth(&t->segments, i);
+    segs[i] = *s;
+    segs[i].path = g_strdup(s->path);
+  }
+
+  g_mutex_unlock(&dvr_mutex);
+  guint8 *buf = g_malloc((gsize)DVR_CHUNK * fb);
+
+  for (int i = 0; i < nsegs; i++) {
+    DVR_SEGMENT *s = &segs[i];
+    gint64 seg_end = s->start + (gint64)s->frames * G_USEC_PER_SEC / s->rate;
+
+    if (seg_end <= start || s->start >= end || s->frames == 0) { continue; }
+
+    if (rate != 0 && s->rate != rate) { break; }
+
+    rate = s->rate;
+    long first = (start > s->start) ? (long)((start - s->start) * s->rate / G_USEC_PER_SEC) : 0;
+    long last = (end < seg_end) ? (long)((end - s->start) * s->rate / G_USEC_PER_SEC) : s->frames;
+    FILE *fp = fopen(s->path, "rb");
+
+    if (fp == NULL) { continue; }   // pruned in the meantime
+
+    if (fseek(fp, DVR_HEADER + first * fb, SEEK_SET) == 0) {
+      while (first < last) {
+        int n = (last - first > DVR_CHUNK) ? DVR_CHUNK : (int)(last - first);
+        n = fread(buf, fb, n, fp);
+
+        if (n <= 0) { break; }
+
+        if (!sink(arg, s, first, buf, n)) {
+          last = -1;
+          break;
+        }
+
+        first += n;
+        total += n;
+      }
+    }
+
+    fclose(fp);
+
+    if (last < 0) { break; }
+  }
+
+  for (int i = 0; i < nsegs; i++) {
+    g_free(segs[i].path);
+  }
+
+  g_free(segs);
+  g_free(buf);
+  return total;
+}
+
+//
+// Frequency and mode valid at frame index "frame" of a segment
+//
+static void dvr_lookup_meta(const DVR_SEGMENT *seg, long frame, long long *freq, char *mode, size_t len) {
+  char *path = dvr_meta_path(seg->path);
+  FILE *fp = fopen(path, "r");
+  char line[256];
+  g_free(path);
+  *freq = 0;
+  g_strlcpy(mode, "?", len);
+
+  if (fp == NULL) { return; }
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    long offset;
+    long long f;
+    char utc[64], m[16];
+
+    if (sscanf(line, "%ld %63s %lld %15s", &offset, utc, &f, m) != 4) { continue; }
+
+    if (offset > frame && *freq != 0) { break; }
+
+    *freq = f;
+    g_strlcpy(mode, m, len);
+  }
+
+  fclose(fp);
+}
+
+typedef struct _dvr_export {
+  const DVR_TRACK *track;
+  FILE  *fp;
+  int    header;
+  long   frames;
+} DVR_EXPORT;
+
+static int export_sink(void *arg, const DVR_SEGMENT *seg, long first, const guint8 *data, int frames) {
+  DVR_EXPORT *e = arg;
+  int fb = e->track->channels * e->track->bytes;
+
+  if (e->header == 0) {
+    long long freq;
+    char mode[16];
+    gint64 t0 = seg->start + (gint64)first * G_USEC_PER_SEC / seg->rate;
+    char *date = dvr_utc_string(t0, "%Y-%m-%dT%H:%M:%SZ");
+    dvr_lookup_meta(seg, first, &freq, mode, sizeof(mode));
+    char *comment = g_strdup_printf("deskHPSDR DVR %s, %lld Hz, %s, start %s", e->track->name, freq, mode, date);
+    e->header = wav_header(e->fp, seg->rate, e->track->channels, e->track->bytes, 0, date, comment);
+    g_free(date);
+    g_free(comment);
+
+    if (e->header < 0) { return 0; }
+  }
+
+  if (fwrite(data, fb, frames, e->fp) != (size_t)frames) { return 0; }
+
+  e->frames += frames;
+  return 1;
+}
+
+//
+// Export a window of a track into a WAV file.
+// Returns the number of frames exported, or -1 on error.
+//
+int dvr_export(int track, double seconds_ago, double seconds, const char *path) {
+  DVR_EXPORT e;
+  gint64 start = g_get_real_time() - (gint64)(seconds_ago * 1.0E6);
+  gint64 end = start + (gint64)(seconds * 1.0E6);
+
+  if (track < 0 || track >= DVR_TRACKS || seconds <= 0.0) { return -1; }
+
+  e.track = &tracks[track];
+  e.header = 0;
+  e.frames = 0;
+  e.fp = fopen(path, "wb");
+
+  if (e.fp == NULL) {
+    t_print("%s: cannot write %s\n", __FUNCTION__, path);
+    return -1;
+  }
+
+  dvr_read(track, start, end, export_sink, &e);
+
+  if (e.header > 0) {
+    //
+    // patch the RIFF and data chunk sizes
+    //
+    guint8 b[4];
+    long data_bytes = e.frames * e.track->channels * e.track->bytes;
+    put_le32(b, e.header - 8 + data_bytes);
+    fseek(e.fp, 4, SEEK_SET);
+    fwrite(b, 4, 1, e.fp);
+    put_le32(b, data_bytes);
+    fseek(e.fp, e.header - 4, SEEK_SET);
+    fwrite(b, 4, 1, e.fp);
+  }
+
+  fclose(e.fp);
+
+  if (e.header <= 0) {
+    g_unlink(path);
+    return e.header < 0 ? -1 : 0;
+  }
+
+  return (int)e.frames;
+}
+
+static gpointer export_thread(gpointer data) {
+  double seconds = *(double *)data;
+  char *stamp = dvr_utc_string(g_get_real_time(), "%Y%m%d-%H%M%S");
+  g_free(data);
+
+  for (int i = 0; i < DVR_TRACKS; i++) {
+    if (dvr_available(i) <= 0.0) { continue; }
+
+    char *path = g_strdup_printf("%s/export-%s-%s.wav", DVR_DIR, tracks[i].name, stamp);
+    int frames = dvr_export(i, seconds, seconds, path);
+
+    if (frames > 0) {
+      t_print("%s: %s: %d frames written to %s\n", __FUNCTION__, tracks[i].name, frames, path);
+    }
+
+    g_free(path);
+  }
+
+  g_free(stamp);
+  return NULL;
+}
+
+//
+// Export the last "seconds" of all tracks, in the background
+//
+void dvr_export_window(double seconds) {
+  double *arg = g_new(double, 1);
+  *arg = seconds;
+  g_thread_unref(g_thread_new("DVR export", export_thread, arg));
+}
+
+typedef struct _dvr_replay {
+  int    track;
+  gint64 start;
+  gint64 end;
+  long   frames;                 // frames put into the mixer
+} DVR_REPLAY;
+
+//
+// Feed the mixer in real time: keep about 40 msec queued
+//
+static int replay_sink(void *arg, const DVR_SEGMENT *seg, long first, const guint8 *data, int frames) {
+  DVR_REPLAY *r = arg;
+  const DVR_TRACK *t = &tracks[r->track];
+
+  if (seg->rate != 48000) { return 0; }
+
+  for (int i = 0; i < frames; i++) {
+    const guint8 *p = data + 2 * t->channels * i;
+    float left = (float)(gint16)(p[0] | (p[1] << 8)) / 32768.0F;
+    float right = left;
+
+    if (t->channels > 1) { right = (float)(gint16)(p[2] | (p[3] << 8)) / 32768.0F; }
+
+    audio_mixer_put_playback(left, right);
+
+    if ((++r->frames % MIXER_BLOCK) == 0) {
+      audio_mixer_commit_playback();
+
+      while (audio_mixer_playback_queued() > 8 * MIXER_BLOCK && g_atomic_int_get(&replay_running)) {
+        g_usleep(5000);
+      }
+
+      if (!g_atomic_int_get(&replay_running)) { return 0; }
+    }
+  }
+
+  return 1;
+}
+
+static gpointer replay_thread(gpointer data) {
+  DVR_REPLAY *r = data;
+  dvr_read(r->track, r->start, r->end, replay_sink, r);
+
+  //
+  // Complete the last mixer block with silence
+  //
+  while (r->frames % MIXER_BLOCK) {
+    audio_mixer_put_playback(0.0F, 0.0F);
+    r->frames++;
+  }
+
+  audio_mixer_commit_playback();
+  t_print("%s: %s: %ld frames replayed\n", __FUNCTION__, tracks[r->track].name, r->frames);
+  g_free(r);
+  g_atomic_int_set(&replay_running, 0);
+  return NULL;
+}
+
+//
+// Replay a window of an audio track on the local audio output of RX1.
+// Returns 0 if there is nothing to replay.
+//
+int dvr_replay(int track, double seconds_ago, double seconds) {
+  if (track != DVR_RX1 && track != DVR_RX2 && track != DVR_MIC) { return 0; }
+
+  if (dvr_available(track) <= 0.0) { return 0; }
+
+  dvr_replay_stop();
+  DVR_REPLAY *r = g_new0(DVR_REPLAY, 1);
+  r->track = track;
+  r->start = g_get_real_time() - (gint64)(seconds_ago * 1.0E6);
+  r->end = r->start + (gint64)(seconds * 1.0E6);
+  g_atomic_int_set(&replay_running, 1);
+  replay_thread_id = g_thread_new("DVR replay", replay_thread, r);
+  return 1;
+}
+
+void dvr_replay_stop() {
+  if (replay_thread_id == NULL) { return; }
+
+  g_atomic_int_set(&replay_running, 0);
+  g_thread_join(replay_thread_id);
+  replay_thread_id = NULL;
+}
+
+int dvr_replay_active() {
+  return g_atomic_int_get(&replay_running);
+}
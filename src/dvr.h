@@ -0,0 +1,76 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _DVR_H
+#define _DVR_H
+
+#include "receiver.h"
+
+//
+// Station DVR: continuous time-shift recorder.
+//
+// The demodulated audio of each receiver, the TX mic and (optionally) the
+// raw IQ of each receiver are recorded as separate tracks. The DSP threads
+// only put samples into a per-track single-producer/single-consumer queue,
+// a dedicated writer thread drains the queues into one-minute WAV segments
+// in the directory dvr/ring (below the working directory). Segments older
+// than dvr_minutes are deleted, so the disk usage is bounded.
+//
+// Each segment has a sidecar file (.meta) that logs the UTC time and the
+// frequency/mode whenever they change. Any window can be exported to a
+// single WAV file (with date and frequency in a LIST/INFO chunk), and the
+// audio tracks can be replayed locally through the audio mixer.
+//
+enum _dvr_track_id {
+  DVR_RX1 = 0,
+  DVR_RX2,
+  DVR_MIC,
+  DVR_IQ1,
+  DVR_IQ2,
+  DVR_TRACKS
+};
+
+#define DVR_SEGMENT_SECONDS 60
+
+extern void dvr_start(void);
+extern void dvr_stop(void);
+extern void dvr_restart(void);
+extern int  dvr_is_running(void);
+
+//
+// Producer side. Samples are only published with the commit,
+// once per DSP buffer.
+//
+extern void dvr_put_rx(const RECEIVER *rx, float left, float right);
+extern void dvr_commit_rx(const RECEIVER *rx);
+extern void dvr_put_iq(const RECEIVER *rx, double i_sample, double q_sample);
+extern void dvr_commit_iq(const RECEIVER *rx);
+extern void dvr_put_mic(float sample);
+extern void dvr_commit_mic(void);
+
+//
+// Export/replay of the window [now - seconds_ago, now - seconds_ago + seconds].
+//
+extern double dvr_available(int track);
+extern int  dvr_export(int track, double seconds_ago, double seconds, const char *path);
+extern void dvr_export_window(double seconds);
+extern int  dvr_replay(int track, double seconds_ago, double seconds);
+extern void dvr_replay_stop(void);
+extern int  dvr_replay_active(void);
+
+#endif
@@ -0,0 +1,153 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <gtk/gtk.h>
+#include <string.h>
+#include <wdsp.h>
+
+#include "eq_update.h"
+#include "message.h"
+#include "receiver.h"
+#include "transmitter.h"
+
+#define EQ_RX_SLOTS  8                // size of the receiver[] array
+#define EQ_SLOTS     (EQ_RX_SLOTS + 1) // plus one transmitter
+#define EQ_DEBOUNCE  20000            // usec, collect slider ticks before designing
+#define EQ_BANDS     13
+
+#if defined (__EQ12__)
+  #define EQ_NFREQS  12
+#else
+  #define EQ_NFREQS  10
+#endif
+
+typedef struct _eq_slot {
+  int pending;
+  int channel;
+  int enable;
+  double freq[EQ_BANDS];
+  double gain[EQ_BANDS];
+} EQ_SLOT;
+
+static EQ_SLOT slots[EQ_SLOTS];       // slots[EQ_RX_SLOTS] is the transmitter
+static GMutex eq_mutex;
+static GCond eq_cond;
+static GThread *eq_thread_id = NULL;
+static int eq_busy = 0;
+
+static int eq_pending() {
+  for (int i = 0; i < EQ_SLOTS; i++) {
+    if (slots[i].pending) { return 1; }
+  }
+
+  return 0;
+}
+
+//
+// This is the only place where the WDSP equalizer profiles are set.
+// WDSP caches the designed impulse responses, so receivers with
+// identical profiles share one design.
+// The profile setters do not take the WDSP channel lock, so nothing
+// else may change the equalizer filter core meanwhile, see eq_update_sync().
+//
+static void eq_apply(int slot, EQ_SLOT *s) {
+  if (slot == EQ_RX_SLOTS) {
+    SetTXAEQProfile(s->channel, EQ_NFREQS, s->freq, s->gain);
+    SetTXAEQRun(s->channel, s->enable);
+  } else {
+    SetRXAEQProfile(s->channel, EQ_NFREQS, s->freq, s->gain);
+    SetRXAEQRun(s->channel, s->enable);
+  }
+}
+
+static gpointer eq_thread(gpointer data) {
+  EQ_SLOT work[EQ_SLOTS];
+  g_mutex_lock(&eq_mutex);
+
+  for (;;) {
+    if (!eq_pending()) {
+      g_cond_wait(&eq_cond, &eq_mutex);
+      continue;
+    }
+
+    eq_busy = 1;
+    g_mutex_unlock(&eq_mutex);
+    g_usleep(EQ_DEBOUNCE);
+    g_mutex_lock(&eq_mutex);
+    memcpy(work, slots, sizeof(work));
+
+    for (int i = 0; i < EQ_SLOTS; i++) {
+      slots[i].pending = 0;
+    }
+
+    g_mutex_unlock(&eq_mutex);
+
+    for (int i = 0; i < EQ_SLOTS; i++) {
+      if (work[i].pending) { eq_apply(i, &work[i]); }
+    }
+
+    g_mutex_lock(&eq_mutex);
+    eq_busy = 0;
+    g_cond_broadcast(&eq_cond);
+  }
+
+  return NULL;
+}
+
+static void eq_queue(int slot, int channel, int enable, const double *freq, const double *gain) {
+  g_mutex_lock(&eq_mutex);
+
+  if (eq_thread_id == NULL) {
+    eq_thread_id = g_thread_new("EQ update", eq_thread, NULL);
+  }
+
+  EQ_SLOT *s = &slots[slot];
+  s->channel = channel;
+  s->enable = enable;
+  memcpy(s->freq, freq, (EQ_NFREQS + 1) * sizeof(double));
+  memcpy(s->gain, gain, (EQ_NFREQS + 1) * sizeof(double));
+  s->pending = 1;
+  g_cond_broadcast(&eq_cond);
+  g_mutex_unlock(&eq_mutex);
+}
+
+void eq_update_rx(const RECEIVER *rx) {
+  if (rx->id < 0 || rx->id >= EQ_RX_SLOTS) { return; }
+
+  eq_queue(rx->id, rx->id, rx->eq_enable, rx->eq_freq, rx->eq_gain);
+}
+
+void eq_update_tx(const TRANSMITTER *tx) {
+  eq_queue(EQ_RX_SLOTS, tx->id, tx->eq_enable, tx->eq_freq, tx->eq_gain);
+}
+
+//
+// Wait until all queued profiles have been applied. This must be called
+// before a WDSP channel is closed, and before the FFT size, the latency
+// or the ctfmode of a channel (and thus its equalizer) is changed.
+//
+void eq_update_sync() {
+  g_mutex_lock(&eq_mutex);
+
+  while (eq_thread_id != NULL && (eq_busy || eq_pending())) {
+    g_cond_wait(&eq_cond, &eq_mutex);
+  }
+
+  g_mutex_unlock(&eq_mutex);
+}
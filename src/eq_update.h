@@ -0,0 +1,35 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _EQ_UPDATE_H_
+#define _EQ_UPDATE_H_
+
+#include "receiver.h"
+#include "transmitter.h"
+
+//
+// Equalizer profiles are handed to a worker thread that designs the
+// filters. Rapid changes (slider drags) are coalesced per channel,
+// and only the most recent profile is applied. Call eq_update_sync()
+// before closing a channel or changing its FFT size, latency or ctfmode.
+//
+extern void eq_update_rx(const RECEIVER *rx);
+extern void eq_update_tx(const TRANSMITTER *tx);
+extern void eq_update_sync(void);
+
+#endif
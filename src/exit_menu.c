@@ -31,6 +31,7 @@
 #include "discovery.h"
 #include "radio.h"
 #include "rigctl.h"
+#include "hamlib.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
 #ifdef SOAPYSDR
@@ -69,6 +70,10 @@ void stop_program() {
     shutdown_tcp_rigctl();
   }
 
+  if (hamlib_enable) {
+    shutdown_hamlib();
+  }
+
   if (have_saturn_xdma) {
 #ifdef SATURN
     saturn_exit();
@@ -39,6 +39,7 @@
   #include <linux/i2c-dev.h>
   #include <i2c/smbus.h>
   #include <sys/ioctl.h>
+  #include <sys/eventfd.h>
 #endif
 
 #include "band.h"
@@ -65,6 +66,7 @@
 #include "zoompan.h"
 #include "iambic.h"
 #include "message.h"
+#include "rotary.h"
 
 ///////////////////////////////////////////////////////////////////////////
 //
@@ -138,97 +140,6 @@ enum {
   B
 };
 
-#define DIR_NONE 0x0
-// Clockwise step.
-#define DIR_CW 0x10
-// Anti-clockwise step.
-#define DIR_CCW 0x20
-
-//
-// Encoder states for a "full cycle"
-//
-#define R_START     0x00
-#define R_CW_FINAL  0x01
-#define R_CW_BEGIN  0x02
-#define R_CW_NEXT   0x03
-#define R_CCW_BEGIN 0x04
-#define R_CCW_FINAL 0x05
-#define R_CCW_NEXT  0x06
-
-//
-// Encoder states for a "half cycle"
-//
-#define R_START1    0x07
-#define R_START0    0x08
-#define R_CW_BEG1   0x09
-#define R_CW_BEG0   0x0A
-#define R_CCW_BEG1  0x0B
-#define R_CCW_BEG0  0x0C
-
-//
-// Few general remarks on the state machine:
-// - if the levels do not change, the machinestate does not change
-// - if there is bouncing on one input line, the machine oscillates
-//   between two "adjacent" states but generates at most one tick
-// - if both input lines change level, move to a suitable new
-//   starting point but do not generate a tick
-// - if one or both of the AB lines are inverted, the same cycles
-//   are passed but with a different starting point. Therefore,
-//   it still works.
-//
-guchar encoder_state_table[13][4] = {
-  //
-  // A "full cycle" has the following state changes
-  // (first line: line levels AB, 1=pressed, 0=released,
-  //  2nd   line: state names
-  //
-  // clockwise:  11   -->   10   -->    00    -->    01     -->  11
-  //            Start --> CWbeg  -->  CWnext  -->  CWfinal  --> Start
-  //
-  // ccw:        11   -->   01    -->   00     -->   10      -->  11
-  //            Start --> CCWbeg  --> CCWnext  --> CCWfinal  --> Start
-  //
-  // Emit the "tick" when moving from "final" to "start".
-  //
-  //                   00           10           01          11
-  // -----------------------------------------------------------------------------
-  /* R_START     */ {R_START,    R_CW_BEGIN,  R_CCW_BEGIN, R_START},
-  /* R_CW_FINAL  */ {R_CW_NEXT,  R_START,     R_CW_FINAL,  R_START | DIR_CW},
-  /* R_CW_BEGIN  */ {R_CW_NEXT,  R_CW_BEGIN,  R_START,     R_START},
-  /* R_CW_NEXT   */ {R_CW_NEXT,  R_CW_BEGIN,  R_CW_FINAL,  R_START},
-  /* R_CCW_BEGIN */ {R_CCW_NEXT, R_START,     R_CCW_BEGIN, R_START},
-  /* R_CCW_FINAL */ {R_CCW_NEXT, R_CCW_FINAL, R_START,     R_START | DIR_CCW},
-  /* R_CCW_NEXT  */ {R_CCW_NEXT, R_CCW_FINAL, R_CCW_BEGIN, R_START},
-  //
-  // The same sequence can be interpreted as two "half cycles"
-  //
-  // clockwise1:   11    -->   10   -->   00
-  //             Start1  --> CWbeg1 --> Start0
-  //
-  // clockwise2:   00    -->   01   -->   11
-  //             Start0  --> CWbeg0 --> Start1
-  //
-  // ccw1:         11    -->   01    -->   00
-  //             Start1  --> CCWbeg1 --> Start0
-  //
-  // ccw2:         00    -->   10    -->   11
-  //             Start0  --> CCWbeg0 --> Start1
-  //
-  // If both lines change, this is interpreted as a two-step move
-  // without changing the orientation and without emitting a "tick".
-  //
-  // Emit the "tick" each time when moving from "beg" to "start".
-  //
-  //                   00                    10          01         11
-  // -----------------------------------------------------------------------------
-  /* R_START1    */ {R_START0,           R_CW_BEG1,  R_CCW_BEG1, R_START1},
-  /* R_START0    */ {R_START0,           R_CCW_BEG0, R_CW_BEG0,  R_START1},
-  /* R_CW_BEG1   */ {R_START0 | DIR_CW,  R_CW_BEG1,  R_CW_BEG0,  R_START1},
-  /* R_CW_BEG0   */ {R_START0,           R_CW_BEG1,  R_CW_BEG0,  R_START1 | DIR_CW},
-  /* R_CCW_BEG1  */ {R_START0 | DIR_CCW, R_CCW_BEG0, R_CCW_BEG1, R_START1},
-  /* R_CCW_BEG0  */ {R_START0,           R_CCW_BEG0, R_CCW_BEG1, R_START1 | DIR_CCW},
-};
-
 #ifdef GPIO
   char *consumer = "deskhpsdr";
 
@@ -239,7 +150,6 @@ guchar encoder_state_table[13][4] = {
   char *gpio_device            = NULL;
 
   static struct gpiod_chip *chip = NULL;
-  static GMutex encoder_mutex;
   static GThread *monitor_thread_id;
 #endif
 
@@ -515,162 +425,140 @@ static unsigned int millis () {
   return (uint32_t)(now - epochMilli) ;
 }
 
-static gpointer rotary_encoder_thread(gpointer data) {
-  int i;
-  enum ACTION action;
-  enum ACTION_MODE mode;
-  int val;
-  usleep(250000);
-  t_print("%s\n", __FUNCTION__);
+//
+// Encoder ticks are counted atomically in the edge callback (process_encoder),
+// which then wakes up the dispatcher through an eventfd. The dispatcher
+// collects the ticks of all encoders over a short coalescing window
+// (1 msec for slow turns, up to 10 msec for fast spins), applies
+// velocity-based acceleration to the VFO encoder and schedules the actions.
+//
+static int encoder_event_fd = -1;
 
-  while (TRUE) {
-    g_mutex_lock(&encoder_mutex);
-
-    for (i = 0; i < MAX_ENCODERS; i++) {
-      if (encoders[i].bottom_encoder_enabled && encoders[i].bottom_encoder_pos != 0) {
-        //t_print("%s: BOTTOM encoder %d pos=%d\n",__FUNCTION__,i,encoders[i].bottom_encoder_pos);
-        action = encoders[i].bottom_encoder_function;
-        mode = RELATIVE;
-        val = encoders[i].bottom_encoder_pos;
-        encoders[i].bottom_encoder_pos = 0;
-        schedule_action(action, mode, val);
-      }
+static void encoder_wakeup() {
+  uint64_t one = 1;
 
-      if (encoders[i].top_encoder_enabled && encoders[i].top_encoder_pos != 0) {
-        //t_print("%s: TOP encoder %d pos=%d\n",__FUNCTION__,i,encoders[i].top_encoder_pos);
-        action = encoders[i].top_encoder_function;
-        mode = RELATIVE;
-        val = encoders[i].top_encoder_pos;
-        encoders[i].top_encoder_pos = 0;
-        schedule_action(action, mode, val);
-      }
-    }
+  if (encoder_event_fd < 0) { return; }
 
-    g_mutex_unlock(&encoder_mutex);
-    usleep(100000); // sleep for 100ms
+  if (write(encoder_event_fd, &one, sizeof(one)) < 0) {
+    t_print("%s: eventfd write failed: %s\n", __FUNCTION__, g_strerror(errno));
   }
-
-  return NULL;
 }
 
-static void process_encoder(int e, int l, int addr, int val) {
-  guchar pinstate;
-  //t_print("%s: encoder=%d level=%d addr=0x%02X val=%d\n",__FUNCTION__,e,l,addr,val);
-  g_mutex_lock(&encoder_mutex);
+//
+// Atomically fetch the accumulated ticks and reset the counter
+//
+static int encoder_take(int *pos) {
+  int val;
 
-  switch (l) {
-  case BOTTOM_ENCODER:
-    switch (addr) {
-    case A:
-      encoders[e].bottom_encoder_a_value = val;
-      pinstate = (encoders[e].bottom_encoder_b_value << 1) | encoders[e].bottom_encoder_a_value;
-      encoders[e].bottom_encoder_state = encoder_state_table[encoders[e].bottom_encoder_state & 0xf][pinstate];
+  do {
+    val = g_atomic_int_get(pos);
+  } while (!g_atomic_int_compare_and_exchange(pos, val, 0));
 
-      //t_print("%s: state=%02X\n",__FUNCTION__,encoders[e].bottom_encoder_state);
-      switch (encoders[e].bottom_encoder_state & 0x30) {
-      case DIR_NONE:
-        break;
+  return val;
+}
 
-      case DIR_CW:
-        encoders[e].bottom_encoder_pos++;
-        break;
+static int encoder_dispatch(int *pos, int function, ROTARY_VELOCITY *vel, gint64 now) {
+  int val = encoder_take(pos);
 
-      case DIR_CCW:
-        encoders[e].bottom_encoder_pos--;
-        break;
+  if (val != 0) {
+    rotary_velocity_update(vel, val, now);
 
-      default:
-        break;
-      }
+    if (function == VFO) {
+      val = rotary_accelerate(vel, val);
+    }
 
-      //t_print("%s: %d BOTTOM pos=%d\n",__FUNCTION__,e,encoders[e].bottom_encoder_pos);
-      break;
+    schedule_action(function, RELATIVE, val);
+  }
 
-    case B:
-      encoders[e].bottom_encoder_b_value = val;
-      pinstate = (encoders[e].bottom_encoder_b_value << 1) | encoders[e].bottom_encoder_a_value;
-      encoders[e].bottom_encoder_state = encoder_state_table[encoders[e].bottom_encoder_state & 0xf][pinstate];
+  return rotary_window(vel);
+}
 
-      //t_print("%s: state=%02X\n",__FUNCTION__,encoders[e].bottom_encoder_state);
-      switch (encoders[e].bottom_encoder_state & 0x30) {
-      case DIR_NONE:
-        break;
+static gpointer rotary_encoder_thread(gpointer data) {
+  ROTARY_VELOCITY bottom_vel[MAX_ENCODERS];
+  ROTARY_VELOCITY top_vel[MAX_ENCODERS];
+  int window = ROTARY_WINDOW_MIN;
 
-      case DIR_CW:
-        encoders[e].bottom_encoder_pos++;
-        break;
+  for (int i = 0; i < MAX_ENCODERS; i++) {
+    rotary_velocity_init(&bottom_vel[i]);
+    rotary_velocity_init(&top_vel[i]);
+  }
 
-      case DIR_CCW:
-        encoders[e].bottom_encoder_pos--;
-        break;
+  usleep(250000);
+  t_print("%s\n", __FUNCTION__);
 
-      default:
-        break;
-      }
+  while (TRUE) {
+    uint64_t count;
+    gint64 now;
+    int w;
 
-      //t_print("%s: %d BOTTOM pos=%d\n",__FUNCTION__,e,encoders[e].bottom_encoder_pos);
+    if (read(encoder_event_fd, &count, sizeof(count)) < 0) {
+      if (errno == EINTR || errno == EAGAIN) { continue; }
+
+      t_print("%s: eventfd read failed: %s\n", __FUNCTION__, g_strerror(errno));
       break;
     }
 
-    break;
+    usleep(1000 * window);
+    now = g_get_monotonic_time();
+    window = ROTARY_WINDOW_MIN;
 
-  case TOP_ENCODER:
-    switch (addr) {
-    case A:
-      encoders[e].top_encoder_a_value = val;
-      pinstate = (encoders[e].top_encoder_b_value << 1) | encoders[e].top_encoder_a_value;
-      encoders[e].top_encoder_state = encoder_state_table[encoders[e].top_encoder_state & 0xf][pinstate];
-
-      //t_print("%s: state=%02X\n",__FUNCTION__,encoders[e].top_encoder_state);
-      switch (encoders[e].top_encoder_state & 0x30) {
-      case DIR_NONE:
-        break;
+    for (int i = 0; i < MAX_ENCODERS; i++) {
+      if (encoders[i].bottom_encoder_enabled) {
+        w = encoder_dispatch(&encoders[i].bottom_encoder_pos, encoders[i].bottom_encoder_function, &bottom_vel[i], now);
 
-      case DIR_CW:
-        encoders[e].top_encoder_pos++;
-        break;
+        if (w > window) { window = w; }
+      }
 
-      case DIR_CCW:
-        encoders[e].top_encoder_pos--;
-        break;
+      if (encoders[i].top_encoder_enabled) {
+        w = encoder_dispatch(&encoders[i].top_encoder_pos, encoders[i].top_encoder_function, &top_vel[i], now);
 
-      default:
-        break;
+        if (w > window) { window = w; }
       }
+    }
+  }
 
-      //t_print("%s: %d TOP pos=%d\n",__FUNCTION__,e,encoders[e].top_encoder_pos);
-      break;
+  return NULL;
+}
 
-    case B:
-      encoders[e].top_encoder_b_value = val;
-      pinstate = (encoders[e].top_encoder_b_value << 1) | encoders[e].top_encoder_a_value;
-      encoders[e].top_encoder_state = encoder_state_table[encoders[e].top_encoder_state & 0xf][pinstate];
+//
+// Called from the gpiod monitor thread only, so the state machine needs
+// no locking. Only the tick counter is shared with the dispatcher.
+//
+static void process_encoder(int e, int l, int addr, int val) {
+  int tick = 0;
 
-      //t_print("%s: state=%02X\n",__FUNCTION__,encoders[e].top_encoder_state);
-      switch (encoders[e].top_encoder_state & 0x30) {
-      case DIR_NONE:
-        break;
+  //t_print("%s: encoder=%d level=%d addr=0x%02X val=%d\n",__FUNCTION__,e,l,addr,val);
+  switch (l) {
+  case BOTTOM_ENCODER:
+    if (addr == A) {
+      encoders[e].bottom_encoder_a_value = val;
+    } else {
+      encoders[e].bottom_encoder_b_value = val;
+    }
 
-      case DIR_CW:
-        encoders[e].top_encoder_pos++;
-        break;
+    tick = rotary_step(&encoders[e].bottom_encoder_state, encoders[e].bottom_encoder_a_value,
+                       encoders[e].bottom_encoder_b_value);
 
-      case DIR_CCW:
-        encoders[e].top_encoder_pos--;
-        break;
+    if (tick != 0) { g_atomic_int_add(&encoders[e].bottom_encoder_pos, tick); }
 
-      default:
-        break;
-      }
+    break;
 
-      //t_print("%s: %d TOP pos=%d\n",__FUNCTION__,e,encoders[e].top_encoder_pos);
-      break;
+  case TOP_ENCODER:
+    if (addr == A) {
+      encoders[e].top_encoder_a_value = val;
+    } else {
+      encoders[e].top_encoder_b_value = val;
     }
 
+    tick = rotary_step(&encoders[e].top_encoder_state, encoders[e].top_encoder_a_value,
+                       encoders[e].top_encoder_b_value);
+
+    if (tick != 0) { g_atomic_int_add(&encoders[e].top_encoder_pos, tick); }
+
     break;
   }
 
-  g_mutex_unlock(&encoder_mutex);
+  if (tick != 0) { encoder_wakeup(); }
 }
 
 static void process_edge(int offset, int value) {
@@ -1295,7 +1183,15 @@ int gpio_init() {
 #ifdef GPIO
   int ret = 0;
   initialiseEpoch();
-  g_mutex_init(&encoder_mutex);
+
+  if (encoder_event_fd < 0) {
+    encoder_event_fd = eventfd(0, EFD_CLOEXEC);
+
+    if (encoder_event_fd < 0) {
+      t_print("%s: eventfd failed: %s\n", __FUNCTION__, g_strerror(errno));
+    }
+  }
+
   gpio_set_defaults(controller);
   chip = NULL;
 
@@ -1432,7 +1328,7 @@ int gpio_init() {
     t_print("%s: monitor_thread: id=%p\n", __FUNCTION__, monitor_thread_id);
   }
 
-  if (controller != NO_CONTROLLER && controller != G2_V2) {
+  if (controller != NO_CONTROLLER && controller != G2_V2 && encoder_event_fd >= 0) {
     rotary_encoder_thread_id = g_thread_new( "encoders", rotary_encoder_thread, NULL);
     t_print("%s: rotary_encoder_thread: id=%p\n", __FUNCTION__, rotary_encoder_thread_id);
   }
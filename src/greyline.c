@@ -32,6 +32,15 @@
 #define DEG2RAD(d) ((d) * M_PI / 180.0)
 #define RAD2DEG(r) ((r) * 180.0 / M_PI)
 
+/* Resolution of the day/night alpha mask: one pixel per degree.
+   It is scaled (bilinear) to the window size when drawn. */
+#define NIGHT_MASK_W 360
+#define NIGHT_MASK_H 180
+
+static long utc_minute(void) {
+  return (long)(time(NULL) / 60);
+}
+
 static GtkWindow *find_active_parent_window(void) {
   GList *wins = gtk_window_list_toplevels();
   GtkWindow *first_realized = NULL;
@@ -63,12 +72,35 @@ typedef struct {
 
   int w;
   int h;
+  int scale;
 
   char locator[16];
 
   GdkPixbuf *map_pixbuf;
   cairo_surface_t *map_surface;
 
+  /* Caches: the map scaled to the window size, the day/night mask and
+     the D-layer estimate (both refreshed once per UTC minute) and the
+     composed frame (refreshed if any of the above changes). */
+  cairo_surface_t *scaled_map;
+  int scaled_w;
+  int scaled_h;
+  int scaled_scale;
+
+  cairo_surface_t *night_mask;
+  double term_lat[NIGHT_MASK_W + 1];
+  long mask_minute;
+
+  double dlayer_alt;
+  gboolean dlayer_valid;
+  long dlayer_minute;
+
+  cairo_surface_t *frame;
+  int frame_w;
+  int frame_h;
+  int frame_scale;
+  long frame_minute;
+
   guint timer_id;
 
   double aspect_w_over_h;
@@ -258,12 +290,7 @@ static void draw_band_state(cairo_t *cr, double x, double y, const char *label,
   draw_text_shadow(cr, x + 16, y, label);
 }
 
-static void draw_dlayer_panel(cairo_t *cr, int w, int h, const char *locator) {
-  double lat, lon;
-
-  if (!locator_to_latlon(locator, &lat, &lon)) { return; }
-
-  double alt = solar_altitude_deg(lat, lon);
+static void draw_dlayer_panel(cairo_t *cr, int w, int h, double alt) {
   /* Simple operational traffic-light logic */
   /* 160/80m: highly D-layer sensitive */
   gboolean lo_red    = (alt > 0.0);
@@ -341,61 +368,67 @@ static double terminator_lat_for_lon(double sub_lat, double sub_lon, double lon)
   return RAD2DEG(atan(-cos(lam) / tanphi));
 }
 
-static void draw_greyline_overlay(cairo_t *cr, int w, int h) {
+/* Recompute the day/night mask and the terminator line (once per minute).
+   The subsolar point moves about 0.25 deg/min, so this is more than sufficient. */
+static void update_night_mask(GreylineWin *gw) {
   double sub_lat, sub_lon;
+  double sin_lat[NIGHT_MASK_H], cos_lat[NIGHT_MASK_H], cos_dlon[NIGHT_MASK_W];
   subsolar_point_utc(&sub_lat, &sub_lon);
-  int steps = w;
-
-  if (steps < 400) { steps = 400; }
+  double dec = DEG2RAD(sub_lat);
 
-  double step = (double)w / (double)steps;
-  /* Determine which side is night by checking the antisolar point */
-  double anti_lat = -sub_lat;
-  double anti_lon = sub_lon + 180.0;
+  if (!gw->night_mask) {
+    gw->night_mask = cairo_image_surface_create(CAIRO_FORMAT_A8, NIGHT_MASK_W, NIGHT_MASK_H);
+  }
 
-  while (anti_lon > 180.0) { anti_lon -= 360.0; }
+  for (int y = 0; y < NIGHT_MASK_H; y++) {
+    double lat = DEG2RAD(90.0 - (y + 0.5) * 180.0 / NIGHT_MASK_H);
+    sin_lat[y] = sin(lat) * sin(dec);
+    cos_lat[y] = cos(lat) * cos(dec);
+  }
 
-  while (anti_lon < -180.0) { anti_lon += 360.0; }
+  for (int x = 0; x < NIGHT_MASK_W; x++) {
+    double lon = -180.0 + (x + 0.5) * 360.0 / NIGHT_MASK_W;
+    cos_dlon[x] = cos(DEG2RAD(lon - sub_lon));
+  }
 
-  double t_lat_at_anti = terminator_lat_for_lon(sub_lat, sub_lon, anti_lon);
-  /* If antisolar latitude is south of terminator at that longitude, night polygon closes to bottom */
-  gboolean night_closes_to_bottom = (anti_lat < t_lat_at_anti);
-  /* Night shading polygon (no CLEAR; avoids white/transparent artifacts) */
-  cairo_save(cr);
-  cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 0.45);
-  cairo_new_path(cr);
+  cairo_surface_flush(gw->night_mask);
+  unsigned char *data = cairo_image_surface_get_data(gw->night_mask);
+  int stride = cairo_image_surface_get_stride(gw->night_mask);
 
-  for (int i = 0; i <= steps; i++) {
-    double x = i * step;
-    double lon = -180.0 + (x / (double)w) * 360.0;
-    double lat = terminator_lat_for_lon(sub_lat, sub_lon, lon);
-    double y = (90.0 - lat) / 180.0 * (double)h;
+  for (int y = 0; y < NIGHT_MASK_H; y++) {
+    unsigned char *row = data + y * stride;
 
-    if (i == 0) { cairo_move_to(cr, x, y); }
-    else { cairo_line_to(cr, x, y); }
+    for (int x = 0; x < NIGHT_MASK_W; x++) {
+      /* sin(solar altitude); a 1 deg wide soft edge around the terminator */
+      double sinalt = sin_lat[y] + cos_lat[y] * cos_dlon[x];
+      double f = 0.5 - RAD2DEG(asin(CLAMP(sinalt, -1.0, 1.0)));
+      row[x] = (unsigned char)(0.45 * 255.0 * CLAMP(f, 0.0, 1.0));
+    }
   }
 
-  if (night_closes_to_bottom) {
-    cairo_line_to(cr, w, h);
-    cairo_line_to(cr, 0, h);
-  } else {
-    cairo_line_to(cr, w, 0);
-    cairo_line_to(cr, 0, 0);
+  cairo_surface_mark_dirty(gw->night_mask);
+
+  for (int i = 0; i <= NIGHT_MASK_W; i++) {
+    double lon = -180.0 + (double)i * 360.0 / NIGHT_MASK_W;
+    gw->term_lat[i] = terminator_lat_for_lon(sub_lat, sub_lon, lon);
   }
+}
 
-  cairo_close_path(cr);
-  cairo_fill(cr);
+static void draw_greyline_overlay(GreylineWin *gw, cairo_t *cr, int w, int h) {
+  /* Night shading */
+  cairo_save(cr);
+  cairo_scale(cr, (double)w / NIGHT_MASK_W, (double)h / NIGHT_MASK_H);
+  cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+  cairo_mask_surface(cr, gw->night_mask, 0, 0);
   cairo_restore(cr);
   /* Terminator line */
   cairo_set_source_rgba(cr, 1.0, 1.0, 0.0, 0.65);
   cairo_set_line_width(cr, 1.2);
   cairo_new_path(cr);
 
-  for (int i = 0; i <= steps; i++) {
-    double x = i * step;
-    double lon = -180.0 + (x / (double)w) * 360.0;
-    double lat = terminator_lat_for_lon(sub_lat, sub_lon, lon);
-    double y = (90.0 - lat) / 180.0 * (double)h;
+  for (int i = 0; i <= NIGHT_MASK_W; i++) {
+    double x = (double)i * (double)w / NIGHT_MASK_W;
+    double y = (90.0 - gw->term_lat[i]) / 180.0 * (double)h;
 
     if (i == 0) { cairo_move_to(cr, x, y); }
     else { cairo_line_to(cr, x, y); }
@@ -404,6 +437,16 @@ static void draw_greyline_overlay(cairo_t *cr, int w, int h) {
   cairo_stroke(cr);
 }
 
+/* D-layer estimate: solar altitude at the own locator, cached by UTC minute */
+static void update_dlayer(GreylineWin *gw) {
+  double lat, lon;
+  gw->dlayer_valid = locator_to_latlon(gw->locator, &lat, &lon);
+
+  if (gw->dlayer_valid) {
+    gw->dlayer_alt = solar_altitude_deg(lat, lon);
+  }
+}
+
 /* --- Draw station marker --- */
 static void draw_locator_marker(cairo_t *cr, int w, int h, const char *locator) {
   double lat, lon;
@@ -451,13 +494,19 @@ static void draw_locator_marker(cairo_t *cr, int w, int h, const char *locator)
   }
 }
 
-/* --- GTK draw callback --- */
-static gboolean on_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
-  GreylineWin *gw = (GreylineWin *)user_data;
-  GtkAllocation a;
-  gtk_widget_get_allocation(widget, &a);
-  gw->w = a.width;
-  gw->h = a.height;
+/* Cache surface at the device resolution of the drawing area (HiDPI),
+   drawn into and painted with widget coordinates */
+static cairo_surface_t *create_cache_surface(GreylineWin *gw) {
+  return gdk_window_create_similar_image_surface(gtk_widget_get_window(gw->area), CAIRO_FORMAT_RGB24,
+         gw->w * gw->scale, gw->h * gw->scale, gw->scale);
+}
+
+/* Map scaled to the window size, re-done only if the size or the scale changes */
+static void update_scaled_map(GreylineWin *gw) {
+  if (gw->scaled_map) {
+    cairo_surface_destroy(gw->scaled_map);
+    gw->scaled_map = NULL;
+  }
 
   if (!gw->map_surface) {
     if (!gw->map_pixbuf) { gw->map_pixbuf = load_embedded_jpg(); }
@@ -467,25 +516,93 @@ static gboolean on_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
     }
   }
 
+  gw->scaled_w = gw->w;
+  gw->scaled_h = gw->h;
+  gw->scaled_scale = gw->scale;
+  gw->scaled_map = create_cache_surface(gw);
+  cairo_t *cr = cairo_create(gw->scaled_map);
+
   if (gw->map_surface) {
-    cairo_save(cr);
     int mw = gdk_pixbuf_get_width(gw->map_pixbuf);
     int mh = gdk_pixbuf_get_height(gw->map_pixbuf);
     cairo_scale(cr,
                 (double)gw->w / (double)mw,
                 (double)gw->h / (double)mh);
     cairo_set_source_surface(cr, gw->map_surface, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
     cairo_paint(cr);
-    cairo_restore(cr);
   } else {
     cairo_set_source_rgb(cr, 0.08, 0.08, 0.10);
-    cairo_rectangle(cr, 0, 0, gw->w, gw->h);
-    cairo_fill(cr);
+    cairo_paint(cr);
+  }
+
+  cairo_destroy(cr);
+}
+
+/* Compose map, night shading, marker and D-layer panel into one surface */
+static void update_frame(GreylineWin *gw, long minute) {
+  if (gw->frame && (gw->frame_w != gw->w || gw->frame_h != gw->h || gw->frame_scale != gw->scale)) {
+    cairo_surface_destroy(gw->frame);
+    gw->frame = NULL;
   }
 
-  draw_greyline_overlay(cr, gw->w, gw->h);
+  if (!gw->frame) {
+    gw->frame = create_cache_surface(gw);
+    gw->frame_w = gw->w;
+    gw->frame_h = gw->h;
+    gw->frame_scale = gw->scale;
+  }
+
+  cairo_t *cr = cairo_create(gw->frame);
+  cairo_set_source_surface(cr, gw->scaled_map, 0, 0);
+  cairo_paint(cr);
+  draw_greyline_overlay(gw, cr, gw->w, gw->h);
   draw_locator_marker(cr, gw->w, gw->h, gw->locator);
-  draw_dlayer_panel(cr, gw->w, gw->h, gw->locator);
+
+  if (gw->dlayer_valid) {
+    draw_dlayer_panel(cr, gw->w, gw->h, gw->dlayer_alt);
+  }
+
+  cairo_destroy(cr);
+  gw->frame_minute = minute;
+}
+
+/* --- GTK draw callback --- */
+static gboolean on_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+  GreylineWin *gw = (GreylineWin *)user_data;
+  GtkAllocation a;
+  gboolean dirty = FALSE;
+  long minute = utc_minute();
+  gtk_widget_get_allocation(widget, &a);
+  gw->w = a.width;
+  gw->h = a.height;
+  gw->scale = gtk_widget_get_scale_factor(widget);
+
+  if (gw->w <= 0 || gw->h <= 0) { return FALSE; }
+
+  if (!gw->scaled_map || gw->scaled_w != gw->w || gw->scaled_h != gw->h || gw->scaled_scale != gw->scale) {
+    update_scaled_map(gw);
+    dirty = TRUE;
+  }
+
+  if (!gw->night_mask || gw->mask_minute != minute) {
+    update_night_mask(gw);
+    gw->mask_minute = minute;
+    dirty = TRUE;
+  }
+
+  if (gw->dlayer_minute != minute) {
+    update_dlayer(gw);
+    gw->dlayer_minute = minute;
+    dirty = TRUE;
+  }
+
+  if (dirty || !gw->frame || gw->frame_minute != minute) {
+    update_frame(gw, minute);
+  }
+
+  cairo_set_source_surface(cr, gw->frame, 0, 0);
+  cairo_paint(cr);
   return FALSE;
 }
 
@@ -516,6 +633,21 @@ static void on_window_destroy(GtkWidget *widget, gpointer user_data) {
     gw->map_surface = NULL;
   }
 
+  if (gw->scaled_map) {
+    cairo_surface_destroy(gw->scaled_map);
+    gw->scaled_map = NULL;
+  }
+
+  if (gw->night_mask) {
+    cairo_surface_destroy(gw->night_mask);
+    gw->night_mask = NULL;
+  }
+
+  if (gw->frame) {
+    cairo_surface_destroy(gw->frame);
+    gw->frame = NULL;
+  }
+
   if (gw->map_pixbuf) {
     g_object_unref(gw->map_pixbuf);
     gw->map_pixbuf = NULL;
@@ -533,6 +665,9 @@ static void open_impl(GtkWindow *parent, int window_width, int window_height, co
 
   GreylineWin *gw = g_malloc0(sizeof(GreylineWin));
   double aspect_w_over_h = 2.0; /* width/height */
+  gw->mask_minute = -1;
+  gw->dlayer_minute = -1;
+  gw->frame_minute = -1;
 
   if (locator && locator[0]) {
     strncpy(gw->locator, locator, sizeof(gw->locator) - 1);
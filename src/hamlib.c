@@ -0,0 +1,927 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+//
+// Hamlib rigctld NET protocol server
+//
+// This speaks the line-oriented protocol between Hamlib's "NET rigctl"
+// backend (rig model 2) and rigctld, so Hamlib clients can talk to
+// deskHPSDR directly. Each command is one line, either a one-letter
+// command ("F 14074000") or a long command ("\set_freq 14074000").
+// A leading '+' (or ';', '|', ',') selects the extended response
+// format. If the client switches on VFO mode (\set_vfo_opt 1), the
+// VFO is the first argument of each VFO-related command.
+//
+// Queries are answered from the radio state in the client thread,
+// as the TCI server does. Commands changing the state are executed
+// in the GTK thread, and the client thread waits until this is done
+// before it sends "RPRT 0", so that a query following a set command
+// already sees the new value.
+//
+
+#include <gtk/gtk.h>
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ext.h"
+#include "filter.h"
+#include "hamlib.h"
+#include "message.h"
+#include "mode.h"
+#include "radio.h"
+#include "receiver.h"
+#include "rigctl.h"
+#include "sliders.h"
+#include "vfo.h"
+
+#define MAX_HAMLIB_CLIENTS 4
+#define HAMLIB_LINELEN     256
+#define HAMLIB_REPLYLEN    2048
+#define HAMLIB_ARGS        4
+
+//
+// Hamlib error codes, sent back negated as "RPRT -x"
+//
+#define RIG_OK        0
+#define RIG_EINVAL    1
+#define RIG_ENIMPL    4
+#define RIG_ETIMEOUT  5
+#define RIG_ENAVAIL  11
+
+//
+// Hamlib capability bits reported in \dump_state
+//
+#define HL_MODE_AM      0x00001
+#define HL_MODE_CW      0x00002
+#define HL_MODE_USB     0x00004
+#define HL_MODE_LSB     0x00008
+#define HL_MODE_FM      0x00020
+#define HL_MODE_CWR     0x00080
+#define HL_MODE_PKTLSB  0x00400
+#define HL_MODE_PKTUSB  0x00800
+#define HL_MODE_SAM     0x10000
+#define HL_MODE_DSB     0x80000
+#define HL_MODES        (HL_MODE_AM | HL_MODE_CW | HL_MODE_USB | HL_MODE_LSB | HL_MODE_FM | HL_MODE_CWR | \
+                         HL_MODE_PKTLSB | HL_MODE_PKTUSB | HL_MODE_SAM | HL_MODE_DSB)
+
+#define HL_LEVEL_AF        0x00000008ULL
+#define HL_LEVEL_RFPOWER   0x00001000ULL
+#define HL_LEVEL_KEYSPD    0x00004000ULL
+#define HL_LEVEL_STRENGTH  0x40000000ULL
+
+int hamlib_enable = 0;
+int hamlib_port   = 4532;
+
+static GThread *hamlib_server_thread_id = NULL;
+static int hamlib_running = 0;
+
+static int server_socket = -1;
+static struct sockaddr_in server_address;
+
+typedef struct _hamlib_client {
+  int seq;                      // Seq. number of the client
+  int fd;                       // socket
+  int busy;                     // slot in use (until the listener has finished)
+  int running;                  // set this to zero to close client connection
+  int vfo;                      // "current" VFO of this client
+  int vfo_opt;                  // client sends the VFO with each command
+  socklen_t address_length;
+  struct sockaddr_in address;
+} CLIENT;
+
+//
+// Reply under construction. In the extended format, each value is
+// preceded by its name and the reply ends with "RPRT x".
+//
+typedef struct _reply {
+  int    ext;                   // extended response format
+  char   sep;                   // separator for extended responses
+  size_t len;
+  char   buf[HAMLIB_REPLYLEN];
+} REPLY;
+
+typedef int (*HANDLER)(CLIENT *client, int v, int argc, char **argv, REPLY *r);
+
+typedef struct _command {
+  char        cmd;              // one-letter command, 0 if there is none
+  const char  *name;            // long command without the backslash
+  int         has_vfo;          // takes a VFO argument in VFO mode
+  int         is_set;           // non-extended reply is "RPRT x"
+  int         nargs;            // required arguments (after the VFO)
+  HANDLER     handler;
+} COMMAND;
+
+//
+// A state change to be executed in the GTK thread
+//
+enum {
+  SET_FREQ = 0,
+  SET_MODE,
+  SET_PTT,
+  SET_SPLIT,
+  SET_RFPOWER,
+  SET_AF
+};
+
+typedef struct _set_cmd {
+  int       what;
+  int       v;
+  long long f;
+  int       val;
+  double    level;
+  int       done;
+  int       abandoned;          // waiting client has given up
+} SET_CMD;
+
+static CLIENT hamlib_client[MAX_HAMLIB_CLIENTS];
+
+static GMutex hamlib_mutex;
+static GMutex set_mutex;
+static GCond  set_cond;
+
+static gpointer hamlib_server(gpointer data);
+static gpointer hamlib_listener(gpointer data);
+
+//
+// Launch Hamlib server. Called upon program start if it is
+// enabled in the props file, and from the CAT/TCI menu.
+//
+void launch_hamlib() {
+  t_print( "---- LAUNCHING HAMLIB SERVER ----\n");
+  hamlib_running = 1;
+  hamlib_server_thread_id = g_thread_new( "hamlib server", hamlib_server, GINT_TO_POINTER(hamlib_port));
+}
+
+//
+// Shut down Hamlib server. The client connections are only shut down
+// here, each listener thread closes its socket and frees its slot.
+//
+void shutdown_hamlib() {
+  t_print("%s: server_socket=%d\n", __FUNCTION__, server_socket);
+  hamlib_running = 0;
+  g_mutex_lock(&hamlib_mutex);
+
+  for (int id = 0; id < MAX_HAMLIB_CLIENTS; id++) {
+    hamlib_client[id].running = 0;
+
+    if (hamlib_client[id].busy) {
+      shutdown(hamlib_client[id].fd, SHUT_RDWR);
+    }
+  }
+
+  g_mutex_unlock(&hamlib_mutex);
+  usleep(100000);  // Let the server thread terminate, if it can
+
+  if (server_socket >= 0) {
+    struct linger linger = { 0 };
+    linger.l_onoff = 1;
+    linger.l_linger = 0;
+    // No error checking since the socket may be closed
+    // in a race condition by the server thread
+    setsockopt(server_socket, SOL_SOCKET, SO_LINGER, (const char *)&linger, sizeof(linger));
+    close(server_socket);
+    server_socket = -1;
+  }
+
+  hamlib_server_thread_id = NULL;
+}
+
+static void reply_printf(REPLY *r, const char *fmt, ...) {
+  va_list args;
+
+  if (r->len >= sizeof(r->buf)) { return; }
+
+  va_start(args, fmt);
+  int n = vsnprintf(r->buf + r->len, sizeof(r->buf) - r->len, fmt, args);
+  va_end(args);
+
+  if (n > 0) {
+    r->len += n;
+
+    if (r->len > sizeof(r->buf) - 1) { r->len = sizeof(r->buf) - 1; }
+  }
+}
+
+//
+// Add one value to the reply, "Key: value" in extended mode
+//
+static void reply_value(REPLY *r, const char *key, const char *value) {
+  if (r->ext) {
+    reply_printf(r, "%s: %s%c", key, value, r->sep);
+  } else {
+    reply_printf(r, "%s\n", value);
+  }
+}
+
+static void reply_int(REPLY *r, const char *key, long long value) {
+  char str[32];
+  snprintf(str, sizeof(str), "%lld", value);
+  reply_value(r, key, str);
+}
+
+static void reply_double(REPLY *r, const char *key, double value) {
+  //
+  // Hamlib expects a decimal point, whatever the locale says
+  //
+  char str[G_ASCII_DTOSTR_BUF_SIZE];
+  g_ascii_formatd(str, sizeof(str), "%.6f", value);
+  reply_value(r, key, str);
+}
+
+static int hamlib_set_cb(gpointer data) {
+  SET_CMD *cmd = (SET_CMD *)data;
+  int v = cmd->v;
+
+  switch (cmd->what) {
+  case SET_FREQ:
+    vfo_set_frequency(v, cmd->f);
+    break;
+
+  case SET_MODE:
+    if (vfo[v].mode != cmd->val) {
+      vfo_id_mode_changed(v, cmd->val);
+    }
+
+    if (cmd->f > 0) {
+      //
+      // Choose the fixed filter whose width is closest to the passband
+      //
+      int best = vfo[v].filter;
+      int diff = INT_MAX;
+
+      for (int f = 0; f < filterVar1; f++) {
+        const FILTER *filter = &filters[cmd->val][f];
+        int d = abs(abs(filter->high - filter->low) - (int) cmd->f);
+
+        if (d < diff) {
+          diff = d;
+          best = f;
+        }
+      }
+
+      if (best != vfo[v].filter) {
+        vfo_id_filter_changed(v, best);
+      }
+    }
+
+    break;
+
+  case SET_PTT:
+    radio_mox_update(cmd->val);
+    break;
+
+  case SET_SPLIT:
+    radio_set_split(cmd->val);
+    break;
+
+  case SET_RFPOWER:
+    set_drive(100.0 * cmd->level);
+    break;
+
+  case SET_AF:
+    if (cmd->level < 0.01) {
+      receiver[v]->volume = -40.0;
+    } else {
+      receiver[v]->volume = 20.0 * log10(cmd->level);
+    }
+
+    set_af_gain(v, receiver[v]->volume);
+    break;
+  }
+
+  g_idle_add(ext_vfo_update, NULL);
+  g_mutex_lock(&set_mutex);
+
+  if (cmd->abandoned) {
+    g_free(cmd);
+  } else {
+    cmd->done = 1;
+    g_cond_broadcast(&set_cond);
+  }
+
+  g_mutex_unlock(&set_mutex);
+  return G_SOURCE_REMOVE;
+}
+
+//
+// Execute a state change in the GTK thread and wait (at most two seconds)
+// until it is done. If the GTK thread does not get to it in time, the
+// command is left to the GTK thread which then also frees it.
+//
+static int hamlib_set(int what, int v, long long f, int val, double level) {
+  SET_CMD *cmd = g_new(SET_CMD, 1);
+  gint64 deadline = g_get_monotonic_time() + 2 * G_TIME_SPAN_SECOND;
+  int rc = RIG_OK;
+  cmd->what = what;
+  cmd->v = v;
+  cmd->f = f;
+  cmd->val = val;
+  cmd->level = level;
+  cmd->done = 0;
+  cmd->abandoned = 0;
+  g_mutex_lock(&set_mutex);
+  g_idle_add(hamlib_set_cb, cmd);
+
+  while (!cmd->done) {
+    if (!g_cond_wait_until(&set_cond, &set_mutex, deadline)) { break; }
+  }
+
+  if (cmd->done) {
+    g_free(cmd);
+  } else {
+    cmd->abandoned = 1;
+    rc = -RIG_ETIMEOUT;
+  }
+
+  g_mutex_unlock(&set_mutex);
+  return rc;
+}
+
+static const char *hamlib_vfo_name(int v) {
+  return v == VFO_B ? "VFOB" : "VFOA";
+}
+
+static int hamlib_vfo(CLIENT *client, const char *name) {
+  if (!strcmp(name, "VFOA") || !strcmp(name, "Main") || !strcmp(name, "MainA")) { return VFO_A; }
+
+  if (!strcmp(name, "VFOB") || !strcmp(name, "Sub") || !strcmp(name, "SubA")) { return VFO_B; }
+
+  if (!strcmp(name, "currVFO") || !strcmp(name, "RX") || !strcmp(name, "VFO")) { return client->vfo; }
+
+  if (!strcmp(name, "TX")) { return vfo_get_tx_vfo(); }
+
+  return -1;
+}
+
+//
+// The receiver controlled by a VFO, -1 if it is not running
+//
+static int hamlib_rx(int v) {
+  if (v == VFO_A) { return 0; }
+
+  return receivers > 1 ? 1 : -1;
+}
+
+static const char *hamlib_mode_name(int m) {
+  switch (m) {
+  case modeLSB:
+    return "LSB";
+
+  case modeCWL:
+    return "CWR";
+
+  case modeCWU:
+    return "CW";
+
+  case modeFMN:
+    return "FM";
+
+  case modeAM:
+    return "AM";
+
+  case modeDIGU:
+    return "PKTUSB";
+
+  case modeDIGL:
+    return "PKTLSB";
+
+  case modeSAM:
+    return "SAM";
+
+  case modeDSB:
+    return "DSB";
+
+  default:     // USB, SPEC, DRM
+    return "USB";
+  }
+}
+
+static int hamlib_mode(const char *name) {
+  if (!strcmp(name, "LSB")) { return modeLSB; }
+
+  if (!strcmp(name, "USB")) { return modeUSB; }
+
+  if (!strcmp(name, "CW")) { return modeCWU; }
+
+  if (!strcmp(name, "CWR")) { return modeCWL; }
+
+  if (!strcmp(name, "FM") || !strcmp(name, "PKTFM")) { return modeFMN; }
+
+  if (!strcmp(name, "AM")) { return modeAM; }
+
+  if (!strcmp(name, "PKTUSB") || !strcmp(name, "RTTY")) { return modeDIGU; }
+
+  if (!strcmp(name, "PKTLSB") || !strcmp(name, "RTTYR")) { return modeDIGL; }
+
+  if (!strcmp(name, "SAM")) { return modeSAM; }
+
+  if (!strcmp(name, "DSB")) { return modeDSB; }
+
+  return -1;
+}
+
+static int hl_get_freq(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  reply_int(r, "Frequency", vfo[v].ctun ? vfo[v].ctun_frequency : vfo[v].frequency);
+  return RIG_OK;
+}
+
+static int hl_set_freq(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  double f = g_ascii_strtod(argv[0], NULL);
+
+  if (f <= 0.0) { return -RIG_EINVAL; }
+
+  return hamlib_set(SET_FREQ, v, llround(f), 0, 0.0);
+}
+
+static int hl_get_mode(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  int m = vfo[v].mode;
+  const FILTER *filter = &filters[m][vfo[v].filter];
+  reply_value(r, "Mode", hamlib_mode_name(m));
+  reply_int(r, "Passband", abs(filter->high - filter->low));
+  return RIG_OK;
+}
+
+static int hl_set_mode(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  int m = hamlib_mode(argv[0]);
+
+  if (m < 0) { return -RIG_EINVAL; }
+
+  //
+  // Passband 0 ("normal") and -1 ("no change") keep the current filter
+  //
+  return hamlib_set(SET_MODE, v, argc > 1 ? atoll(argv[1]) : 0, m, 0.0);
+}
+
+static int hl_get_vfo(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  reply_value(r, "VFO", hamlib_vfo_name(client->vfo));
+  return RIG_OK;
+}
+
+static int hl_set_vfo(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  int id = hamlib_vfo(client, argv[0]);
+
+  if (id < 0) { return -RIG_EINVAL; }
+
+  client->vfo = id;
+  return RIG_OK;
+}
+
+static int hl_get_ptt(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  reply_int(r, "PTT", radio_is_transmitting());
+  return RIG_OK;
+}
+
+static int hl_set_ptt(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  return hamlib_set(SET_PTT, v, 0, atoi(argv[0]) != 0, 0.0);
+}
+
+static int hl_get_split_vfo(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  reply_int(r, "Split", split);
+  reply_value(r, "TX VFO", hamlib_vfo_name(vfo_get_tx_vfo()));
+  return RIG_OK;
+}
+
+static int hl_set_split_vfo(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  return hamlib_set(SET_SPLIT, v, 0, atoi(argv[0]) != 0, 0.0);
+}
+
+static int hl_get_split_freq(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  reply_int(r, "TX Frequency", vfo_get_tx_freq());
+  return RIG_OK;
+}
+
+static int hl_set_split_freq(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  return hl_set_freq(client, VFO_B, argc, argv, r);
+}
+
+static int hl_get_split_mode(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  int m = vfo[VFO_B].mode;
+  const FILTER *filter = &filters[m][vfo[VFO_B].filter];
+  reply_value(r, "TX Mode", hamlib_mode_name(m));
+  reply_int(r, "TX Passband", abs(filter->high - filter->low));
+  return RIG_OK;
+}
+
+static int hl_set_split_mode(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  return hl_set_mode(client, VFO_B, argc, argv, r);
+}
+
+static int hl_get_level(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  int id = hamlib_rx(v);
+
+  if (!strcmp(argv[0], "STRENGTH")) {
+    if (id < 0) { return -RIG_ENAVAIL; }
+
+    // dB relative to S9 (-73 dBm)
+    reply_int(r, "Level Value", (long long) lround(receiver[id]->meter + 73.0));
+  } else if (!strcmp(argv[0], "AF")) {
+    if (id < 0) { return -RIG_ENAVAIL; }
+
+    reply_double(r, "Level Value", pow(10.0, 0.05 * receiver[id]->volume));
+  } else if (!strcmp(argv[0], "RFPOWER")) {
+    reply_double(r, "Level Value", 0.01 * radio_get_drive());
+  } else if (!strcmp(argv[0], "KEYSPD")) {
+    reply_int(r, "Level Value", cw_keyer_speed);
+  } else {
+    return -RIG_EINVAL;
+  }
+
+  return RIG_OK;
+}
+
+static int hl_set_level(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  double level = g_ascii_strtod(argv[1], NULL);
+  int id = hamlib_rx(v);
+
+  if (level < 0.0 || level > 1.0) { return -RIG_EINVAL; }
+
+  if (!strcmp(argv[0], "AF")) {
+    if (id < 0) { return -RIG_ENAVAIL; }
+
+    return hamlib_set(SET_AF, id, 0, 0, level);
+  }
+
+  if (!strcmp(argv[0], "RFPOWER")) {
+    return hamlib_set(SET_RFPOWER, v, 0, 0, level);
+  }
+
+  return -RIG_EINVAL;
+}
+
+static int hl_get_powerstat(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  reply_int(r, "Power Status", 1);
+  return RIG_OK;
+}
+
+static int hl_chk_vfo(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  reply_int(r, "ChkVFO", client->vfo_opt);
+  return RIG_OK;
+}
+
+static int hl_set_vfo_opt(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  client->vfo_opt = (atoi(argv[0]) != 0);
+  return RIG_OK;
+}
+
+static int hl_dump_state(CLIENT *client, int v, int argc, char **argv, REPLY *r) {
+  long long fmin = (long long) radio->frequency_min;
+  long long fmax = (long long) radio->frequency_max;
+  //
+  // rigctld protocol version 1: rig model (2 = NET rigctl), ITU region,
+  // RX and TX ranges, tuning steps, filters, RIT/XIT/IF shift limits,
+  // announces, preamps, attenuators and function/level/parm masks,
+  // then a key=value list terminated by "done". A client only reads
+  // that list if the version is at least 1, so both must go together.
+  //
+  reply_printf(r, "1\n2\n0\n");
+  reply_printf(r, "%lld %lld 0x%x -1 -1 0x3 0x0\n", fmin, fmax, HL_MODES);
+  reply_printf(r, "0 0 0 0 0 0 0\n");
+  reply_printf(r, "%lld %lld 0x%x -1 -1 0x3 0x0\n", fmin, fmax, HL_MODES);
+  reply_printf(r, "0 0 0 0 0 0 0\n");
+  reply_printf(r, "0x%x 1\n", HL_MODES);
+  reply_printf(r, "0 0\n");
+  reply_printf(r, "0x%x 2400\n", HL_MODE_USB | HL_MODE_LSB | HL_MODE_PKTUSB | HL_MODE_PKTLSB);
+  reply_printf(r, "0x%x 500\n", HL_MODE_CW | HL_MODE_CWR);
+  reply_printf(r, "0x%x 8000\n", HL_MODE_AM | HL_MODE_SAM | HL_MODE_DSB);
+  reply_printf(r, "0x%x 12000\n", HL_MODE_FM);
+  reply_printf(r, "0 0\n");
+  reply_printf(r, "9999\n9999\n0\n0\n\n\n");
+  reply_printf(r, "0x0\n0x0\n0x%llx\n0x%llx\n0x0\n0x0\n",
+               HL_LEVEL_AF | HL_LEVEL_RFPOWER | HL_LEVEL_KEYSPD | HL_LEVEL_STRENGTH,
+               HL_LEVEL_AF | HL_LEVEL_RFPOWER);
+  reply_printf(r, "vfo_ops=0x0\nptt_type=0x1\ntargetable_vfo=0x3\nhas_set_vfo=1\nhas_get_vfo=1\n"
+               "has_set_freq=1\nhas_get_freq=1\nhas_set_conf=0\nhas_get_conf=0\n"
+               "has_power2mW=0\nhas_mW2power=0\ntimeout=0\ndone\n");
+  return RIG_OK;
+}
+
+static const COMMAND hamlib_commands[] = {
+  { 'f', "get_freq",       1, 0, 0, hl_get_freq       },
+  { 'F', "set_freq",       1, 1, 1, hl_set_freq       },
+  { 'm', "get_mode",       1, 0, 0, hl_get_mode       },
+  { 'M', "set_mode",       1, 1, 1, hl_set_mode       },
+  { 'v', "get_vfo",        0, 0, 0, hl_get_vfo        },
+  { 'V', "set_vfo",        0, 1, 1, hl_set_vfo        },
+  { 't', "get_ptt",        1, 0, 0, hl_get_ptt        },
+  { 'T', "set_ptt",        1, 1, 1, hl_set_ptt        },
+  { 's', "get_split_vfo",  1, 0, 0, hl_get_split_vfo  },
+  { 'S', "set_split_vfo",  1, 1, 1, hl_set_split_vfo  },
+  { 'i', "get_split_freq", 1, 0, 0, hl_get_split_freq },
+  { 'I', "set_split_freq", 1, 1, 1, hl_set_split_freq },
+  { 'x', "get_split_mode", 1, 0, 0, hl_get_split_mode },
+  { 'X', "set_split_mode", 1, 1, 1, hl_set_split_mode },
+  { 'l', "get_level",      1, 0, 1, hl_get_level      },
+  { 'L', "set_level",      1, 1, 2, hl_set_level      },
+  { 0,   "get_powerstat",  0, 0, 0, hl_get_powerstat  },
+  { 0,   "chk_vfo",        0, 0, 0, hl_chk_vfo        },
+  { 0,   "set_vfo_opt",    0, 1, 1, hl_set_vfo_opt    },
+  { 0,   "dump_state",     0, 0, 0, hl_dump_state     },
+};
+
+//
+// Process one command line and send the reply.
+// Returns 0 if the client asked to close the connection.
+//
+static int hamlib_command(CLIENT *client, char *line) {
+  REPLY r;
+  char *argv[HAMLIB_ARGS + 1];
+  int argc = 0;
+  const COMMAND *cmd = NULL;
+  const char *name;
+  char *p = line;
+  int v = client->vfo;
+  int rc;
+  r.len = 0;
+  r.ext = 0;
+  r.sep = '\n';
+
+  while (isspace((unsigned char) *p)) { p++; }
+
+  if (*p == 0) { return 1; }
+
+  if (*p == '+' || *p == ';' || *p == '|' || *p == ',') {
+    r.ext = 1;
+    r.sep = (*p == '+') ? '\n' : *p;
+    p++;
+  }
+
+  if (*p == 'q' || *p == 'Q') { return 0; }
+
+  //
+  // Split into command and arguments
+  //
+  if (*p == '\\') {
+    name = ++p;
+
+    while (*p && !isspace((unsigned char) *p)) { p++; }
+
+    if (*p) { *p++ = 0; }
+
+    for (size_t i = 0; i < sizeof(hamlib_commands) / sizeof(COMMAND); i++) {
+      if (!strcmp(name, hamlib_commands[i].name)) { cmd = &hamlib_commands[i]; }
+    }
+  } else {
+    for (size_t i = 0; i < sizeof(hamlib_commands) / sizeof(COMMAND); i++) {
+      if (*p == hamlib_commands[i].cmd) { cmd = &hamlib_commands[i]; }
+    }
+
+    name = cmd ? cmd->name : "";
+    p++;
+  }
+
+  while (argc < HAMLIB_ARGS) {
+    while (isspace((unsigned char) *p)) { p++; }
+
+    if (*p == 0) { break; }
+
+    argv[argc++] = p;
+
+    while (*p && !isspace((unsigned char) *p)) { p++; }
+
+    if (*p) { *p++ = 0; }
+  }
+
+  argv[argc] = NULL;
+
+  if (rigctl_debug) {
+    t_print("HAMLIB%d command rcvd=%s argc=%d\n", client->seq, name, argc);
+  }
+
+  if (cmd == NULL) {
+    rc = -RIG_ENIMPL;
+  } else {
+    char **cargv = argv;
+    int cargc = argc;
+
+    if (cmd->has_vfo && client->vfo_opt) {
+      if (cargc < 1 || (v = hamlib_vfo(client, cargv[0])) < 0) {
+        v = -1;
+      } else {
+        cargc--;
+        cargv++;
+      }
+    }
+
+    if (v < 0 || cargc < cmd->nargs) {
+      rc = -RIG_EINVAL;
+    } else {
+      if (r.ext) {
+        //
+        // Echo the command. The arguments have been split in place,
+        // so rebuild them from argv.
+        //
+        reply_printf(&r, "%s:", name);
+
+        for (int i = 0; i < argc; i++) {
+          reply_printf(&r, " %s", argv[i]);
+        }
+
+        reply_printf(&r, "%c", r.sep);
+      }
+
+      rc = cmd->handler(client, v, cargc, cargv, &r);
+    }
+  }
+
+  if (rc != RIG_OK) {
+    // Values of a failed query are discarded
+    r.len = 0;
+
+    if (r.ext && cmd) { reply_printf(&r, "%s:%c", name, r.sep); }
+
+    reply_printf(&r, "RPRT %d\n", rc);
+  } else if (r.ext || cmd->is_set) {
+    reply_printf(&r, "RPRT %d\n", rc);
+  }
+
+  return send(client->fd, r.buf, r.len, 0) == (ssize_t) r.len;
+}
+
+static gpointer hamlib_listener(gpointer data) {
+  CLIENT *client = (CLIENT *)data;
+  char buf[HAMLIB_LINELEN];
+  int offset = 0;
+  t_print("%s: starting client: socket=%d\n", __FUNCTION__, client->fd);
+  // update CAT status onscreen
+  cat_control++;
+  g_idle_add(ext_vfo_update, NULL);
+
+  while (client->running) {
+    int numbytes = recv(client->fd, buf + offset, sizeof(buf) - 1 - offset, 0);
+
+    if (numbytes == 0) { break; }    // connection closed by the client
+
+    if (numbytes < 0) { continue; }  // 0.1 sec time-out
+
+    offset += numbytes;
+    buf[offset] = 0;
+    //
+    // The chunk just read may contain more than one command line
+    //
+    char *line = buf;
+    char *eol;
+
+    while (client->running && (eol = strchr(line, '\n')) != NULL) {
+      *eol = 0;
+
+      if (eol > line && eol[-1] == '\r') { eol[-1] = 0; }
+
+      if (!hamlib_command(client, line)) {
+        g_mutex_lock(&hamlib_mutex);
+        client->running = 0;
+        g_mutex_unlock(&hamlib_mutex);
+      }
+
+      line = eol + 1;
+    }
+
+    offset = strlen(line);
+    memmove(buf, line, offset + 1);
+
+    //
+    // A line that does not fit into the buffer is not a valid command
+    //
+    if (offset >= (int) sizeof(buf) - 1) { offset = 0; }
+  }
+
+  g_mutex_lock(&hamlib_mutex);
+  close(client->fd);
+  client->fd = -1;
+  client->running = 0;
+  client->busy = 0;
+  g_mutex_unlock(&hamlib_mutex);
+  t_print("%s: leaving thread\n", __FUNCTION__);
+  // update CAT status onscreen
+  cat_control--;
+  g_idle_add(ext_vfo_update, NULL);
+  return NULL;
+}
+
+static gpointer hamlib_server(gpointer data) {
+  signal(SIGPIPE, SIG_IGN);
+  int port = GPOINTER_TO_INT(data);
+  int on = 1;
+  struct timeval tv;
+  tv.tv_sec = 0;
+  tv.tv_usec = 100000;
+  t_print("%s: starting Hamlib server on port %d\n", __FUNCTION__, port);
+  server_socket = socket(AF_INET, SOCK_STREAM, 0);
+
+  if (server_socket < 0) {
+    t_perror("HAMLIB: listen socket failed");
+    return NULL;
+  }
+
+  if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0) {
+    t_perror("HamlibSrvReuseAddr");
+  }
+
+  if (setsockopt(server_socket, SOL_SOCKET, SO_RCVTIMEO,  &tv, sizeof(tv)) < 0) {
+    t_perror("HamlibSrvTimeOut");
+  }
+
+  memset(&server_address, 0, sizeof(server_address));
+  server_address.sin_family = AF_INET;
+  server_address.sin_addr.s_addr = htonl(INADDR_ANY);
+  server_address.sin_port = htons(port);
+
+  if (bind(server_socket, (struct sockaddr * )&server_address, sizeof(server_address)) < 0) {
+    t_perror("HAMLIB: listen socket bind failed");
+    close(server_socket);
+    server_socket = -1;
+    return NULL;
+  }
+
+  if (listen(server_socket, 3) < 0) {
+    t_perror("HAMLIB: listen failed");
+    close(server_socket);
+    server_socket = -1;
+    return NULL;
+  }
+
+  while (hamlib_running) {
+    int spare = -1;
+    int fd;
+    g_mutex_lock(&hamlib_mutex);
+
+    for (int id = 0; id < MAX_HAMLIB_CLIENTS; id++) {
+      if (!hamlib_client[id].busy) {
+        spare = id;
+        break;
+      }
+    }
+
+    g_mutex_unlock(&hamlib_mutex);
+
+    // if all slots are in use, wait and continue
+    if (spare < 0) {
+      usleep(100000L);
+      continue;
+    }
+
+    hamlib_client[spare].address_length = sizeof(struct sockaddr_in);
+    fd = accept(server_socket, (struct sockaddr*)&hamlib_client[spare].address,
+                &hamlib_client[spare].address_length);
+
+    if (fd < 0) {
+      // Since we have a 0.1 sec time-out, this is normal
+      continue;
+    }
+
+    t_print("%s: slot= %d connected with fd=%d\n", __FUNCTION__, spare, fd);
+
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO,  &tv, sizeof(tv)) < 0) {
+      t_perror("HamlibClntSetTimeOut");
+    }
+
+    //
+    // Replies are small and latency matters, so disable Nagle's algorithm
+    //
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void *)&on, sizeof(on)) < 0) {
+      t_perror("TCP_NODELAY");
+    }
+
+    g_mutex_lock(&hamlib_mutex);
+    hamlib_client[spare].fd      = fd;
+    hamlib_client[spare].busy    = 1;
+    hamlib_client[spare].running = 1;
+    hamlib_client[spare].seq     = spare;
+    hamlib_client[spare].vfo     = VFO_A;
+    hamlib_client[spare].vfo_opt = 0;
+    g_mutex_unlock(&hamlib_mutex);
+    g_thread_unref(g_thread_new("Hamlib listener", hamlib_listener, (gpointer)&hamlib_client[spare]));
+  }
+
+  if (server_socket >= 0) {
+    close(server_socket);
+    server_socket = -1;
+  }
+
+  return NULL;
+}
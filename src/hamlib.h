@@ -0,0 +1,38 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _HAMLIB_H
+#define _HAMLIB_H
+
+//
+// Built-in server for the Hamlib rigctld NET protocol, so that Hamlib
+// clients (WSJT-X, fldigi, ...) can use rig model 2 ("Hamlib NET rigctl")
+// without an external rigctld translating to the Kenwood dialect.
+//
+// VFO-A/VFO-B map to vfo[0]/vfo[1] and to receiver[0]/receiver[1].
+// Queries are answered from the radio state directly in the client
+// thread, commands that change the radio state are executed in the
+// GTK thread and acknowledged once they are done.
+//
+extern int hamlib_enable;
+extern int hamlib_port;   // usually 4532
+
+extern void launch_hamlib(void);
+extern void shutdown_hamlib(void);
+
+#endif
@@ -0,0 +1,416 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Scripted client test for the built-in Hamlib server (src/hamlib.c).
+ *
+ * The server runs against a stub radio with two VFOs, the main thread
+ * plays the GTK thread. A client thread connects via TCP and
+ *   - parses the dump_state reply the way Hamlib's NET rigctl backend
+ *     does, including the key=value list up to "done", and checks that
+ *     the next reply is still in step,
+ *   - gets and sets frequency, mode, PTT, split and levels in the normal
+ *     and the extended response formats,
+ *   - uses the VFO mode, several commands in one packet and "q",
+ *   - times get_freq round trips.
+ * Every state change must arrive in the GTK thread.
+ * The exit code is 0 if all checks pass.
+ *
+ * Build and run: make hamlib_test && ./hamlib_test
+ */
+
+#include <gtk/gtk.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ext.h"
+#include "filter.h"
+#include "hamlib.h"
+#include "message.h"
+#include "mode.h"
+#include "radio.h"
+#include "receiver.h"
+#include "rigctl.h"
+#include "sliders.h"
+#include "test_util.h"
+#include "vfo.h"
+
+static int port = 45320;
+static int rounds = 2000;                // get_freq round trips to time
+
+//
+// Stub radio
+//
+static DISCOVERED stub_radio;
+static RECEIVER stub_rx[2];
+static FILTER stub_filters[MODES][FILTERS];
+static double drive = 50.0;
+static int mox = 0;
+
+DISCOVERED *radio = &stub_radio;
+RECEIVER *receiver[8] = { &stub_rx[0], &stub_rx[1] };
+FILTER *filters[MODES];
+struct _vfo vfo[MAX_VFOS];
+int receivers = 1;
+int split = 0;
+int cw_keyer_speed = 22;
+int cat_control = 0;
+gboolean rigctl_debug = FALSE;
+
+static GThread *gtk_thread;
+static gint wrong_thread = 0;
+
+static void gtk_only(void) {
+  if (g_thread_self() != gtk_thread) { g_atomic_int_inc(&wrong_thread); }
+}
+
+int ext_vfo_update(void *data) { return G_SOURCE_REMOVE; }
+
+void radio_mox_update(int state) { gtk_only(); mox = state; }
+
+void radio_set_split(int v) { gtk_only(); split = v; }
+
+double radio_get_drive(void) { return drive; }
+
+int radio_is_transmitting(void) { return mox; }
+
+void set_af_gain(int rx, double value) { gtk_only(); }
+
+void set_drive(double d) { gtk_only(); drive = d; }
+
+void vfo_set_frequency(int v, long long f) { gtk_only(); vfo[v].frequency = f; }
+
+void vfo_id_mode_changed(int id, int m) { gtk_only(); vfo[id].mode = m; }
+
+void vfo_id_filter_changed(int id, int f) { gtk_only(); vfo[id].filter = f; }
+
+int vfo_get_tx_vfo(void) { return split ? VFO_B : VFO_A; }
+
+long long vfo_get_tx_freq(void) { return vfo[vfo_get_tx_vfo()].frequency; }
+
+static void stub_init(void) {
+  static const int width[filterVar1] = { 5000, 4000, 3000, 2700, 2400, 2100, 1800, 1000, 500, 250, 100, 50, 25, 10, 5 };
+  stub_radio.frequency_min = 0.0;
+  stub_radio.frequency_max = 61440000.0;
+  stub_rx[0].meter = -80.0;
+  stub_rx[0].volume = -6.0;
+  stub_rx[1].meter = -100.0;
+
+  for (int m = 0; m < MODES; m++) {
+    filters[m] = stub_filters[m];
+
+    for (int f = 0; f < FILTERS; f++) {
+      stub_filters[m][f].low = 100;
+      stub_filters[m][f].high = 100 + (f < filterVar1 ? width[f] : 2400);
+    }
+  }
+
+  vfo[VFO_A].frequency = 14074000;
+  vfo[VFO_A].mode = modeUSB;
+  vfo[VFO_B].frequency = 7074000;
+  vfo[VFO_B].mode = modeLSB;
+}
+
+//
+// Client side
+//
+typedef struct {
+  int  fd;
+  int  len;
+  char buf[4096];
+} CONN;
+
+static int conn_open(CONN *c) {
+  struct sockaddr_in addr;
+  struct timeval tv = { 2, 0 };
+  memset(c, 0, sizeof(CONN));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+
+  //
+  // the server thread needs a moment to bind
+  //
+  for (int i = 0; i < 50; i++) {
+    c->fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+      setsockopt(c->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+      return 1;
+    }
+
+    close(c->fd);
+    g_usleep(100000);
+  }
+
+  return 0;
+}
+
+static void conn_send(CONN *c, const char *str) {
+  if (send(c->fd, str, strlen(str), 0) < 0) { perror("send"); }
+}
+
+//
+// Read one line including the newline, return 0 on time-out or EOF
+//
+static int conn_line(CONN *c, char *line, int size) {
+  for (;;) {
+    char *eol = memchr(c->buf, '\n', c->len);
+
+    if (eol) {
+      int n = eol - c->buf + 1;
+
+      if (n >= size) { n = size - 1; }
+
+      memcpy(line, c->buf, n);
+      line[n] = 0;
+      c->len -= eol - c->buf + 1;
+      memmove(c->buf, eol + 1, c->len);
+      return 1;
+    }
+
+    if (c->len >= (int) sizeof(c->buf)) { c->len = 0; }
+
+    int n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+
+    if (n <= 0) { return 0; }
+
+    c->len += n;
+  }
+}
+
+//
+// Send a command and compare the reply with the expected one,
+// which has as many lines as it has newlines
+//
+static void query(CONN *c, const char *cmd, const char *expected) {
+  char reply[1024], line[256], what[128];
+  int lines = 0;
+  reply[0] = 0;
+
+  for (const char *p = expected; *p; p++) {
+    if (*p == '\n') { lines++; }
+  }
+
+  conn_send(c, cmd);
+
+  for (int i = 0; i < lines && conn_line(c, line, sizeof(line)); i++) {
+    g_strlcat(reply, line, sizeof(reply));
+  }
+
+  snprintf(what, sizeof(what), "%.*s", (int) strcspn(cmd, "\n"), cmd);
+
+  if (strcmp(reply, expected)) {
+    printf("got: \"%s\"\nexpected: \"%s\"\n", g_strescape(reply, NULL), g_strescape(expected, NULL));
+  }
+
+  check(!strcmp(reply, expected), what);
+}
+
+//
+// Parse dump_state as Hamlib's NET rigctl backend does
+//
+static void dump_state(CONN *c) {
+  char line[256];
+  int ok = 1;
+  int version, keys = 0, done = 0;
+  conn_send(c, "\\dump_state\n");
+  ok &= conn_line(c, line, sizeof(line));
+  version = atoi(line);
+  check(version >= 1, "dump_state: protocol version at least 1");
+  ok &= conn_line(c, line, sizeof(line));
+  check(atoi(line) == 2, "dump_state: rig model 2 (NET rigctl)");
+  ok &= conn_line(c, line, sizeof(line));    // ITU region
+
+  //
+  // RX and TX ranges, each list ends with seven zeros
+  //
+  for (int list = 0; list < 2; list++) {
+    int n = 0;
+
+    while (ok && (ok = conn_line(c, line, sizeof(line))) && strcmp(line, "0 0 0 0 0 0 0\n")) {
+      long long fmin, fmax;
+
+      if (sscanf(line, "%lld %lld", &fmin, &fmax) == 2 && fmax == 61440000) { n++; }
+    }
+
+    check(n == 1, list ? "dump_state: TX range" : "dump_state: RX range");
+  }
+
+  //
+  // tuning steps and filters, each list ends with "0 0"
+  //
+  for (int list = 0; list < 2; list++) {
+    while (ok && (ok = conn_line(c, line, sizeof(line))) && strcmp(line, "0 0\n")) {}
+  }
+
+  //
+  // max RIT, XIT, IF shift, announces, preamps, attenuators, six masks
+  //
+  for (int i = 0; i < 12; i++) { ok &= conn_line(c, line, sizeof(line)); }
+
+  check(ok && !strncmp(line, "0x", 2), "dump_state: fixed part complete");
+
+  if (version >= 1) {
+    while (conn_line(c, line, sizeof(line))) {
+      if (!strcmp(line, "done\n")) {
+        done = 1;
+        break;
+      }
+
+      if (strchr(line, '=')) { keys++; }
+    }
+
+    check(done && keys > 0, "dump_state: key=value list ends with done");
+  }
+
+  //
+  // the next reply must not be mixed up with left-overs
+  //
+  query(c, "f\n", "14074000\n");
+}
+
+static void latency(CONN *c) {
+  char line[256];
+  int ok = 1;
+  gint64 start = g_get_monotonic_time();
+
+  for (int i = 0; i < rounds && ok; i++) {
+    conn_send(c, "f\n");
+    ok = conn_line(c, line, sizeof(line));
+  }
+
+  printf("get_freq: %d round trips, %.1f us each\n", rounds,
+         (double)(g_get_monotonic_time() - start) / rounds);
+  check(ok, "get_freq: all round trips answered");
+}
+
+static gpointer client_thread(gpointer data) {
+  GMainLoop *loop = (GMainLoop *) data;
+  CONN c, c2;
+  char line[16];
+
+  if (!conn_open(&c)) {
+    check(0, "connect to the Hamlib server");
+    g_main_loop_quit(loop);
+    return NULL;
+  }
+
+  query(&c, "\\chk_vfo\n", "0\n");
+  dump_state(&c);
+  query(&c, "F 7074000.000000\n", "RPRT 0\n");
+  query(&c, "f\n", "7074000\n");
+  query(&c, "m\n", "USB\n5000\n");
+  query(&c, "M PKTUSB 2400\n", "RPRT 0\n");
+  query(&c, "m\n", "PKTUSB\n2400\n");
+  query(&c, "M FOO 0\n", "RPRT -1\n");
+  query(&c, "t\n", "0\n");
+  query(&c, "T 1\n", "RPRT 0\n");
+  query(&c, "t\n", "1\n");
+  query(&c, "\\set_ptt 0\n", "RPRT 0\n");
+  query(&c, "l STRENGTH\n", "-7\n");
+  query(&c, "l RFPOWER\n", "0.500000\n");
+  query(&c, "L RFPOWER 0.25\n", "RPRT 0\n");
+  query(&c, "l RFPOWER\n", "0.250000\n");
+  query(&c, "l KEYSPD\n", "22\n");
+  //
+  // extended response format
+  //
+  query(&c, "+f\n", "get_freq:\nFrequency: 7074000\nRPRT 0\n");
+  query(&c, "+\\get_mode\n", "get_mode:\nMode: PKTUSB\nPassband: 2400\nRPRT 0\n");
+  query(&c, "+F 14074000\n", "set_freq: 14074000\nRPRT 0\n");
+  query(&c, ";l STRENGTH\n", "get_level: STRENGTH;Level Value: -7;RPRT 0\n");
+  query(&c, "+\\foo\n", "RPRT -4\n");
+  //
+  // split, VFO B has no receiver
+  //
+  query(&c, "S 1 VFOB\n", "RPRT 0\n");
+  query(&c, "s\n", "1\nVFOB\n");
+  query(&c, "i\n", "7074000\n");
+  query(&c, "V VFOB\n", "RPRT 0\n");
+  query(&c, "v\n", "VFOB\n");
+  query(&c, "l STRENGTH\n", "RPRT -11\n");
+  query(&c, "f\n", "7074000\n");
+  //
+  // VFO mode
+  //
+  query(&c, "\\set_vfo_opt 1\n", "RPRT 0\n");
+  query(&c, "\\chk_vfo\n", "1\n");
+  query(&c, "f VFOA\n", "14074000\n");
+  query(&c, "F VFOB 3573000\n", "RPRT 0\n");
+  query(&c, "+f VFOB\n", "get_freq: VFOB\nFrequency: 3573000\nRPRT 0\n");
+  query(&c, "f\n", "RPRT -1\n");
+  //
+  // several commands in one packet
+  //
+  query(&c, "\\set_vfo_opt 0\nf\nm\n", "RPRT 0\n3573000\nLSB\n5000\n");
+  latency(&c);
+
+  //
+  // a second client, closed with "q"
+  //
+  if (conn_open(&c2)) {
+    query(&c2, "f\n", "14074000\n");
+    conn_send(&c2, "q\n");
+    check(recv(c2.fd, line, sizeof(line), 0) == 0, "q: server closes the connection");
+    close(c2.fd);
+  } else {
+    check(0, "second connection");
+  }
+
+  close(c.fd);
+  g_main_loop_quit(loop);
+  return NULL;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-port <port>] [-n <round trips>]\n", prog);
+  exit(8);
+}
+
+int main(int argc, char *argv[]) {
+  GMainLoop *loop;
+  GThread *thread;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-port") && i < argc - 1) { port = atoi(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-n")    && i < argc - 1) { rounds = atoi(argv[++i]); continue; }
+
+    usage(argv[0]);
+  }
+
+  if (port <= 0 || rounds < 1) { usage(argv[0]); }
+
+  stub_init();
+  gtk_thread = g_thread_self();
+  loop = g_main_loop_new(NULL, FALSE);
+  hamlib_port = port;
+  launch_hamlib();
+  thread = g_thread_new("Hamlib client", client_thread, loop);
+  g_main_loop_run(loop);
+  g_thread_join(thread);
+  shutdown_hamlib();
+  check(g_atomic_int_get(&wrong_thread) == 0, "state changes only in the GTK thread");
+  return test_result();
+}
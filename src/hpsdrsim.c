@@ -149,6 +149,21 @@ static int              hl2_tune = -1;
 static int              hl2_pa = -1;
 static int              hl2_tx_latency = 1;
 static int              hl2_ptt_hang = -1;
+
+//
+// Model of the HermesLite-II TX FIFO (samples at 48 kHz). During TX it is
+// filled with the TX IQ samples of each incoming packet, and once the TX
+// latency has been reached, it is drained at 48 kHz by the EP6 thread.
+// Filling level and under/overflows are reported in the C&C data (C3 of
+// address 0). The FIFO holds about 3600 samples.
+//
+#define HL2_FIFO_SIZE 3600
+static int              hl2_fifo = 0;
+static int              hl2_fifo_running = 0;
+static int              hl2_fifo_flag = 0;       // under/overflow since last report
+static int              hl2_fifo_underruns = 0;
+static int              hl2_fifo_overruns = 0;
+static pthread_mutex_t  hl2_fifo_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int              c25_ext_board_i2c_data = -1;
 static int              rx_adc[7] = {-1, -1, -1, -1, -1, -1, -1};
 static int              cw_hang = -1;
@@ -194,6 +209,7 @@ static int sock_udp;
  */
 static int enable_thread = 0;
 static int active_thread = 0;
+static int ep4_enable = 0;     // set if the START command asked for EP4 (bandscope) data
 
 static void process_ep2(uint8_t *frame);
 static void *handler_ep6(void *arg);
@@ -314,6 +330,9 @@ int main(int argc, char *argv[]) {
   noiseblank = 0;
   nb_pulse = 0;
   nb_width = 0;
+  sim_drop = 0;
+  sim_dup = 0;
+  sim_reorder = 0;
   const int MAC1 = 0x00;
   const int MAC2 = 0x1C;
   const int MAC3 = 0xC0;
@@ -323,6 +342,11 @@ int main(int argc, char *argv[]) {
   const int MAC6N = 0xEE; // P2
   OLDDEVICE = ODEV_ORION2;
   NEWDEVICE = NDEV_ORION2;
+  //
+  // Line-buffered output, such that the log can be followed through a pipe
+  // (this is what the mox_latency test does)
+  //
+  setvbuf(stdout, NULL, _IOLBF, 0);
 
   for (i = 1; i < argc; i++) {
     if (!strncmp(argv[i], "-atlas",        6))  {OLDDEVICE = ODEV_METIS;        NEWDEVICE = NDEV_ATLAS;         MAC5 = 0x11;             continue;}
@@ -359,6 +383,12 @@ int main(int argc, char *argv[]) {
 
     if (!strncmp(argv[i], "-slow",         5))  {speed = -1; continue;}
 
+    if (!strncmp(argv[i], "-drop",         5) && i < argc - 1)  {sim_drop = atoi(argv[++i]); continue;}
+
+    if (!strncmp(argv[i], "-dup",          4) && i < argc - 1)  {sim_dup = atoi(argv[++i]); continue;}
+
+    if (!strncmp(argv[i], "-reorder",      8) && i < argc - 1)  {sim_reorder = atoi(argv[++i]); continue;}
+
     if (!strncmp(argv[i], "-nb",           3))  {
       noiseblank = 1;
 
@@ -378,6 +408,7 @@ int main(int argc, char *argv[]) {
     t_print("                   -orion | -orion2 | -hermeslite | -hermeslite2 | -c25     |\n");
     t_print("                   -diversity | -P1 | -P2         | -fast        | -slow    |\n");
     t_print("                   -nb <num> <width>\n");
+    t_print("                   -drop <permille> | -dup <permille> | -reorder <permille>\n");
     exit(8);
   }
 
@@ -930,6 +961,8 @@ int main(int argc, char *argv[]) {
 
         // wrap-around of ring buffer
         if (txptr >= OLDRTXLEN) { txptr = 0; }
+
+        if (OLDDEVICE == ODEV_HERMES_LITE2) { hl2_fifo_put(126); }
       }
 
       break;
@@ -1039,6 +1072,8 @@ int main(int argc, char *argv[]) {
 
       while (active_thread) { usleep(1000); }
 
+      ep4_enable = (code >> 24) & 0x02;
+
       memset(&addr_old, 0, sizeof(addr_old));
       addr_old.sin_family = AF_INET;
       addr_old.sin_addr.s_addr = addr_from.sin_addr.s_addr;
@@ -1642,6 +1677,41 @@ void process_ep2(uint8_t *frame) {
   }
 }
 
+//
+// Send one bandscope frame, that is, 8 EP4 packets with 512 raw ADC samples
+// each. The sequence number of the first packet is a multiple of 8.
+//
+static void send_ep4_frame(SIM_IMPAIR *imp, unsigned int *seed) {
+  static uint32_t counter = 0;
+  static int16_t samples[8 * 512];
+  uint8_t buffer[1032];
+  sim_wideband_frame(samples, 8 * 512, seed);
+  buffer[0] = 0xEF;
+  buffer[1] = 0xFE;
+  buffer[2] = 0x01;
+  buffer[3] = 0x04;
+
+  for (int p = 0; p < 8; p++) {
+    buffer[4] = (counter >> 24) & 0xFF;
+    buffer[5] = (counter >> 16) & 0xFF;
+    buffer[6] = (counter >>  8) & 0xFF;
+    buffer[7] = (counter      ) & 0xFF;
+    counter++;
+
+    for (int i = 0; i < 512; i++) {
+      int16_t s = samples[512 * p + i];
+      buffer[8 + 2 * i] = s & 0xFF;
+      buffer[9 + 2 * i] = (s >> 8) & 0xFF;
+    }
+
+    if (sock_TCP_Client > -1) {
+      sendto(sock_TCP_Client, buffer, 1032, 0, (struct sockaddr *)&addr_old, sizeof(addr_old));
+    } else {
+      sim_sendto(imp, sock_udp, buffer, 1032, &addr_old);
+    }
+  }
+}
+
 void *handler_ep6(void *arg) {
   int i, j, k, n, size;
   int header_offset;
@@ -1667,7 +1737,13 @@ void *handler_ep6(void *arg) {
   double i1, q1, fac1, fac1a, fac2, fac3, fac4;
   unsigned int seed;
   int decimation;
+  long ep4_wait;
+  static SIM_IMPAIR impair;
+  static SIM_IMPAIR ep4_impair;
   seed = ((uintptr_t) &seed) & 0xffffff;
+  sim_impair_init(&impair, 1);
+  sim_impair_init(&ep4_impair, 4);
+  ep4_wait = 0;
   memcpy(buffer, id, 4);
   header_offset = 0;
   counter = 0;
@@ -1697,6 +1773,17 @@ void *handler_ep6(void *arg) {
       wait = 1000000L;
     }
 
+    if (OLDDEVICE == ODEV_HERMES_LITE2) {
+      //
+      // drain the TX FIFO by the number of 48k samples that correspond
+      // to the RX samples in this packet
+      //
+      static int hl2_acc = 0;
+      hl2_acc += 2 * n;
+      hl2_fifo_get(hl2_acc >> rate);
+      hl2_acc &= (1 << rate) - 1;
+    }
+
     // plug in sequence numbers
     buffer[4] = (counter >> 24) & 0xFF;
     buffer[5] = (counter >> 16) & 0xFF;
@@ -1783,9 +1870,9 @@ void *handler_ep6(void *arg) {
 
         if (OLDDEVICE == ODEV_HERMES_LITE2) {
           *(pointer + 4) = 0;
-          // C2/C3 is TX FIFO count
+          // C2/C3 is TX FIFO count, bit7 of C3 is the under/overflow flag
           *(pointer + 5) = 0;
-          *(pointer + 6) = 0;
+          *(pointer + 6) = hl2_fifo_report();
         }
 
         header_offset = 8;
@@ -1996,7 +2083,19 @@ void *handler_ep6(void *arg) {
         t_print( "TCP sendmsg error occurred at sequence number: %u !\n", counter);
       }
     } else {
-      sendto(sock_udp, buffer, 1032, 0, (struct sockaddr *)&addr_old, sizeof(addr_old));
+      sim_sendto(&impair, sock_udp, buffer, 1032, &addr_old);
+    }
+
+    //
+    // One bandscope frame every 50 msec
+    //
+    if (ep4_enable) {
+      ep4_wait += wait;
+
+      if (ep4_wait >= 50000000L) {
+        ep4_wait = 0;
+        send_ep4_frame(&ep4_impair, &seed);
+      }
     }
   }
 
@@ -2004,6 +2103,152 @@ void *handler_ep6(void *arg) {
   return NULL;
 }
 
+void hl2_fifo_put(int samples) {
+  pthread_mutex_lock(&hl2_fifo_mutex);
+
+  if (ptt) {
+    hl2_fifo += samples;
+
+    if (hl2_fifo > HL2_FIFO_SIZE) {
+      hl2_fifo = HL2_FIFO_SIZE;
+
+      if (!hl2_fifo_flag) { hl2_fifo_overruns++; }
+
+      hl2_fifo_flag = 1;
+    }
+  }
+
+  pthread_mutex_unlock(&hl2_fifo_mutex);
+}
+
+void hl2_fifo_get(int samples) {
+  pthread_mutex_lock(&hl2_fifo_mutex);
+
+  if (!ptt) {
+    if (hl2_fifo_underruns + hl2_fifo_overruns > 0) {
+      t_print("HL2 TX FIFO: %d underruns, %d overruns\n", hl2_fifo_underruns, hl2_fifo_overruns);
+    }
+
+    hl2_fifo = 0;
+    hl2_fifo_running = 0;
+    hl2_fifo_underruns = 0;
+    hl2_fifo_overruns = 0;
+  } else if (!hl2_fifo_running) {
+    // TX starts when the FIFO contains "TX latency" msec of samples
+    if (hl2_fifo >= 48 * hl2_tx_latency) { hl2_fifo_running = 1; }
+  } else {
+    hl2_fifo -= samples;
+
+    if (hl2_fifo < 0) {
+      hl2_fifo = 0;
+
+      if (!hl2_fifo_flag) { hl2_fifo_underruns++; }
+
+      hl2_fifo_flag = 1;
+    }
+  }
+
+  pthread_mutex_unlock(&hl2_fifo_mutex);
+}
+
+uint8_t hl2_fifo_report() {
+  uint8_t c3;
+  pthread_mutex_lock(&hl2_fifo_mutex);
+  c3 = (hl2_fifo / 32) & 0x7F;
+
+  if (hl2_fifo_flag) { c3 |= 0x80; }
+
+  hl2_fifo_flag = 0;
+  pthread_mutex_unlock(&hl2_fifo_mutex);
+  return c3;
+}
+
+void sim_impair_init(SIM_IMPAIR *imp, unsigned int seed) {
+  imp->seed = seed;
+  imp->held = 0;
+}
+
+//
+// sendto() with simulated packet loss, duplication and reordering.
+// The random numbers are seeded per stream, so a run can be reproduced.
+//
+int sim_sendto(SIM_IMPAIR *imp, int sock, const void *buf, size_t len, const struct sockaddr_in *to) {
+  int rc;
+
+  if (sim_drop > 0 && rand_r(&imp->seed) % 1000 < sim_drop) {
+    return len;
+  }
+
+  if (sim_reorder > 0 && imp->held == 0 && len <= sizeof(imp->buffer) && rand_r(&imp->seed) % 1000 < sim_reorder) {
+    memcpy(imp->buffer, buf, len);
+    imp->held = len;
+    return len;
+  }
+
+  rc = sendto(sock, buf, len, 0, (const struct sockaddr *)to, sizeof(struct sockaddr_in));
+
+  if (imp->held > 0) {
+    sendto(sock, imp->buffer, imp->held, 0, (const struct sockaddr *)to, sizeof(struct sockaddr_in));
+    imp->held = 0;
+  }
+
+  if (sim_dup > 0 && rand_r(&imp->seed) % 1000 < sim_dup) {
+    sendto(sock, buf, len, 0, (const struct sockaddr *)to, sizeof(struct sockaddr_in));
+  }
+
+  return rc;
+}
+
+//
+// A few carriers (broadcast, ham bands, a 6m beacon) on top of white noise.
+// The carriers are generated by rotating phasors, starting with a random phase.
+//
+static const double sim_wide_carrier[][2] = {
+  // frequency (Hz), amplitude (relative to full scale)
+  {  1008000.0, 0.05   },
+  {  3650000.0, 0.005  },
+  {  6075000.0, 0.02   },
+  {  7100000.0, 0.01   },
+  {  9650000.0, 0.02   },
+  { 14200000.0, 0.003  },
+  { 21300000.0, 0.001  },
+  { 28500000.0, 0.0005 },
+  { 50100000.0, 0.0002 },
+};
+
+#define SIM_WIDE_CARRIERS (int)(sizeof(sim_wide_carrier) / sizeof(sim_wide_carrier[0]))
+
+void sim_wideband_frame(int16_t *samples, int n, unsigned int *seed) {
+  double re[SIM_WIDE_CARRIERS], im[SIM_WIDE_CARRIERS];
+  double cs[SIM_WIDE_CARRIERS], sn[SIM_WIDE_CARRIERS];
+
+  for (int k = 0; k < SIM_WIDE_CARRIERS; k++) {
+    double phase = 6.283185307179586476925286766559 * rand_r(seed) / RAND_MAX;
+    double step = 6.283185307179586476925286766559 * sim_wide_carrier[k][0] / SIM_ADC_RATE;
+    re[k] = 32767.0 * sim_wide_carrier[k][1] * cos(phase);
+    im[k] = 32767.0 * sim_wide_carrier[k][1] * sin(phase);
+    cs[k] = cos(step);
+    sn[k] = sin(step);
+  }
+
+  for (int i = 0; i < n; i++) {
+    double s = (double)((int)(rand_r(seed) & 0xFFFF) - 32768) * (8.0 / 32768.0);  // +/- 8 LSB
+
+    for (int k = 0; k < SIM_WIDE_CARRIERS; k++) {
+      double r = re[k] * cs[k] - im[k] * sn[k];
+      im[k] = re[k] * sn[k] + im[k] * cs[k];
+      re[k] = r;
+      s += r;
+    }
+
+    if (s > 32767.0) { s = 32767.0; }
+
+    if (s < -32768.0) { s = -32768.0; }
+
+    samples[i] = (int16_t) lrint(s);
+  }
+}
+
 void t_print(const char *format, ...) {
   va_list(args);
   va_start(args, format);
@@ -114,6 +114,39 @@ EXTERN struct sockaddr_in addr_old;
 //
 EXTERN double c1, c2, maxpwr;
 
+//
+// Network impairments, used to test the packet loss detection and
+// concealment of the SDR program. The probabilities (in units of 1/1000)
+// that an outgoing data packet is dropped, sent twice, or held back and
+// sent after the next one.
+//
+EXTERN int sim_drop;
+EXTERN int sim_dup;
+EXTERN int sim_reorder;
+
+//
+// One of these for each outgoing packet stream
+//
+typedef struct _sim_impair {
+  unsigned int  seed;
+  size_t        held;                     // length of the packet held back, 0 if none
+  unsigned char buffer[1444];
+} SIM_IMPAIR;
+
+void    hl2_fifo_put(int samples);
+void    hl2_fifo_get(int samples);
+uint8_t hl2_fifo_report(void);
+
+void   sim_impair_init(SIM_IMPAIR *imp, unsigned int seed);
+int    sim_sendto(SIM_IMPAIR *imp, int sock, const void *buf, size_t len, const struct sockaddr_in *to);
+
+//
+// Synthetic raw ADC samples (122.88 MHz) for the wideband (bandscope) data,
+// used by both protocols. The frames are not contiguous in time.
+//
+#define SIM_ADC_RATE 122880000.0
+void   sim_wideband_frame(int16_t *samples, int n, unsigned int *seed);
+
 //
 // Forward declarations for new protocol stuff
 //
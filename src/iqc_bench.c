@@ -0,0 +1,211 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Benchmark for the PureSignal IQ corrector of WDSP (iqc.c).
+ *
+ * While PureSignal corrects, xiqc() is in the RUN state and processes
+ * each block in separate passes. This program sets up an IQC as TXA.c
+ * does (16 intervals, 256 samples per interval) at the PureSignal rate
+ * of 192 kHz, loads a smooth amplitude and phase correction and feeds
+ * 10 s of enveloped two-tone IQ, in blocks of 1024 and 4096 samples.
+ * A copy of the former per-sample RUN loop runs side by side and
+ *   - the outputs must agree to within -maxerr relative to the largest
+ *     output sample,
+ *   - the watchdog counts may differ by at most one round.
+ * The CPU time of both is printed for information only, since it depends
+ * on the machine and its load. The exit code is 0 if all checks pass.
+ *
+ * Build and run: make iqc_bench && ./iqc_bench
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comm.h"
+#include "test_util.h"
+
+#define IQC_RATE   192000
+#define IQC_INTS   16                    // TXA.c
+#define IQC_TUP    0.005                 // TXA.c
+#define IQC_SPI    256                   // TXA.c
+
+static double duration = 10.0;           // seconds of IQ
+static double max_err = 1.0e-12;         // allowed difference relative to the largest output sample
+
+//
+// Correction: gain 1 + 0.1 env^2, phase 0.2 env. The cubic of each interval
+// is the Taylor expansion around its start, as the spline fit would give.
+//
+static void load_correction(IQC a) {
+  for (int k = 0; k < a->ints; k++) {
+    double x = a->t[k];
+    double *cm = a->cm[a->cset] + 4 * k;
+    double *cc = a->cc[a->cset] + 4 * k;
+    double *cs = a->cs[a->cset] + 4 * k;
+    double p = 0.2 * x;
+    cm[0] = 1.0 + 0.1 * x * x;
+    cm[1] = 0.2 * x;
+    cm[2] = 0.1;
+    cm[3] = 0.0;
+    cc[0] = cos(p);
+    cc[1] = -0.2 * sin(p);
+    cc[2] = -0.02 * cos(p);
+    cc[3] = 0.008 / 6.0 * sin(p);
+    cs[0] = sin(p);
+    cs[1] = 0.2 * cos(p);
+    cs[2] = -0.02 * sin(p);
+    cs[3] = -0.008 / 6.0 * cos(p);
+  }
+}
+
+//
+// The former RUN path of xiqc(), one sample at a time, with its own watchdog
+//
+typedef struct {
+  int cpi[IQC_INTS];
+  int full_ints;
+  int count;
+} REF_DOG;
+
+static void ref_xiqc(IQC a, REF_DOG *dog, const double *in, double *out) {
+  int cset = a->cset;
+
+  for (int i = 0; i < a->size; i++) {
+    double I = in[2 * i + 0];
+    double Q = in[2 * i + 1];
+    double env = sqrt (I * I + Q * Q);
+    double dx, ym, yc, ys;
+    const double *cm, *cc, *cs;
+    int k;
+
+    if ((k = (int)(env * a->ints)) > a->ints - 1) { k = a->ints - 1; }
+
+    dx = env - a->t[k];
+    cm = a->cm[cset] + 4 * k;
+    cc = a->cc[cset] + 4 * k;
+    cs = a->cs[cset] + 4 * k;
+    ym = cm[0] + dx * (cm[1] + dx * (cm[2] + dx * cm[3]));
+    yc = cc[0] + dx * (cc[1] + dx * (cc[2] + dx * cc[3]));
+    ys = cs[0] + dx * (cs[1] + dx * (cs[2] + dx * cs[3]));
+    out[2 * i + 0] = ym * (I * yc - Q * ys);
+    out[2 * i + 1] = ym * (I * ys + Q * yc);
+
+    if (dog->cpi[k] != IQC_SPI)
+      if (++dog->cpi[k] == IQC_SPI) {
+        dog->full_ints++;
+      }
+
+    if (dog->full_ints == a->ints) {
+      ++dog->count;
+      dog->full_ints = 0;
+      memset (dog->cpi, 0, sizeof (dog->cpi));
+    }
+  }
+}
+
+//
+// Two-tone envelope on a 1.5 kHz carrier with some amplitude noise
+//
+static double *make_signal(long n) {
+  double *iq = malloc(2 * n * sizeof(double));
+  unsigned int seed = 3;
+
+  for (long k = 0; k < n; k++) {
+    double t = (double) k / IQC_RATE;
+    double env = 0.5 + 0.45 * sin(TWOPI * 700.0 * t) * sin(TWOPI * 1900.0 * t);
+    env *= 0.9 + 0.1 * (double) rand_r(&seed) / RAND_MAX;
+
+    if (env > 1.0) { env = 1.0; }
+
+    iq[2 * k + 0] = env * cos(TWOPI * 1500.0 * t);
+    iq[2 * k + 1] = env * sin(TWOPI * 1500.0 * t);
+  }
+
+  return iq;
+}
+
+static void run_size(int size, const double *iq, long n) {
+  int nb = (int)(n / size);
+  double *buf = malloc(2 * size * sizeof(double));
+  double *ref = malloc(2 * size * sizeof(double));
+  double err = 0.0, peak = 0.0, t_new = 0.0, t_ref = 0.0, start;
+  REF_DOG dog;
+  char what[128];
+  IQC a = create_iqc(1, size, buf, buf, (double) IQC_RATE, IQC_INTS, IQC_TUP, IQC_SPI);
+  a->state = 0;                          // RUN
+  load_correction(a);
+  memset(&dog, 0, sizeof(dog));
+
+  for (int b = 0; b < nb; b++) {
+    const double *in = iq + 2L * size * b;
+    memcpy(buf, in, 2 * size * sizeof(double));
+    start = now();
+    xiqc(a);
+    t_new += now() - start;
+    start = now();
+    ref_xiqc(a, &dog, in, ref);
+    t_ref += now() - start;
+
+    for (int k = 0; k < 2 * size; k++) {
+      if (fabs(buf[k] - ref[k]) > err) { err = fabs(buf[k] - ref[k]); }
+
+      if (fabs(ref[k]) > peak) { peak = fabs(ref[k]); }
+    }
+  }
+
+  snprintf(what, sizeof(what), "size %d: max difference %.2g of %.2g", size, err, peak);
+  check(err <= max_err * peak, what);
+  snprintf(what, sizeof(what), "size %d: watchdog rounds %d, reference %d", size, a->dog.count, dog.count);
+  check(abs(a->dog.count - dog.count) <= 1 && dog.count > 0, what);
+  snprintf(what, sizeof(what), "size %d: CPU for %.0f s: %.2f ms, reference %.2f ms (x%.2f)",
+           size, duration, 1.0e3 * t_new, 1.0e3 * t_ref, t_ref / t_new);
+  printf("%s\n", what);
+  destroy_iqc(a);
+  free(buf);
+  free(ref);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-t <seconds>] [-maxerr <relative error>]\n", prog);
+  exit(8);
+}
+
+int main(int argc, char *argv[]) {
+  double *iq;
+  long n;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-t")      && i < argc - 1) { duration = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-maxerr") && i < argc - 1) { max_err = atof(argv[++i]); continue; }
+
+    usage(argv[0]);
+  }
+
+  if (duration < 1.0 || max_err < 0.0) { usage(argv[0]); }
+
+  n = (long)(duration * IQC_RATE);
+  iq = make_signal(n);
+  run_size(1024, iq, n);
+  run_size(4096, iq, n);
+  free(iq);
+  return test_result();
+}
@@ -377,30 +377,7 @@ gboolean keypress_cb(GtkWidget *widget, GdkEventKey *event, gpointer data) {
 
   case GDK_KEY_r:
     // toggle NR
-#ifdef EXTNR
-    if (active_receiver->nr == 0) {
-      active_receiver->nr = 1;
-    } else if (active_receiver->nr == 1) {
-      active_receiver->nr = 2;
-    } else if (active_receiver->nr == 2) {
-      active_receiver->nr = 3;
-    } else if (active_receiver->nr == 3) {
-      active_receiver->nr = 4;
-    } else {
-      active_receiver->nr = 0;
-    }
-
-#else
-
-    if (active_receiver->nr == 0) {
-      active_receiver->nr = 1;
-    } else if (active_receiver->nr == 1) {
-      active_receiver->nr = 2;
-    } else {
-      active_receiver->nr = 0;
-    }
-
-#endif
+    active_receiver->nr = rx_next_nr(active_receiver->nr);
     update_noise();
     break;
 
@@ -767,9 +744,6 @@ static void activate_deskhpsdr(GtkApplication *app, gpointer data) {
   */
   // Hier setzen wir den GTK-Mainloop-Thread
   deskhpsdr_main_thread = pthread_self();
-  g_mutex_init(&vfo_timer.lock);
-  g_mutex_init(&vfoa_timer.lock);
-  g_mutex_init(&vfob_timer.lock);
   char text[2048];
   char config_directory[1024];
   (void) getcwd(config_directory, sizeof(config_directory));
@@ -1005,9 +979,6 @@ int main(int argc, char **argv) {
   rc = g_application_run(G_APPLICATION(deskhpsdr), argc, argv);
   t_print("exiting ...\n");
   g_object_unref(deskhpsdr);
-  g_mutex_clear(&vfo_timer.lock);
-  g_mutex_clear(&vfoa_timer.lock);
-  g_mutex_clear(&vfob_timer.lock);
   return rc;
 }
 
@@ -129,6 +129,7 @@ void NewMidiEvent(enum MIDIevent event, int channel, int note, int val);
 int ReadLegacyMidiFile(char *filename);
 void MidiAddCommand(int note, struct desc *desc);
 void MidiReleaseCommands(void);
+void MidiBuildLookup(void);
 
 //
 // Layer-3 entry point (called by Layer2). In Layer-3, all the deskhpsdr
@@ -139,15 +140,4 @@ void MidiReleaseCommands(void);
 
 void DoTheMidi(int code, enum ACTIONtype type, int val);
 
-typedef struct _vfo_timer {
-  int action;
-  int val;
-  guint timeout;
-  GMutex lock;
-} VFO_TIMER;
-
-extern VFO_TIMER vfo_timer;
-extern VFO_TIMER vfoa_timer;
-extern VFO_TIMER vfob_timer;
-
 #endif
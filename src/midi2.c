@@ -50,6 +50,40 @@
 
 struct desc *MidiCommandsTable[129];
 
+//
+// Flat lookup table, directly indexed by event, channel and note. Each entry
+// points to the matching command in MidiCommandsTable (or is NULL), so
+// NewMidiEvent() does not have to walk the linked lists for each MIDI message.
+// A command for the channel takes precedence over an ANY-channel command,
+// wherever the latter is in the list (the MIDI menu may change the channel
+// of a command in place).
+// It must be re-built whenever MidiCommandsTable changes.
+//
+static struct desc *MidiLookup[3][16][129];
+
+void MidiBuildLookup() {
+  for (int e = 0; e < 3; e++) {
+    for (int chan = 0; chan < 16; chan++) {
+      for (int note = 0; note < 129; note++) {
+        struct desc *desc = MidiCommandsTable[note];
+        struct desc *any = NULL;
+
+        while (desc) {
+          if (desc->event == MIDI_NOTE + e) {
+            if (desc->channel == chan) { break; }
+
+            if (desc->channel == -1 && any == NULL) { any = desc; }
+          }
+
+          desc = desc->next;
+        }
+
+        MidiLookup[e][chan][note] = desc ? desc : any;
+      }
+    }
+  }
+}
+
 void NewMidiEvent(enum MIDIevent event, int channel, int note, int val) {
   struct desc *desc;
   int new;
@@ -65,72 +99,67 @@ void NewMidiEvent(enum MIDIevent event, int channel, int note, int val) {
     return;
   }
 
+  if (event < MIDI_NOTE || event > MIDI_PITCH || channel < 0 || channel > 15) {
+    return;
+  }
+
   if (event == MIDI_PITCH) {
-    desc = MidiCommandsTable[128];
-  } else {
-    desc = MidiCommandsTable[note];
+    note = 128;
+  } else if (note < 0 || note > 127) {
+    return;
   }
 
-  //t_print("%s: init DESC=%p\n",__FUNCTION__,desc);
-  while (desc) {
-    //t_print("%s: DESC=%p next=%p CHAN=%d EVENT=%d\n",__FUNCTION__,desc,desc->next,desc->channel,desc->event);
-    if ((desc->channel == channel || desc->channel == -1) && (desc->event == event)) {
-      // Found matching entry
-      switch (desc->event) {
-      case EVENT_NONE:
-        // this cannot happen
-        t_print("%s: Unknown Event\n", __FUNCTION__);
-        break;
+  desc = MidiLookup[event - MIDI_NOTE][channel][note];
 
-      case MIDI_NOTE:
-        DoTheMidi(desc->action, desc->type, val);
-        break;
+  if (desc) {
+    switch (desc->event) {
+    case EVENT_NONE:
+      // this cannot happen
+      t_print("%s: Unknown Event\n", __FUNCTION__);
+      break;
 
-      case MIDI_CTRL:
-        if (desc->type == MIDI_KNOB) {
-          // CHANGED Jan 2024: report the "raw" value (0-127) upstream
-          DoTheMidi(desc->action, desc->type, val);
-        } else if (desc->type == MIDI_WHEEL) {
-          // translate value to direction/speed
-          new = 0;
+    case MIDI_NOTE:
+      DoTheMidi(desc->action, desc->type, val);
+      break;
 
-          if ((val >= desc->vfl1) && (val <= desc->vfl2)) { new = -16; }
+    case MIDI_CTRL:
+      if (desc->type == MIDI_KNOB) {
+        // CHANGED Jan 2024: report the "raw" value (0-127) upstream
+        DoTheMidi(desc->action, desc->type, val);
+      } else if (desc->type == MIDI_WHEEL) {
+        // translate value to direction/speed
+        new = 0;
 
-          if ((val >= desc-> fl1) && (val <= desc-> fl2)) { new = -4; }
+        if ((val >= desc->vfl1) && (val <= desc->vfl2)) { new = -16; }
 
-          if ((val >= desc->lft1) && (val <= desc->lft2)) { new = -1; }
+        if ((val >= desc-> fl1) && (val <= desc-> fl2)) { new = -4; }
 
-          if ((val >= desc->rgt1) && (val <= desc->rgt2)) { new = 1; }
+        if ((val >= desc->lft1) && (val <= desc->lft2)) { new = -1; }
 
-          if ((val >= desc-> fr1) && (val <= desc-> fr2)) { new = 4; }
+        if ((val >= desc->rgt1) && (val <= desc->rgt2)) { new = 1; }
 
-          if ((val >= desc->vfr1) && (val <= desc->vfr2)) { new = 16; }
+        if ((val >= desc-> fr1) && (val <= desc-> fr2)) { new = 4; }
 
-          //                      t_print("%s: WHEEL PARAMS: val=%d new=%d thrs=%d/%d, %d/%d, %d/%d, %d/%d, %d/%d, %d/%d\n",
-          //                               __FUNCTION__,
-          //                               val, new, desc->vfl1, desc->vfl2, desc->fl1, desc->fl2, desc->lft1, desc->lft2,
-          //                               desc->rgt1, desc->rgt2, desc->fr1, desc->fr2, desc->vfr1, desc->vfr2);
-          if (new != 0) { DoTheMidi(desc->action, desc->type, new); }
-        }
+        if ((val >= desc->vfr1) && (val <= desc->vfr2)) { new = 16; }
 
-        break;
+        //                      t_print("%s: WHEEL PARAMS: val=%d new=%d thrs=%d/%d, %d/%d, %d/%d, %d/%d, %d/%d, %d/%d\n",
+        //                               __FUNCTION__,
+        //                               val, new, desc->vfl1, desc->vfl2, desc->fl1, desc->fl2, desc->lft1, desc->lft2,
+        //                               desc->rgt1, desc->rgt2, desc->fr1, desc->fr2, desc->vfr1, desc->vfr2);
+        if (new != 0) { DoTheMidi(desc->action, desc->type, new); }
+      }
 
-      case MIDI_PITCH:
-        if (desc->type == MIDI_KNOB) {
-          // use upper 7  bits
-          DoTheMidi(desc->action, desc->type, val >> 7);
-        }
+      break;
 
-        break;
+    case MIDI_PITCH:
+      if (desc->type == MIDI_KNOB) {
+        // use upper 7  bits
+        DoTheMidi(desc->action, desc->type, val >> 7);
       }
 
       break;
-    } else {
-      desc = desc->next;
     }
-  }
-
-  if (!desc) {
+  } else {
     // Nothing found. This is nothing to worry about, but log the key to stderr
     if (event == MIDI_PITCH) { t_print("%s: Unassigned PitchBend Value=%d\n", __FUNCTION__, val); }
 
@@ -147,6 +176,7 @@ void NewMidiEvent(enum MIDIevent event, int channel, int note, int val) {
 void MidiReleaseCommands() {
   int i;
   struct desc *loop, *new;
+  memset(MidiLookup, 0, sizeof(MidiLookup));
 
   for (i = 0; i < 129; i++) {
     loop = MidiCommandsTable[i];
@@ -190,6 +220,8 @@ void MidiAddCommand(int note, struct desc *desc) {
 
     loop->next = desc;
   }
+
+  MidiBuildLookup();
 }
 
 #if 0
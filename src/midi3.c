@@ -36,80 +36,139 @@
 #include "rigctl.h"
 #include "midi.h"
 
-VFO_TIMER vfo_timer  = { VFO,  0, 0, {0} };
-VFO_TIMER vfoa_timer = { VFOA, 0, 0, {0} };
-VFO_TIMER vfob_timer = { VFOB, 0, 0, {0} };
-
-static int vfo_timeout_cb(gpointer data) {
-  VFO_TIMER *timer = (VFO_TIMER *)data;
-  g_mutex_lock(&timer->lock);
-  t_print("%s: action=%d val=%d\n", __FUNCTION__, timer->action, timer->val);
-  schedule_action(timer->action, RELATIVE, timer->val);
-  timer->timeout = 0;
-  timer->val = 0;
-  g_mutex_unlock(&timer->lock);
-  return FALSE;
+//
+// Knobs and wheels, in particular "big wheels" and high-resolution
+// controllers, can produce MIDI events at a rate that would flood the GTK
+// main loop if each event were scheduled as an action. Therefore, these
+// events are coalesced per action: for a knob the latest value wins, for a
+// wheel the relative changes are summed up. The MIDI threads only update
+// the slots (lock-free, using atomics), and the first event that finds a
+// slot empty triggers a flush. The flush runs in the GTK idle loop, but not
+// more often than every MIDI_FLUSH_INTERVAL msec, so an isolated event is
+// processed at once while a fast-turning wheel leads to one (consolidated)
+// action per interval.
+//
+// Keys (press/release) are never coalesced.
+//
+#define MIDI_FLUSH_INTERVAL 50  // msec
+
+typedef struct _midi_slot {
+  gint pending;
+  gint val;                     // KNOB: latest value, WHEEL: accumulated change
+} MIDI_SLOT;
+
+static MIDI_SLOT knob_slot[ACTIONS];
+static MIDI_SLOT wheel_slot[ACTIONS];
+static gint flush_scheduled = 0;
+static gint last_flush = 0;     // msec, wraps around
+
+//
+// statistics
+//
+static gint midi_events = 0;
+static int midi_actions = 0;
+static int midi_flushes = 0;
+static gint64 midi_report = 0;
+
+static gint midi_msec() {
+  return (gint)(g_get_monotonic_time() / 1000);
 }
 
-void DoTheMidi(int action, enum ACTIONtype type, int val) {
-  switch (type) {
-  case MIDI_KEY:
-    //t_print("%s: action=%d val=%d\n", __FUNCTION__, action, val);
-    schedule_action(action, val ? PRESSED : RELEASED, 0);
-    break;
+static int midi_flush_cb(gpointer data) {
+  gint64 now = g_get_monotonic_time();
+  g_atomic_int_set(&last_flush, (gint)(now / 1000));
+  //
+  // Clear the flag before draining: an event that arrives
+  // while draining schedules the next flush
+  //
+  g_atomic_int_set(&flush_scheduled, 0);
+  midi_flushes++;
+
+  for (int action = 0; action < ACTIONS; action++) {
+    MIDI_SLOT *slot = &knob_slot[action];
+
+    if (g_atomic_int_get(&slot->pending)) {
+      g_atomic_int_set(&slot->pending, 0);
+      schedule_action(action, ABSOLUTE, g_atomic_int_get(&slot->val));
+      midi_actions++;
+    }
 
-  case MIDI_KNOB:
-    //t_print("%s: action=%d val=%d\n", __FUNCTION__, action, val);
-    schedule_action(action, ABSOLUTE, val);
-    break;
+    slot = &wheel_slot[action];
 
-  case MIDI_WHEEL:
+    if (g_atomic_int_get(&slot->pending)) {
+      int val;
+      g_atomic_int_set(&slot->pending, 0);
+
+      do {
+        val = g_atomic_int_get(&slot->val);
+      } while (!g_atomic_int_compare_and_exchange(&slot->val, val, 0));
+
+      if (val != 0) {
+        if (rigctl_debug) { t_print("%s: action=%d val=%d\n", __FUNCTION__, action, val); }
 
-    //
-    // There are "big wheels" at various MIDI consoles that can produce MIDI events
-    // with rather high frequency, and these are usually used for VFO, VFOA, VFOB
-    // Therefore, these events are filtererd out here in a way that several such events
-    // lead to a single scheduled action with a "consolidated" value. The idea is, that
-    // turning the VFO knob fast will only generate one VFO update every 100 msec.
-    //
-    switch (action) {
-    case VFOA:
-      g_mutex_lock(&vfoa_timer.lock);
-      vfoa_timer.val += val;
-
-      if (vfoa_timer.timeout == 0) {
-        vfoa_timer.timeout = g_timeout_add(100, vfo_timeout_cb, &vfoa_timer);
+        schedule_action(action, RELATIVE, val);
+        midi_actions++;
       }
+    }
+  }
 
-      g_mutex_unlock(&vfoa_timer.lock);
-      break;
+  if (now >= midi_report) {
+    int events = g_atomic_int_get(&midi_events);
+    g_atomic_int_add(&midi_events, -events);
 
-    case VFOB:
-      g_mutex_lock(&vfob_timer.lock);
-      vfob_timer.val += val;
+    if (midi_report != 0 && events > 0) {
+      t_print("%s: %d knob/wheel events, %d flushes, %d actions in the last 5 minutes\n",
+              __FUNCTION__, events, midi_flushes, midi_actions);
+    }
 
-      if (vfob_timer.timeout == 0) {
-        vfob_timer.timeout = g_timeout_add(100, vfo_timeout_cb, &vfob_timer);
-      }
+    midi_report = now + 300000000LL;
+    midi_flushes = 0;
+    midi_actions = 0;
+  }
 
-      g_mutex_unlock(&vfob_timer.lock);
-      break;
+  return G_SOURCE_REMOVE;
+}
 
-    case VFO:
-      g_mutex_lock(&vfo_timer.lock);
-      vfo_timer.val += val;
+static void midi_schedule_flush() {
+  if (g_atomic_int_compare_and_exchange(&flush_scheduled, 0, 1)) {
+    gint elapsed = (gint)((guint)midi_msec() - (guint)g_atomic_int_get(&last_flush));
 
-      if (vfo_timer.timeout == 0) {
-        vfo_timer.timeout = g_timeout_add(100, vfo_timeout_cb, &vfo_timer);
-      }
+    if (elapsed >= 0 && elapsed < MIDI_FLUSH_INTERVAL) {
+      g_timeout_add(MIDI_FLUSH_INTERVAL - elapsed, midi_flush_cb, NULL);
+    } else {
+      g_idle_add(midi_flush_cb, NULL);
+    }
+  }
+}
 
-      g_mutex_unlock(&vfo_timer.lock);
-      break;
+void DoTheMidi(int action, enum ACTIONtype type, int val) {
+  if (action < 0 || action >= ACTIONS) {
+    return;
+  }
 
-    default:
-      if (rigctl_debug) { t_print("%s: action=%d val=%d\n", __FUNCTION__, action, val); }
+  switch (type) {
+  case MIDI_KEY:
+    //t_print("%s: action=%d val=%d\n", __FUNCTION__, action, val);
+    schedule_action(action, val ? PRESSED : RELEASED, 0);
+    break;
+
+  case MIDI_KNOB:
+    //t_print("%s: action=%d val=%d\n", __FUNCTION__, action, val);
+    g_atomic_int_set(&knob_slot[action].val, val);
+    g_atomic_int_inc(&midi_events);
+
+    if (g_atomic_int_compare_and_exchange(&knob_slot[action].pending, 0, 1)) {
+      midi_schedule_flush();
+    }
+
+    break;
+
+  case MIDI_WHEEL:
+    g_atomic_int_add(&wheel_slot[action].val, val);
+    g_atomic_int_inc(&midi_events);
 
-      schedule_action(action, RELATIVE, val);
+    if (g_atomic_int_compare_and_exchange(&wheel_slot[action].pending, 0, 1)) {
+      midi_schedule_flush();
     }
 
     break;
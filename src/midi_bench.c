@@ -0,0 +1,260 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Replay benchmark for the MIDI layers 2 and 3 (src/midi2.c, src/midi3.c).
+ *
+ * A controller map with 60 knobs and some ANY-channel entries is set up via
+ * MidiAddCommand(), then
+ *   - the lookup precedence (channel entries before ANY-channel entries) is
+ *     checked,
+ *   - the hot path NewMidiEvent() -> lookup -> coalescing slot is timed
+ *     without a running main loop,
+ *   - a controller session is replayed in real time: a jog wheel and a knob
+ *     sending 1000 messages per second each, plus a key every 100 msec,
+ *     while the main loop runs the flushes.
+ * The replay must deliver the wheel movement without loss, the last knob
+ * value and all key presses, with far fewer actions than MIDI messages.
+ * The exit code is 0 if all checks pass.
+ *
+ * Build and run: make midi_bench && ./midi_bench
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "actions.h"
+#include "midi.h"
+#include "test_util.h"
+
+gboolean rigctl_debug = FALSE;
+int midiIgnoreCtrlPairs = 0;
+
+static long hot_events = 20000000;       // messages for the hot path timing
+static double replay_time = 2.0;         // seconds of replayed controller session
+static int rate = 1000;                  // messages per second, wheel and knob each
+
+//
+// schedule_action() is the exit of layer 3, count what arrives there
+//
+static long actions = 0;
+static long wheel_sum = 0;
+static long keys = 0;
+static int last_knob = -1;
+static int last_action = -1;
+
+void schedule_action(enum ACTION action, enum ACTION_MODE mode, int val) {
+  actions++;
+  last_action = action;
+
+  switch (action) {
+  case VFO:
+    wheel_sum += val;
+    break;
+
+  case AF_GAIN:
+    last_knob = val;
+    break;
+
+  case MOX:
+    if (mode == PRESSED) { keys++; }
+
+    break;
+
+  default:
+    break;
+  }
+}
+
+static struct desc *new_desc(int channel, enum MIDIevent event, enum ACTIONtype type, int action) {
+  struct desc *desc = (struct desc *) malloc(sizeof(struct desc));
+  memset(desc, 0, sizeof(struct desc));
+  desc->channel = channel;
+  desc->event = event;
+  desc->type = type;
+  desc->action = action;
+  desc->vfl1 = desc->vfl2 = desc->fl1 = desc->fl2 = -1;
+  desc->vfr1 = desc->vfr2 = desc->fr1 = desc->fr2 = -1;
+  desc->lft1 = 0;
+  desc->lft2 = 63;
+  desc->rgt1 = 65;
+  desc->rgt2 = 127;
+  return desc;
+}
+
+static void drain(void) {
+  //
+  // wait for the flush interval to pass and run all pending flushes
+  //
+  for (int i = 0; i < 3; i++) {
+    g_usleep(60000);
+
+    while (g_main_context_iteration(NULL, FALSE)) {}
+  }
+}
+
+static void reset_counters(void) {
+  actions = wheel_sum = keys = 0;
+  last_knob = last_action = -1;
+}
+
+//
+// Real-time controller session, running in its own thread as the MIDI
+// input thread does
+//
+static gint replay_done = 0;
+static long replay_messages = 0;
+static long replay_wheel = 0;
+static long replay_keys = 0;
+static int replay_last_knob = -1;
+
+static gpointer replay_thread(gpointer data) {
+  gint64 start = g_get_monotonic_time();
+  long n = (long)(replay_time * rate);
+
+  for (long i = 0; i < n; i++) {
+    NewMidiEvent(MIDI_CTRL, 0, 10, 65);               // jog wheel, one step right
+    replay_wheel++;
+    NewMidiEvent(MIDI_CTRL, 0, 7, (int)(i & 127));    // knob
+    replay_last_knob = (int)(i & 127);
+    replay_messages += 2;
+
+    if (i % (rate / 10) == 0) {
+      NewMidiEvent(MIDI_NOTE, 0, 20, 1);              // key press and release
+      NewMidiEvent(MIDI_NOTE, 0, 20, 0);
+      replay_keys++;
+      replay_messages += 2;
+    }
+
+    gint64 next = start + (i + 1) * 1000000LL / rate;
+    gint64 now = g_get_monotonic_time();
+
+    if (next > now) { g_usleep(next - now); }
+  }
+
+  g_atomic_int_set(&replay_done, 1);
+  return NULL;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-n <hot path messages>] [-t <replay seconds>] [-rate <messages/s>]\n", prog);
+  exit(8);
+}
+
+int main(int argc, char *argv[]) {
+  char what[128];
+  gint64 start;
+  double dt;
+  GThread *thread;
+  struct desc *desc;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n")    && i < argc - 1) { hot_events = atol(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-t")    && i < argc - 1) { replay_time = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-rate") && i < argc - 1) { rate = atoi(argv[++i]); continue; }
+
+    usage(argv[0]);
+  }
+
+  if (hot_events < 1 || replay_time <= 0.0 || rate < 10) { usage(argv[0]); }
+
+  //
+  // 60 knobs on various channels, then a wheel, a knob and a key on
+  // ANY channel, and a channel-specific knob sharing a note with them
+  //
+  for (int n = 0; n < 60; n++) {
+    MidiAddCommand(n + 30, new_desc(n % 16, MIDI_CTRL, MIDI_KNOB, AF_GAIN));
+  }
+
+  MidiAddCommand(10, new_desc(-1, MIDI_CTRL, MIDI_WHEEL, VFO));
+  MidiAddCommand(7, new_desc(-1, MIDI_CTRL, MIDI_KNOB, AF_GAIN));
+  MidiAddCommand(7, new_desc(3, MIDI_CTRL, MIDI_KNOB, TUNE));
+  MidiAddCommand(20, new_desc(-1, MIDI_NOTE, MIDI_KEY, MOX));
+  //
+  // Lookup precedence
+  //
+  reset_counters();
+  NewMidiEvent(MIDI_CTRL, 3, 7, 42);
+  drain();
+  check(last_action == TUNE, "lookup: channel entry before ANY-channel entry");
+  reset_counters();
+  NewMidiEvent(MIDI_CTRL, 5, 7, 42);
+  drain();
+  check(last_action == AF_GAIN && last_knob == 42, "lookup: ANY-channel entry for other channels");
+  reset_counters();
+  NewMidiEvent(MIDI_CTRL, 0, 99, 42);
+  drain();
+  check(actions == 0, "lookup: unmapped controller is ignored");
+  //
+  // The MIDI menu changes the channel of a command in place, so an
+  // ANY-channel entry may come first in the list
+  //
+  desc = new_desc(2, MIDI_CTRL, MIDI_KNOB, AF_GAIN);
+  MidiAddCommand(8, new_desc(4, MIDI_CTRL, MIDI_KNOB, TUNE));
+  MidiAddCommand(8, desc);
+  desc->channel = -1;
+  MidiBuildLookup();
+  reset_counters();
+  NewMidiEvent(MIDI_CTRL, 4, 8, 42);
+  drain();
+  check(last_action == TUNE, "lookup: channel entry before an earlier ANY entry");
+  //
+  // Hot path: lookup and coalescing without a main loop
+  //
+  reset_counters();
+  start = g_get_monotonic_time();
+
+  for (long i = 0; i < hot_events; i++) {
+    NewMidiEvent(MIDI_CTRL, 0, 7, (int)(i & 127));
+  }
+
+  dt = 1.0E-6 * (g_get_monotonic_time() - start);
+  printf("hot path: %ld messages in %.3f s, %.1f M messages/s, %.1f ns/message\n",
+         hot_events, dt, 1.0E-6 * hot_events / dt, 1.0E9 * dt / hot_events);
+  drain();
+  check(actions == 1 && last_knob == (int)((hot_events - 1) & 127), "hot path: one action with the last knob value");
+  //
+  // Real-time replay with the main loop running
+  //
+  reset_counters();
+  thread = g_thread_new("MIDI replay", replay_thread, NULL);
+
+  while (!g_atomic_int_get(&replay_done)) {
+    g_main_context_iteration(NULL, FALSE);
+    g_usleep(200);
+  }
+
+  g_thread_join(thread);
+  drain();
+  printf("replay: %ld MIDI messages in %.1f s, %ld actions (%.1f per second)\n",
+         replay_messages, replay_time, actions, actions / replay_time);
+  snprintf(what, sizeof(what), "replay: wheel moved by %ld steps, expected %ld", wheel_sum, replay_wheel);
+  check(wheel_sum == replay_wheel, what);
+  snprintf(what, sizeof(what), "replay: last knob value %d, expected %d", last_knob, replay_last_knob);
+  check(last_knob == replay_last_knob, what);
+  snprintf(what, sizeof(what), "replay: %ld key presses, expected %ld", keys, replay_keys);
+  check(keys == replay_keys, what);
+  snprintf(what, sizeof(what), "replay: %ld actions for %ld messages", actions, replay_messages);
+  check(actions * 10 < replay_messages, what);
+  MidiReleaseCommands();
+  return test_result();
+}
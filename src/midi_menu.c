@@ -513,28 +513,25 @@ static void updateDescription() {
 static void delete_cb(GtkButton *widget, GdkEventButton *event, gpointer user_data) {
   struct desc *previous_cmd;
   struct desc *next_cmd;
+  struct desc *cmd = current_cmd;
 
   //t_print("%s: thisNote=%d current_cmd=%p\n", __FUNCTION__, thisNote, current_cmd);
-  if (current_cmd == NULL) {
+  if (cmd == NULL) {
     t_print("%s: current_cmd is NULL!\n", __FUNCTION__);
     return;
   }
 
   // remove from MidiCommandsTable
-  if (MidiCommandsTable[thisNote] == current_cmd) {
-    MidiCommandsTable[thisNote] = current_cmd->next;
-    g_free(current_cmd);
-    current_cmd = NULL;
+  if (MidiCommandsTable[thisNote] == cmd) {
+    MidiCommandsTable[thisNote] = cmd->next;
   } else {
     previous_cmd = MidiCommandsTable[thisNote];
 
     while (previous_cmd->next != NULL) {
       next_cmd = previous_cmd->next;
 
-      if (next_cmd == current_cmd) {
+      if (next_cmd == cmd) {
         previous_cmd->next = next_cmd->next;
-        g_free(next_cmd);
-        current_cmd = NULL; // note next_cmd == current_cmd
         break;
       }
 
@@ -542,6 +539,13 @@ static void delete_cb(GtkButton *widget, GdkEventButton *event, gpointer user_da
     }
   }
 
+  current_cmd = NULL;
+  //
+  // The MIDI input thread finds the commands through the lookup table,
+  // so the command may only be freed once the lookup table is re-built.
+  //
+  MidiBuildLookup();
+  g_free(cmd);
   // remove from list store. This triggers "tree selection changed"
   gtk_list_store_remove(store, &iter);
 }
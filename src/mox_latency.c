@@ -0,0 +1,402 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Headless MOX latency test for the T/R sequencer (src/trx_sequencer.c).
+ *
+ * The real sequencer runs against a minimal radio: two receivers and a
+ * transmitter whose slew-down takes -slew ms, and a protocol-1 link to
+ * hpsdrsim. hpsdrsim is started as a child process. A sender thread streams
+ * EP2 frames to it at the 48 kHz TX packet rate, with the MOX bit taken from
+ * trx_sequencer_state() (this is what radio_tx_active() reports). The
+ * MOX-to-air latency is the time from the MOX request to the moment hpsdrsim
+ * logs the PTT change.
+ *
+ * For each transition, the program checks that
+ *   - trx_sequencer_switch() returns at once, i.e. does not block the caller,
+ *   - hpsdrsim sees the PTT change, within -maxlat ms for 99% of them,
+ * and it reports p50/p95/p99/max of the latency for both directions.
+ * The exit code is 0 if all checks pass.
+ *
+ * Build and run: make hpsdrsim mox_latency && ./mox_latency
+ * hpsdrsim binds to UDP port 1024, so no other radio or simulator may be
+ * running on this host.
+ */
+
+#include <gtk/gtk.h>
+#include <arpa/inet.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "discovered.h"
+#include "gpio.h"
+#include "message.h"
+#include "mode.h"
+#include "radio.h"
+#include "receiver.h"
+#include "test_util.h"
+#include "transmitter.h"
+#include "trx_sequencer.h"
+#include "vfo.h"
+
+#define MOXL_MAXCYCLES 10000
+
+static const char *sim_path = "./hpsdrsim";
+static int cycles = 200;
+static double slew = 5.0;                // ms, slew-down of a WDSP channel
+static double hold = 20.0;               // ms, time between two transitions
+static double max_block = 1.0;           // ms, allowed time in trx_sequencer_switch()
+static double max_lat = 25.0;            // ms, allowed p99 of the MOX-to-air latency
+
+//
+// The minimal radio the T/R sequencer works on
+//
+static RECEIVER rxs[2];
+static TRANSMITTER txs;
+RECEIVER *receiver[8];
+TRANSMITTER *transmitter;
+int receivers = 2;
+gboolean duplex = FALSE;
+int protocol = ORIGINAL_PROTOCOL;
+int device = DEVICE_HERMES;
+int tune = 0;
+int PS_TX_FEEDBACK = 2;
+int PS_RX_FEEDBACK = 3;
+
+static gint64 slew_start[2];
+
+static void sleep_until(gint64 t) {
+  gint64 now = g_get_monotonic_time();
+
+  if (t > now) { g_usleep(t - now); }
+}
+
+void rx_off_nowait(const RECEIVER *rx) {
+  slew_start[rx->id] = g_get_monotonic_time();
+}
+
+int rx_off_wait(const RECEIVER *rx) {
+  sleep_until(slew_start[rx->id] + (gint64)(1000.0 * slew));
+  return 1;
+}
+
+void rx_on(const RECEIVER *rx) {
+}
+
+void tx_on(const TRANSMITTER *tx) {
+}
+
+void tx_off(const TRANSMITTER *tx) {
+  g_usleep((gulong)(1000.0 * slew));
+}
+
+void tx_ps_mox(const TRANSMITTER *tx, int state) {
+}
+
+void gpio_set_ptt(int state) {
+}
+
+int vfo_get_tx_mode() {
+  return modeUSB;
+}
+
+//
+// hpsdrsim child process and its log
+//
+static pid_t sim_pid = -1;
+static FILE *sim_log = NULL;
+static GMutex ev_mutex;
+static GCond ev_cond;
+static int sim_ready = 0;
+static int sim_ptt = 0;                  // PTT state last logged by hpsdrsim
+static gint64 sim_ptt_time = 0;          // when it was logged
+static int sim_eof = 0;
+
+static gpointer log_thread(gpointer data) {
+  char line[512];
+
+  while (fgets(line, sizeof(line), sim_log)) {
+    gint64 now = g_get_monotonic_time();
+    const char *p;
+    g_mutex_lock(&ev_mutex);
+
+    if (strstr(line, "Listening for TCP")) { sim_ready = 1; }
+
+    if ((p = strstr(line, " PTT= ")) != NULL && (p = strchr(p, '(')) != NULL) {
+      sim_ptt = atoi(p + 1);
+      sim_ptt_time = now;
+    }
+
+    g_cond_broadcast(&ev_cond);
+    g_mutex_unlock(&ev_mutex);
+  }
+
+  g_mutex_lock(&ev_mutex);
+  sim_eof = 1;
+  g_cond_broadcast(&ev_cond);
+  g_mutex_unlock(&ev_mutex);
+  return NULL;
+}
+
+static int sim_start(void) {
+  int fd[2];
+
+  if (pipe(fd) < 0) {
+    t_perror("pipe");
+    return 0;
+  }
+
+  sim_pid = fork();
+
+  if (sim_pid < 0) {
+    t_perror("fork");
+    return 0;
+  }
+
+  if (sim_pid == 0) {
+    dup2(fd[1], 1);
+    close(fd[0]);
+    close(fd[1]);
+    execl(sim_path, sim_path, "-P1", "-hermes", (char *)NULL);
+    perror(sim_path);
+    _exit(127);
+  }
+
+  close(fd[1]);
+  sim_log = fdopen(fd[0], "r");
+  g_thread_new("hpsdrsim log", log_thread, NULL);
+  //
+  // wait until hpsdrsim has bound its sockets
+  //
+  gint64 end = g_get_monotonic_time() + 5 * G_TIME_SPAN_SECOND;
+  g_mutex_lock(&ev_mutex);
+
+  while (!sim_ready && !sim_eof) {
+    if (!g_cond_wait_until(&ev_cond, &ev_mutex, end)) { break; }
+  }
+
+  int ok = sim_ready;
+  g_mutex_unlock(&ev_mutex);
+  return ok;
+}
+
+static void sim_stop(void) {
+  if (sim_pid > 0) {
+    kill(sim_pid, SIGTERM);
+    waitpid(sim_pid, NULL, 0);
+    sim_pid = -1;
+  }
+}
+
+//
+// Wait until hpsdrsim has logged PTT=state, return the time stamp or 0 on time-out.
+//
+static gint64 sim_wait_ptt(int state, gint64 timeout) {
+  gint64 end = g_get_monotonic_time() + timeout;
+  gint64 t = 0;
+  g_mutex_lock(&ev_mutex);
+
+  while (sim_ptt != state && !sim_eof) {
+    if (!g_cond_wait_until(&ev_cond, &ev_mutex, end)) { break; }
+  }
+
+  if (sim_ptt == state) { t = sim_ptt_time; }
+
+  g_mutex_unlock(&ev_mutex);
+  return t;
+}
+
+//
+// EP2 sender: 126 TX samples per packet at 48 kHz, i.e. one packet every 2.625 msec,
+// as the protocol-1 code does while transmitting.
+//
+static volatile int send_running = 1;
+
+static gpointer send_thread(gpointer data) {
+  unsigned char buffer[1032];
+  struct sockaddr_in addr;
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  guint32 seq = 0;
+  gint64 next = g_get_monotonic_time();
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(1024);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  while (send_running) {
+    int mox = trx_sequencer_state();
+    memset(buffer, 0, sizeof(buffer));
+    buffer[0] = 0xEF;
+    buffer[1] = 0xFE;
+    buffer[2] = 0x01;
+    buffer[3] = 0x02;
+    buffer[4] = (seq >> 24) & 0xFF;
+    buffer[5] = (seq >> 16) & 0xFF;
+    buffer[6] = (seq >> 8) & 0xFF;
+    buffer[7] = seq & 0xFF;
+    seq++;
+
+    for (int i = 8; i < 1032; i += 512) {
+      buffer[i + 0] = 0x7F;
+      buffer[i + 1] = 0x7F;
+      buffer[i + 2] = 0x7F;
+      buffer[i + 3] = mox;           // C0: address 0, MOX bit
+    }
+
+    sendto(sock, buffer, sizeof(buffer), 0, (struct sockaddr *)&addr, sizeof(addr));
+    next += 2625;
+    sleep_until(next);
+  }
+
+  close(sock);
+  return NULL;
+}
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int n, int p) {
+  return sorted[(n * p) / 100 < n ? (n * p) / 100 : n - 1];
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-sim <hpsdrsim>] [-n <cycles>] [-slew <ms>] [-hold <ms>]\n", prog);
+  fprintf(stderr, "       [-maxblock <ms>] [-maxlat <ms>]\n");
+  exit(8);
+}
+
+int main(int argc, char *argv[]) {
+  static double lat[2][MOXL_MAXCYCLES];
+  int nlat[2] = {0, 0};
+  int missed = 0, blocked = 0;
+  double max_call = 0.0;
+  char what[128];
+  GThread *sender;
+  unsigned int seed = 4711;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-sim")      && i < argc - 1) { sim_path = argv[++i]; continue; }
+
+    if (!strcmp(argv[i], "-n")        && i < argc - 1) { cycles = atoi(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-slew")     && i < argc - 1) { slew = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-hold")     && i < argc - 1) { hold = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-maxblock") && i < argc - 1) { max_block = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-maxlat")   && i < argc - 1) { max_lat = atof(argv[++i]); continue; }
+
+    usage(argv[0]);
+  }
+
+  if (cycles < 1 || cycles > MOXL_MAXCYCLES) { usage(argv[0]); }
+
+  signal(SIGPIPE, SIG_IGN);
+  g_mutex_init(&ev_mutex);
+  g_cond_init(&ev_cond);
+
+  for (int i = 0; i < 2; i++) {
+    rxs[i].id = i;
+    rxs[i].sample_rate = 48000;
+    receiver[i] = &rxs[i];
+  }
+
+  txs.id = 8;
+  transmitter = &txs;
+
+  snprintf(what, sizeof(what), "start %s", sim_path);
+  check(sim_start(), what);
+
+  if (failures) {
+    sim_stop();
+    return test_result();
+  }
+
+  printf("MOX latency: %d cycles, slew %.1f ms, hold %.1f ms, simulator %s\n", cycles, slew, hold, sim_path);
+  trx_sequencer_start();
+  sender = g_thread_new("EP2 sender", send_thread, NULL);
+  g_usleep(100000);
+
+  for (int i = 0; i < cycles; i++) {
+    for (int state = 1; state >= 0; state--) {
+      gint64 start = g_get_monotonic_time();
+      trx_sequencer_switch(state, NULL);
+      double call = 1.0E-3 * (g_get_monotonic_time() - start);
+
+      if (call > max_call) { max_call = call; }
+
+      if (call > max_block) { blocked++; }
+
+      gint64 t = sim_wait_ptt(state, G_TIME_SPAN_SECOND);
+
+      if (t == 0) {
+        missed++;
+      } else {
+        lat[state][nlat[state]++] = 1.0E-3 * (t - start);
+      }
+
+      trx_sequencer_wait();
+      // do not always start at the same phase of the packet clock
+      g_usleep((gulong)(1000.0 * hold + 2625.0 * rand_r(&seed) / RAND_MAX));
+    }
+  }
+
+  //
+  // A MOX on/off burst must collapse, not pile up, and end in RX.
+  //
+  for (int i = 0; i < 10; i++) {
+    trx_sequencer_switch(1, NULL);
+    trx_sequencer_switch(0, NULL);
+  }
+
+  trx_sequencer_wait();
+  check(trx_sequencer_state() == 0 && sim_wait_ptt(0, G_TIME_SPAN_SECOND) != 0, "MOX on/off burst ends in RX");
+
+  send_running = 0;
+  g_thread_join(sender);
+  trx_sequencer_stop();
+  sim_stop();
+
+  for (int state = 1; state >= 0; state--) {
+    int n = nlat[state];
+
+    if (n == 0) { continue; }
+
+    qsort(lat[state], n, sizeof(double), cmp_double);
+    printf("%s: n=%d latency p50=%.2f p95=%.2f p99=%.2f max=%.2f ms\n", state ? "RX/TX" : "TX/RX", n,
+           percentile(lat[state], n, 50), percentile(lat[state], n, 95), percentile(lat[state], n, 99), lat[state][n - 1]);
+    snprintf(what, sizeof(what), "%s: p99 latency within %.1f ms", state ? "RX/TX" : "TX/RX", max_lat);
+    check(percentile(lat[state], n, 99) <= max_lat, what);
+  }
+
+  printf("trx_sequencer_switch(): max %.3f ms in the call\n", max_call);
+  snprintf(what, sizeof(what), "trx_sequencer_switch(): %d call(s) above %.1f ms", blocked, max_block);
+  check(blocked == 0, what);
+  snprintf(what, sizeof(what), "hpsdrsim: %d PTT change(s) not seen", missed);
+  check(missed == 0, what);
+  return test_result();
+}
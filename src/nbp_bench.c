@@ -0,0 +1,176 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Benchmark for the tuning update of the WDSP notched bandpass (nbp.c).
+ *
+ * While tuning with notches in the passband, calc_nbp_lightweight()
+ * rebuilds the impulse response with fir_mbandpass_tuned() from a cached
+ * window instead of fir_mbandpass(). Both are static in nbp.c, so this
+ * program includes nbp.c directly.
+ *
+ * Two notches are swept across a 150...2850 Hz passband, as happens when
+ * tuning across two notched carriers, and for each step
+ *   - the two impulse responses are compared for all filter sizes and
+ *     both window types (tolerance relative to the largest tap),
+ *   - both are timed for filter sizes 1024...8192 with 1 Hz steps.
+ * The impulse cache is off, so fir_mbandpass() computes every response.
+ * The timing is printed for information only, it depends on the machine
+ * and its load. The exit code is 0 if the responses agree.
+ *
+ * Build and run: make nbp_bench && ./nbp_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nbp.c"
+#include "test_util.h"
+
+static int steps = 2000;                 // tuning steps per timing run
+static double max_err = 1.0e-9;          // allowed difference relative to the largest tap
+
+static const int active[2] = { 1, 1 };
+static const double fcenter[2] = { 1000.0, 2600.0 };
+static const double fwidth[2] = { 100.0, 150.0 };
+static double nlow[2], nhigh[2];
+
+static void init_nbp(NBP a, int nc, int wintype) {
+  memset(a, 0, sizeof(nbp));
+  a->nc = nc;
+  a->size = 1024;
+  a->rate = 48000.0;
+  a->wintype = wintype;
+  a->gain = 1.0;
+  a->flow = 150.0;
+  a->fhigh = 2850.0;
+  a->maxpb = 16;
+  a->bplow = (double *) malloc0(a->maxpb * sizeof(double));
+  a->bphigh = (double *) malloc0(a->maxpb * sizeof(double));
+}
+
+static void free_nbp(NBP a) {
+  _aligned_free(a->tkern);
+  _aligned_free(a->bplow);
+  _aligned_free(a->bphigh);
+}
+
+//
+// Passbands for a tuning offset, as calc_nbp_lightweight() computes them
+//
+static void tune(NBP a, double offset) {
+  a->numpb = make_nbp(2, (int *) active, (double *) fcenter, (double *) fwidth, nlow, nhigh, 0.0, 0,
+                      a->flow + offset, a->fhigh + offset, a->bplow, a->bphigh, &a->havnotch);
+
+  for (int i = 0; i < a->numpb; i++) {
+    a->bplow[i]  -= offset;
+    a->bphigh[i] -= offset;
+  }
+}
+
+static double *reference(NBP a) {
+  return fir_mbandpass(a->nc, a->numpb, a->bplow, a->bphigh, a->rate, a->gain / (double)(2 * a->size), a->wintype);
+}
+
+static void compare(int nc, int wintype) {
+  nbp A;
+  NBP a = &A;
+  double err = 0.0, peak = 0.0;
+  char what[128];
+  init_nbp(a, nc, wintype);
+
+  for (int step = 0; step < 200; step++) {
+    tune(a, -500.0 + 10.3 * step);
+    double *r = reference(a);
+    double *t = fir_mbandpass_tuned(a);
+
+    for (int i = 0; i < 2 * nc; i++) {
+      if (fabs(r[i] - t[i]) > err) { err = fabs(r[i] - t[i]); }
+
+      if (fabs(r[i]) > peak) { peak = fabs(r[i]); }
+    }
+
+    _aligned_free(r);
+    _aligned_free(t);
+  }
+
+  snprintf(what, sizeof(what), "nc=%d wintype=%d: max difference %.2g of %.2g", nc, wintype, err, peak);
+  check(err <= max_err * peak, what);
+  free_nbp(a);
+}
+
+static void timing(int nc) {
+  nbp A;
+  NBP a = &A;
+  double dt[2];
+  char what[128];
+  init_nbp(a, nc, 1);
+
+  for (int pass = 0; pass < 2; pass++) {
+    double start = now();
+
+    for (int step = 0; step < steps; step++) {
+      tune(a, -1000.0 + step + 0.5 * pass);
+      double *h = pass ? fir_mbandpass_tuned(a) : reference(a);
+      _aligned_free(h);
+    }
+
+    dt[pass] = 1.0e6 * (now() - start) / steps;
+  }
+
+  snprintf(what, sizeof(what), "nc=%5d per step: fir_mbandpass %7.1f us, tuned %6.1f us", nc, dt[0], dt[1]);
+  printf("%s\n", what);
+  free_nbp(a);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-n <tuning steps>] [-maxerr <relative error>]\n", prog);
+  exit(8);
+}
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n")      && i < argc - 1) { steps = atoi(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-maxerr") && i < argc - 1) { max_err = atof(argv[++i]); continue; }
+
+    usage(argv[0]);
+  }
+
+  if (steps < 1 || max_err <= 0.0) { usage(argv[0]); }
+
+  init_impulse_cache(0);
+
+  for (int k = 0; k < 2; k++) {
+    nlow[k] = fcenter[k] - 0.5 * fwidth[k];
+    nhigh[k] = fcenter[k] + 0.5 * fwidth[k];
+  }
+
+  for (int wintype = 0; wintype < 2; wintype++) {
+    compare(2047, wintype);
+    compare(2048, wintype);
+    compare(4096, wintype);
+  }
+
+  for (int nc = 1024; nc <= 8192; nc *= 2) {
+    timing(nc);
+  }
+
+  return test_result();
+}
@@ -0,0 +1,146 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "message.h"
+#include "net_stream.h"
+#include "radio.h"
+
+void net_stream_init(NET_STREAM *s, const char *name) {
+  memset(s, 0, sizeof(NET_STREAM));
+  g_strlcpy(s->name, name, sizeof(s->name));
+}
+
+void net_stream_restart(NET_STREAM *s) {
+  s->started = 0;
+}
+
+gint64 net_stream_arrival(NET_STREAM *s) {
+  gint64 now = g_get_monotonic_time();
+
+  if (s->last_arrival != 0) {
+    double iat = (double)(now - s->last_arrival);
+    int bin = 0;
+
+    for (gint64 t = iat; t >= 32 && bin < NET_HIST_BINS - 1; t >>= 1) { bin++; }
+
+    s->hist[bin]++;
+
+    if (s->mean_iat == 0.0) {
+      s->mean_iat = iat;
+    } else {
+      s->mean_iat += (iat - s->mean_iat) * 0.015625;
+    }
+
+    s->jitter += (fabs(iat - s->mean_iat) - s->jitter) * 0.0625;
+  }
+
+  s->last_arrival = now;
+  return now;
+}
+
+static void net_stream_resync(NET_STREAM *s, guint32 sequence) {
+  s->expected = sequence + 1;
+  s->seen = 1;
+}
+
+int net_stream_sequence(NET_STREAM *s, guint32 sequence) {
+  s->packets++;
+
+  if (!s->started) {
+    s->started = 1;
+    net_stream_resync(s, sequence);
+    return 0;
+  }
+
+  gint32 diff = (gint32)(sequence - s->expected);
+
+  if (diff == 0) {
+    s->expected++;
+    s->seen = (s->seen << 1) | 1;
+    return 0;
+  }
+
+  sequence_errors++;
+
+  if (diff < 0) {
+    int k = -diff - 1;        // position in the "seen" bitmap
+
+    if (k >= NET_REORDER_WINDOW) {
+      t_print("%s: %s: sequence jumps back from %u to %u\n", __FUNCTION__, s->name, s->expected, sequence);
+      s->resyncs++;
+      net_stream_resync(s, sequence);
+      return 0;
+    }
+
+    if (s->seen & (1U << k)) {
+      s->duplicates++;
+    } else {
+      s->seen |= (1U << k);
+      s->late++;
+      s->lost--;
+    }
+
+    return -1;
+  }
+
+  s->lost += diff;
+
+  if (diff > NET_MAX_CONCEAL) {
+    t_print("%s: %s: %d packets lost (expected %u got %u)\n", __FUNCTION__, s->name, diff, s->expected, sequence);
+    s->resyncs++;
+    net_stream_resync(s, sequence);
+    return 0;
+  }
+
+  t_print("%s: %s: %d packets lost (expected %u got %u), concealed\n", __FUNCTION__, s->name, diff, s->expected,
+          sequence);
+  s->concealed += diff;
+  s->seen = (diff + 1 >= NET_REORDER_WINDOW) ? 1 : (s->seen << (diff + 1)) | 1;
+  s->expected = sequence + 1;
+  return diff;
+}
+
+void net_stream_report(const NET_STREAM *s) {
+  char hist[256] = "";
+  int len = 0;
+
+  if (s->packets == 0) { return; }
+
+  t_print("%s: %s: packets=%ld lost=%ld concealed=%ld late=%ld duplicates=%ld resyncs=%ld\n", __FUNCTION__, s->name,
+          s->packets, s->lost, s->concealed, s->late, s->duplicates, s->resyncs);
+
+  for (int i = 0; i < NET_HIST_BINS; i++) {
+    if (s->hist[i] == 0) { continue; }
+
+    if (i < NET_HIST_BINS - 1) {
+      len += snprintf(hist + len, sizeof(hist) - len, " <%d:%ld", 32 << i, s->hist[i]);
+    } else {
+      len += snprintf(hist + len, sizeof(hist) - len, " >=%d:%ld", 16 << i, s->hist[i]);
+    }
+
+    if (len >= (int) sizeof(hist)) { break; }
+  }
+
+  t_print("%s: %s: inter-arrival mean=%0.0f jitter=%0.0f usec, histogram [usec]%s\n", __FUNCTION__, s->name,
+          s->mean_iat, s->jitter, hist);
+}
@@ -0,0 +1,73 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _NET_STREAM_H
+#define _NET_STREAM_H
+
+#include <gtk/gtk.h>
+
+//
+// Sequence number tracking and health telemetry for one incoming
+// packet stream (P1 EP6, P2 DDC/mic/high-priority).
+//
+// net_stream_arrival() is called in the thread that receives the packets,
+// records the inter-arrival time and returns the arrival time stamp. net_stream_sequence() is called in
+// the thread that processes the packets (in order) and returns how many
+// lost packets should be concealed before the current one, or -1 if the
+// current packet is a duplicate or arrives too late (it has already been
+// concealed) and must be dropped.
+//
+// Gaps larger than NET_MAX_CONCEAL packets, and sequence numbers that jump
+// backwards further than the reorder window, are not concealed: the stream
+// is re-synchronised. net_stream_restart() does this silently, e.g. if the
+// radio is known to have restarted its sequence numbers.
+//
+#define NET_REORDER_WINDOW 32    // bits in the "seen" bitmap
+#define NET_MAX_CONCEAL    16
+#define NET_HIST_BINS      12    // inter-arrival time histogram, <32 usec ... >=32 msec
+
+typedef struct _net_stream {
+  char     name[16];
+  //
+  // owned by the processing thread
+  //
+  int      started;
+  guint32  expected;             // next sequence number expected
+  guint32  seen;                 // bit k: packet expected-1-k has been processed
+  long     packets;
+  long     lost;                 // never arrived
+  long     concealed;            // packets inserted
+  long     late;                 // arrived out of order, after having been concealed
+  long     duplicates;
+  long     resyncs;
+  //
+  // owned by the receiving thread
+  //
+  gint64   last_arrival;
+  double   mean_iat;             // usec
+  double   jitter;               // usec, mean deviation of the inter-arrival time
+  long     hist[NET_HIST_BINS];
+} NET_STREAM;
+
+extern void net_stream_init(NET_STREAM *s, const char *name);
+extern void net_stream_restart(NET_STREAM *s);
+extern gint64 net_stream_arrival(NET_STREAM *s);
+extern int  net_stream_sequence(NET_STREAM *s, guint32 sequence);
+extern void net_stream_report(const NET_STREAM *s);
+
+#endif
@@ -0,0 +1,109 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Unit test for the sequence number tracking in src/net_stream.c.
+ *
+ * Sequence number patterns (in order, losses, reordering, duplicates,
+ * large gaps, backward jumps and the 32-bit wrap-around) are fed into
+ * net_stream_sequence() on a fresh stream each. For each pattern the
+ * program checks the value returned for every packet (packets to conceal,
+ * or -1 for a packet to drop) and the lost/concealed/late/duplicate/resync
+ * counters of the stream.
+ *
+ * Build and run: make net_stream_test && ./net_stream_test
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+
+#include "net_stream.h"
+#include "test_util.h"
+
+int sequence_errors = 0;
+
+#define PAT_MAX 8
+
+typedef struct {
+  const char *what;
+  int n;
+  guint32 seq[PAT_MAX];
+  int ret[PAT_MAX];                      // expected result for each packet
+  long lost, concealed, late, duplicates, resyncs;
+} PATTERN;
+
+static const PATTERN patterns[] = {
+  { "in order", 5, { 100, 101, 102, 103, 104 }, { 0, 0, 0, 0, 0 }, 0, 0, 0, 0, 0 },
+  { "one lost", 4, { 0, 1, 2, 4 }, { 0, 0, 0, 1 }, 1, 1, 0, 0, 0 },
+  { "three lost", 3, { 10, 11, 15 }, { 0, 0, 3 }, 3, 3, 0, 0, 0 },
+  { "late after concealment", 4, { 0, 1, 3, 2 }, { 0, 0, 1, -1 }, 0, 1, 1, 0, 0 },
+  { "swapped pair", 4, { 0, 2, 1, 3 }, { 0, 1, -1, 0 }, 0, 1, 1, 0, 0 },
+  { "late packet arrives twice", 5, { 0, 1, 3, 2, 2 }, { 0, 0, 1, -1, -1 }, 0, 1, 1, 1, 0 },
+  { "duplicate", 4, { 0, 1, 2, 2 }, { 0, 0, 0, -1 }, 0, 0, 0, 1, 0 },
+  { "old duplicate", 6, { 0, 1, 2, 3, 4, 1 }, { 0, 0, 0, 0, 0, -1 }, 0, 0, 0, 1, 0 },
+  {
+    "largest concealed gap", 3, { 0, NET_MAX_CONCEAL + 1, NET_MAX_CONCEAL + 2 }, { 0, NET_MAX_CONCEAL, 0 },
+    NET_MAX_CONCEAL, NET_MAX_CONCEAL, 0, 0, 0
+  },
+  { "gap too large", 3, { 0, NET_MAX_CONCEAL + 2, NET_MAX_CONCEAL + 3 }, { 0, 0, 0 }, NET_MAX_CONCEAL + 1, 0, 0, 0, 1 },
+  { "jump back beyond the window", 4, { 1000, 1001, 100, 101 }, { 0, 0, 0, 0 }, 0, 0, 0, 0, 1 },
+  { "wrap-around", 4, { 0xFFFFFFFE, 0xFFFFFFFF, 0, 1 }, { 0, 0, 0, 0 }, 0, 0, 0, 0, 0 },
+  { "loss across the wrap-around", 3, { 0xFFFFFFFE, 0xFFFFFFFF, 1 }, { 0, 0, 1 }, 1, 1, 0, 0, 0 },
+};
+
+static void run_pattern(const PATTERN *p) {
+  NET_STREAM s;
+  char what[128];
+  int ok = 1;
+  net_stream_init(&s, "test");
+
+  for (int i = 0; i < p->n; i++) {
+    int r = net_stream_sequence(&s, p->seq[i]);
+
+    if (r != p->ret[i]) {
+      printf("%s: packet %u returned %d, expected %d\n", p->what, p->seq[i], r, p->ret[i]);
+      ok = 0;
+    }
+  }
+
+  snprintf(what, sizeof(what), "%s: results", p->what);
+  check(ok, what);
+  snprintf(what, sizeof(what), "%s: lost %ld concealed %ld late %ld dup %ld resync %ld", p->what,
+           s.lost, s.concealed, s.late, s.duplicates, s.resyncs);
+  check(s.packets == p->n && s.lost == p->lost && s.concealed == p->concealed && s.late == p->late
+        && s.duplicates == p->duplicates && s.resyncs == p->resyncs, what);
+}
+
+int main(int argc, char *argv[]) {
+  NET_STREAM s;
+
+  for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+    run_pattern(&patterns[i]);
+  }
+
+  //
+  // After net_stream_restart() any sequence number is accepted silently
+  //
+  net_stream_init(&s, "test");
+  net_stream_sequence(&s, 0);
+  net_stream_sequence(&s, 1);
+  net_stream_restart(&s);
+  check(net_stream_sequence(&s, 5000) == 0 && net_stream_sequence(&s, 5001) == 0 && s.resyncs == 0 && s.lost == 0,
+        "restart: new sequence numbers are accepted");
+  return test_result();
+}
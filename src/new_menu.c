@@ -43,10 +43,13 @@
 #include "meter_menu.h"
 #include "band_menu.h"
 #include "bandstack_menu.h"
+#include "bandscope.h"
+#include "bandscope_menu.h"
 #include "mode_menu.h"
 #include "filter_menu.h"
 #include "noise_menu.h"
 #include "agc_menu.h"
+#include "voice_keyer_menu.h"
 #include "vox_menu.h"
 #include "diversity_menu.h"
 #include "tx_menu.h"
@@ -233,6 +236,12 @@ static gboolean xvtr_cb (GtkWidget *widget, GdkEventButton *event, gpointer data
   return TRUE;
 }
 
+static gboolean bandscope_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  cleanup();
+  bandscope_menu(top_window);
+  return TRUE;
+}
+
 static gboolean equalizer_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
   cleanup();
   equalizer_menu(top_window);
@@ -374,6 +383,17 @@ static gboolean vox_cb (GtkWidget *widget, GdkEventButton *event, gpointer data)
   return TRUE;
 }
 
+void start_voice_keyer() {
+  cleanup();
+  voice_keyer_menu(top_window);
+}
+
+// cppcheck-suppress constParameterCallback
+static gboolean voice_keyer_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  start_voice_keyer();
+  return TRUE;
+}
+
 void start_dsp() {
   cleanup();
   fft_menu(top_window);
@@ -516,7 +536,7 @@ void new_menu() {
     col = 0;
     //
     // First Column: Menus related to the Radio in general.
-    //               Radio/Screen/Display/Meter/XVTR
+    //               Radio/Screen/Display/Meter/XVTR/Bandscope
     //
     GtkWidget *radio_b = gtk_button_new_with_label("Radio");
     g_signal_connect (radio_b, "button-press-event", G_CALLBACK(radio_cb), NULL);
@@ -538,6 +558,14 @@ void new_menu() {
     g_signal_connect (xvtr_b, "button-press-event", G_CALLBACK(xvtr_cb), NULL);
     gtk_grid_attach(GTK_GRID(grid), xvtr_b, col, row, 1, 1);
     row++;
+
+    if (bandscope_available()) {
+      GtkWidget *bandscope_b = gtk_button_new_with_label("Bandscope");
+      g_signal_connect (bandscope_b, "button-press-event", G_CALLBACK(bandscope_cb), NULL);
+      gtk_grid_attach(GTK_GRID(grid), bandscope_b, col, row, 1, 1);
+      row++;
+    }
+
 #ifdef SATURN
 
     if (have_saturn_xdma) { // only display on the xdma client
@@ -614,7 +642,7 @@ void new_menu() {
 
     //
     // Fourth column:  TX-related menus
-    //                 TX, PA, VOX, PS, CW
+    //                 TX, PA, VOX, Voice Keyer, PS, CW
     //
     if (can_transmit) {
       GtkWidget *tx_b = gtk_button_new_with_label("TX");
@@ -629,6 +657,10 @@ void new_menu() {
       g_signal_connect (vox_b, "button-press-event", G_CALLBACK(vox_cb), NULL);
       gtk_grid_attach(GTK_GRID(grid), vox_b, col, row, 1, 1);
       row++;
+      GtkWidget *voice_keyer_b = gtk_button_new_with_label("Voice Keyer");
+      g_signal_connect (voice_keyer_b, "button-press-event", G_CALLBACK(voice_keyer_cb), NULL);
+      gtk_grid_attach(GTK_GRID(grid), voice_keyer_b, col, row, 1, 1);
+      row++;
 
       if (protocol == ORIGINAL_PROTOCOL || protocol == NEW_PROTOCOL) {
         GtkWidget *ps_b = gtk_button_new_with_label("PS");
@@ -46,6 +46,7 @@
 #include "alex.h"
 #include "audio.h"
 #include "band.h"
+#include "bandscope.h"
 #include "new_protocol.h"
 #include "discovered.h"
 #include "mode.h"
@@ -60,6 +61,7 @@
 #include "iambic.h"
 #include "rigctl.h"
 #include "message.h"
+#include "net_stream.h"
 
 #ifdef SATURN
   #include "saturnmain.h"
@@ -126,12 +128,21 @@ static unsigned long high_priority_sequence = 0;
 static unsigned long general_sequence = 0;
 static unsigned long rx_specific_sequence = 0;
 static unsigned long tx_specific_sequence = 0;
-static unsigned long ddc_sequence[MAX_DDC];
 
 static unsigned long tx_iq_sequence = 0;
 
-static unsigned long highprio_rcvd_sequence = 0;
-static unsigned long micsamples_sequence = 0;
+//
+// Incoming packet streams (sequence numbers and telemetry)
+//
+static NET_STREAM ddc_stream[MAX_DDC];
+static NET_STREAM highprio_stream;
+static NET_STREAM mic_stream;
+
+//
+// Last IQ samples (up to two sample pairs) of each DDC, needed
+// to conceal lost packets
+//
+static unsigned char ddc_last[MAX_DDC][12];
 
 #ifdef __APPLE__
   static sem_t *high_priority_sem_ready;
@@ -282,6 +293,9 @@ static void  process_ps_iq_data(const unsigned char *buffer);
 static void process_div_iq_data(const unsigned char *buffer);
 static void  process_high_priority(void);
 static void  process_mic_data(const unsigned char *buffer);
+static void  process_mic_samples(const unsigned char *buffer);
+static void  process_ddc_data(int ddc, const unsigned char *buffer, gint64 stamp);
+static void  conceal_ddc_data(int ddc, const unsigned char *buffer, int lost);
 
 //
 // Obtain a free buffer. If no one is available allocate
@@ -350,7 +364,7 @@ void update_action_table() {
   // determine the actions to be taken when a DDC packet arrives
   //
   int flag = 0;
-  int xmit = radio_is_transmitting(); // store such that it cannot change while building the flag
+  int xmit = radio_tx_active(); // store such that it cannot change while building the flag
   int newdev = (device == NEW_DEVICE_ANGELIA  || device == NEW_DEVICE_ORION ||
                 device == NEW_DEVICE_ORION2 || device == NEW_DEVICE_SATURN);
 
@@ -651,6 +665,15 @@ static void new_protocol_general() {
   general_buffer[37] = 0x08; //  phase word (not frequency)
   general_buffer[38] = 0x01; //  enable hardware timer
 
+  if (bandscope_enabled) {
+    general_buffer[23] = 0x01;                              // wideband data from ADC0
+    general_buffer[24] = (BS_PACKET_SAMPLES >> 8) & 0xFF;   // samples per packet
+    general_buffer[25] = BS_PACKET_SAMPLES & 0xFF;
+    general_buffer[26] = 16;                                // bits per sample
+    general_buffer[27] = BS_INTERVAL;                       // update rate (msec)
+    general_buffer[28] = BS_P2_PACKETS;                     // packets per frame
+  }
+
   if (!pa_enabled || band->disablePA) {
     local_pa_enable = 0;
     general_buffer[58] = 0x00;
@@ -713,9 +736,9 @@ static void new_protocol_high_priority() {
   //
   // If deskHPSDR is not (yet) transmitting, but a PTT signal came from the
   // radio, set HighPrio data accoring to the TX state as early as possible.
-  // To this end, radio_is_transmitting() is ORed with radio_ptt.
+  // To this end, radio_tx_active() is ORed with radio_ptt.
   //
-  int xmit     = radio_is_transmitting() | radio_ptt;
+  int xmit     = radio_tx_active() | radio_ptt;
   int txvfo    = vfo_get_tx_vfo();    // VFO governing the TX frequency
   int rxvfo    = active_receiver->id; // id of the active receiver
   int othervfo = 1 - rxvfo;           // id of the "other" receiver (only valid if receivers > 1)
@@ -1538,7 +1561,7 @@ static void new_protocol_receive_specific() {
   int xmit;
   pthread_mutex_lock(&rx_spec_mutex);
   memset(receive_specific_buffer, 0, sizeof(receive_specific_buffer));
-  xmit = radio_is_transmitting();
+  xmit = radio_tx_active();
   receive_specific_buffer[0] = (rx_specific_sequence >> 24) & 0xFF;
   receive_specific_buffer[1] = (rx_specific_sequence >> 16) & 0xFF;
   receive_specific_buffer[2] = (rx_specific_sequence >>  8) & 0xFF;
@@ -1681,6 +1704,13 @@ void new_protocol_menu_stop() {
 
   g_thread_join(new_protocol_timer_thread_id);
   new_protocol_high_priority();
+
+  for (int i = 0; i < MAX_DDC; i++) {
+    net_stream_report(&ddc_stream[i]);
+  }
+
+  net_stream_report(&highprio_stream);
+  net_stream_report(&mic_stream);
   // let the FPGA rest a while
   usleep(200000); // 200 ms
 
@@ -1713,13 +1743,20 @@ void new_protocol_menu_start() {
   high_priority_sequence = 0;
   rx_specific_sequence = 0;
   tx_specific_sequence = 0;
-  highprio_rcvd_sequence = 0;
-  micsamples_sequence = 0;
   audio_sequence = 0;
   tx_iq_sequence = 0;
   memset(rxcase, 0, sizeof(rxcase));
   memset(rxid, 0, sizeof(rxid));
-  memset(ddc_sequence, 0, sizeof(ddc_sequence));
+  memset(ddc_last, 0, sizeof(ddc_last));
+
+  for (int i = 0; i < MAX_DDC; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "DDC%d", i);
+    net_stream_init(&ddc_stream[i], name);
+  }
+
+  net_stream_init(&highprio_stream, "HighPrio");
+  net_stream_init(&mic_stream, "Mic");
   update_action_table();
 
   //
@@ -2071,6 +2108,19 @@ static gpointer new_protocol_thread(gpointer data) {
       saturn_post_micaudio(bytesread, mybuf);
       break;
 
+    case WIDE_BAND_TO_HOST_PORT:
+      //
+      // 4 bytes sequence number, followed by 16-bit big-endian samples.
+      // The samples are copied right away, so the buffer can be released.
+      //
+      if (bandscope_enabled && bytesread > 4) {
+        unsigned int seq = ((unsigned int)buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+        bandscope_add_packet(&buffer[4], (bytesread - 4) / 2, seq, BS_P2_PACKETS, 1);
+      }
+
+      mybuf->free = 1;
+      break;
+
     default:
       t_print("new_protocol_thread: Unknown port %d\n", sourceport);
       mybuf->free = 1;
@@ -2140,6 +2190,7 @@ static gpointer mic_line_thread(gpointer data) {
 // interface.
 //
 void saturn_post_high_priority(mybuffer *buffer) {
+  net_stream_arrival(&highprio_stream);
 #ifdef __APPLE__
   sem_wait(high_priority_sem_ready);
 #else
@@ -2159,6 +2210,8 @@ void saturn_post_micaudio(int bytesread, mybuffer *mybuf) {
     return;
   }
 
+  net_stream_arrival(&mic_stream);
+
   if (mic_count < 0) {
     mic_count++;
     mybuf->free = 1;
@@ -2198,27 +2251,14 @@ void saturn_post_iq_data(int ddc, mybuffer *mybuf) {
     return;
   }
 
+  mybuf->stamp = net_stream_arrival(&ddc_stream[ddc]);
+
   if (iq_count[ddc] < 0) {
     iq_count[ddc]++;
     mybuf->free = 1;
     return;
   }
 
-  //
-  // Check sequence HERE
-  //
-  unsigned const char *buffer = mybuf->buffer;
-  unsigned long sequence = ((buffer[0] & 0xFF) << 24)
-                           + ((buffer[1] & 0xFF) << 16)
-                           + ((buffer[2] & 0xFF) << 8)
-                           + (buffer[3] & 0xFF);
-
-  if (ddc_sequence[ddc] != sequence) {
-    t_print("%s: DDC(%d) sequence error: expected %ld got %ld\n", __FUNCTION__, ddc, ddc_sequence[ddc], sequence);
-    sequence_errors++;
-  }
-
-  ddc_sequence[ddc] = sequence + 1;
   int iptr = iq_inptr[ddc];
   int nptr = iptr + 1;
 
@@ -2243,12 +2283,8 @@ void saturn_post_iq_data(int ddc, mybuffer *mybuf) {
 
 static gpointer iq_thread(gpointer data) {
   int ddc = GPOINTER_TO_INT(data);
-  //
-  // TEMPORARY: additional sequence check here
-  //
   int nptr, optr;
-  long sequence;
-  long expected_sequence = 0;
+  guint32 sequence;
   volatile mybuffer *mybuf;
   const unsigned char *buffer;
   t_print("iq_thread: ddc=%d\n", ddc);
@@ -2279,46 +2315,115 @@ static gpointer iq_thread(gpointer data) {
     if (mybuf->free) { continue; }
 
     buffer = (unsigned char *) mybuf->buffer;
-    //
-    //  TEMP: perform additional sequence check
-    //
     sequence = ((buffer[0] & 0xFF) << 24) + ((buffer[1] & 0xFF) << 16) + ((buffer[2] & 0xFF) << 8) + (buffer[3] & 0xFF);
+    int lost = net_stream_sequence(&ddc_stream[ddc], sequence);
 
-    if (expected_sequence == 0) { expected_sequence = sequence; }
+    if (lost > 0) {
+      conceal_ddc_data(ddc, buffer, lost);
+    }
 
-    if (sequence != expected_sequence) {
-      t_print("%s: DDC(%d) sequence error: expected %ld got %ld\n", __FUNCTION__, ddc, expected_sequence, sequence);
-      sequence_errors++;
+    if (lost >= 0) {
+      process_ddc_data(ddc, buffer, mybuf->stamp);
     }
 
-    expected_sequence = sequence + 1;
+    mybuf->free = 1;
+  }
 
-    //
-    //  Now comes the action table:
-    //  for each DDC we have set up which action to be taken
-    //  (and, possibly, for which receiver)
-    //
-    switch (rxcase[ddc]) {
-    case RXACTION_SKIP:
-      break;
+  return NULL;
+}
 
-    case RXACTION_NORMAL:
-      process_iq_data(buffer, receiver[rxid[ddc]]);
-      break;
+//
+// stamp is the arrival time of the packet, 0 for concealed packets
+//
+static void process_ddc_data(int ddc, const unsigned char *buffer, gint64 stamp) {
+  int samplesperframe = ((buffer[14] & 0xFF) << 8) + (buffer[15] & 0xFF);
 
-    case RXACTION_PS:
-      process_ps_iq_data(buffer);
-      break;
+  //
+  //  Now comes the action table:
+  //  for each DDC we have set up which action to be taken
+  //  (and, possibly, for which receiver)
+  //
+  switch (rxcase[ddc]) {
+  case RXACTION_SKIP:
+    break;
 
-    case RXACTION_DIV:
-      process_div_iq_data(buffer);
-      break;
+  case RXACTION_NORMAL:
+    if (stamp != 0) { rx_stamp_iq(receiver[rxid[ddc]], stamp); }
+
+    process_iq_data(buffer, receiver[rxid[ddc]]);
+    break;
+
+  case RXACTION_PS:
+    process_ps_iq_data(buffer);
+    break;
+
+  case RXACTION_DIV:
+    if (stamp != 0) {
+      rx_stamp_iq(receiver[0], stamp);
+
+      if (receivers > 1) { rx_stamp_iq(receiver[1], stamp); }
     }
 
-    mybuf->free = 1;
+    process_div_iq_data(buffer);
+    break;
   }
 
-  return NULL;
+  //
+  // Remember the last two sample pairs (PS and DIV packets contain
+  // interleaved pairs from two ADCs)
+  //
+  if (samplesperframe >= 2 && 16 + 6 * samplesperframe <= NET_BUFFER_SIZE) {
+    memcpy(ddc_last[ddc], buffer + 16 + 6 * (samplesperframe - 2), 12);
+  }
+}
+
+static int get24(const unsigned char *p) {
+  return ((int)((signed char) p[0]) << 16) | ((p[1] & 0xFF) << 8) | (p[2] & 0xFF);
+}
+
+static void put24(unsigned char *p, int v) {
+  p[0] = (v >> 16) & 0xFF;
+  p[1] = (v >>  8) & 0xFF;
+  p[2] = (v      ) & 0xFF;
+}
+
+//
+// Insert "lost" packets before the packet in buffer, to keep the sample
+// timeline continuous. Their samples interpolate linearly between the last
+// samples of the previous packet and the first samples of this one, which
+// avoids the clicks (and AGC transients) of a zero-filled gap.
+// For PS and DIV, even and odd sample pairs come from different ADCs and
+// are interpolated separately.
+//
+static void conceal_ddc_data(int ddc, const unsigned char *buffer, int lost) {
+  unsigned char fake[NET_BUFFER_SIZE];
+  unsigned char last[12];
+  int samplesperframe = ((buffer[14] & 0xFF) << 8) + (buffer[15] & 0xFF);
+  int lanes = (rxcase[ddc] == RXACTION_PS || rxcase[ddc] == RXACTION_DIV) ? 2 : 1;
+
+  if (samplesperframe < 2 || 16 + 6 * samplesperframe > NET_BUFFER_SIZE) { return; }
+
+  int frames = samplesperframe / lanes;          // per packet
+  double total = (double)(lost * frames + 1);
+  memcpy(last, ddc_last[ddc], sizeof(last));  // process_ddc_data() overwrites ddc_last
+  memcpy(fake, buffer, 16);
+
+  for (int p = 0; p < lost; p++) {
+    for (int i = 0; i < samplesperframe; i++) {
+      int lane = i % lanes;
+      const unsigned char *from = last + 6 * (lane + 2 - lanes);
+      const unsigned char *to = buffer + 16 + 6 * lane;
+      double t = (double)(p * frames + i / lanes + 1) / total;
+
+      for (int k = 0; k < 6; k += 3) {
+        int a = get24(from + k);
+        int b = get24(to + k);
+        put24(fake + 16 + 6 * i + k, a + (int)(t * (b - a)));
+      }
+    }
+
+    process_ddc_data(ddc, fake, 0);
+  }
 }
 
 static void process_iq_data(const unsigned char *buffer, RECEIVER *rx) {
@@ -2502,13 +2607,11 @@ static void process_high_priority() {
   const unsigned char *buffer = high_priority_buffer->buffer;
   sequence = ((buffer[0] & 0xFF) << 24) + ((buffer[1] & 0xFF) << 16) + ((buffer[2] & 0xFF) << 8) + (buffer[3] & 0xFF);
 
-  if (sequence != highprio_rcvd_sequence) {
-    t_print("HighPrio SeqErr Expected=%ld Seen=%ld\n", highprio_rcvd_sequence, sequence);
-    highprio_rcvd_sequence = sequence;
-    sequence_errors++;
-  }
+  //
+  // Status packets are not concealed, but outdated ones are dropped
+  //
+  if (net_stream_sequence(&highprio_stream, sequence) < 0) { return; }
 
-  highprio_rcvd_sequence++;
   previous_ptt = radio_ptt;
   previous_dot = radio_dot;
   previous_dash = radio_dash;
@@ -2621,23 +2724,38 @@ static void process_high_priority() {
 }
 
 static void process_mic_data(const unsigned char *buffer) {
-  unsigned long sequence;
-  int b;
-  int i;
-  float fsample;
+  guint32 sequence;
   sequence = ((buffer[0] & 0xFF) << 24) + ((buffer[1] & 0xFF) << 16) + ((buffer[2] & 0xFF) << 8) + (buffer[3] & 0xFF);
+  int lost = net_stream_sequence(&mic_stream, sequence);
 
-  if (sequence != micsamples_sequence) {
-    t_print("MicSample SeqErr Expected=%ld Seen=%ld\n", micsamples_sequence, sequence);
-    sequence_errors++;
+  //
+  // Lost mic packets are replaced by silence
+  //
+  for (int i = 0; i < lost; i++) {
+    process_mic_samples(NULL);
+  }
+
+  if (lost >= 0) {
+    process_mic_samples(buffer);
   }
+}
 
-  micsamples_sequence = sequence + 1;
+//
+// Feed one packet of mic samples (or silence if buffer is NULL) to the TX engine
+//
+static void process_mic_samples(const unsigned char *buffer) {
+  int b;
+  int i;
+  float fsample;
   b = 4;
 
   for (i = 0; i < MIC_SAMPLES; i++) {
-    short sample = (short)(buffer[b++] << 8);
-    sample |= (short) (buffer[b++] & 0xFF);
+    short sample = 0;
+
+    if (buffer != NULL) {
+      sample  = (short)(buffer[b++] << 8);
+      sample |= (short) (buffer[b++] & 0xFF);
+    }
 
     //
     // If PTT comes from the radio, possibly use audio from BOTH sources
@@ -2658,7 +2776,7 @@ static void process_mic_data(const unsigned char *buffer) {
 void new_protocol_cw_audio_samples(short left_audio_sample, short right_audio_sample) {
   int txmode = vfo_get_tx_mode();
 
-  if (radio_is_transmitting() && (txmode == modeCWU || txmode == modeCWL)) {
+  if (radio_tx_active() && (txmode == modeCWU || txmode == modeCWL)) {
     //
     // Only process samples if transmitting in CW
     //
@@ -2723,7 +2841,7 @@ void new_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
   //
   // Only process samples if NOT transmitting in CW
   //
-  if (radio_is_transmitting() && (txmode == modeCWU || txmode == modeCWL)) { return; }
+  if (radio_tx_active() && (txmode == modeCWU || txmode == modeCWL)) { return; }
 
   pthread_mutex_lock(&send_rxaudio_mutex);
 
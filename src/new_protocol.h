@@ -69,6 +69,7 @@
 struct mybuffer_ {
   struct mybuffer_ *next;
   int             free;
+  gint64          stamp;      // arrival time (usec, monotonic)
   long            lowfence;
   unsigned char   buffer[NET_BUFFER_SIZE];
   long            highfence;
@@ -153,6 +153,7 @@ static pthread_t rx_thread_id[NUMRECEIVERS];
 static pthread_t tx_thread_id;
 static pthread_t mic_thread_id;
 static pthread_t audio_thread_id;
+static pthread_t wideband_thread_id;
 static pthread_t highprio_thread_id = 0;
 static pthread_t send_highprio_thread_id;
 
@@ -166,6 +167,7 @@ void   *rx_thread(void *);
 void   *tx_thread(void *);
 void   *mic_thread(void *);
 void   *audio_thread(void *);
+void   *wideband_thread(void *);
 
 static double txlevel;
 
@@ -850,6 +852,10 @@ void *highprio_thread(void *data) {
         if (pthread_create(&audio_thread_id, NULL, audio_thread, NULL) < 0) {
           t_perror("***** ERROR: Create Audio thread");
         }
+
+        if (pthread_create(&wideband_thread_id, NULL, wideband_thread, NULL) < 0) {
+          t_perror("***** ERROR: Create Wideband thread");
+        }
       } else {
         // Clean-Up done below
         break;
@@ -1058,6 +1064,7 @@ void *highprio_thread(void *data) {
   pthread_join(tx_thread_id, NULL);
   pthread_join(mic_thread_id, NULL);
   pthread_join(audio_thread_id, NULL);
+  pthread_join(wideband_thread_id, NULL);
   t_print("HP thread terminating.\n");
   watchdog_count = 0;
   highprio_thread_id = 0;
@@ -1088,6 +1095,7 @@ void *rx_thread(void *data) {
   int divptr;
   int decimation;
   unsigned int seed;
+  SIM_IMPAIR impair;
   double off, tonearg, tonedelta;
   double off2, tonearg2, tonedelta2;
   int do_tone, t3p, t3l;
@@ -1103,6 +1111,7 @@ void *rx_thread(void *data) {
   seqnum = 0;
   // unique seed value for random number generator
   seed = ((uintptr_t) &seed) & 0xffffff;
+  sim_impair_init(&impair, 10 + myddc);
   sock = socket(AF_INET, SOCK_DGRAM, 0);
 
   if (sock < 0) {
@@ -1357,7 +1366,7 @@ void *rx_thread(void *data) {
 
     clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &delay, NULL);
 
-    if (sendto(sock, buffer, 1444, 0, (struct sockaddr * )&addr_new, sizeof(addr_new)) < 0) {
+    if (sim_sendto(&impair, sock, buffer, 1444, &addr_new) < 0) {
       t_perror("***** ERROR: RX thread sendto");
       break;
     }
@@ -1535,7 +1544,9 @@ void *send_highprio_thread(void *data) {
   unsigned char uc;
   int yes = 1;
   int rc;
+  SIM_IMPAIR impair;
   seqnum = 0;
+  sim_impair_init(&impair, 2);
   sock = socket(AF_INET, SOCK_DGRAM, 0);
 
   if (sock < 0) {
@@ -1670,7 +1681,7 @@ void *send_highprio_thread(void *data) {
     buffer[59] = uc;   // Digital user inputs
     radio_digi_changed = 0;
 
-    if (sendto(sock, buffer, 60, 0, (struct sockaddr * )&addr_new, sizeof(addr_new)) < 0) {
+    if (sim_sendto(&impair, sock, buffer, 60, &addr_new) < 0) {
       t_perror("***** ERROR: HP send thread sendto");
       break;
     }
@@ -1806,6 +1817,8 @@ void *mic_thread(void *data) {
   unsigned char *p;
   int yes = 1;
   struct timespec delay;
+  SIM_IMPAIR impair;
+  sim_impair_init(&impair, 3);
   sock = socket(AF_INET, SOCK_DGRAM, 0);
 
   if (sock < 0) {
@@ -1854,7 +1867,7 @@ void *mic_thread(void *data) {
 
     clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &delay, NULL);
 
-    if (sendto(sock, buffer, 132, 0, (struct sockaddr * )&addr_new, sizeof(addr_new)) < 0) {
+    if (sim_sendto(&impair, sock, buffer, 132, &addr_new) < 0) {
       t_perror("***** ERROR: Mic thread sendto");
       break;
     }
@@ -1863,3 +1876,91 @@ void *mic_thread(void *data) {
   close(sock);
   return NULL;
 }
+
+//
+// Wideband (bandscope) data of ADC0: every wide_rate msec, a frame of
+// wide_ppf packets with wide_len 16-bit big-endian raw ADC samples each
+//
+#define WIDE_MAX_LEN   1024
+#define WIDE_MAX_FRAME 65536
+
+void *wideband_thread(void *data) {
+  int sock;
+  struct sockaddr_in addr;
+  unsigned long seqnum = 0;
+  unsigned char buffer[4 + 2 * WIDE_MAX_LEN];
+  static int16_t samples[WIDE_MAX_FRAME];
+  unsigned int seed;
+  int yes = 1;
+  struct timespec delay;
+  SIM_IMPAIR impair;
+  seed = ((uintptr_t) &seed) & 0xffffff;
+  sim_impair_init(&impair, 5);
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (sock < 0) {
+    t_perror("***** ERROR: Wideband thread: socket");
+    return NULL;
+  }
+
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (void *)&yes, sizeof(yes));
+  setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (void *)&yes, sizeof(yes));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(wide_port);
+
+  if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    t_perror("***** ERROR: Wideband thread: bind");
+    close(sock);
+    return NULL;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &delay);
+
+  while (run) {
+    int len = wide_len;
+    int ppf = wide_ppf;
+    int interval = wide_rate > 0 ? wide_rate : 70;
+
+    if (!(wide_enable & 0x01) || wide_size != 16 || len <= 0 || len > WIDE_MAX_LEN || ppf <= 0
+        || len * ppf > WIDE_MAX_FRAME) {
+      usleep(5000);
+      clock_gettime(CLOCK_MONOTONIC, &delay);
+      continue;
+    }
+
+    sim_wideband_frame(samples, len * ppf, &seed);
+
+    for (int p = 0; p < ppf; p++) {
+      buffer[0] = (seqnum >> 24) & 0xFF;
+      buffer[1] = (seqnum >> 16) & 0xFF;
+      buffer[2] = (seqnum >>  8) & 0xFF;
+      buffer[3] = (seqnum >>  0) & 0xFF;
+      seqnum++;
+
+      for (int i = 0; i < len; i++) {
+        int16_t s = samples[len * p + i];
+        buffer[4 + 2 * i] = (s >> 8) & 0xFF;
+        buffer[5 + 2 * i] = s & 0xFF;
+      }
+
+      if (sim_sendto(&impair, sock, buffer, 4 + 2 * len, &addr_new) < 0) {
+        t_perror("***** ERROR: Wideband thread sendto");
+        break;
+      }
+    }
+
+    delay.tv_nsec += 1000000L * interval;
+
+    while (delay.tv_nsec >= 1000000000) {
+      delay.tv_nsec -= 1000000000;
+      delay.tv_sec++;
+    }
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &delay, NULL);
+  }
+
+  close(sock);
+  return NULL;
+}
@@ -113,7 +113,7 @@ static void nb_cb(GtkToggleButton *widget, gpointer data) {
 }
 
 static void nr_cb(GtkToggleButton *widget, gpointer data) {
-  active_receiver->nr = gtk_combo_box_get_active (GTK_COMBO_BOX(widget));
+  active_receiver->nr = atoi(gtk_combo_box_get_active_id(GTK_COMBO_BOX(widget)));
   update_noise();
 }
 
@@ -122,6 +122,11 @@ static void anf_cb(GtkWidget *widget, gpointer data) {
   update_noise();
 }
 
+static void carrier_notch_cb(GtkWidget *widget, gpointer data) {
+  active_receiver->carrier_notch = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget));
+  update_noise();
+}
+
 static void snb_cb(GtkWidget *widget, gpointer data) {
   active_receiver->snb = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget));
   update_noise();
@@ -291,6 +296,14 @@ void noise_menu(GtkWidget *parent) {
   gtk_widget_set_name(close_b, "close_button");
   g_signal_connect (close_b, "button-press-event", G_CALLBACK(close_cb), NULL);
   gtk_grid_attach(GTK_GRID(grid), close_b, 0, 0, 1, 1);
+  GtkWidget *b_carrier = gtk_check_button_new_with_label("Carrier Notch");
+  gtk_widget_set_name(b_carrier, "boldlabel");
+  gtk_widget_set_tooltip_text(b_carrier, "Automatically notch steady carriers inside the RX filter.\n"
+                              "Works best with the panadapter zoomed in.");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (b_carrier), active_receiver->carrier_notch);
+  gtk_widget_show(b_carrier);
+  gtk_grid_attach(GTK_GRID(grid), b_carrier, 1, 0, 2, 1);
+  g_signal_connect(b_carrier, "toggled", G_CALLBACK(carrier_notch_cb), NULL);
   //
   // First row: SNB/ANF/NR method
   //
@@ -317,14 +330,20 @@ void noise_menu(GtkWidget *parent) {
   gtk_widget_show(nr_title);
   gtk_grid_attach(GTK_GRID(grid), nr_title, 2, 1, 1, 1);
   GtkWidget *nr_combo = gtk_combo_box_text_new();
-  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), NULL, "NONE");
-  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), NULL, "NR");
-  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), NULL, "NR2");
+  //
+  // The combo box IDs are the values of rx->nr, since NR3/NR4 may be missing
+  //
+  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), "0", "NONE");
+  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), "1", "NR");
+  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), "2", "NR2");
 #ifdef EXTNR
-  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), NULL, "NR3");
-  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), NULL, "NR4");
+  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), "3", "NR3");
+  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), "4", "NR4");
 #endif
-  gtk_combo_box_set_active(GTK_COMBO_BOX(nr_combo), active_receiver->nr);
+  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(nr_combo), "5", "NR5");
+  char nr_id[8];
+  snprintf(nr_id, sizeof(nr_id), "%d", active_receiver->nr);
+  gtk_combo_box_set_active_id(GTK_COMBO_BOX(nr_combo), nr_id);
   gtk_widget_set_hexpand(GTK_WIDGET(nr_combo), FALSE);
   gtk_widget_set_halign(nr_combo, GTK_ALIGN_START);
   my_combo_attach(GTK_GRID(grid), nr_combo, 3, 1, 1, 1);
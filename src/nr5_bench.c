@@ -0,0 +1,434 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Benchmark for the NR5 noise reduction (WDSP ssnr.c) against NR2 (emnr.c).
+ *
+ * A synthetic voice (harmonics of a wobbling 140 Hz pitch with two formants,
+ * in bursts of 300 msec every 500 msec) is mixed with white noise at input
+ * SNRs of 0, 5 and 10 dB and run through SSNR and EMNR with the settings of
+ * RXA.c, as one receiver at 48 kHz with blocks of 1024 samples.
+ * For each input SNR the program reports
+ *   - the output SNR, after removing the delay and the gain of the stage,
+ *   - the CPU time per receiver in percent of real time,
+ * and checks that NR5 improves the SNR by at least -mingain dB. The CPU
+ * time is printed for information only, it depends on the machine and
+ * its load. The exit code is 0 if all checks pass.
+ *
+ * With -i, a recorded IQ file (as the DVR writes it: WAV, two float
+ * channels, any sample rate) is used instead. It is resampled to 48 kHz
+ * and demodulated as USB (150...2850 Hz). There is no clean reference
+ * here, so the SNR is estimated from the power of 20 msec frames and the
+ * result is reported only.
+ *
+ * Build and run: make nr5_bench && ./nr5_bench
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comm.h"
+#include "test_util.h"
+
+#define NR_RATE    48000
+#define NR_SIZE    1024
+#define NR_MAXLAG  4096                  // more than the EMNR latency
+#define NR_SETTLE  3.0                   // seconds before the measurement starts
+#define NR_TAPS    512                   // USB filter for recorded IQ
+
+static double duration = 20.0;           // seconds of signal
+static double min_gain = 6.0;            // required SNR improvement of NR5 (dB)
+static const char *iq_file = NULL;       // recorded IQ instead of the synthetic signal
+
+static long ns;
+static double *clean, *noise, *noisy, *output;
+
+static double gauss(unsigned int *seed) {
+  double u = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+  double v = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+  return sqrt(-2.0 * log(u)) * cos(TWOPI * v);
+}
+
+static void make_signals(void) {
+  unsigned int seed = 1;
+  double ph = 0.0;
+
+  for (long i = 0; i < ns; i++) {
+    double t = (double) i / NR_RATE;
+    double f0 = 140.0 + 30.0 * sin(TWOPI * 0.7 * t);
+    double s = 0.0;
+    double burst = fmod(t, 0.5);
+    ph += TWOPI * f0 / NR_RATE;
+
+    for (int h = 1; h * f0 <= 2800.0; h++) {
+      double f = h * f0;
+      double a = exp(-pow((f - 600.0) / 400.0, 2)) + 0.5 * exp(-pow((f - 1700.0) / 500.0, 2)) + 0.1;
+      s += a * sin(h * ph + 0.3 * h * h);
+    }
+
+    clean[i] = burst < 0.3 ? s * sin(PI * burst / 0.3) : 0.0;
+    noise[i] = gauss(&seed);
+  }
+}
+
+//
+// Output SNR: find the delay, scale the output to the clean signal by
+// least squares, everything that is left is noise and distortion
+//
+static double output_snr(void) {
+  long start = (long)(NR_SETTLE * NR_RATE);
+  long end = ns - NR_MAXLAG;
+  double num = 0.0, den = 0.0, err = 0.0, scale;
+  int lag = 0;
+
+  //
+  // coarse search in steps of 8 samples, then around the best one
+  //
+  for (int step = 8; step > 0; step /= 8) {
+    int from = step == 8 ? 0 : (lag > 8 ? lag - 8 : 0);
+    int to = step == 8 ? NR_MAXLAG - 1 : (lag < NR_MAXLAG - 9 ? lag + 8 : NR_MAXLAG - 1);
+    double best = -1.0e300;
+
+    for (int d = from; d <= to; d += step) {
+      double c = 0.0;
+
+      for (long i = start; i < end; i += 4) {
+        c += output[i + d] * clean[i];
+      }
+
+      if (c > best) {
+        best = c;
+        lag = d;
+      }
+    }
+  }
+
+  for (long i = start; i < end; i++) {
+    num += output[i + lag] * clean[i];
+    den += clean[i] * clean[i];
+  }
+
+  scale = num / den;
+
+  for (long i = start; i < end; i++) {
+    double e = output[i + lag] / scale - clean[i];
+    err += e * e;
+  }
+
+  return 10.0 * log10(den / err);
+}
+
+//
+// Without a clean reference, estimate the SNR from the power of 20 msec
+// frames: the quietest tenth is taken as the noise, the loudest tenth as
+// signal plus noise
+//
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+static double estimated_snr(const double *x) {
+  int len = NR_RATE / 50;
+  long start = (long)(NR_SETTLE * NR_RATE);
+  int n = (int)((ns - NR_MAXLAG - start) / len);
+  double *pwr = malloc(n * sizeof(double));
+  double pn, psn;
+
+  for (int k = 0; k < n; k++) {
+    const double *f = x + start + (long) k * len;
+    pwr[k] = 0.0;
+
+    for (int i = 0; i < len; i++) {
+      pwr[k] += f[i] * f[i];
+    }
+  }
+
+  qsort(pwr, n, sizeof(double), cmp_double);
+  pn = pwr[n / 10];
+  psn = pwr[n - 1 - n / 10];
+  free(pwr);
+
+  if (psn <= pn) { return 0.0; }
+
+  return 10.0 * log10((psn - pn) / (pn + 1.0e-300));
+}
+
+static unsigned int le16(const unsigned char *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static unsigned long le32(const unsigned char *p) {
+  return le16(p) | ((unsigned long) le16(p + 2) << 16);
+}
+
+//
+// Read a recorded IQ file, resample it to NR_RATE and demodulate USB into
+// noisy[]. Returns 0 on success.
+//
+static int read_iq(const char *filename) {
+  FILE *fp = fopen(filename, "rb");
+  unsigned char h[16], f[8 * NR_SIZE];
+  int format = 0, channels = 0, bits = 0, rate = 0, outmax;
+  long remaining = -1, cap = 0, n48 = 0;
+  double *in, *out, *taps, *iq = NULL;
+  size_t got;
+  RESAMPLE rs;
+
+  if (fp == NULL) {
+    perror(filename);
+    return -1;
+  }
+
+  if (fread(h, 1, 12, fp) != 12 || memcmp(h, "RIFF", 4) || memcmp(h + 8, "WAVE", 4)) {
+    fprintf(stderr, "%s: not a WAV file\n", filename);
+    fclose(fp);
+    return -1;
+  }
+
+  //
+  // walk the chunks up to the sample data
+  //
+  while (fread(h, 1, 8, fp) == 8) {
+    long size = le32(h + 4);
+    long skip = size + (size & 1);
+
+    if (!memcmp(h, "data", 4)) {
+      remaining = size / 8;
+      break;
+    }
+
+    if (!memcmp(h, "fmt ", 4) && size >= 16) {
+      if (fread(h, 1, 16, fp) != 16) { break; }
+
+      format   = le16(h);
+      channels = le16(h + 2);
+      rate     = le32(h + 4);
+      bits     = le16(h + 14);
+      skip    -= 16;
+    }
+
+    if (fseek(fp, skip, SEEK_CUR) != 0) { break; }
+  }
+
+  if (remaining < 0 || format != 3 || channels != 2 || bits != 32 || rate < 8000) {
+    fprintf(stderr, "%s: need IQ as two float channels (fmt=%d ch=%d rate=%d bits=%d)\n",
+            filename, format, channels, rate, bits);
+    fclose(fp);
+    return -1;
+  }
+
+  outmax = (int)((long) NR_SIZE * NR_RATE / rate) + 16;
+  in = (double *) malloc0(2 * NR_SIZE * sizeof(double));
+  out = (double *) malloc0(2 * outmax * sizeof(double));
+  rs = create_resample(rate != NR_RATE, NR_SIZE, in, out, rate, NR_RATE, 0.0, 0, 1.0);
+
+  while (remaining > 0 && (got = fread(f, 8, remaining < NR_SIZE ? remaining : NR_SIZE, fp)) > 0) {
+    int m;
+    remaining -= got;
+
+    for (int i = 0; i < 2 * NR_SIZE; i++) {
+      union { uint32_t u; float v; } x;
+      x.u = le32(f + 4 * i);
+      in[i] = i < 2 * (int) got ? x.v : 0.0;
+    }
+
+    m = xresample(rs);
+
+    if (rate == NR_RATE) { m = NR_SIZE; }
+
+    if (n48 + m > cap) {
+      cap = 2 * cap + outmax;
+      iq = realloc(iq, 2 * cap * sizeof(double));
+    }
+
+    memcpy(iq + 2 * n48, out, 2 * m * sizeof(double));
+    n48 += m;
+  }
+
+  fclose(fp);
+  destroy_resample(rs);
+  _aligned_free(in);
+  _aligned_free(out);
+  ns = n48 / NR_SIZE * NR_SIZE;
+
+  if (ns < (long)(2.0 * NR_SETTLE * NR_RATE)) {
+    fprintf(stderr, "%s: need at least %.0f seconds of IQ\n", filename, 2.0 * NR_SETTLE);
+    free(iq);
+    return -1;
+  }
+
+  //
+  // USB: complex bandpass 150...2850 Hz, keep the real part. fir_bandpass()
+  // returns the conjugate response, as used by the FFT filter cores.
+  //
+  noisy = malloc(ns * sizeof(double));
+  output = malloc(ns * sizeof(double));
+  taps = fir_bandpass(NR_TAPS, 150.0, 2850.0, NR_RATE, 1, 1, 1.0);
+
+  for (long i = 0; i < ns; i++) {
+    double re = 0.0;
+
+    for (int k = 0; k < NR_TAPS && k <= i; k++) {
+      const double *x = iq + 2 * (i - k);
+      re += taps[2 * k] * x[0] + taps[2 * k + 1] * x[1];
+    }
+
+    noisy[i] = re;
+  }
+
+  _aligned_free(taps);
+  free(iq);
+  return 0;
+}
+
+//
+// Run one stage over the whole signal, return the CPU time in percent of real time
+//
+static double run(int nr5, double *buf) {
+  SSNR s = NULL;
+  EMNR e = NULL;
+  double dt;
+
+  if (nr5) {
+    s = create_ssnr(1, 0, NR_SIZE, buf, buf, NR_RATE, 15.0);
+  } else {
+    e = create_emnr(1, 0, NR_SIZE, buf, buf, 4096, 4, NR_RATE, 0, 1.0, 2, 0, 1);
+  }
+
+  dt = 0.0;
+
+  for (long b = 0; b + NR_SIZE <= ns; b += NR_SIZE) {
+    double start;
+
+    for (int i = 0; i < NR_SIZE; i++) {
+      buf[2 * i + 0] = noisy[b + i];
+      buf[2 * i + 1] = 0.0;
+    }
+
+    start = now();
+
+    if (nr5) {
+      xssnr(s, 0);
+    } else {
+      xemnr(e, 0);
+    }
+
+    dt += now() - start;
+
+    for (int i = 0; i < NR_SIZE; i++) {
+      output[b + i] = buf[2 * i + 0];
+    }
+  }
+
+  if (nr5) {
+    destroy_ssnr(s);
+  } else {
+    destroy_emnr(e);
+  }
+
+  return 100.0 * dt / ((double) ns / NR_RATE);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-t <seconds>] [-mingain <dB>] [-i <IQ file>]\n", prog);
+  exit(8);
+}
+
+int main(int argc, char *argv[]) {
+  static const double snr_in[3] = { 0.0, 5.0, 10.0 };
+  double *buf;
+  double ps = 0.0, pn = 0.0;
+  char what[128];
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-t")       && i < argc - 1) { duration = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-mingain") && i < argc - 1) { min_gain = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-i")       && i < argc - 1) { iq_file = argv[++i]; continue; }
+
+    usage(argv[0]);
+  }
+
+  if (duration < 2.0 * NR_SETTLE) { usage(argv[0]); }
+
+  buf = (double *) malloc0(2 * NR_SIZE * sizeof(double));
+
+  if (iq_file != NULL) {
+    double in, cpu5, cpu2, out5, out2;
+
+    if (read_iq(iq_file) != 0) { return 1; }
+
+    in = estimated_snr(noisy);
+    cpu5 = run(1, buf);
+    out5 = estimated_snr(output);
+    cpu2 = run(0, buf);
+    out2 = estimated_snr(output);
+    printf("SNR in   NR5 out  NR2 out  NR5 CPU  NR2 CPU   (estimated SNR, CPU per receiver, %% of real time)\n");
+    printf("%5.1f dB %5.1f dB  %5.1f dB  %5.2f%%   %5.2f%%\n", in, out5, out2, cpu5, cpu2);
+    printf("%s: %.1f s, NR5 improves the estimated SNR by %.1f dB, NR2 by %.1f dB\n",
+           iq_file, (double) ns / NR_RATE, out5 - in, out2 - in);
+    _aligned_free(buf);
+    free(noisy);
+    free(output);
+    return 0;
+  }
+
+  ns = (long)(duration * NR_RATE);
+  clean = malloc(ns * sizeof(double));
+  noise = malloc(ns * sizeof(double));
+  noisy = malloc(ns * sizeof(double));
+  output = malloc(ns * sizeof(double));
+  make_signals();
+
+  for (long i = 0; i < ns; i++) {
+    ps += clean[i] * clean[i];
+    pn += noise[i] * noise[i];
+  }
+
+  printf("SNR in   NR5 out  NR2 out  NR5 CPU  NR2 CPU   (CPU per receiver, %% of real time)\n");
+
+  for (int k = 0; k < 3; k++) {
+    double g = sqrt(ps / pn / pow(10.0, 0.1 * snr_in[k]));
+    double cpu5, cpu2, out5, out2;
+
+    for (long i = 0; i < ns; i++) {
+      noisy[i] = clean[i] + g * noise[i];
+    }
+
+    cpu5 = run(1, buf);
+    out5 = output_snr();
+    cpu2 = run(0, buf);
+    out2 = output_snr();
+    printf("%5.1f dB %5.1f dB  %5.1f dB  %5.2f%%   %5.2f%%\n", snr_in[k], out5, out2, cpu5, cpu2);
+    snprintf(what, sizeof(what), "%.0f dB in: NR5 improves the SNR by %.1f dB", snr_in[k], out5 - snr_in[k]);
+    check(out5 - snr_in[k] >= min_gain, what);
+  }
+
+  _aligned_free(buf);
+  free(clean);
+  free(noise);
+  free(noisy);
+  free(output);
+  return test_result();
+}
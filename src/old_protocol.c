@@ -44,6 +44,7 @@
 #include "main.h"
 #include "audio.h"
 #include "band.h"
+#include "bandscope.h"
 #include "discovered.h"
 #include "mode.h"
 #include "filter.h"
@@ -55,6 +56,7 @@
 #include "ext.h"
 #include "iambic.h"
 #include "message.h"
+#include "net_stream.h"
 #ifdef __APPLE__
   #include "toolset.h"
 #endif
@@ -142,9 +144,36 @@ static unsigned char control_in[5] = {0x00, 0x00, 0x00, 0x00, 0x00};
 
 static volatile int P1running = 0;
 
-static uint32_t last_seq_num = -0xffffffff;
+static NET_STREAM ep6_stream;
 static int tx_fifo_flag = 0;
 
+//
+// HermesLite-II TX FIFO readback. The FIFO depth is reported in every C&C
+// response with address 0 and is used by the TX IQ thread to pace the
+// outgoing packets (closed loop), such that the FIFO stays close to the
+// TX latency programmed into the HL2 (see hl2_tx_latency_ms()).
+// A small latency (CW) then gives a short key-down delay without under-runs.
+//
+static atomic_int hl2_fifo_depth;   // last reported depth (samples)
+static atomic_int hl2_fifo_fresh;   // set when a new report has arrived
+static atomic_int hl2_fifo_target;  // target depth (samples), 0 if unknown
+
+//
+// Statistics of the current TX phase (and totals), reported when going RX
+//
+static struct _hl2_fifo_stats {
+  long reports;
+  long sum;
+  int  min;
+  int  max;
+  int  underruns;
+  int  overruns;
+  int  last_underrun;
+  int  last_overrun;
+  long total_underruns;
+  long total_overruns;
+} hl2_fifo_stats;
+
 static int current_rx = 0;
 
 static int mic_samples = 0;
@@ -161,7 +190,10 @@ static gpointer receive_thread(gpointer arg);
 static gpointer process_ozy_input_buffer_thread(gpointer arg);
 
 static void queue_two_ozy_input_buffers(unsigned const char *buf1,
-                                        unsigned const char *buf2);
+                                        unsigned const char *buf2, gint64 stamp);
+static void conceal_ozy_input_buffers(unsigned const char *buf, int lost);
+static void hl2_fifo_readback(int depth, int underrun, int overrun);
+static void hl2_fifo_phase_end(void);
 void ozy_send_buffer(void);
 
 static unsigned char metis_buffer[1032];
@@ -428,6 +460,7 @@ static unsigned char *RXRINGBUF = NULL;
 static atomic_int rxring_inptr;   // pointer updated when writing into the ring buffer
 static atomic_int rxring_outptr;  // pointer updated when reading from the ring buffer
 static atomic_int rxring_count;   // a sample counter
+static gint64 rxring_stamp[RXRINGBUFLEN / 1024];  // arrival time of each double-buffer, 0 if concealed
 
 #ifdef __APPLE__
 void old_protocol_update_timing(void) {
@@ -493,6 +526,25 @@ static gpointer old_protocol_txiq_thread(gpointer data) {
     // 🕒 Dynamisch berechneter Abstand je nach aktueller Sample-Rate
     int sr_local = atomic_load_explicit(&sr, memory_order_relaxed);
     int interval_us = 126 * 1000000 / (sr_local ? sr_local : 48000);
+    int target = atomic_load_explicit(&hl2_fifo_target, memory_order_relaxed);
+
+    //
+    // HL2 while TXing: use the reported FIFO depth to correct the pace.
+    // Catch up at once if the FIFO runs low, skip one slot if it holds
+    // more than one packet above the target.
+    //
+    if (device == DEVICE_HERMES_LITE2 && target > 0 && radio_tx_active()
+        && atomic_exchange_explicit(&hl2_fifo_fresh, 0, memory_order_acq_rel)) {
+      int depth = atomic_load_explicit(&hl2_fifo_depth, memory_order_relaxed);
+
+      if (depth < target / 2) {
+        clock_gettime(CLOCK_MONOTONIC, &target_time);
+        continue;
+      }
+
+      if (depth > target + 126) { target_time.tv_nsec += interval_us * 1000; }
+    }
+
     // ➤ Zielzeitpunkt für nächstes Paket berechnen
     target_time.tv_nsec += interval_us * 1000;
 
@@ -572,15 +624,42 @@ static gpointer old_protocol_txiq_thread(gpointer data) {
       FIFO = 0.0;
     }
 
-    //
-    // Depending on how we estimate the FIFO filling, wait
-    // 2000usec, or 500 usec, or nothing before sending
-    // out the next packet.
-    //
-    // Note that in reality, the "sleep" is a little bit longer
-    // than specified by ts (we cannot rely on a wake-up in time).
-    //
-    if (FIFO > 1500.0) {
+    int target = atomic_load_explicit(&hl2_fifo_target, memory_order_relaxed);
+
+    if (device == DEVICE_HERMES_LITE2 && target > 0 && radio_tx_active()) {
+      //
+      // HL2 while TXing: correct the estimate with the FIFO depth reported
+      // by the radio, and hold the FIFO at the target depth. If it is below,
+      // send at once, otherwise wait until the surplus has been consumed
+      // (but never longer than 2000 usec).
+      //
+      if (atomic_exchange_explicit(&hl2_fifo_fresh, 0, memory_order_acq_rel)) {
+        FIFO += 0.5 * ((double) atomic_load_explicit(&hl2_fifo_depth, memory_order_relaxed) - FIFO);
+      }
+
+      if (FIFO > target) {
+        long wait = (long)((FIFO - target) * 1.0E9 / 48000.0);  // TX IQ is always 48k
+
+        if (wait > 2000000L) { wait = 2000000L; }
+
+        ts.tv_nsec += wait;
+
+        if (ts.tv_nsec > 999999999) {
+          ts.tv_sec++;
+          ts.tv_nsec -= 1000000000;
+        }
+
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+      }
+    } else if (FIFO > 1500.0) {
+      //
+      // Depending on how we estimate the FIFO filling, wait
+      // 2000usec, or 500 usec, or nothing before sending
+      // out the next packet.
+      //
+      // Note that in reality, the "sleep" is a little bit longer
+      // than specified by ts (we cannot rely on a wake-up in time).
+      //
       // Wait about 2000 usec before sending the next packet.
       ts.tv_nsec += 2000000;
 
@@ -640,6 +719,12 @@ void old_protocol_stop() {
   P1running = 0;
   metis_start_stop(0);
   pthread_mutex_unlock(&send_ozy_mutex);
+  net_stream_report(&ep6_stream);
+
+  if (device == DEVICE_HERMES_LITE2) {
+    t_print("%s: HL2 TX FIFO underruns=%ld overruns=%ld\n", __FUNCTION__,
+            hl2_fifo_stats.total_underruns, hl2_fifo_stats.total_overruns);
+  }
 }
 
 void old_protocol_run() {
@@ -649,6 +734,17 @@ void old_protocol_run() {
   pthread_mutex_unlock(&send_ozy_mutex);
 }
 
+//
+// Re-send the start command to switch the EP4 (bandscope) data on or off
+//
+void old_protocol_bandscope() {
+  if (device == DEVICE_OZY || !P1running) { return; }
+
+  pthread_mutex_lock(&send_ozy_mutex);
+  metis_start_stop(bandscope_enabled ? 3 : 1);
+  pthread_mutex_unlock(&send_ozy_mutex);
+}
+
 void old_protocol_set_mic_sample_rate(int rate) {
   atomic_store_explicit(&mic_sample_divisor, rate / 48000, memory_order_relaxed);
 #ifdef __APPLE__
@@ -760,7 +856,7 @@ void old_protocol_init(int rate) {
 #ifdef USBOZY
 //
 // starts the threads for USB receive
-// EP4 is the bandscope endpoint (not yet used)
+// EP4 is the bandscope endpoint (not used with OZY)
 // EP6 is the "normal" USB frame endpoint
 //
 static void start_usb_receive_threads() {
@@ -874,8 +970,9 @@ static gpointer ozy_ep6_rx_thread(gpointer arg) {
     } else
       // process the received data normally
     {
-      queue_two_ozy_input_buffers(&ep6_inbuffer[   0], &ep6_inbuffer[ 512]);
-      queue_two_ozy_input_buffers(&ep6_inbuffer[1024], &ep6_inbuffer[1536]);
+      gint64 stamp = g_get_monotonic_time();
+      queue_two_ozy_input_buffers(&ep6_inbuffer[   0], &ep6_inbuffer[ 512], stamp);
+      queue_two_ozy_input_buffers(&ep6_inbuffer[1024], &ep6_inbuffer[1536], 0);
     }
   }
 
@@ -1223,23 +1320,26 @@ static gpointer receive_thread(gpointer arg) {
           // get the sequence number
           sequence = ((buffer[4] & 0xFF) << 24) + ((buffer[5] & 0xFF) << 16) + ((buffer[6] & 0xFF) << 8) + (buffer[7] & 0xFF);
 
-          // A sequence error with a seqnum of zero usually indicates a METIS restart
-          // and is no error condition
-          if (sequence != 0 && sequence != last_seq_num + 1) {
-            t_print("SEQ ERROR: last %ld, recvd %ld\n", (long) last_seq_num, (long) sequence);
-            sequence_errors++;
-          }
+          switch (ep) {
+          case 6: { // EP6
+            // A seqnum of zero usually indicates a METIS restart and is no error condition
+            if (sequence == 0) { net_stream_restart(&ep6_stream); }
 
-          last_seq_num = sequence;
+            gint64 stamp = net_stream_arrival(&ep6_stream);
+            int lost = net_stream_sequence(&ep6_stream, sequence);
+
+            if (lost < 0) { break; }
+
+            if (lost > 0) { conceal_ozy_input_buffers(&buffer[8], lost); }
 
-          switch (ep) {
-          case 6: // EP6
             // process the data
-            queue_two_ozy_input_buffers(&buffer[8], &buffer[520]);
-            break;
+            queue_two_ozy_input_buffers(&buffer[8], &buffer[520], stamp);
+          }
+          break;
 
           case 4: // EP4
-            // not implemented
+            if (bandscope_enabled) { bandscope_add_packet(&buffer[8], BS_PACKET_SAMPLES, sequence, BS_P1_PACKETS, 0); }
+
             break;
 
           default:
@@ -1357,26 +1457,25 @@ static gpointer receive_thread(gpointer arg) {
           sequence = ((buffer[4] & 0xFF) << 24) | ((buffer[5] & 0xFF) << 16) |
                      ((buffer[6] & 0xFF) << 8) | (buffer[7] & 0xFF);
 
-          if (sequence != 0 && sequence != last_seq_num + 1) {
-            long diff = (long)sequence - (long)last_seq_num;
+          switch (ep) {
+          case 6: {
+            if (sequence == 0) { net_stream_restart(&ep6_stream); }
+
+            gint64 stamp = net_stream_arrival(&ep6_stream);
+            int lost = net_stream_sequence(&ep6_stream, sequence);
 
-            if (diff > 1 || diff < 0) {
-              t_print("SEQ ERROR: last %ld, recvd %ld (diff=%ld)\n",
-                      (long)last_seq_num, (long)sequence, diff);
-              sequence_errors++;
-            }
-          }
+            if (lost < 0) { break; }
 
-          last_seq_num = sequence;
+            if (lost > 0) { conceal_ozy_input_buffers(&buffer[8], lost); }
 
-          switch (ep) {
-          case 6:
             // HL2 IQ-Daten
-            queue_two_ozy_input_buffers(&buffer[8], &buffer[520]);
-            break;
+            queue_two_ozy_input_buffers(&buffer[8], &buffer[520], stamp);
+          }
+          break;
+
+          case 4: // EP4
+            if (bandscope_enabled) { bandscope_add_packet(&buffer[8], BS_PACKET_SAMPLES, sequence, BS_P1_PACKETS, 0); }
 
-          case 4:
-            // nicht implementiert
             break;
 
           default:
@@ -1529,7 +1628,7 @@ static long long channel_freq(int chan) {
 
   // Radios (especially with small FPGAs) may use RX1/RX2 for feedback while transmitting,
   //
-  if (radio_is_transmitting() && transmitter->puresignal && (chan == rx_feedback_channel()
+  if (radio_tx_active() && transmitter->puresignal && (chan == rx_feedback_channel()
       || chan == tx_feedback_channel())) {
     vfonum = -1;
   }
@@ -1818,20 +1917,28 @@ static void process_control_bytes() {
       // until the first packet reporting "no underflow" after each
       // RX/TX transition.
       //
-      if (!radio_is_transmitting()) {
+      // The lower seven bits of C3 are the FIFO count in units of 32 samples.
+      //
+      if (!radio_tx_active()) {
         // during RX: set flag to zero
         tx_fifo_flag = 0;
         tx_fifo_underrun = 0;
+        hl2_fifo_phase_end();
       } else {
         // after RX/TX transition: ignore underflow condition
         // until it first vanishes. tx_fifo_flag becomes "true"
         // as soon as a "no underflow" condition is seen.
         //
+        int underrun = 0;
+        int overrun = 0;
+
         if ((control_in[3] & 0xC0) != 0x80) { tx_fifo_flag = 1; }
 
-        if ((control_in[3] & 0xC0) == 0x80 && tx_fifo_flag) { tx_fifo_underrun = 1; }
+        if ((control_in[3] & 0xC0) == 0x80 && tx_fifo_flag) { tx_fifo_underrun = underrun = 1; }
+
+        if ((control_in[3] & 0xC0) == 0xC0) { tx_fifo_overrun = overrun = 1; }
 
-        if ((control_in[3] & 0xC0) == 0xC0) { tx_fifo_overrun = 1; }
+        hl2_fifo_readback((control_in[3] & 0x7F) * 32, underrun, overrun);
       }
     }
 
@@ -1987,7 +2094,7 @@ static void process_ozy_byte(int b) {
     right_sample |= (int)((unsigned char)b & 0xFF);
     right_sample_double = (double)right_sample * 1.1920928955078125E-7;
 
-    if (radio_is_transmitting() && transmitter->puresignal) {
+    if (radio_tx_active() && transmitter->puresignal) {
       //
       // transmitting with PureSignal. Get sample pairs and feed to pscc
       //
@@ -2006,7 +2113,7 @@ static void process_ozy_byte(int b) {
       }
     }
 
-    if (!radio_is_transmitting() && diversity_enabled) {
+    if (!radio_tx_active() && diversity_enabled) {
       //
       // receiving with DIVERSITY. Get sample pairs and feed to diversity mixer.
       // If the second RX is running, feed aux samples to that receiver.
@@ -2024,7 +2131,7 @@ static void process_ozy_byte(int b) {
       }
     }
 
-    if ((!radio_is_transmitting() || duplex) && !diversity_enabled) {
+    if ((!radio_tx_active() || duplex) && !diversity_enabled) {
       //
       // RX without DIVERSITY. Feed samples to RX1 and RX2
       //
@@ -2090,7 +2197,7 @@ static void process_ozy_byte(int b) {
 }
 
 static void queue_two_ozy_input_buffers(unsigned const char *buf1,
-                                        unsigned const char *buf2) {
+                                        unsigned const char *buf2, gint64 stamp) {
   //
   // To achieve minimum overhead in the RX thread, the data is
   // simply put into a large ring buffer. We queue two buffers
@@ -2126,6 +2233,7 @@ static void queue_two_ozy_input_buffers(unsigned const char *buf1,
 
   memcpy((void *)(&RXRINGBUF[in]),       buf1, 512);
   memcpy((void *)(&RXRINGBUF[in + 512]), buf2, 512);
+  rxring_stamp[in / 1024] = stamp;
   MEMORY_BARRIER;
   atomic_store_explicit(&rxring_inptr, nptr, memory_order_release);
   sem_post(rxring_sem);
@@ -2134,6 +2242,7 @@ static void queue_two_ozy_input_buffers(unsigned const char *buf1,
   if (nptr != out) {
     memcpy((void *)(&RXRINGBUF[in]),       buf1, 512);
     memcpy((void *)(&RXRINGBUF[in + 512]), buf2, 512);
+    rxring_stamp[in / 1024] = stamp;
     MEMORY_BARRIER;
     atomic_store_explicit(&rxring_inptr, nptr, memory_order_release);
     sem_post(&rxring_sem);
@@ -2147,6 +2256,57 @@ static void queue_two_ozy_input_buffers(unsigned const char *buf1,
 #endif
 }
 
+static void hl2_fifo_readback(int depth, int underrun, int overrun) {
+  atomic_store_explicit(&hl2_fifo_depth, depth, memory_order_relaxed);
+  atomic_store_explicit(&hl2_fifo_fresh, 1, memory_order_release);
+
+  if (hl2_fifo_stats.reports == 0 || depth < hl2_fifo_stats.min) { hl2_fifo_stats.min = depth; }
+
+  if (hl2_fifo_stats.reports == 0 || depth > hl2_fifo_stats.max) { hl2_fifo_stats.max = depth; }
+
+  hl2_fifo_stats.reports++;
+  hl2_fifo_stats.sum += depth;
+
+  if (underrun && !hl2_fifo_stats.last_underrun) { hl2_fifo_stats.underruns++; }
+
+  if (overrun && !hl2_fifo_stats.last_overrun) { hl2_fifo_stats.overruns++; }
+
+  hl2_fifo_stats.last_underrun = underrun;
+  hl2_fifo_stats.last_overrun = overrun;
+}
+
+static void hl2_fifo_phase_end() {
+  if (hl2_fifo_stats.reports == 0) { return; }
+
+  t_print("%s: HL2 TX FIFO depth min=%d mean=%ld max=%d (target %d) samples, underruns=%d overruns=%d\n",
+          __FUNCTION__, hl2_fifo_stats.min, hl2_fifo_stats.sum / hl2_fifo_stats.reports, hl2_fifo_stats.max,
+          atomic_load_explicit(&hl2_fifo_target, memory_order_relaxed), hl2_fifo_stats.underruns,
+          hl2_fifo_stats.overruns);
+  hl2_fifo_stats.total_underruns += hl2_fifo_stats.underruns;
+  hl2_fifo_stats.total_overruns += hl2_fifo_stats.overruns;
+  hl2_fifo_stats.reports = 0;
+  hl2_fifo_stats.sum = 0;
+  hl2_fifo_stats.underruns = 0;
+  hl2_fifo_stats.overruns = 0;
+  hl2_fifo_stats.last_underrun = 0;
+  hl2_fifo_stats.last_overrun = 0;
+}
+
+//
+// Replace lost METIS packets by packets that carry the C&C bytes of the
+// next packet and silence (zero IQ and mic samples), such that the sample
+// timeline remains continuous.
+//
+static void conceal_ozy_input_buffers(unsigned const char *buf, int lost) {
+  static unsigned char silence[1024];  // only the C&C bytes are ever written
+  memcpy(silence, buf, 8);
+  memcpy(silence + 512, buf + 512, 8);
+
+  for (int i = 0; i < lost; i++) {
+    queue_two_ozy_input_buffers(silence, silence + 512, 0);
+  }
+}
+
 static gpointer process_ozy_input_buffer_thread(gpointer arg) {
   //
   // This thread constantly monitors the input ring buffer and
@@ -2174,6 +2334,11 @@ static gpointer process_ozy_input_buffer_thread(gpointer arg) {
     st_num_hpsdr_receivers = how_many_receivers();
     st_rxfdbk = rx_feedback_channel();
     st_txfdbk = tx_feedback_channel();
+    gint64 stamp = rxring_stamp[out / 1024];
+
+    if (stamp != 0) {
+      for (int i = 0; i < receivers && i < 2; i++) { rx_stamp_iq(receiver[i], stamp); }
+    }
 
     for (int i = 0; i < 1024; i++) { process_ozy_byte(RXRINGBUF[out + i] & 0xFF); }
 
@@ -2185,7 +2350,7 @@ static gpointer process_ozy_input_buffer_thread(gpointer arg) {
 }
 
 void old_protocol_audio_samples(short left_audio_sample, short right_audio_sample) {
-  if (!radio_is_transmitting()) {
+  if (!radio_tx_active()) {
     pthread_mutex_lock(&send_audio_mutex);
     int tc = atomic_load_explicit(&txring_count, memory_order_relaxed);
 
@@ -2275,7 +2440,7 @@ void old_protocol_audio_samples(short left_audio_sample, short right_audio_sampl
 }
 
 void old_protocol_iq_samples(int isample, int qsample, int side) {
-  if (radio_is_transmitting()) {
+  if (radio_tx_active()) {
     pthread_mutex_lock(&send_audio_mutex);
     int tc = atomic_load_explicit(&txring_count, memory_order_relaxed);
 
@@ -2398,7 +2563,7 @@ static inline unsigned char hl2_tx_latency_ms(int txvfo) {
    */
   static int sticky = 0;
 
-  if (!radio_is_transmitting()) {
+  if (!radio_tx_active()) {
     sticky = 0;
   } else if (tx_fifo_underrun) {
     sticky = 1;
@@ -2530,7 +2695,7 @@ void ozy_send_buffer() {
       output_buffer[C2] |= 0x01;
     }
 
-    if (radio_is_transmitting()) {
+    if (radio_tx_active()) {
       output_buffer[C2] |= txband->OCtx << 1;
 
       if (tune) {
@@ -2589,7 +2754,7 @@ void ozy_send_buffer() {
     // the feedback signal is routed automatically/internally
     // If feedback is to the second ADC, leave RX1 ANT settings untouched
     //
-    if (radio_is_transmitting() && transmitter->puresignal) { i = receiver[PS_RX_FEEDBACK]->alex_antenna; }
+    if (radio_tx_active() && transmitter->puresignal) { i = receiver[PS_RX_FEEDBACK]->alex_antenna; }
 
     if (device == DEVICE_ORION2) {
       i += 100;
@@ -2687,7 +2852,7 @@ void ozy_send_buffer() {
     // and this should be
     //  enough.
     //
-    if (radio_is_transmitting() || radio_ptt) {
+    if (radio_tx_active() || radio_ptt) {
       i = transmitter->alex_antenna;
 
       //
@@ -2806,13 +2971,13 @@ void ozy_send_buffer() {
       if (txband->disablePA || !pa_enabled) {
         output_buffer[C3] |= 0x80; // disable Alex T/R relay
 
-        if (radio_is_transmitting()) {
+        if (radio_tx_active()) {
           output_buffer[C2] |= 0x40; // Manual Filter Selection
           output_buffer[C3] |= 0x20; // bypass all RX filters
         }
       }
 
-      if (!radio_is_transmitting() && adc0_filter_bypass) {
+      if (!radio_tx_active() && adc0_filter_bypass) {
         output_buffer[C2] |= 0x40; // Manual Filter Selection
         output_buffer[C3] |= 0x20; // bypass all RX filters
       }
@@ -2823,7 +2988,7 @@ void ozy_send_buffer() {
       // un-altered. This is not necessary for feedback at the "ByPass" jack since filter bypass
       // is realized in hardware here.
       //
-      if (radio_is_transmitting() && transmitter->puresignal && receiver[PS_RX_FEEDBACK]->alex_antenna == 6) {
+      if (radio_tx_active() && transmitter->puresignal && receiver[PS_RX_FEEDBACK]->alex_antenna == 6) {
         output_buffer[C2] |= 0x40;  // enable manual filter selection
         output_buffer[C3] &= 0x80;  // preserve ONLY "PA enable" bit and clear all filters including "6m LNA"
         output_buffer[C3] |= 0x20;  // bypass all RX filters
@@ -2924,7 +3089,7 @@ void ozy_send_buffer() {
         //
         int rxgain = adc[active_receiver->adc].gain + 12; // -12..48 to 0..60
 
-        if (radio_is_transmitting()) {
+        if (radio_tx_active()) {
           //
           // If have_rx_gain, the "TX attenuation range" is extended from
           // -29 to +31 which is then mapped to 60 ... 0
@@ -2945,7 +3110,7 @@ void ozy_send_buffer() {
         //
         output_buffer[C4] = 0x20 | (adc[0].attenuation & 0x1F);
 
-        if (radio_is_transmitting()) {
+        if (radio_tx_active()) {
           if (pa_enabled && !txband->disablePA) {
             output_buffer[C4] = 0x3F;
           }
@@ -2976,10 +3141,10 @@ void ozy_send_buffer() {
 
 #ifdef __AH4IOB__
 
-        if (radio_is_transmitting() && pa_enabled && !txband->disablePA && !hl2_pa_enable_suppressed) {
+        if (radio_tx_active() && pa_enabled && !txband->disablePA && !hl2_pa_enable_suppressed) {
 #else
 
-        if (radio_is_transmitting() && pa_enabled && !txband->disablePA) {
+        if (radio_tx_active() && pa_enabled && !txband->disablePA) {
 #endif
           output_buffer[C1] = 0x3F;
         }
@@ -3093,7 +3258,7 @@ void ozy_send_buffer() {
       //
       output_buffer[C0] = 0x24;
 
-      if (radio_is_transmitting()) {
+      if (radio_tx_active()) {
         output_buffer[C1] |= 0x80; // ground RX2 on transmit, bit0-6 are Alex2 filters
       }
 
@@ -3181,6 +3346,7 @@ void ozy_send_buffer() {
       output_buffer[C0] = 0x2E;
       output_buffer[C3] = 20; // 20 msec PTT hang time, only bits 4:0
       output_buffer[C4] = hl2_tx_latency_ms(txvfo);
+      atomic_store_explicit(&hl2_fifo_target, 48 * output_buffer[C4], memory_order_relaxed);
 #ifdef __AH4IOB__
 
       //
@@ -3418,7 +3584,7 @@ void ozy_send_buffer() {
 }
 
   // set mox
-if (radio_is_transmitting()) {
+if (radio_tx_active()) {
   if (txmode == modeCWU || txmode == modeCWL) {
     //
     //    For "internal" CW, we should not set
@@ -3610,6 +3776,7 @@ static void metis_restart() {
   //
 
   if (device != DEVICE_OZY) {
+    net_stream_init(&ep6_stream, "EP6");
     P1running = 1;  // set it HERE so outgoing data will not be suppressed
   }
 
@@ -3624,7 +3791,7 @@ static void metis_restart() {
   // start the data flowing
   // No mutex here, since metis_restart() is mutex protected
   if (device != DEVICE_OZY) {
-    metis_start_stop(1);
+    metis_start_stop(bandscope_enabled ? 3 : 1);
     usleep(100000);
   }
 }
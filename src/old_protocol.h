@@ -34,6 +34,7 @@ extern unsigned char hl2_iob_get_antenna_tuner_status(void);
 
 extern void old_protocol_stop(void);
 extern void old_protocol_run(void);
+extern void old_protocol_bandscope(void);
 
 extern void old_protocol_init(int rate);
 extern void old_protocol_set_mic_sample_rate(int rate);
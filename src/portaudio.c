@@ -49,6 +49,7 @@
 #include "receiver.h"
 #include "mode.h"
 #include "audio.h"
+#include "audio_mixer.h"
 #include "message.h"
 #include "vfo.h"
 
@@ -64,40 +65,34 @@ GMutex audio_mutex;
 //
 // We now use callback functions to provide the "headphone" audio data,
 // and therefore can control the latency.
-// RX audio samples are put into a ring buffer and "fetched" therefreom
-// by the portaudio "headphone" callback.
-//
-// We choose a ring buffer of 9600 (stereo) samples that is kept about half-full
-// during RX (latency: 0.1 sec) which should be more than enough.
-// If the buffer falls below 1800, half a buffer length of silence is
-// inserted. This usually only happens after TX/RX transitions
-//
-// If we go TX in CW mode, cw_audio_write() is called. If it is called for
-// the first time with a non-zero sidetone volume,
+// RX audio samples are put into an AUDIO_MATCH (see audio_match.c) and "fetched"
+// therefrom by the portaudio "headphone" callback. The rmatch resampler inside
+// absorbs the slight mismatch between the 48 kHz of the SDR and the 48 kHz of the
+// audio hardware, so the latency stays at its target (20 msec) during RX, without
+// "brutally" inserting or deleting audio.
+//
+// If we go TX in CW mode, cw_audio_write() is called. The side tone does not go
+// through the resampler but into a ring buffer of 9600 (stereo) samples.
+// If cw_audio_write() is called for the first time with a non-zero sidetone volume,
 // the ring buffer is cleared and only few (stereo) samples of silence
 // are put into it. This is probably the minimum amount necessary to avoid
 // audio underruns which manifest themselves as ugly cracks in the side ton.
 // During the TX phase, the buffer filling is kept between two rather low
 // water marks to ensure the small CW sidetone latency is kept.
-// If we then go to RX again a "low water mark" condition is detected in the
-// first call to audio_write() and half a buffer length of silence is inserted
-// again.
+// The callback reads from the ring buffer while in CW mode, or while it still
+// contains side tone samples after going RX again, and from the AUDIO_MATCH otherwise.
 // Of course, a small portaudio audio buffer size (128 sample) helps
 // keeping the latency small. With the CW low/high water marks of 128/256
 // I have achieved a latency of slightly less than 15 msec on my
 // old 2013 iMac.
 //
-// Experiments indicate that we can indeed keep the ring buffer about half filling
-// during RX and quite empty during CW-TX.
-//
 //
 
 #define MY_AUDIO_BUFFER_SIZE  128
 #define MY_RING_BUFFER_SIZE  9600
-#define MY_RING_LOW_WATER     512
-#define MY_RING_HIGH_WATER   9000
 #define MY_CW_LOW_WATER       128
 #define MY_CW_HIGH_WATER      256
+#define MY_MATCH_LATENCY       20   // target latency (ms) of the clock-drift compensation
 
 //
 // Ring buffer for "local microphone" samples stored locally here.
@@ -329,9 +324,15 @@ int pa_out_cb(const void *inputBuffer, void *outputBuffer, unsigned long framesP
 
   g_mutex_lock(&rx->local_audio_mutex);
 
-  if (rx->local_audio_buffer != NULL) {
+  if (rx->audio_match != NULL && cwmode == 0 && rx->local_audio_buffer_inpt == rx->local_audio_buffer_outpt) {
+    //
+    // RX audio. Mutex protection: the AUDIO_MATCH cannot vanish
+    // until callback is completed
     //
-    // Mutex protection: if the buffer is non-NULL it cannot vanish
+    audio_match_read(rx->audio_match, out, (int) framesPerBuffer);
+  } else if (rx->local_audio_buffer != NULL) {
+    //
+    // CW side tone. Mutex protection: if the buffer is non-NULL it cannot vanish
     // util callback is completed
     //
     int newpt = rx->local_audio_buffer_outpt;
@@ -544,6 +545,7 @@ int audio_open_output(RECEIVER *rx) {
     return -1;
   }
 
+  rx->audio_match = audio_match_new(MY_AUDIO_BUFFER_SIZE, rx->buffer_size, MY_MATCH_LATENCY);
   err = Pa_StartStream(rx->playstream);
 
   if (err != paNoError) {
@@ -552,6 +554,8 @@ int audio_open_output(RECEIVER *rx) {
     rx->playstream = NULL;
     g_free(rx->local_audio_buffer);
     rx->local_audio_buffer = NULL;
+    audio_match_free(rx->audio_match);
+    rx->audio_match = NULL;
     g_mutex_unlock(&rx->local_audio_mutex);
     return -1;
   }
@@ -627,28 +631,33 @@ void audio_close_output(RECEIVER *rx) {
     rx->playstream = NULL;
   }
 
+  if (rx->audio_match != NULL) {
+    audio_match_free(rx->audio_match);
+    rx->audio_match = NULL;
+  }
+
   g_mutex_unlock(&rx->local_audio_mutex);
 }
 
 //
-// AUDIO_WRITE
+// AUDIO_WRITE_BUFFER
 //
-// send RX audio data to a PA output stream
-// we have to store the data such that the PA callback function
+// send a block of mixed RX audio data (from the audio mixer) to a PA output stream
+// we have to store the data (in the AUDIO_MATCH) such that the PA callback function
 // can access it.
 //
 // Note that the check on radio_is_transmitting() takes care that "blocking"
 // by the mutex can only occur in the moment of a RX/TX transition if
-// both audio_write() and cw_audio_write() get a "go".
+// both audio_write_buffer() and cw_audio_write() get a "go".
 //
 // So mutex locking/unlocking should only cost few CPU cycles in
 // normal operation.
 //
-int audio_write (RECEIVER *rx, float left, float right) {
+int audio_write_buffer(RECEIVER *rx, const float *buffer, int frames) {
   int txmode = vfo_get_tx_mode();
-  float *buffer = rx->local_audio_buffer;
 
-  if (rx == active_receiver && radio_is_transmitting() && (txmode == modeCWU || txmode == modeCWL)) {
+  if (rx == audio_mixer_output(active_receiver) && radio_is_transmitting()
+      && (txmode == modeCWU || txmode == modeCWL)) {
     //
     // If a CW side tone may occur, quickly return
     //
@@ -658,75 +667,9 @@ int audio_write (RECEIVER *rx, float left, float right) {
   g_mutex_lock(&rx->local_audio_mutex);
   cwmode = 0;
 
-  if (rx->playstream != NULL && buffer != NULL) {
-    int avail = rx->local_audio_buffer_inpt - rx->local_audio_buffer_outpt;
-
-    if (avail < 0) { avail += MY_RING_BUFFER_SIZE; }
-
-    if (avail <  MY_RING_LOW_WATER) {
-      //
-      // Running the RX-audio for a very long time
-      // and with audio hardware whose "48000 Hz" are a little faster than the "48000 Hz" of
-      // the SDR will very slowly drain the buffer. We recover from this by brutally
-      // inserting half a buffer's length of silence.
-      //
-      // This is not always an "error" to be reported and necessarily happens in three cases:
-      //  a) we come here for the first time
-      //  b) we come from a TX/RX transition in non-CW mode, and no duplex
-      //  c) we come from a TX/RX transition in CW mode
-      //
-      // In case a) and b) the buffer will be empty, in c) the buffer will contain "few" samples
-      // because of the "CW audio low latency" strategy.
-      //
-      int oldpt = rx->local_audio_buffer_inpt;
-
-      for (int i = 0; i < MY_RING_BUFFER_SIZE / 2 - avail; i++) {
-        buffer[2 * oldpt] = 0.0;
-        buffer[2 * oldpt + 1] = 0.0;
-        oldpt++;
-
-        if (oldpt >= MY_RING_BUFFER_SIZE) { oldpt = 0; }
-      }
-
-      MEMORY_BARRIER;
-      rx->local_audio_buffer_inpt = oldpt;
-      //t_print("%s: buffer was nearly empty, inserted silence.\n", __FUNCTION__);
-    }
-
-    if (avail > MY_RING_HIGH_WATER) {
-      //
-      // Running the RX-audio for a very long time
-      // and with audio hardware whose "48000 Hz" are a little slower than the "48000 Hz" of
-      // the SDR will very slowly fill the buffer. This should be the only situation where
-      // this "buffer overrun" condition should occur. We recover from this by brutally
-      // deleting half a buffer size of audio, such that the next overrun is in the distant
-      // future.
-      //
-      int oldpt = rx->local_audio_buffer_inpt - avail + MY_RING_BUFFER_SIZE / 2;
-
-      if (oldpt < 0) { oldpt += MY_RING_BUFFER_SIZE; }
-
-      rx->local_audio_buffer_inpt = oldpt;
-      t_print("%s: buffer was nearly full, deleted audio\n", __FUNCTION__);
-    }
-
-    //
-    // put sample into ring buffer
-    //
-    int oldpt = rx->local_audio_buffer_inpt;
-    int newpt = oldpt + 1;
-
-    if (newpt == MY_RING_BUFFER_SIZE) { newpt = 0; }
-
-    if (newpt != rx->local_audio_buffer_outpt) {
-      //
-      // buffer space available
-      //
-      MEMORY_BARRIER;
-      buffer[2 * oldpt] = left;
-      buffer[2 * oldpt + 1] = right;
-      MEMORY_BARRIER;
-      rx->local_audio_buffer_inpt = newpt;
+  if (rx->playstream != NULL && rx->audio_match != NULL) {
+    for (int i = 0; i < frames; i++) {
+      audio_match_write(rx->audio_match, buffer[2 * i], buffer[2 * i + 1]);
     }
   }
 
@@ -28,6 +28,7 @@
 #include "receiver.h"
 #include "transmitter.h"
 #include "audio.h"
+#include "audio_mixer.h"
 #include "mode.h"
 #include "vfo.h"
 #include "message.h"
@@ -41,6 +42,18 @@
 static const int out_buffer_size = 512;
 static const int mic_buffer_size = 512;
 
+//
+// target latency (ms) of the clock-drift compensation (see audio_match.c)
+//
+static const int out_match_latency = 20;
+
+//
+// CW side tone ring buffer (100 msec), and the filling above which
+// zero samples are dropped to keep the side tone latency low
+//
+static const int cw_ring_size = 4800;
+static const int cw_high_water = 512;
+
 int n_input_devices;
 AUDIO_DEVICE input_devices[MAX_AUDIO_DEVICES];
 int n_output_devices;
@@ -391,6 +404,93 @@ void audio_get_cards() {
   }
 }
 
+//
+// RX audio is not written to the stream from the RX thread. It goes into
+// rx->audio_match, and this thread pulls it out at the pace of the sound card,
+// so the clock difference between radio and sound card is absorbed by the
+// rmatch resampler instead of building up (or draining) the pulse buffer.
+// pa_simple_write() blocks, so the sound card clock paces this loop.
+//
+// The CW side tone goes the same way: cw_audio_write() puts it into a ring
+// buffer (rx->local_audio_buffer) and this thread writes it to the stream.
+// pa_simple is not thread-safe, so this is the only thread using
+// rx->playstream, and it decides under local_audio_mutex which source it
+// takes. If the ring buffer fills up because the sound card is slower than
+// the radio, zero samples are dropped in the silence between the elements
+// (one after 16 zero samples in a row).
+//
+static int cw_ring_read(RECEIVER *rx, float *buffer, int frames) {
+  static int count = 0;
+  int n = 0;
+
+  while (n < frames && rx->local_audio_buffer_outpt != rx->local_audio_buffer_inpt) {
+    int avail = rx->local_audio_buffer_inpt - rx->local_audio_buffer_outpt;
+    float sample = rx->local_audio_buffer[rx->local_audio_buffer_outpt];
+
+    if (avail < 0) { avail += cw_ring_size; }
+
+    if (++rx->local_audio_buffer_outpt >= cw_ring_size) { rx->local_audio_buffer_outpt = 0; }
+
+    if (sample != 0.0) { count = 0; } // count upwards during silence
+
+    if (++count >= 16) {
+      count = 0;
+
+      if (avail > cw_high_water) { continue; }  // drop this zero sample
+    }
+
+    buffer[2 * n] = buffer[2 * n + 1] = sample;
+    n++;
+  }
+
+  return n;
+}
+
+static gpointer audio_out_thread(gpointer arg) {
+  RECEIVER *rx = (RECEIVER *)arg;
+  float *buffer = g_new(float, 2 * out_buffer_size);
+  int err;
+
+  while (g_atomic_int_get(&rx->local_audio_running)) {
+    int txmode = vfo_get_tx_mode();
+    int frames = 0;
+
+    //
+    // It is guaranteed that rx->playstream, rx->audio_match and the CW ring
+    // buffer are not destroyed before this thread has terminated (and waited
+    // for via thread joining). local_audio_mutex is not held in pa_simple_write(),
+    // which blocks.
+    //
+    g_mutex_lock(&rx->local_audio_mutex);
+
+    if (rx->local_audio_cw || rx->local_audio_buffer_inpt != rx->local_audio_buffer_outpt) {
+      frames = cw_ring_read(rx, buffer, out_buffer_size);
+    } else if (rx == audio_mixer_output(active_receiver) && radio_is_transmitting()
+               && (txmode == modeCWU || txmode == modeCWL)) {
+      //
+      // Going TX in CW, but the side tone has not yet started. audio_write_buffer()
+      // no longer feeds the match buffer, so just wait for the side tone.
+      //
+    } else {
+      audio_match_read(rx->audio_match, buffer, out_buffer_size);
+      frames = out_buffer_size;
+    }
+
+    g_mutex_unlock(&rx->local_audio_mutex);
+
+    if (frames == 0) {
+      g_usleep(1000);
+    } else if (pa_simple_write(rx->playstream, buffer, frames * sizeof(float) * 2, &err) != 0) {
+      t_print("%s: simple_write failed err=%d\n", __FUNCTION__, err);
+      g_usleep(10000);
+    }
+  }
+
+  g_free(buffer);
+  t_print("%s: exiting\n", __FUNCTION__);
+  return NULL;
+}
+
 int audio_open_output(RECEIVER *rx) {
   int result = 0;
   pa_sample_spec sample_spec;
@@ -427,10 +527,15 @@ int audio_open_output(RECEIVER *rx) {
                                 );
 
   if (rx->playstream != NULL) {
-    rx->local_audio_buffer_offset = 0;
-    rx->local_audio_buffer = g_new0(float, 2 * out_buffer_size);
+    rx->local_audio_buffer = g_new0(float, cw_ring_size);
+    rx->local_audio_buffer_inpt = 0;
+    rx->local_audio_buffer_outpt = 0;
+    rx->local_audio_cw = 0;
     t_print("%s: allocated local_audio_buffer %p size %ld bytes\n", __FUNCTION__, rx->local_audio_buffer,
-            2 * out_buffer_size * sizeof(float));
+            cw_ring_size * sizeof(float));
+    rx->audio_match = audio_match_new(out_buffer_size, rx->buffer_size, out_match_latency);
+    g_atomic_int_set(&rx->local_audio_running, 1);
+    rx->local_audio_thread = g_thread_new("RX audio out", audio_out_thread, rx);
   } else {
     result = -1;
     t_print("%s: pa-simple_new failed: err=%d\n", __FUNCTION__, err);
@@ -602,8 +707,23 @@ int audio_open_input() {
 }
 
 void audio_close_output(RECEIVER *rx) {
+  //
+  // Join WITHOUT holding local_audio_mutex, pa_simple_write() may block
+  //
+  g_atomic_int_set(&rx->local_audio_running, 0);
+
+  if (rx->local_audio_thread != NULL) {
+    g_thread_join(rx->local_audio_thread);
+    rx->local_audio_thread = NULL;
+  }
+
   g_mutex_lock(&rx->local_audio_mutex);
 
+  if (rx->audio_match != NULL) {
+    audio_match_free(rx->audio_match);
+    rx->audio_match = NULL;
+  }
+
   if (rx->playstream != NULL) {
     pa_simple_free(rx->playstream);
     rx->playstream = NULL;
@@ -678,70 +798,64 @@ float audio_get_next_mic_sample() {
   return sample;
 }
 
+//
+// The CW side tone goes into the CW ring buffer, audio_out_thread() writes
+// it to the stream. The first side tone sample after a RX/TX transition
+// discards what is left in the ring buffer.
+//
 int cw_audio_write(RECEIVER *rx, float sample) {
-  int result = 0;
-  int err;
   g_mutex_lock(&rx->local_audio_mutex);
 
   if (rx->playstream != NULL && rx->local_audio_buffer != NULL) {
-    //
-    // Since this is mutex-protected, we know that both rx->playstream
-    // and rx->local_audio_buffer will not be destroyes until we
-    // are finished here.
-    //
-    rx->local_audio_buffer[rx->local_audio_buffer_offset * 2] = sample;
-    rx->local_audio_buffer[(rx->local_audio_buffer_offset * 2) + 1] = sample;
-    rx->local_audio_buffer_offset++;
-
-    if (rx->local_audio_buffer_offset >= out_buffer_size) {
-      int rc = pa_simple_write(rx->playstream,
-                               rx->local_audio_buffer,
-                               out_buffer_size * sizeof(float) * 2,
-                               &err);
-
-      if (rc != 0) {
-        t_print("%s: simple_write failed err=%d\n", __FUNCTION__, err);
-      }
+    int newpt;
+
+    if (!rx->local_audio_cw) {
+      rx->local_audio_buffer_inpt = rx->local_audio_buffer_outpt = 0;
+      rx->local_audio_cw = 1;
+    }
+
+    newpt = rx->local_audio_buffer_inpt + 1;
+
+    if (newpt >= cw_ring_size) { newpt = 0; }
 
-      rx->local_audio_buffer_offset = 0;
+    if (newpt != rx->local_audio_buffer_outpt) {
+      //
+      // buffer space available. The side tone is mono, it is put into
+      // the left and right channel when it is written to the stream.
+      //
+      rx->local_audio_buffer[rx->local_audio_buffer_inpt] = sample;
+      rx->local_audio_buffer_inpt = newpt;
     }
   }
 
   g_mutex_unlock(&rx->local_audio_mutex);
-  return result;
+  return 0;
 }
 
-int audio_write(RECEIVER *rx, float left_sample, float right_sample) {
+int audio_write_buffer(RECEIVER *rx, const float *buffer, int frames) {
   int result = 0;
-  int err;
   int txmode = vfo_get_tx_mode();
 
-  if (rx == active_receiver && radio_is_transmitting() && (txmode == modeCWU || txmode == modeCWL)) {
+  if (rx == audio_mixer_output(active_receiver) && radio_is_transmitting()
+      && (txmode == modeCWU || txmode == modeCWL)) {
     return 0;
   }
 
   g_mutex_lock(&rx->local_audio_mutex);
+  //
+  // RX audio again: the side tone still in the ring buffer is played,
+  // then audio_out_thread switches back to the match buffer.
+  //
+  rx->local_audio_cw = 0;
 
-  if (rx->playstream != NULL && rx->local_audio_buffer != NULL) {
+  if (rx->audio_match != NULL) {
     //
-    // Since this is mutex-protected, we know that both rx->playstream
-    // and rx->local_audio_buffer will not be destroyes until we
-    // are finished here.
-    rx->local_audio_buffer[rx->local_audio_buffer_offset * 2] = left_sample;
-    rx->local_audio_buffer[(rx->local_audio_buffer_offset * 2) + 1] = right_sample;
-    rx->local_audio_buffer_offset++;
-
-    if (rx->local_audio_buffer_offset >= out_buffer_size) {
-      int rc = pa_simple_write(rx->playstream,
-                               rx->local_audio_buffer,
-                               out_buffer_size * sizeof(float) * 2,
-                               &err);
-
-      if (rc != 0) {
-        t_print("%s: simple_write failed err=%d\n", __FUNCTION__, err);
-      }
-
-      rx->local_audio_buffer_offset = 0;
+    // Since this is mutex-protected, we know that rx->audio_match
+    // will not be destroyed until we are finished here.
+    // The samples are sent to the stream by audio_out_thread.
+    //
+    for (int i = 0; i < frames; i++) {
+      audio_match_write(rx->audio_match, buffer[2 * i], buffer[2 * i + 1]);
     }
   }
 
@@ -44,13 +44,16 @@
 #include "adc.h"
 #include "dac.h"
 #include "audio.h"
+#include "audio_mixer.h"
 #include "discovered.h"
+#include "dvr.h"
 #include "filter.h"
 #include "main.h"
 #include "mode.h"
 #include "radio.h"
 #include "receiver.h"
 #include "transmitter.h"
+#include "trx_sequencer.h"
 #include "agc.h"
 #include "band.h"
 #include "channel.h"
@@ -65,6 +68,7 @@
 #include "actions.h"
 #include "gpio.h"
 #include "vfo.h"
+#include "voice_keyer.h"
 #include "vox.h"
 #include "meter.h"
 #include "rx_panadapter.h"
@@ -75,6 +79,7 @@
 #include "toolbar.h"
 #include "rigctl.h"
 #include "tci.h"
+#include "hamlib.h"
 #include "ext.h"
 #include "radio_menu.h"
 #include "iambic.h"
@@ -225,6 +230,7 @@ int display_clock = 0;
 int display_solardata = 0;
 int display_ah4 = 0;
 int display_wmap = 0;
+int display_activity = 0;
 int pan_peak_hold_enabled = 0;
 int pan_peak_hold_TX_enabled = 0;
 int pan_peak_hold_mode = 2;
@@ -315,9 +321,11 @@ unsigned int ADC0 = 0;
 
 //
 // At the moment we have "late mox update", this means:
-// in a RX/TX or TX/RX transition, mox is updated after
-// rxtx has completed (which may take a while during
-// down- and up-slew).
+// in a RX/TX or TX/RX transition, radio_tx_active()
+// changes when the T/R sequencer has completed the transition
+// (which may take a while during down- and up-slew).
+// radio_is_transmitting() is what has been requested and
+// changes at once.
 // Sometimes one wants to know before, that a RX/TX
 // change is being initiated. So rxtx() sets the pre_mox
 // variable immediatedly after it has been called to the new
@@ -328,6 +336,8 @@ unsigned int ADC0 = 0;
 //
 int pre_mox = 0;
 
+static int rxtx_layout = 0;      // 1 if the TX layout is on the screen
+
 int ptt = 0;
 int mox = 0;
 int tune = 0;
@@ -362,10 +372,14 @@ int tx_filter_high = 2900;
 
 static int pre_tune_mode;
 static int pre_tune_cw_internal;
+static int tune_restore_pending = 0;  // TUNE is off, but its settings are not yet restored
 
 int vox_enabled = 0;
 double vox_threshold = 0.001;
 double vox_hang = 250.0;
+double vox_delay = 50.0;
+int vox_antivox = 0;
+double vox_antivox_gain = 1.0;
 int vox = 0;
 int CAT_cw_is_active = 0;
 int MIDI_cw_is_active = 0;
@@ -389,6 +403,13 @@ int capture_record_pointer;
 int capture_replay_pointer;
 double *capture_data = NULL;
 
+//
+// Station DVR (continuous recorder), see dvr.c
+//
+int dvr_minutes = 0;       // length of the on-disk ring, 0 = off
+int dvr_iq = 0;            // record the raw IQ data as well
+int dvr_window = 30;       // seconds replayed/exported by the DVR actions
+
 int can_transmit = 0;
 int optimize_for_touchscreen = 0;
 
@@ -433,6 +454,9 @@ static gboolean launch_autogain_hl2_wrapper(gpointer data) {
 static void radio_restore_state();
 
 void radio_stop() {
+  trx_sequencer_stop();
+  dvr_stop();
+
   if (can_transmit) {
     t_print("radio_stop: TX: stop display update\n");
     transmitter->displaying = 0;
@@ -448,6 +472,8 @@ void radio_stop() {
     t_print("radio_stop: RX id=%d: close\n", receiver[i]->id);
     rx_close(receiver[i]);
   }
+
+  audio_mixer_stop();
 }
 
 /*
@@ -872,7 +898,7 @@ void radio_reconfigure() {
       rx_update_zoom(rx);
       rx_reconfigure(rx, rx_height);
 
-      if (!radio_is_transmitting() || duplex) {
+      if (!rxtx_layout || duplex) {
         gtk_fixed_move(GTK_FIXED(fixed), rx->panel, x, y);
       }
 
@@ -889,7 +915,7 @@ void radio_reconfigure() {
       rx_update_zoom(rx);
       rx_reconfigure(rx, rx_height / receivers);
 
-      if (!radio_is_transmitting() || duplex) {
+      if (!rxtx_layout || duplex) {
         gtk_fixed_move(GTK_FIXED(fixed), rx->panel, 0, y);
       }
 
@@ -1312,6 +1338,9 @@ static void radio_create_visual() {
   }
 
   active_receiver = receiver[0];
+  audio_mixer_start();
+  trx_sequencer_start();
+  dvr_start();
   //
   // This is to detect illegal accesses to the PS receivers
   //
@@ -2117,6 +2146,10 @@ void radio_start_radio() {
 
 #endif
 
+  if (hamlib_enable) {
+    launch_hamlib();
+  }
+
   if (rigctl_tcp_enable) {
     launch_tcp_rigctl();
     rigctld_enabled = 1;
@@ -2384,33 +2417,21 @@ void radio_change_sample_rate(int rate) {
   }
 }
 
-static void rxtx(int state) {
-  int i;
+//
+// GUI part of a RX/TX transition. It is done after the T/R sequencer has
+// completed the switch, so it does not add to the MOX-to-RF delay. Several
+// transitions in a row are collapsed into one re-layout.
+//
+static gboolean rxtx_layout_cb(gpointer data) {
+  int state = trx_sequencer_state();
 
-  if (!can_transmit) {
-    t_print("WARNING: rxtx called but no transmitter!");
-    return;
-  }
+  if (state == rxtx_layout || !can_transmit) { return G_SOURCE_REMOVE; }
 
-  pre_mox = state && !duplex;
+  rxtx_layout = state;
 
   if (state) {
-    // switch to tx
-    RECEIVER *rx_feedback = receiver[PS_RX_FEEDBACK];
-    RECEIVER *tx_feedback = receiver[PS_TX_FEEDBACK];
-
-    if (rx_feedback) { rx_feedback->samples = 0; }
-
-    if (tx_feedback) { tx_feedback->samples = 0; }
-
     if (!duplex) {
-      for (i = 0; i < receivers; i++) {
-        // Delivery of RX samples
-        // to WDSP via fexchange0() may come to an abrupt stop
-        // (especially with PureSignal or DIVERSITY).
-        // Therefore, wait for *all* receivers to complete
-        // their slew-down before going TX.
-        rx_off(receiver[i]);
+      for (int i = 0; i < receivers; i++) {
         receiver[i]->displaying = 0;
         rx_set_displaying(receiver[i]);
         g_object_ref((gpointer)receiver[i]->panel);
@@ -2437,30 +2458,43 @@ static void rxtx(int state) {
       gtk_fixed_put(GTK_FIXED(fixed), transmitter->panel, transmitter->x, transmitter->y);
     }
 
-    if (transmitter->puresignal) {
-      tx_ps_mox(transmitter, 1);
-    }
-
-    tx_on(transmitter);
+    tx_set_levels(transmitter, 1);
     transmitter->displaying = 1;
     tx_set_displaying(transmitter);
+  } else {
+    tx_set_levels(transmitter, 0);
+    transmitter->displaying = 0;
+    tx_set_displaying(transmitter);
 
-    switch (protocol) {
-#ifdef SOAPYSDR
+    if (transmitter->dialog) {
+      gtk_window_get_position(GTK_WINDOW(transmitter->dialog), &transmitter->dialog_x, &transmitter->dialog_y);
+      gtk_widget_hide(transmitter->dialog);
+    } else {
+      gtk_container_remove(GTK_CONTAINER(fixed), transmitter->panel);
+    }
 
-    case SOAPYSDR_PROTOCOL:
-      soapy_protocol_set_tx_frequency(transmitter);
-      //soapy_protocol_start_transmitter(transmitter);
-      break;
-#endif
+    if (!duplex) {
+      for (int i = 0; i < receivers; i++) {
+        gtk_fixed_put(GTK_FIXED(fixed), receiver[i]->panel, receiver[i]->x, receiver[i]->y);
+        receiver[i]->displaying = 1;
+        rx_set_displaying(receiver[i]);
+      }
     }
+  }
 
+  return G_SOURCE_REMOVE;
+}
+
+static void rxtx_then(int state, GSourceFunc done) {
+  if (!can_transmit) {
+    t_print("WARNING: rxtx called but no transmitter!");
+    return;
+  }
+
+  pre_mox = state && !duplex;
 #ifdef DUMP_TX_DATA
-    rxiq_count = 0;
-#endif
-  } else {
-    // switch to rx
-#ifdef DUMP_TX_DATA
+
+  if (!state) {
     static int snapshot = 0;
     snapshot++;
     char fname[32];
@@ -2474,98 +2508,94 @@ static void rxtx(int state) {
 
       fclose(fp);
     }
+  }
 
 #endif
+  //
+  // DSP, protocol and PTT are switched by the T/R sequencer thread,
+  // the GUI follows when the transition has completed.
+  //
+  trx_sequencer_switch(state, done);
+#ifdef DUMP_TX_DATA
 
-    switch (protocol) {
-#ifdef SOAPYSDR
+  if (state) { rxiq_count = 0; }
 
-    case SOAPYSDR_PROTOCOL:
-      //soapy_protocol_stop_transmitter(transmitter);
-      break;
 #endif
-    }
-
-    if (transmitter->puresignal) {
-      tx_ps_mox(transmitter, 0);
-    }
+}
 
-    tx_off(transmitter);
-    transmitter->displaying = 0;
-    tx_set_displaying(transmitter);
+static void rxtx(int state) {
+  rxtx_then(state, rxtx_layout_cb);
+}
 
-    if (transmitter->dialog) {
-      gtk_window_get_position(GTK_WINDOW(transmitter->dialog), &transmitter->dialog_x, &transmitter->dialog_y);
-      gtk_widget_hide(transmitter->dialog);
-    } else {
-      gtk_container_remove(GTK_CONTAINER(fixed), transmitter->panel);
+//
+// Completion of the TX/RX transition that ends TUNE. The TX mode, the CW keyer,
+// PureSignal and the compressor are restored only now, such that they do not
+// change while the TX channel is still slewing down. If TUNE has been switched
+// on again in the meantime, the settings are left as they are and the saved
+// ones remain valid.
+//
+static gboolean tune_done_cb(gpointer data) {
+  if (tune_restore_pending && !tune) {
+    switch (pre_tune_mode) {
+    case modeCWL:
+    case modeCWU:
+      tx_set_mode(transmitter, pre_tune_mode);
+      cw_keyer_internal = pre_tune_cw_internal;
+      break;
     }
 
-    if (!duplex) {
+    if (transmitter->puresignal && !transmitter->ps_oneshot) {
       //
-      // Set parameters for the "silence first RXIQ samples after TX/RX transition" feature
-      // the default is "no silence", that is, fastest turnaround.
-      // Seeing "tails" of the own TX signal (from crosstalk at the T/R relay) has been observed
-      // for RedPitayas (the identify themself as STEMlab or HERMES) and HermesLite2 devices,
-      // we also include the original HermesLite in this list (which can be enlarged if necessary).
+      // DL1YCF:
+      // If we have done a "PS reset" when we started tuning,
+      // resume PS engine now.
       //
-      int do_silence = 0;
-
-      if (device == DEVICE_HERMES_LITE2 || device == DEVICE_HERMES_LITE ||
-          device == DEVICE_HERMES || device == DEVICE_STEMLAB || device == DEVICE_STEMLAB_Z20) {
-        //
-        // These systems get a significant "tail" of the RX feedback signal into the RX after TX/RX,
-        // leading to AGC pumping. The problem is most severe if there is a carrier until the end of
-        // the TX phase (TUNE, AM, FM), the problem is virtually non-existent for CW, and of medium
-        // importance in SSB. On the other hand, one wants a very fast turnaround in CW.
-        // So there is no "muting" for CW, 31 msec "muting" for TUNE/AM/FM, and 16 msec for other modes.
-        //
-        // Note that for doing "TwoTone" the silence is built into tx_set_twotone().
-        //
-        switch (vfo_get_tx_mode()) {
-        case modeCWU:
-        case modeCWL:
-          do_silence = 0; // no "silence"
-          break;
-
-        case modeAM:
-        case modeFMN:
-          do_silence = 5; // leads to 31 ms "silence"
-          break;
+      tx_ps_resume(transmitter);
+    }
 
-        default:
-          do_silence = 6; // leads to 16 ms "silence"
-          break;
-        }
+    // restore settings we switched off earlier
+    tx_set_compressor(transmitter);
+    int id = active_receiver->id;
+    int m = vfo[id].mode;
 
-        if (tune) { do_silence = 5; } // 31 ms "silence" for TUNEing in any mode
+    if (display_sliders) {
+      if (m == modeDIGU || m == modeDIGL) {
+        update_slider_bbcompr_scale(FALSE);
+        update_slider_bbcompr_button(FALSE);
+        update_slider_lev_scale(FALSE);
+        update_slider_lev_button(FALSE);
+      } else {
+        update_slider_bbcompr_scale(TRUE);
+        update_slider_bbcompr_button(TRUE);
+        update_slider_lev_scale(TRUE);
+        update_slider_lev_button(TRUE);
       }
+    }
 
-      for (i = 0; i < receivers; i++) {
-        gtk_fixed_put(GTK_FIXED(fixed), receiver[i]->panel, receiver[i]->x, receiver[i]->y);
-        rx_on(receiver[i]);
-        receiver[i]->displaying = 1;
-        rx_set_displaying(receiver[i]);
-        //
-        // There might be some left-over samples in the RX buffer that were filled in
-        // *before* going TX, delete them
-        //
-        receiver[i]->samples = 0;
+    radio_calc_drive_level();
+#if defined (__HAVEATU__)
+    transmitter->is_tuned = 1;
 
-        if (do_silence) {
-          receiver[i]->txrxmax = receiver[i]->sample_rate >> do_silence;
-        } else {
-          receiver[i]->txrxmax = 0;
-        }
+    if (transmitter->stored_drive > 0) {
+      set_drive(transmitter->stored_drive);
+    }
 
-        receiver[i]->txrxcount = 0;
-      }
+    t_print("%s: stored drive level: %.1f\n", __FUNCTION__, transmitter->stored_drive);
+    t_print("%s: current drive level: %.1f\n", __FUNCTION__, radio_get_drive());
+#endif
+#if defined (__AUTOG__)
+
+    if (device == DEVICE_HERMES_LITE2 || device == NEW_DEVICE_HERMES_LITE2) {
+      autogain_is_adjusted = 0;
     }
-  }
 
-#ifdef GPIO
-  gpio_set_ptt(state);
 #endif
+    schedule_high_priority();
+    schedule_transmit_specific();
+  }
+
+  tune_restore_pending = 0;
+  return rxtx_layout_cb(data);
 }
 
 void radio_mox_update(int state) {
@@ -2617,7 +2647,7 @@ void radio_set_mox(int state) {
   // then switch from VOX to MOX mode but no RX/TX
   // transition is necessary.
   //
-  if (state != radio_is_transmitting()) {
+  if (state != (mox | vox)) {
     rxtx(state);
   }
 
@@ -2763,23 +2793,22 @@ void radio_set_tune(int state) {
     schedule_high_priority();
 
     if (state) {
-      if (!duplex) {
-        for (int i = 0; i < receivers; i++) {
-          // Delivery of RX samples
-          // to WDSP via fexchange0() may come to an abrupt stop
-          // (especially with PureSignal or DIVERSITY)
-          // Therefore, wait for *all* receivers to complete
-          // their slew-down before going TX.
-          rx_off(receiver[i]);
-          receiver[i]->displaying = 0;
-          rx_set_displaying(receiver[i]);
-          schedule_high_priority();
-        }
+      //
+      // The receivers are slewed down by the T/R sequencer (all of them
+      // in parallel, before the TX channel is switched on), and their
+      // display is stopped in rxtx_layout_cb(), as for MOX.
+      //
+      int txmode = vfo_get_tx_mode();
+
+      //
+      // If TUNE is pressed again before the settings of the previous
+      // TUNE have been restored, the saved ones are still valid.
+      //
+      if (!tune_restore_pending) {
+        pre_tune_mode = txmode;
+        pre_tune_cw_internal = cw_keyer_internal;
       }
 
-      int txmode = vfo_get_tx_mode();
-      pre_tune_mode = txmode;
-      pre_tune_cw_internal = cw_keyer_internal;
       double freq = 0.0;
 #if 0
 
@@ -2826,63 +2855,9 @@ void radio_set_tune(int state) {
       rxtx(state);
     } else {
       tx_set_singletone(transmitter, 0, 0.0);
-      rxtx(state);
-
-      switch (pre_tune_mode) {
-      case modeCWL:
-      case modeCWU:
-        tx_set_mode(transmitter, pre_tune_mode);
-        cw_keyer_internal = pre_tune_cw_internal;
-        break;
-      }
-
-      if (transmitter->puresignal && !transmitter->ps_oneshot) {
-        //
-        // DL1YCF:
-        // If we have done a "PS reset" when we started tuning,
-        // resume PS engine now.
-        //
-        tx_ps_resume(transmitter);
-      }
-
-      // restore settings we switched off earlier
-      tx_set_compressor(transmitter);
-      int id = active_receiver->id;
-      int m = vfo[id].mode;
-
-      if (can_transmit && display_sliders) {
-        if (m == modeDIGU || m == modeDIGL) {
-          update_slider_bbcompr_scale(FALSE);
-          update_slider_bbcompr_button(FALSE);
-          update_slider_lev_scale(FALSE);
-          update_slider_lev_button(FALSE);
-        } else {
-          update_slider_bbcompr_scale(TRUE);
-          update_slider_bbcompr_button(TRUE);
-          update_slider_lev_scale(TRUE);
-          update_slider_lev_button(TRUE);
-        }
-      }
-
       tune = state;
-      radio_calc_drive_level();
-#if defined (__HAVEATU__)
-      transmitter->is_tuned = 1;
-
-      if (transmitter->stored_drive > 0) {
-        set_drive(transmitter->stored_drive);
-      }
-
-      t_print("%s: stored drive level: %.1f\n", __FUNCTION__, transmitter->stored_drive);
-      t_print("%s: current drive level: %.1f\n", __FUNCTION__, radio_get_drive());
-#endif
-#if defined (__AUTOG__)
-
-      if (device == DEVICE_HERMES_LITE2 || device == NEW_DEVICE_HERMES_LITE2) {
-        autogain_is_adjusted = 0;
-      }
-
-#endif
+      tune_restore_pending = 1;
+      rxtx_then(state, tune_done_cb);
     }
   }
 
@@ -2895,10 +2870,26 @@ int radio_get_tune() {
   return tune;
 }
 
+//
+// radio_is_transmitting() reports what has been requested (mox, vox, tune),
+// it changes as soon as MOX/VOX/TUNE is switched.
+//
+// radio_tx_active() reports the state of the RF path: the radio only
+// transmits once the T/R sequencer has completed the RX/TX transition, and
+// it continues to do so until the TX/RX transition has completed. This is
+// for code that must follow the hardware: the MOX/PTT bits and the sample
+// routing in the protocol code, the TX IQ output, the CW pulse shaping and
+// the PureSignal feedback in transmitter.c. RX samples thus keep flowing
+// during the RX slew-down, and the TX slew-down reaches the radio.
+//
 int radio_is_transmitting() {
   return mox | vox | tune;
 }
 
+int radio_tx_active() {
+  return trx_sequencer_state();
+}
+
 double radio_get_drive() {
   if (can_transmit) {
     return transmitter->drive;
@@ -3177,6 +3168,7 @@ static void radio_restore_state() {
   GetPropF0("pan_peak_hold_hold_sec",                        pan_peak_hold_hold_sec);
   GetPropF0("pan_peak_hold_decay_db_per_sec",                pan_peak_hold_decay_db_per_sec);
   GetPropI0("display_wmap",                                  display_wmap);
+  GetPropI0("display_activity",                              display_activity);
   GetPropI0("display_zoompan",                               display_zoompan);
   GetPropI0("display_sliders",                               display_sliders);
   GetPropI0("display_extra_sliders",                         display_extra_sliders);
@@ -3187,6 +3179,9 @@ static void radio_restore_state() {
   GetPropI0("vfo_layout",                                    vfo_layout);
   GetPropI0("optimize_touchscreen",                          optimize_for_touchscreen);
   GetPropI0("capture_max",                                   capture_max);
+  GetPropI0("dvr_minutes",                                   dvr_minutes);
+  GetPropI0("dvr_iq",                                        dvr_iq);
+  GetPropI0("dvr_window",                                    dvr_window);
   GetPropI0("max_pan_label_rows",                            max_pan_label_rows);
   GetPropI0("pan_spot_lifetime_min",                         pan_spot_lifetime_min);
 
@@ -3282,6 +3277,9 @@ static void radio_restore_state() {
   GetPropI0("vox_enabled",                                   vox_enabled);
   GetPropF0("vox_threshold",                                 vox_threshold);
   GetPropF0("vox_hang",                                      vox_hang);
+  GetPropF0("vox_delay",                                     vox_delay);
+  GetPropI0("vox_antivox",                                   vox_antivox);
+  GetPropF0("vox_antivox_gain",                              vox_antivox_gain);
   GetPropI0("calibration",                                   frequency_calibration);
   GetPropF0("ppm_factor",                                    ppm_factor);
   GetPropI0("receivers",                                     receivers);
@@ -3299,6 +3297,8 @@ static void radio_restore_state() {
   GetPropI0("tci_port",                                    tci_port);
   GetPropI0("tci_txonly",                                  tci_txonly);
 #endif
+  GetPropI0("hamlib_enable",                                 hamlib_enable);
+  GetPropI0("hamlib_port",                                   hamlib_port);
   GetPropI0("rigctl_tcp_enable",                             rigctl_tcp_enable);
   GetPropI0("rigctl_tcp_andromeda",                          rigctl_tcp_andromeda);
   GetPropI0("rigctl_tcp_autoreporting",                      rigctl_tcp_autoreporting);
@@ -3382,6 +3382,7 @@ static void radio_restore_state() {
   filterRestoreState();
   bandRestoreState();
   memRestoreState();
+  vkRestoreState();
   vfo_restore_state();
   gpioRestoreActions();
 #ifdef MIDI
@@ -3474,6 +3475,7 @@ void radio_save_state() {
   SetPropF0("pan_peak_hold_hold_sec",                        pan_peak_hold_hold_sec);
   SetPropF0("pan_peak_hold_decay_db_per_sec",                pan_peak_hold_decay_db_per_sec);
   SetPropI0("display_wmap",                                  display_wmap);
+  SetPropI0("display_activity",                              display_activity);
   SetPropI0("display_zoompan",                               hide_status ? old_zoom : display_zoompan);
   SetPropI0("display_sliders",                               hide_status ? old_slid : display_sliders);
   SetPropI0("display_extra_sliders",                         display_extra_sliders);
@@ -3484,6 +3486,9 @@ void radio_save_state() {
   SetPropI0("vfo_layout",                                    vfo_layout);
   SetPropI0("optimize_touchscreen",                          optimize_for_touchscreen);
   SetPropI0("capture_max",                                   capture_max);
+  SetPropI0("dvr_minutes",                                   dvr_minutes);
+  SetPropI0("dvr_iq",                                        dvr_iq);
+  SetPropI0("dvr_window",                                    dvr_window);
   SetPropI0("max_pan_label_rows",                            max_pan_label_rows);
   SetPropI0("pan_spot_lifetime_min",                         pan_spot_lifetime_min);
   SetPropC0("radio_bgcolor",                                 radio_bgcolor);
@@ -3560,6 +3565,9 @@ void radio_save_state() {
   SetPropI0("vox_enabled",                                   vox_enabled);
   SetPropF0("vox_threshold",                                 vox_threshold);
   SetPropF0("vox_hang",                                      vox_hang);
+  SetPropF0("vox_delay",                                     vox_delay);
+  SetPropI0("vox_antivox",                                   vox_antivox);
+  SetPropF0("vox_antivox_gain",                              vox_antivox_gain);
   // SetPropI0("calibration",                                frequency_calibration);
   SetPropF0("ppm_factor",                                    ppm_factor);
   SetPropI0("receivers",                                     receivers);
@@ -3577,6 +3585,8 @@ void radio_save_state() {
   SetPropI0("tci_port",                                    tci_port);
   SetPropI0("tci_txonly",                                  tci_txonly);
 #endif
+  SetPropI0("hamlib_enable",                                 hamlib_enable);
+  SetPropI0("hamlib_port",                                   hamlib_port);
   SetPropI0("rigctl_tcp_enable",                             rigctl_tcp_enable);
   SetPropI0("rigctl_tcp_andromeda",                          rigctl_tcp_andromeda);
   SetPropI0("rigctl_tcp_autoreporting",                      rigctl_tcp_autoreporting);
@@ -3651,6 +3661,7 @@ void radio_save_state() {
   filterSaveState();
   bandSaveState();
   memSaveState();
+  vkSaveState();
   vfo_save_state();
   gpioSaveActions();
 #ifdef MIDI
@@ -175,6 +175,7 @@ extern int display_clock;
 extern int display_solardata;
 extern int display_ah4;
 extern int display_wmap;
+extern int display_activity;
 extern int pan_peak_hold_enabled;
 extern int pan_peak_hold_TX_enabled;
 extern int pan_peak_hold_mode;
@@ -305,6 +306,9 @@ extern int ctun;
 extern int vox_enabled;
 extern double vox_threshold;
 extern double vox_hang;
+extern double vox_delay;
+extern int vox_antivox;
+extern double vox_antivox_gain;
 extern int vox;
 extern int CAT_cw_is_active;
 extern int MIDI_cw_is_active;
@@ -322,6 +326,10 @@ extern int capture_record_pointer;
 extern int capture_replay_pointer;
 extern double *capture_data;
 
+extern int dvr_minutes;
+extern int dvr_iq;
+extern int dvr_window;
+
 extern int can_transmit;
 
 extern int have_rx_gain;         // programmable RX gain available
@@ -398,6 +406,7 @@ extern void   radio_set_rf_gain(const RECEIVER *rx);
 extern void   radio_set_attenuation(int value);
 extern void   radio_set_alex_attenuation(int v);
 extern int    radio_is_transmitting(void);
+extern int    radio_tx_active(void);
 extern void   radio_set_satmode(int mode);
 extern int    radio_max_band(void);
 extern void   radio_start_playback(void);
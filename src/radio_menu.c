@@ -28,6 +28,7 @@
 
 #include "main.h"
 #include "discovered.h"
+#include "dvr.h"
 #include "new_menu.h"
 #include "radio_menu.h"
 #include "adc.h"
@@ -144,6 +145,29 @@ static void capture_time_changed_cb(GtkWidget *widget, gpointer data) {
 }
 //-------------------------------------------------------------------------------------
 
+//
+// A new DVR length takes effect with the next segment, only switching
+// the DVR on or off (re-)starts it.
+//
+static void dvr_minutes_changed_cb(GtkWidget *widget, gpointer data) {
+  dvr_minutes = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget));
+
+  if (dvr_minutes == 0) {
+    dvr_stop();
+  } else if (!dvr_is_running()) {
+    dvr_start();
+  }
+}
+
+static void dvr_window_changed_cb(GtkWidget *widget, gpointer data) {
+  dvr_window = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget));
+}
+
+static void dvr_iq_cb(GtkWidget *widget, gpointer data) {
+  dvr_iq = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+  dvr_restart();
+}
+
 static void ptt_ring_cb(GtkWidget *widget, gpointer data) {
   if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget))) {
     mic_ptt_tip_bias_ring = 0;
@@ -1161,6 +1185,48 @@ void radio_menu(GtkWidget *parent) {
   gtk_grid_attach(GTK_GRID(grid), rx_gain_calibration_b, col, row, 1, 1);
   g_signal_connect(rx_gain_calibration_b, "value_changed", G_CALLBACK(rx_gain_calibration_value_changed_cb), NULL);
   //
+  // Station DVR
+  //
+  row++;
+  col = 0;
+  label = gtk_label_new("DVR Length\n(min, 0 = off):");
+  gtk_widget_set_name(label, "boldlabel");
+  gtk_grid_attach(GTK_GRID(grid), label, col, row, 1, 1);
+  col++;
+  GtkWidget *dvr_minutes_b = gtk_spin_button_new_with_range(0.0, 120.0, 5.0);
+  gtk_spin_button_set_value(GTK_SPIN_BUTTON(dvr_minutes_b), (double)dvr_minutes);
+  gtk_widget_set_tooltip_text(dvr_minutes_b,
+                              "Continuously record the audio of all receivers\n"
+                              "and the TX mic to disk (directory dvr/ring),\n"
+                              "keeping the last n minutes.\n\n"
+                              "Use the DVR Replay and DVR Export actions\n"
+                              "to listen to or save the recent past.");
+  gtk_widget_set_hexpand(dvr_minutes_b, FALSE);
+  gtk_widget_set_halign(dvr_minutes_b, GTK_ALIGN_START);
+  gtk_grid_attach(GTK_GRID(grid), dvr_minutes_b, col, row, 1, 1);
+  g_signal_connect(dvr_minutes_b, "value_changed", G_CALLBACK(dvr_minutes_changed_cb), NULL);
+  col++;
+  label = gtk_label_new("DVR Replay/Export\nWindow (sec):");
+  gtk_widget_set_name(label, "boldlabel");
+  gtk_grid_attach(GTK_GRID(grid), label, col, row, 1, 1);
+  col++;
+  GtkWidget *dvr_window_b = gtk_spin_button_new_with_range(5.0, 600.0, 5.0);
+  gtk_spin_button_set_value(GTK_SPIN_BUTTON(dvr_window_b), (double)dvr_window);
+  gtk_widget_set_hexpand(dvr_window_b, FALSE);
+  gtk_widget_set_halign(dvr_window_b, GTK_ALIGN_START);
+  gtk_grid_attach(GTK_GRID(grid), dvr_window_b, col, row, 1, 1);
+  g_signal_connect(dvr_window_b, "value_changed", G_CALLBACK(dvr_window_changed_cb), NULL);
+  col++;
+  ChkBtn = gtk_check_button_new_with_label("DVR records IQ");
+  gtk_widget_set_name(ChkBtn, "boldlabel");
+  gtk_widget_set_tooltip_text(ChkBtn,
+                              "Record the raw IQ data of the receivers as well.\n"
+                              "Needs 8 bytes per sample, that is about 5 GB per hour\n"
+                              "and receiver at 192 kHz. Changing this restarts the DVR.");
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(ChkBtn), dvr_iq);
+  gtk_grid_attach(GTK_GRID(grid), ChkBtn, col, row, 1, 1);
+  g_signal_connect(ChkBtn, "toggled", G_CALLBACK(dvr_iq_cb), NULL);
+  //
   // Insert small separation between top columns and bottom rows
   //
   row++;
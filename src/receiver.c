@@ -28,10 +28,14 @@
 
 #include "agc.h"
 #include "audio.h"
+#include "audio_mixer.h"
 #include "band.h"
 #include "bandstack.h"
+#include "carrier_notch.h"
 #include "channel.h"
 #include "discovered.h"
+#include "dvr.h"
+#include "eq_update.h"
 #include "filter.h"
 #include "main.h"
 #include "meter.h"
@@ -42,6 +46,7 @@
 #include "transmitter.h"
 #include "vfo.h"
 #include "meter.h"
+#include "rx_display.h"
 #include "rx_panadapter.h"
 #include "zoompan.h"
 #include "sliders.h"
@@ -269,6 +274,8 @@ void rx_save_state(const RECEIVER *rx) {
   SetPropI1("receiver.%d.audio_device", rx->id,                 rx->audio_device);
   SetPropI1("receiver.%d.mute_when_not_active", rx->id,         rx->mute_when_not_active);
   SetPropI1("receiver.%d.mute_radio", rx->id,                   rx->mute_radio);
+  SetPropF1("receiver.%d.mixer_gain", rx->id,                   rx->mixer_gain);
+  SetPropF1("receiver.%d.mixer_pan", rx->id,                    rx->mixer_pan);
 #ifdef __APPLE__
   SetPropI1("receiver.%d.wheel_present", rx->id,                rx->wheel_present);
 #endif
@@ -320,6 +327,7 @@ void rx_save_state(const RECEIVER *rx) {
   SetPropI1("receiver.%d.nr", rx->id,                           rx->nr);
   SetPropI1("receiver.%d.anf", rx->id,                          rx->anf);
   SetPropI1("receiver.%d.snb", rx->id,                          rx->snb);
+  SetPropI1("receiver.%d.carrier_notch", rx->id,                rx->carrier_notch);
   SetPropI1("receiver.%d.nr_agc", rx->id,                       rx->nr_agc);
   SetPropI1("receiver.%d.nr2_gain_method", rx->id,              rx->nr2_gain_method);
   SetPropI1("receiver.%d.nr2_npe_method", rx->id,               rx->nr2_npe_method);
@@ -389,6 +397,8 @@ void rx_restore_state(RECEIVER *rx) {
   GetPropI1("receiver.%d.audio_device", rx->id,                 rx->audio_device);
   GetPropI1("receiver.%d.mute_when_not_active", rx->id,         rx->mute_when_not_active);
   GetPropI1("receiver.%d.mute_radio", rx->id,                   rx->mute_radio);
+  GetPropF1("receiver.%d.mixer_gain", rx->id,                   rx->mixer_gain);
+  GetPropF1("receiver.%d.mixer_pan", rx->id,                    rx->mixer_pan);
 #ifdef __APPLE__
   GetPropI1("receiver.%d.wheel_present", rx->id,                rx->wheel_present);
 #endif
@@ -448,6 +458,7 @@ void rx_restore_state(RECEIVER *rx) {
   GetPropI1("receiver.%d.nr", rx->id,                           rx->nr);
   GetPropI1("receiver.%d.anf", rx->id,                          rx->anf);
   GetPropI1("receiver.%d.snb", rx->id,                          rx->snb);
+  GetPropI1("receiver.%d.carrier_notch", rx->id,                rx->carrier_notch);
   GetPropI1("receiver.%d.nr_agc", rx->id,                       rx->nr_agc);
   GetPropI1("receiver.%d.nr2_gain_method", rx->id,              rx->nr2_gain_method);
   GetPropI1("receiver.%d.nr2_npe_method", rx->id,               rx->nr2_npe_method);
@@ -583,27 +594,15 @@ void rx_reconfigure(RECEIVER *rx, int height) {
   g_mutex_unlock(&rx->display_mutex);
 }
 
+//
+// The panadapter and waterfall are drawn by the render thread (rx_display.c),
+// this timer only updates the S-meter, which has to be done in the GTK thread.
+//
 static int rx_update_display(gpointer data) {
   RECEIVER *rx = (RECEIVER *)data;
 
   if (rx->displaying) {
     if (rx->pixels > 0) {
-      int rc;
-      g_mutex_lock(&rx->display_mutex);
-      rc = rx_get_pixels(rx);
-
-      if (rc) {
-        if (rx->display_panadapter) {
-          rx_panadapter_update(rx);
-        }
-
-        if (rx->display_waterfall) {
-          waterfall_update(rx);
-        }
-      }
-
-      g_mutex_unlock(&rx->display_mutex);
-
       if (active_receiver == rx) {
         //
         // since rx->meter is used in other places as well (e.g. rigctl),
@@ -643,6 +642,7 @@ void rx_set_displaying(RECEIVER *rx) {
     }
 
     rx->update_timer_id = gdk_threads_add_timeout_full(G_PRIORITY_HIGH_IDLE, 1000 / rx->fps, rx_update_display, rx, NULL);
+    rx_display_start();
   } else {
     if (rx->update_timer_id > 0) {
       g_source_remove(rx->update_timer_id);
@@ -657,6 +657,7 @@ static void rx_create_visual(RECEIVER *rx) {
   t_print("%s: RXid=%d width=%d height=%d %p\n", __FUNCTION__, rx->id, rx->width, rx->height, rx->panel);
   g_object_weak_ref(G_OBJECT(rx->panel), rx_weak_notify, (gpointer)rx);
   gtk_widget_set_size_request (rx->panel, rx->width, rx->height);
+  rx_display_attach(rx);
   rx->panadapter = NULL;
   rx->waterfall = NULL;
   int height = rx->height;
@@ -739,6 +740,7 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
   rx->id = id;
   g_mutex_init(&rx->mutex);
   g_mutex_init(&rx->display_mutex);
+  g_mutex_init(&rx->frame_mutex);
 
   switch (id) {
   case 0:
@@ -824,6 +826,7 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
   rx->nr = 0;
   rx->anf = 0;
   rx->snb = 0;
+  rx->carrier_notch = 0;
   rx->nr_agc = 0;                   // NR/NR2/ANF before AGC
   rx->nr2_gain_method = 2;          // Gamma
   rx->nr2_npe_method = 0;           // OSMS
@@ -878,9 +881,14 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
   rx->local_audio = 0;
   g_mutex_init(&rx->local_audio_mutex);
   rx->local_audio_buffer = NULL;
+  rx->audio_match = NULL;
+  rx->local_audio_thread = NULL;
+  rx->local_audio_running = 0;
   g_strlcpy(rx->audio_name, "NO AUDIO", sizeof(rx->audio_name));
   rx->mute_when_not_active = 0;
   rx->audio_channel = STEREO;
+  rx->mixer_gain = 0.0;
+  rx->mixer_pan = 0.0;
   rx->audio_device = -1;
   rx->squelch_enable = 0;
   rx->squelch = 0;
@@ -1002,7 +1010,7 @@ RECEIVER *rx_create_receiver(int id, int pixels, int width, int height) {
   rx_create_visual(rx);
 
   if (rx->local_audio) {
-    if (audio_open_output(rx) < 0) {
+    if (audio_mixer_open_output(rx) < 0) {
       rx->local_audio = 0;
     }
   }
@@ -1104,6 +1112,7 @@ void rx_frequency_changed(RECEIVER *rx) {
   // and send the (possibly changed) frequency to the radio in any case.
   //
   rx_set_offset(rx, vfo[id].offset);
+  carrier_notch_retune(rx);
 
   switch (protocol) {
   case ORIGINAL_PROTOCOL:
@@ -1177,27 +1186,14 @@ static void rx_process_buffer(RECEIVER *rx) {
     }
 
     if (rx->local_audio) {
-      if (rx->mute_radio || (rx != active_receiver && rx->mute_when_not_active)) {
-        left_sample = 0.0;
-        right_sample = 0.0;
-      } else {
-        switch (rx->audio_channel) {
-        case STEREO:
-          break;
-
-        case LEFT:
-          right_sample = 0.0;
-          break;
-
-        case RIGHT:
-          left_sample = 0.0;
-          break;
-        }
-      }
-
-      audio_write(rx, (float)left_sample, (float)right_sample);
+      //
+      // gain, pan, channel assignment and muting are applied by the audio mixer
+      //
+      audio_mixer_put(rx, (float)left_sample, (float)right_sample);
     }
 
+    dvr_put_rx(rx, (float)left_sample, (float)right_sample);
+
     if (rx == active_receiver && capture_state == CAP_RECORDING) {
       if (capture_record_pointer < capture_max) {
         //
@@ -1244,12 +1240,19 @@ static void rx_process_buffer(RECEIVER *rx) {
       }
     }
   }
+
+  if (rx->local_audio) {
+    audio_mixer_commit(rx);
+  }
+
+  dvr_commit_rx(rx);
 }
 
 void rx_full_buffer(RECEIVER *rx) {
   int error;
 
   //t_print("%s: rx=%p\n",__FUNCTION__,rx);
+  rx->block_time = sample_clock_time(&rx->clock, rx->iq_count);
   //
   // rx->mutex is locked if a sample rate change is currently going on,
   // in this case we should not block the receiver thread
@@ -1278,15 +1281,49 @@ void rx_full_buffer(RECEIVER *rx) {
       t_print("%s: id=%d fexchange0: error=%d\n", __FUNCTION__, rx->id, error);
     }
 
+    if (rx->block_time != 0) {
+      double latency = (double)(g_get_monotonic_time() - rx->block_time);
+      rx->dsp_latency += (latency - rx->dsp_latency) * 0.05;
+    }
+
     if (rx->displaying) {
       g_mutex_lock(&rx->display_mutex);
       Spectrum0(1, rx->id, 0, 0, rx->iq_input_buffer);
+      rx->spectrum_time = rx->block_time;
       g_mutex_unlock(&rx->display_mutex);
     }
 
     rx_process_buffer(rx);
     g_mutex_unlock(&rx->mutex);
   }
+
+  //
+  // Report the clock model every five minutes
+  //
+  rx->clock_report += rx->buffer_size;
+
+  if (rx->clock_report >= 300L * rx->sample_rate) {
+    rx->clock_report = 0;
+    t_print("%s: RX%d sample rate error=%0.1f ppm arrival jitter=%0.0f usec latency dsp=%0.1f display=%0.1f msec\n",
+            __FUNCTION__, rx->id + 1, sample_clock_ppm(&rx->clock), rx->clock.jitter, rx->dsp_latency * 0.001,
+            rx->display_latency * 0.001);
+  }
+}
+
+//
+// Called by the protocol code before the IQ samples of a packet that
+// arrived at "stamp" are added. The previous packet is complete now,
+// so its arrival time belongs to its last sample.
+//
+void rx_stamp_iq(RECEIVER *rx, gint64 stamp) {
+  if (rx->clock.nominal != rx->sample_rate) {
+    sample_clock_init(&rx->clock, rx->sample_rate);
+  } else if (rx->iq_stamp != 0 && rx->iq_count > rx->iq_stamp_count) {
+    sample_clock_update(&rx->clock, rx->iq_count, rx->iq_stamp);
+  }
+
+  rx->iq_stamp = stamp;
+  rx->iq_stamp_count = rx->iq_count;
 }
 
 void rx_add_iq_samples(RECEIVER *rx, double i_sample, double q_sample) {
@@ -1310,8 +1347,11 @@ void rx_add_iq_samples(RECEIVER *rx, double i_sample, double q_sample) {
   rx->iq_input_buffer[rx->samples * 2] = i_sample;
   rx->iq_input_buffer[(rx->samples * 2) + 1] = q_sample;
   rx->samples = rx->samples + 1;
+  rx->iq_count++;
+  dvr_put_iq(rx, i_sample, q_sample);
 
   if (rx->samples >= rx->buffer_size) {
+    dvr_commit_iq(rx);
     rx_full_buffer(rx);
     rx->samples = 0;
   }
@@ -1501,6 +1541,8 @@ void rx_change_sample_rate(RECEIVER *rx, int sample_rate) {
 }
 
 void rx_close(const RECEIVER *rx) {
+  eq_update_sync();
+  carrier_notch_close(rx);
   CloseChannel(rx->id);
 }
 
@@ -1637,6 +1679,16 @@ void rx_off(const RECEIVER *rx) {
   SetChannelState(rx->id, 0, 1);
 }
 
+void rx_off_nowait(const RECEIVER *rx) {
+  // switch receiver OFF, slew-down completion is waited for with rx_off_wait()
+  SetChannelState(rx->id, 0, 0);
+}
+
+int rx_off_wait(const RECEIVER *rx) {
+  // wait (at most 100 msec) until the slew-down has completed
+  return WaitChannelFlush(rx->id, 100);
+}
+
 void rx_on(const RECEIVER *rx) {
   // switch receiver ON
   SetChannelState(rx->id, 1, 0);
@@ -1823,21 +1875,23 @@ void rx_set_deviation(const RECEIVER *rx) {
 
 void rx_set_equalizer(RECEIVER *rx) {
   //
-  // Apply the equalizer parameters stored in rx
+  // Apply the equalizer parameters stored in rx.
+  // The filter design is done in the background.
   //
-#if defined (__EQ12__)
-  SetRXAEQProfile(rx->id, 12, rx->eq_freq, rx->eq_gain);
-#else
-  SetRXAEQProfile(rx->id, 10, rx->eq_freq, rx->eq_gain);
-#endif
-  SetRXAEQRun(rx->id, rx->eq_enable);
+  eq_update_rx(rx);
 }
 
 void rx_set_fft_latency(const RECEIVER *rx) {
+  //
+  // The equalizer worker updates the same filter core without
+  // holding the WDSP channel lock, so let it finish first.
+  //
+  eq_update_sync();
   RXASetMP(rx->id, rx->low_latency);
 }
 
 void rx_set_fft_size(const RECEIVER *rx) {
+  eq_update_sync();
   RXASetNC(rx->id, rx->fft_size);
 }
 
@@ -1899,6 +1953,11 @@ void rx_set_noise(const RECEIVER *rx) {
   SetRXAEMNRaeRun(rx->id, rx->nr2_ae); // ArtifactElminiation ON
   SetRXAEMNRRun(rx->id, (rx->nr == 2));
   //
+  // NR5
+  //
+  SetRXASSNRPosition(rx->id, rx->nr_agc);
+  SetRXASSNRRun(rx->id, (rx->nr == 5));
+  //
   // e) ANF
   //
   SetRXAANFRun(rx->id, rx->anf);
@@ -1907,6 +1966,10 @@ void rx_set_noise(const RECEIVER *rx) {
   // f) SNB
   //
   SetRXASNBARun(rx->id, rx->snb);
+  //
+  // Automatic carrier notches
+  //
+  carrier_notch_update(rx);
 #ifdef EXTNR
   //
   // These WDSP functions only exist in a special, non-official version
@@ -1926,6 +1989,33 @@ void rx_set_noise(const RECEIVER *rx) {
 #endif
 }
 
+int rx_next_nr(int nr) {
+  //
+  // Cycle through the noise reduction methods available in this build
+  //
+  switch (nr) {
+  case 0:
+    return 1;
+
+  case 1:
+    return 2;
+
+  case 2:
+#ifdef EXTNR
+    return 3;
+
+  case 3:
+    return 4;
+
+  case 4:
+#endif
+    return 5;
+
+  default:
+    return 0;
+  }
+}
+
 void rx_set_offset(const RECEIVER *rx, long long offset) {
   if (offset == 0) {
     SetRXAShiftFreq(rx->id, (double)offset);
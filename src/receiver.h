@@ -33,6 +33,9 @@
   #include <pulse/simple.h>
 #endif
 
+#include "audio_match.h"
+#include "sample_clock.h"
+
 enum _audio_channel_enum {
   STEREO = 0,
   LEFT,
@@ -62,6 +65,8 @@ typedef struct _receiver {
   int fps;
   int displaying;
   int audio_channel; // STEREO or LEFT or RIGHT
+  double mixer_gain; // local audio mixer: gain in dB
+  double mixer_pan;  // local audio mixer: -1.0 (left) ... +1.0 (right)
   int sample_rate;
   int pixels;
   int samples;
@@ -90,6 +95,7 @@ typedef struct _receiver {
   // nr = 2:         Spectral Noise Reduction, "NR2", "AEMNR"
   // nr = 3:         non-standard extension to WDSP
   // nr = 4:         non-standard extension to WDSP
+  // nr = 5:         Light-weight spectral subtraction, "NR5", "SSNR"
   //
   // nb = 0:         No noise blanker
   // nb = 1:         Preemptive Wideband Blanker, "NB", "ANB"
@@ -97,11 +103,13 @@ typedef struct _receiver {
   //
   // anf= 0/1:       Automatic notch filter off/on
   // snb= 0/1:       Spectral noise blanker off/on
+  // carrier_notch=0/1: automatic carrier notches (NBP) off/on
   //
   int nb;
   int nr;
   int anf;
   int snb;
+  int carrier_notch;
 
   //
   // NR/NR2/ANF: position
@@ -196,8 +204,26 @@ typedef struct _receiver {
   int waterfall_mode;  // 0=2D (Cairo), 1=3DSS (OpenGL)
   int last_waterfall_mode;  // Track mode changes for dynamic switching
   int waterfall3dss_palette;  // Color palette: 0=Rainbow, 1=Ocean, 2=Green, 3=Gray, 4=Hot, 5=Cool, 6=Plasma
-  cairo_surface_t *panadapter_surface;
+  cairo_surface_t *panadapter_surface;  // back buffers, owned by the render thread
   GdkPixbuf *pixbuf;
+  //
+  // display pipeline (rx_display.c). The front buffers and the widget
+  // sizes requested by the configure callbacks are protected by frame_mutex
+  //
+  GMutex frame_mutex;
+  cairo_surface_t *panadapter_front;
+  GdkPixbuf *pixbuf_front;
+  int pan_width;
+  int pan_height;
+  int pan_scale;                // HiDPI scale factor of the panadapter widget
+  int wf_width;
+  int wf_height;
+  guint frame_ready;            // RX_FRAME_* bits, atomic
+  gint64 frame_deadline;
+  long frames_rendered;
+  long frames_late;
+  long frames_dropped;
+  guint tick_id;
   int local_audio;
   int mute_when_not_active;
   int audio_device;
@@ -209,8 +235,8 @@ typedef struct _receiver {
   void *playstream;
   int local_audio_buffer_inpt;
   int local_audio_buffer_outpt;
-  int local_audio_buffer_offset;
-  void *local_audio_buffer;
+  int local_audio_cw;
+  float *local_audio_buffer;
   snd_pcm_t *playback_handle;
   snd_pcm_format_t local_audio_format;
 #endif
@@ -223,15 +249,23 @@ typedef struct _receiver {
 #if !defined(PORTAUDIO) && !defined(PULSEAUDIO) && defined(ALSA)
   snd_pcm_t *playback_handle;
   snd_pcm_format_t local_audio_format;
-  void *local_audio_buffer;        // different formats possible, so void*
-  int local_audio_buffer_offset;
+  float *local_audio_buffer;       // CW side tone ring buffer (mono)
+  int local_audio_buffer_inpt;     // pointers in the ring buffer
+  int local_audio_buffer_outpt;
+  int local_audio_cw;              // the CW side tone owns the output
 #endif
 #if !defined(PORTAUDIO) && defined(PULSEAUDIO) && !defined(ALSA)
   pa_simple *playstream;
-  float *local_audio_buffer;
-  int local_audio_buffer_offset;
+  float *local_audio_buffer;       // CW side tone ring buffer (mono)
+  int local_audio_buffer_inpt;     // pointers in the ring buffer
+  int local_audio_buffer_outpt;
+  int local_audio_cw;              // the CW side tone owns the output
 #endif
 
+  AUDIO_MATCH *audio_match;        // clock-drift compensation radio -> sound card
+  GThread *local_audio_thread;     // feeds the sound card from audio_match (ALSA, PulseAudio)
+  gint local_audio_running;
+
   GMutex local_audio_mutex;
 
   int squelch_enable;
@@ -270,6 +304,22 @@ typedef struct _receiver {
   int txrxcount;
   int txrxmax;
 
+  //
+  // Sample timeline, see sample_clock.h. All times are monotonic (usec)
+  // and refer to the arrival of a sample at the host.
+  // iq_count and clock are only used by the thread feeding IQ samples.
+  //
+  SAMPLE_CLOCK clock;
+  guint64 iq_count;        // IQ samples received so far
+  guint64 iq_stamp_count;  // iq_count when the current packet started
+  gint64 iq_stamp;         // arrival time of the current packet
+  gint64 block_time;       // last sample of the block passed to fexchange0
+  gint64 spectrum_time;    // last sample fed to the spectrum analyzer
+  gint64 display_time;     // last sample contained in the displayed spectrum
+  double dsp_latency;      // from arrival to the audio block leaving fexchange0
+  double display_latency;  // from arrival to display
+  long clock_report;
+
   int display_gradient;
   int display_filled;
   int display_detector_mode;
@@ -300,6 +350,7 @@ extern gboolean rx_scroll_event(GtkWidget *widget, const GdkEventScroll *event,
 
 extern void   rx_add_iq_samples(RECEIVER *rx, double i_sample, double q_sample);
 extern void   rx_add_div_iq_samples(RECEIVER *rx, double i0, double q0, double i1, double q1);
+extern void   rx_stamp_iq(RECEIVER *rx, gint64 stamp);
 
 extern void   rx_change_sample_rate(RECEIVER *rx, int sample_rate);
 extern void   rx_change_adc(const RECEIVER *rx);
@@ -310,7 +361,10 @@ extern int    rx_get_pixels(RECEIVER *rx);
 extern double rx_get_smeter(const RECEIVER *rx);
 extern void   rx_frequency_changed(RECEIVER *rx);
 extern void   rx_mode_changed(RECEIVER *rx);
+extern int    rx_next_nr(int nr);
 extern void   rx_off(const RECEIVER *rx);
+extern void   rx_off_nowait(const RECEIVER *rx);
+extern int    rx_off_wait(const RECEIVER *rx);
 extern void   rx_on(const RECEIVER *rx);
 extern void   rx_reconfigure(RECEIVER *rx, int height);
 extern void   rx_restore_state(RECEIVER *rx);
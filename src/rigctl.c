@@ -57,6 +57,7 @@
 #include "bandstack.h"
 #include "filter_menu.h"
 #include "vfo.h"
+#include "voice_keyer.h"
 #include "transmitter.h"
 #include "agc.h"
 #include "store.h"
@@ -6101,8 +6102,32 @@ int parse_cmd(void *data) {
       break;
 
     case 'B': //PB
-      // set/read FRU-3A playback status
-      implemented = FALSE;
+
+      //CATDEF    PB
+      //DESCR     Set/Read voice keyer playback
+      //SET       PBx;
+      //READ      PB;
+      //RESP      PBx;
+      //NOTE      x=1...4: send voice keyer message x, x=0: stop playback
+      //NOTE      Reading reports the message being sent (or repeated), 0 if none
+      //ENDDEF
+      if (can_transmit) {
+        if (command[2] == ';') {
+          snprintf(reply, 256, "PB%d;", voice_keyer_playing());
+          send_resp(client->fd, reply);
+        } else if (command[3] == ';') {
+          int slot = atoi(&command[2]);
+
+          if (slot == 0) {
+            voice_keyer_stop();
+          } else if (slot <= VK_SLOTS) {
+            voice_keyer_play(slot - 1);
+          }
+
+          g_idle_add(ext_vfo_update, NULL);
+        }
+      }
+
       break;
 
     case 'C': //PC
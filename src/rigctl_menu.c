@@ -30,6 +30,7 @@
 #include "new_menu.h"
 #include "rigctl_menu.h"
 #include "rigctl.h"
+#include "hamlib.h"
 #include "band.h"
 #include "radio.h"
 #include "vfo.h"
@@ -47,6 +48,7 @@ static GtkWidget *rigctld_btn;
 static GtkWidget *rigctl_andromeda_btn;
 static GtkWidget *rigctl_port_select;
 static GtkWidget *tci_port_select;
+static GtkWidget *hamlib_port_select;
 
 static void cleanup() {
   if (dialog != NULL) {
@@ -114,6 +116,22 @@ static void tci_txonly_changed_cb(GtkWidget *widget, gpointer data) {
 
 #endif
 
+static void hamlib_enable_cb(GtkWidget *widget, gpointer data) {
+  hamlib_enable = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+
+  if (hamlib_enable) {
+    gtk_widget_set_sensitive(hamlib_port_select, FALSE);
+    launch_hamlib();
+  } else {
+    gtk_widget_set_sensitive(hamlib_port_select, TRUE);
+    shutdown_hamlib();
+  }
+}
+
+static void hamlib_port_changed_cb(GtkWidget *widget, gpointer data) {
+  hamlib_port = gtk_spin_button_get_value(GTK_SPIN_BUTTON(widget));
+}
+
 static void rigctl_tcp_enable_cb(GtkWidget *widget, gpointer data) {
   rigctl_tcp_enable = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
 
@@ -602,6 +620,32 @@ void rigctl_menu(GtkWidget *parent) {
   }
 
   //-----------------------------------------------------------------------------------------------------------------
+  row++;
+  w = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
+  gtk_widget_set_size_request(w, -1, 3);
+  gtk_grid_attach(GTK_GRID(grid), w, 0, row, 7, 1);
+  row++;
+  w = gtk_label_new("Hamlib");
+  gtk_widget_set_name(w, "boldlabel");
+  gtk_widget_set_halign(w, GTK_ALIGN_END);
+  gtk_grid_attach(GTK_GRID(grid), w, 0, row, 1, 1);
+  hamlib_port_select = gtk_spin_button_new_with_range(1025, 65535, 1);
+  gtk_widget_set_tooltip_text(hamlib_port_select, "Select Hamlib rigctld port");
+  gtk_spin_button_set_value(GTK_SPIN_BUTTON(hamlib_port_select), (double)hamlib_port);
+  gtk_grid_attach(GTK_GRID(grid), hamlib_port_select, 1, row, 1, 1);
+  g_signal_connect(hamlib_port_select, "value_changed", G_CALLBACK(hamlib_port_changed_cb), NULL);
+  gtk_widget_set_sensitive(hamlib_port_select, !hamlib_enable);
+  w = gtk_check_button_new_with_label("Enable");
+  gtk_widget_set_name(w, "boldlabel");
+  gtk_widget_set_tooltip_text(w,
+                              "Built-in Hamlib rigctld server\n\n"
+                              "Use |Hamlib NET rigctl| as rig selection\n"
+                              "and 127.0.0.1:<port> as port in the app,\n"
+                              "no external rigctld is needed");
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (w), hamlib_enable);
+  gtk_widget_show(w);
+  gtk_grid_attach(GTK_GRID(grid), w, 2, row, 1, 1);
+  g_signal_connect(w, "toggled", G_CALLBACK(hamlib_enable_cb), NULL);
   // row++;
   // w = gtk_check_button_new_with_label("Enable RigCtl Debug Logging");
   // gtk_widget_set_name(w, "boldlabel");
@@ -0,0 +1,289 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Soak test for the WDSP rate matcher (rmatch).
+ *
+ * A producer feeds a sine tone into xrmatchIN() at a nominal 48 kHz that is
+ * off by -in ppm, a consumer pulls blocks with xrmatchOUT() at 48 kHz off by
+ * -out ppm. The rmatch parameters are those of src/audio_match.c.
+ *
+ * Default is a virtual clock: producer and consumer calls are interleaved in
+ * the order of their time stamps, so an hour of audio runs in a few
+ * seconds and every run is reproducible. With -rt both sides run as real-time
+ * paced threads, which is the mode to use under a thread sanitizer. The drift
+ * estimate needs a few minutes to settle, so give -rt runs at least -t 600.
+ *
+ * After the settle time, the program checks that
+ *   - the resampling ratio tracks the true clock ratio (drift error in ppm),
+ *   - no under- or overflow happens,
+ * and reports the spread of the ring filling around the target.
+ * The exit code is 0 if all checks pass.
+ *
+ * Build: make rmatch_soak
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <wdsp.h>
+
+#include "test_util.h"
+
+#define SOAK_RATE     48000
+#define SOAK_INSIZE   256            // audio_match.c: match_insize
+#define SOAK_PROPMIN  256            // audio_match.c: match_prop_min
+#define SOAK_PROPMAX  1024           // audio_match.c: match_prop_max
+#define SOAK_GAIN     1.0e-6         // audio_match.c: match_gain
+
+static double in_ppm = 120.0;        // producer clock error
+static double out_ppm = -80.0;       // consumer clock error
+static double duration = 1800.0;     // seconds of audio
+static double settle = 120.0;        // seconds before the checks start
+static double jitter = 2.0e-3;       // consumer wake-up delay (seconds, max)
+static int outsize = 512;            // consumer block size
+static int burst = 1024;             // producer burst size (RX output_samples)
+static int target;                   // target ring filling
+static int realtime = 0;
+static double max_err = 10.0;        // allowed drift tracking error (ppm)
+
+static void *rm;
+static double *inbuf, *outbuf;
+static double tone_phase;
+
+//
+// statistics, only collected after the settle time
+//
+static double sum_var, sum_var2, min_var = 1.0e9, max_var = -1.0e9;
+static long n_var;
+static int min_fill = 1 << 30, max_fill;
+static int under0, over0;
+static int checking;
+
+static void produce(void) {
+  for (int i = 0; i < SOAK_INSIZE; i++) {
+    inbuf[2 * i + 0] = 0.5 * cos(tone_phase);
+    inbuf[2 * i + 1] = 0.5 * sin(tone_phase);
+    tone_phase += 2.0 * M_PI * 1000.0 / SOAK_RATE;
+
+    if (tone_phase > 2.0 * M_PI) { tone_phase -= 2.0 * M_PI; }
+  }
+
+  xrmatchIN(rm, inbuf);
+}
+
+static void consume(double now) {
+  int underflows, overflows, ringsize, fill;
+  double var;
+  xrmatchOUT(rm, outbuf);
+  getRMatchDiags(rm, &underflows, &overflows, &var, &ringsize, &fill);
+
+  if (now < settle) {
+    under0 = underflows;
+    over0 = overflows;
+    return;
+  }
+
+  checking = 1;
+  sum_var += var;
+  sum_var2 += var * var;
+  n_var++;
+
+  if (var < min_var) { min_var = var; }
+
+  if (var > max_var) { max_var = var; }
+
+  if (fill < min_fill) { min_fill = fill; }
+
+  if (fill > max_fill) { max_fill = fill; }
+}
+
+//
+// virtual clock: the producer delivers bursts of "burst" samples,
+// the consumer wakes up every outsize samples, up to "jitter" late
+//
+static void run_virtual(void) {
+  double t_in = 0.0, t_out = 0.0, j = 0.0;
+  double dt_in = (double) burst / (SOAK_RATE * (1.0 + 1.0e-6 * in_ppm));
+  double dt_out = (double) outsize / (SOAK_RATE * (1.0 + 1.0e-6 * out_ppm));
+  unsigned int seed = 4711;
+  // start the consumer when the ring is half full, as the audio thread does
+  t_out = (double) target / SOAK_RATE;
+
+  while (t_in < duration || t_out < duration) {
+    if (t_in <= t_out + j) {
+      for (int i = 0; i < burst / SOAK_INSIZE; i++) { produce(); }
+
+      t_in += dt_in;
+    } else {
+      // late wake-up, the jitter does not accumulate
+      consume(t_out + j);
+      t_out += dt_out;
+      j = jitter * (double) rand_r(&seed) / RAND_MAX;
+    }
+  }
+}
+
+//
+// real time: two threads paced by clock_nanosleep on CLOCK_MONOTONIC
+//
+static struct timespec t_start;
+static volatile int rt_stop;
+
+static double rt_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec - t_start.tv_sec) + 1.0e-9 * (ts.tv_nsec - t_start.tv_nsec);
+}
+
+static void rt_sleep_until(double t) {
+  struct timespec ts = t_start;
+  double s = floor(t);
+  ts.tv_sec += (time_t) s;
+  ts.tv_nsec += (long) (1.0e9 * (t - s));
+
+  if (ts.tv_nsec >= 1000000000L) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000L;
+  }
+
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static void *rt_producer(void *arg) {
+  double dt = (double) burst / (SOAK_RATE * (1.0 + 1.0e-6 * in_ppm));
+  double t = 0.0;
+
+  while (!rt_stop) {
+    for (int i = 0; i < burst / SOAK_INSIZE; i++) { produce(); }
+
+    t += dt;
+    rt_sleep_until(t);
+  }
+
+  return NULL;
+}
+
+static void *rt_consumer(void *arg) {
+  double dt = (double) outsize / (SOAK_RATE * (1.0 + 1.0e-6 * out_ppm));
+  double t = (double) target / SOAK_RATE;
+  rt_sleep_until(t);
+
+  while (!rt_stop) {
+    consume(rt_now());
+    t += dt;
+    rt_sleep_until(t);
+  }
+
+  return NULL;
+}
+
+static void run_realtime(void) {
+  pthread_t p, c;
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+  pthread_create(&p, NULL, rt_producer, NULL);
+  pthread_create(&c, NULL, rt_consumer, NULL);
+  rt_sleep_until(duration);
+  rt_stop = 1;
+  pthread_join(p, NULL);
+  pthread_join(c, NULL);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-rt] [-in <ppm>] [-out <ppm>] [-t <seconds>] [-settle <seconds>]\n", prog);
+  fprintf(stderr, "       [-outsize <frames>] [-burst <frames>] [-jitter <ms>] [-maxerr <ppm>]\n");
+  exit(8);
+}
+
+int main(int argc, char *argv[]) {
+  int underflows, overflows, ringsize, fill;
+  double var, mean_var, expected, err, sdev;
+  char what[128];
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-rt"))                           { realtime = 1; continue; }
+
+    if (!strcmp(argv[i], "-in")      && i < argc - 1)      { in_ppm = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-out")     && i < argc - 1)      { out_ppm = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-t")       && i < argc - 1)      { duration = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-settle")  && i < argc - 1)      { settle = atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-outsize") && i < argc - 1)      { outsize = atoi(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-burst")   && i < argc - 1)      { burst = atoi(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-jitter")  && i < argc - 1)      { jitter = 1.0e-3 * atof(argv[++i]); continue; }
+
+    if (!strcmp(argv[i], "-maxerr")  && i < argc - 1)      { max_err = atof(argv[++i]); continue; }
+
+    usage(argv[0]);
+  }
+
+  if (burst < SOAK_INSIZE || burst % SOAK_INSIZE || outsize < 1 || settle >= duration) { usage(argv[0]); }
+
+  // same target filling as audio_match_new() with a latency of 0
+  target = burst / 2 + outsize + 128;
+  inbuf = calloc(2 * SOAK_INSIZE, sizeof(double));
+  outbuf = calloc(2 * outsize, sizeof(double));
+  rm = create_rmatchV(SOAK_INSIZE, outsize, SOAK_RATE, SOAK_RATE, 2 * target, 1.0);
+  setRMatchPropRingMin(rm, SOAK_PROPMIN);
+  setRMatchPropRingMax(rm, SOAK_PROPMAX);
+  setRMatchFeedbackGain(rm, SOAK_GAIN);
+  printf("rmatch soak: %s clock, %.0f s, producer %+.1f ppm (bursts of %d), consumer %+.1f ppm (blocks of %d)\n",
+         realtime ? "real-time" : "virtual", duration, in_ppm, burst, out_ppm, outsize);
+  printf("             ring %d, target filling %d\n", 2 * target, target);
+
+  if (realtime) {
+    run_realtime();
+  } else {
+    run_virtual();
+  }
+
+  getRMatchDiags(rm, &underflows, &overflows, &var, &ringsize, &fill);
+
+  check(checking && n_var > 0, "consumer calls after the settle time");
+
+  if (failures) { return test_result(); }
+
+  // var is the ratio (consumer rate / producer rate) relative to the nominal ratio
+  expected = (1.0 + 1.0e-6 * out_ppm) / (1.0 + 1.0e-6 * in_ppm);
+  mean_var = sum_var / n_var;
+  sdev = sqrt(fmax(0.0, sum_var2 / n_var - mean_var * mean_var));
+  err = 1.0e6 * (mean_var / expected - 1.0);
+  printf("var:         expected %.8f  mean %.8f  (error %+.2f ppm, sdev %.2f ppm, span %.2f ppm)\n",
+         expected, mean_var, err, 1.0e6 * sdev, 1.0e6 * (max_var - min_var));
+  printf("filling:     min %d  max %d  target %d  ring %d\n", min_fill, max_fill, target, ringsize);
+  printf("underflows:  %d (%d after settle)\n", underflows, underflows - under0);
+  printf("overflows:   %d (%d after settle)\n", overflows, overflows - over0);
+
+  snprintf(what, sizeof(what), "drift tracking error within %.2f ppm", max_err);
+  check(fabs(err) <= max_err, what);
+  check(underflows == under0 && overflows == over0, "no under/overflow after the settle time");
+  destroy_rmatchV(rm);
+  free(inbuf);
+  free(outbuf);
+  return test_result();
+}
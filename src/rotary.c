@@ -0,0 +1,191 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <math.h>
+
+#include "rotary.h"
+
+#define DIR_NONE 0x0
+// Clockwise step.
+#define DIR_CW 0x10
+// Anti-clockwise step.
+#define DIR_CCW 0x20
+
+//
+// Encoder states for a "full cycle", R_START is in rotary.h
+//
+#define R_CW_FINAL  0x01
+#define R_CW_BEGIN  0x02
+#define R_CW_NEXT   0x03
+#define R_CCW_BEGIN 0x04
+#define R_CCW_FINAL 0x05
+#define R_CCW_NEXT  0x06
+
+//
+// Encoder states for a "half cycle", R_START1 is in rotary.h
+//
+#define R_START0    0x08
+#define R_CW_BEG1   0x09
+#define R_CW_BEG0   0x0A
+#define R_CCW_BEG1  0x0B
+#define R_CCW_BEG0  0x0C
+
+//
+// Few general remarks on the state machine:
+// - if the levels do not change, the machinestate does not change
+// - if there is bouncing on one input line, the machine oscillates
+//   between two "adjacent" states but generates at most one tick
+// - if both input lines change level, move to a suitable new
+//   starting point but do not generate a tick
+// - if one or both of the AB lines are inverted, the same cycles
+//   are passed but with a different starting point. Therefore,
+//   it still works.
+//
+static const guchar encoder_state_table[13][4] = {
+  //
+  // A "full cycle" has the following state changes
+  // (first line: line levels AB, 1=pressed, 0=released,
+  //  2nd   line: state names
+  //
+  // clockwise:  11   -->   10   -->    00    -->    01     -->  11
+  //            Start --> CWbeg  -->  CWnext  -->  CWfinal  --> Start
+  //
+  // ccw:        11   -->   01    -->   00     -->   10      -->  11
+  //            Start --> CCWbeg  --> CCWnext  --> CCWfinal  --> Start
+  //
+  // Emit the "tick" when moving from "final" to "start".
+  //
+  //                   00           10           01          11
+  // -----------------------------------------------------------------------------
+  /* R_START     */ {R_START,    R_CW_BEGIN,  R_CCW_BEGIN, R_START},
+  /* R_CW_FINAL  */ {R_CW_NEXT,  R_START,     R_CW_FINAL,  R_START | DIR_CW},
+  /* R_CW_BEGIN  */ {R_CW_NEXT,  R_CW_BEGIN,  R_START,     R_START},
+  /* R_CW_NEXT   */ {R_CW_NEXT,  R_CW_BEGIN,  R_CW_FINAL,  R_START},
+  /* R_CCW_BEGIN */ {R_CCW_NEXT, R_START,     R_CCW_BEGIN, R_START},
+  /* R_CCW_FINAL */ {R_CCW_NEXT, R_CCW_FINAL, R_START,     R_START | DIR_CCW},
+  /* R_CCW_NEXT  */ {R_CCW_NEXT, R_CCW_FINAL, R_CCW_BEGIN, R_START},
+  //
+  // The same sequence can be interpreted as two "half cycles"
+  //
+  // clockwise1:   11    -->   10   -->   00
+  //             Start1  --> CWbeg1 --> Start0
+  //
+  // clockwise2:   00    -->   01   -->   11
+  //             Start0  --> CWbeg0 --> Start1
+  //
+  // ccw1:         11    -->   01    -->   00
+  //             Start1  --> CCWbeg1 --> Start0
+  //
+  // ccw2:         00    -->   10    -->   11
+  //             Start0  --> CCWbeg0 --> Start1
+  //
+  // If both lines change, this is interpreted as a two-step move
+  // without changing the orientation and without emitting a "tick".
+  //
+  // Emit the "tick" each time when moving from "beg" to "start".
+  //
+  //                   00                    10          01         11
+  // -----------------------------------------------------------------------------
+  /* R_START1    */ {R_START0,           R_CW_BEG1,  R_CCW_BEG1, R_START1},
+  /* R_START0    */ {R_START0,           R_CCW_BEG0, R_CW_BEG0,  R_START1},
+  /* R_CW_BEG1   */ {R_START0 | DIR_CW,  R_CW_BEG1,  R_CW_BEG0,  R_START1},
+  /* R_CW_BEG0   */ {R_START0,           R_CW_BEG1,  R_CW_BEG0,  R_START1 | DIR_CW},
+  /* R_CCW_BEG1  */ {R_START0 | DIR_CCW, R_CCW_BEG0, R_CCW_BEG1, R_START1},
+  /* R_CCW_BEG0  */ {R_START0,           R_CCW_BEG0, R_CCW_BEG1, R_START1 | DIR_CCW},
+};
+
+
+//
+// Feed the current levels of the A and B lines (1 = pressed) into the
+// state machine. Returns +1 for a clockwise tick, -1 for an anti-clockwise
+// tick and 0 otherwise.
+//
+int rotary_step(guchar *state, int a, int b) {
+  guchar pinstate = (guchar)(((b & 1) << 1) | (a & 1));
+  *state = encoder_state_table[*state & 0xf][pinstate];
+
+  switch (*state & 0x30) {
+  case DIR_CW:
+    return 1;
+
+  case DIR_CCW:
+    return -1;
+
+  default:
+    return 0;
+  }
+}
+
+//
+// The turning speed is tracked as a recursive average of ticks per second,
+// with a time constant of about 100 msec. When the knob stops, the
+// velocity decays accordingly at the next update.
+//
+void rotary_velocity_init(ROTARY_VELOCITY *v) {
+  v->velocity = 0.0;
+  v->last = 0;
+}
+
+void rotary_velocity_update(ROTARY_VELOCITY *v, int ticks, gint64 now) {
+  double dt, alpha;
+
+  if (v->last == 0) {
+    v->last = now;
+    v->velocity = 0.0;
+    return;
+  }
+
+  dt = 1.0E-6 * (double)(now - v->last);
+  v->last = now;
+
+  if (dt <= 0.0) { dt = 1.0E-3; }
+
+  alpha = 1.0 - exp(-dt / 0.1);
+  v->velocity += alpha * ((double)abs(ticks) / dt - v->velocity);
+}
+
+//
+// Velocity-based acceleration: below 20 ticks/sec every tick counts
+// once, above that the factor grows linearly up to 5 at 200 ticks/sec.
+// Fine tuning thus stays exact, while fast spins cover more ground.
+//
+int rotary_accelerate(const ROTARY_VELOCITY *v, int ticks) {
+  double factor;
+
+  if (v->velocity <= 20.0) { return ticks; }
+
+  factor = 1.0 + 4.0 * (v->velocity - 20.0) / 180.0;
+
+  if (factor > 5.0) { factor = 5.0; }
+
+  return (int)lround(factor * (double)ticks);
+}
+
+//
+// Coalescing window (in msec) for the next dispatch: a slowly turned knob
+// is dispatched (nearly) immediately, while the ticks of a fast spin are
+// collected over a longer window so the GTK main loop is not flooded.
+//
+int rotary_window(const ROTARY_VELOCITY *v) {
+  int w = ROTARY_WINDOW_MIN + (int)(v->velocity / 20.0);
+
+  if (w > ROTARY_WINDOW_MAX) { w = ROTARY_WINDOW_MAX; }
+
+  return w;
+}
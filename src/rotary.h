@@ -0,0 +1,49 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _ROTARY_H
+#define _ROTARY_H
+
+//
+// Rotary encoder state machine, velocity tracking and acceleration.
+// These functions do not depend on GPIO and can be fed with synthetic
+// edge sequences.
+//
+
+//
+// Initial states: R_START for encoders that tick once per full AB cycle,
+// R_START1 for encoders that tick on every half cycle.
+//
+#define R_START     0x00
+#define R_START1    0x07
+
+#define ROTARY_WINDOW_MIN   1   // ms, coalescing window for slow turns
+#define ROTARY_WINDOW_MAX  10   // ms, coalescing window for fast spins
+
+typedef struct _rotary_velocity {
+  double velocity;        // smoothed ticks per second
+  gint64 last;            // time (usec) of the last update, 0 = never
+} ROTARY_VELOCITY;
+
+extern int rotary_step(guchar *state, int a, int b);
+extern void rotary_velocity_init(ROTARY_VELOCITY *v);
+extern void rotary_velocity_update(ROTARY_VELOCITY *v, int ticks, gint64 now);
+extern int rotary_accelerate(const ROTARY_VELOCITY *v, int ticks);
+extern int rotary_window(const ROTARY_VELOCITY *v);
+
+#endif
@@ -0,0 +1,167 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/*
+ * Unit test for the rotary encoder code in src/rotary.c.
+ *
+ * Synthetic AB edge sequences are fed into rotary_step() for both the
+ * full-cycle and the half-cycle state machine: both directions, inverted
+ * lines, contact bounce and "both lines changed" glitches. The velocity
+ * tracker, the acceleration curve and the coalescing window are checked
+ * with synthetic time stamps.
+ *
+ * Build and run: make rotary_test && ./rotary_test
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+
+#include "rotary.h"
+#include "test_util.h"
+
+static void check_got(int ok, const char *what, int got, int expected) {
+  char line[128];
+  snprintf(line, sizeof(line), "%-44s got %5d expected %5d", what, got, expected);
+  check(ok, line);
+}
+
+static void check_int(const char *what, int got, int expected) {
+  check_got(got == expected, what, got, expected);
+}
+
+//
+// Feed a sequence of AB levels (a = first line) reps times, return the sum of the ticks
+//
+static int feed(guchar *state, const int (*seq)[2], int n, int reps) {
+  int sum = 0;
+
+  for (int r = 0; r < reps; r++) {
+    for (int i = 0; i < n; i++) {
+      sum += rotary_step(state, seq[i][0], seq[i][1]);
+    }
+  }
+
+  return sum;
+}
+
+static void test_state_machine(void) {
+  // one detent of a real encoder, starting from and returning to AB=11
+  static const int cw[4][2]  = {{1, 0}, {0, 0}, {0, 1}, {1, 1}};
+  static const int ccw[4][2] = {{0, 1}, {0, 0}, {1, 0}, {1, 1}};
+  // the same with both lines inverted, i.e. starting from AB=00
+  static const int cw_inv[4][2]  = {{0, 1}, {1, 1}, {1, 0}, {0, 0}};
+  // contact bounce on line A around AB=11
+  static const int bounce[6][2] = {{1, 0}, {1, 1}, {1, 0}, {1, 1}, {1, 0}, {1, 1}};
+  // both lines change at once: 11 -> 00 -> 11
+  static const int jump[2][2] = {{0, 0}, {1, 1}};
+  guchar st;
+  st = R_START;
+  rotary_step(&st, 1, 1);
+  check_int("full cycle: 10 detents clockwise", feed(&st, cw, 4, 10), 10);
+  check_int("full cycle: 7 detents counter-clockwise", feed(&st, ccw, 4, 7), -7);
+  check_int("full cycle: bounce on A", feed(&st, bounce, 6, 5), 0);
+  check_int("full cycle: both lines jump", feed(&st, jump, 2, 5), 0);
+  check_int("full cycle: clockwise after glitches", feed(&st, cw, 4, 3), 3);
+  //
+  // with inverted lines the machine needs one detent to find its starting point
+  //
+  st = R_START;
+  rotary_step(&st, 0, 0);
+  feed(&st, cw_inv, 4, 1);
+  check_int("full cycle: inverted lines clockwise", feed(&st, cw_inv, 4, 4), 4);
+  st = R_START1;
+  rotary_step(&st, 1, 1);
+  check_int("half cycle: 10 detents clockwise", feed(&st, cw, 4, 10), 20);
+  check_int("half cycle: 3 detents counter-clockwise", feed(&st, ccw, 4, 3), -6);
+  check_int("half cycle: bounce on A", feed(&st, bounce, 6, 5), 0);
+  check_int("half cycle: both lines jump", feed(&st, jump, 2, 5), 0);
+  st = R_START1;
+  rotary_step(&st, 0, 0);
+  feed(&st, cw_inv, 4, 1);
+  check_int("half cycle: inverted lines clockwise", feed(&st, cw_inv, 4, 4), 8);
+  //
+  // direction reversal in the middle of a detent must not produce a tick
+  //
+  st = R_START;
+  rotary_step(&st, 1, 1);
+  check_int("full cycle: reversal half way", rotary_step(&st, 1, 0) + rotary_step(&st, 0, 0)
+            + rotary_step(&st, 1, 0) + rotary_step(&st, 1, 1), 0);
+}
+
+static void test_velocity(void) {
+  ROTARY_VELOCITY v;
+  gint64 t = 1000000;
+  int last, monotonic = 1;
+  rotary_velocity_init(&v);
+  rotary_velocity_update(&v, 1, t);
+  check_int("velocity: first update starts at zero", (int) v.velocity, 0);
+
+  //
+  // two ticks per second: no acceleration, shortest window
+  //
+  for (int i = 0; i < 50; i++) {
+    t += 500000;
+    rotary_velocity_update(&v, 1, t);
+  }
+
+  check_got(v.velocity > 1.5 && v.velocity < 2.5, "velocity: slow turn, ticks/s", (int) v.velocity, 2);
+  check_int("acceleration: slow turn, 1 tick", rotary_accelerate(&v, 1), 1);
+  check_int("acceleration: slow turn, -1 tick", rotary_accelerate(&v, -1), -1);
+  check_int("window: slow turn (ms)", rotary_window(&v), ROTARY_WINDOW_MIN);
+
+  //
+  // 300 ticks per second: full acceleration, longest window
+  //
+  for (int i = 0; i < 100; i++) {
+    t += 10000;
+    rotary_velocity_update(&v, 3, t);
+  }
+
+  check_got(v.velocity > 290.0 && v.velocity < 310.0, "velocity: fast spin, ticks/s", (int) v.velocity, 300);
+  check_int("acceleration: fast spin, 3 ticks", rotary_accelerate(&v, 3), 15);
+  check_int("acceleration: fast spin, -3 ticks", rotary_accelerate(&v, -3), -15);
+  check_int("window: fast spin (ms)", rotary_window(&v), ROTARY_WINDOW_MAX);
+  //
+  // after the knob stops, the next update decays the velocity
+  //
+  t += 1000000;
+  rotary_velocity_update(&v, 1, t);
+  check_got(v.velocity < 20.0, "velocity: decays after a 1 s pause", (int) v.velocity, 0);
+  check_int("acceleration: after the pause", rotary_accelerate(&v, 1), 1);
+  //
+  // the acceleration factor never decreases with speed and stays within 1..5
+  //
+  last = 0;
+
+  for (int speed = 0; speed <= 400; speed += 5) {
+    ROTARY_VELOCITY w = { (double) speed, 1 };
+    int n = rotary_accelerate(&w, 100);
+
+    if (n < last || n < 100 || n > 500) { monotonic = 0; }
+
+    last = n;
+  }
+
+  check_int("acceleration: monotonic and within 1..5", monotonic, 1);
+}
+
+int main(int argc, char *argv[]) {
+  test_state_machine();
+  test_velocity();
+  return test_result();
+}
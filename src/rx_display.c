@@ -0,0 +1,277 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <gtk/gtk.h>
+#include <string.h>
+
+#include "band_activity.h"
+#include "carrier_notch.h"
+#include "message.h"
+#include "radio.h"
+#include "receiver.h"
+#include "rx_display.h"
+#include "rx_panadapter.h"
+#include "waterfall.h"
+#include "waterfall3dss.h"
+
+#define RX_DISPLAY_IDLE   100000LL        // usec, poll interval if no receiver is displaying
+#define RX_DISPLAY_REPORT 300000000LL     // usec, statistics every 5 minutes
+
+static GThread *render_thread_id = NULL;
+
+//
+// (Re-)allocate the back buffers if the configure callbacks
+// have requested a different size
+//
+static void rx_display_buffers(RECEIVER *rx) {
+  g_mutex_lock(&rx->frame_mutex);
+  int pan_width = rx->pan_width;
+  int pan_height = rx->pan_height;
+  int pan_scale = rx->pan_scale > 0 ? rx->pan_scale : 1;
+  int wf_width = rx->wf_width;
+  int wf_height = rx->wf_height;
+  g_mutex_unlock(&rx->frame_mutex);
+
+  //
+  // The panadapter surface has the device resolution, i.e. the widget size
+  // times the HiDPI scale factor, and a device scale so that it is drawn
+  // into (and painted onto the widget) with widget coordinates
+  //
+  if (pan_width > 0 && pan_height > 0) {
+    double scale_x = 0.0, scale_y = 0.0;
+
+    if (rx->panadapter_surface) {
+      cairo_surface_get_device_scale(rx->panadapter_surface, &scale_x, &scale_y);
+    }
+
+    if (rx->panadapter_surface == NULL || scale_x != (double)pan_scale
+        || cairo_image_surface_get_width(rx->panadapter_surface) != pan_width * pan_scale
+        || cairo_image_surface_get_height(rx->panadapter_surface) != pan_height * pan_scale) {
+      if (rx->panadapter_surface) {
+        cairo_surface_destroy(rx->panadapter_surface);
+      }
+
+      rx->panadapter_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, pan_width * pan_scale,
+                               pan_height * pan_scale);
+      cairo_surface_set_device_scale(rx->panadapter_surface, pan_scale, pan_scale);
+    }
+  }
+
+  if (wf_width > 0 && wf_height > 0) {
+    if (rx->pixbuf == NULL
+        || gdk_pixbuf_get_width(rx->pixbuf) != wf_width
+        || gdk_pixbuf_get_height(rx->pixbuf) != wf_height) {
+      if (rx->pixbuf) {
+        g_object_unref(rx->pixbuf);
+      }
+
+      rx->pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, wf_width, wf_height);
+      memset(gdk_pixbuf_get_pixels(rx->pixbuf), 0, gdk_pixbuf_get_byte_length(rx->pixbuf));
+      rx->waterfall_frequency = 0;
+    }
+  }
+}
+
+//
+// Render one frame into the back buffers and publish it
+//
+static void rx_display_render(RECEIVER *rx) {
+  guint bits = 0;
+  g_mutex_lock(&rx->display_mutex);
+
+  if (rx_get_pixels(rx)) {
+    rx->display_time = rx->spectrum_time;
+    carrier_notch_frame(rx);
+    band_activity_frame(rx);
+    rx_display_buffers(rx);
+
+    if (rx->display_panadapter && rx->panadapter_surface) {
+      rx_panadapter_update(rx);
+      //
+      // The panadapter is re-drawn completely in each frame,
+      // so front and back buffer can simply be swapped
+      //
+      g_mutex_lock(&rx->frame_mutex);
+      cairo_surface_t *tmp = rx->panadapter_front;
+      rx->panadapter_front = rx->panadapter_surface;
+      rx->panadapter_surface = tmp;
+      g_mutex_unlock(&rx->frame_mutex);
+      bits |= RX_FRAME_PANADAPTER;
+    }
+
+    if (rx->display_waterfall) {
+      if (rx->waterfall_mode == 1) {
+        bits |= RX_FRAME_3DSS;
+      } else if (rx->pixbuf) {
+        waterfall_update(rx);
+        //
+        // The waterfall scrolls, so the back buffer must keep its
+        // contents and is copied to the front buffer
+        //
+        g_mutex_lock(&rx->frame_mutex);
+
+        if (rx->pixbuf_front == NULL
+            || gdk_pixbuf_get_width(rx->pixbuf_front) != gdk_pixbuf_get_width(rx->pixbuf)
+            || gdk_pixbuf_get_height(rx->pixbuf_front) != gdk_pixbuf_get_height(rx->pixbuf)) {
+          if (rx->pixbuf_front) {
+            g_object_unref(rx->pixbuf_front);
+          }
+
+          rx->pixbuf_front = gdk_pixbuf_copy(rx->pixbuf);
+        } else {
+          memcpy(gdk_pixbuf_get_pixels(rx->pixbuf_front), gdk_pixbuf_get_pixels(rx->pixbuf),
+                 gdk_pixbuf_get_byte_length(rx->pixbuf));
+        }
+
+        g_mutex_unlock(&rx->frame_mutex);
+        bits |= RX_FRAME_WATERFALL;
+      }
+    }
+
+    if (rx->display_time != 0) {
+      double latency = (double)(g_get_monotonic_time() - rx->display_time);
+      rx->display_latency += (latency - rx->display_latency) * 0.1;
+    }
+  }
+
+  g_mutex_unlock(&rx->display_mutex);
+
+  if (bits) {
+    //
+    // If the previous frame has not yet been picked up by the GTK
+    // thread, it is dropped (it has just been overwritten)
+    //
+    guint pending = g_atomic_int_or(&rx->frame_ready, bits);
+
+    if (pending & bits) { rx->frames_dropped++; }
+
+    rx->frames_rendered++;
+  }
+}
+
+static gpointer rx_display_thread(gpointer data) {
+  gint64 report = g_get_monotonic_time() + RX_DISPLAY_REPORT;
+
+  for (;;) {
+    gint64 now = g_get_monotonic_time();
+    gint64 wakeup = now + RX_DISPLAY_IDLE;
+
+    for (int i = 0; i < RECEIVERS; i++) {
+      RECEIVER *rx = receiver[i];
+
+      if (rx == NULL) { continue; }
+
+      if (!rx->displaying || rx->pixels <= 0 || rx->fps <= 0) {
+        rx->frame_deadline = 0;
+        continue;
+      }
+
+      gint64 period = 1000000 / rx->fps;
+
+      //
+      // (re-)start the schedule when the display is switched on,
+      // or when the frame rate has been increased
+      //
+      if (rx->frame_deadline == 0 || rx->frame_deadline > now + period) {
+        rx->frame_deadline = now;
+      }
+
+      if (now >= rx->frame_deadline) {
+        rx_display_render(rx);
+        rx->frame_deadline += period;
+        now = g_get_monotonic_time();
+
+        if (now >= rx->frame_deadline) {
+          //
+          // Deadline(s) missed: skip these frames rather than
+          // rendering them back-to-back
+          //
+          gint64 missed = (now - rx->frame_deadline) / period + 1;
+          rx->frames_late += missed;
+          rx->frame_deadline += missed * period;
+        }
+      }
+
+      if (rx->frame_deadline < wakeup) {
+        wakeup = rx->frame_deadline;
+      }
+    }
+
+    if (now >= report) {
+      report = now + RX_DISPLAY_REPORT;
+
+      for (int i = 0; i < RECEIVERS; i++) {
+        const RECEIVER *rx = receiver[i];
+
+        if (rx == NULL || !rx->displaying) { continue; }
+
+        t_print("%s: RX%d fps=%d frames=%ld late=%ld dropped=%ld latency=%0.1f ms\n", __FUNCTION__,
+                rx->id + 1, rx->fps, rx->frames_rendered, rx->frames_late, rx->frames_dropped,
+                rx->display_latency * 0.001);
+      }
+    }
+
+    now = g_get_monotonic_time();
+
+    if (wakeup > now) {
+      g_usleep(wakeup - now);
+    }
+  }
+
+  return NULL;
+}
+
+void rx_display_start() {
+  if (render_thread_id == NULL) {
+    render_thread_id = g_thread_new("RX display", rx_display_thread, NULL);
+    t_print("%s: render thread started\n", __FUNCTION__);
+  }
+}
+
+//
+// Called by the GTK frame clock once per (vsync-aligned) frame.
+// Only the latest completed frame is painted.
+//
+static gboolean rx_display_tick(GtkWidget *widget, GdkFrameClock *clock, gpointer data) {
+  RECEIVER *rx = (RECEIVER *)data;
+  guint ready = g_atomic_int_and(&rx->frame_ready, 0);
+
+  if ((ready & RX_FRAME_PANADAPTER) && rx->panadapter != NULL) {
+    gtk_widget_queue_draw(rx->panadapter);
+  }
+
+  if ((ready & RX_FRAME_WATERFALL) && rx->waterfall != NULL) {
+    gtk_widget_queue_draw(rx->waterfall);
+  }
+
+  if ((ready & RX_FRAME_3DSS) && rx->waterfall != NULL && rx->waterfall_mode == 1) {
+    g_mutex_lock(&rx->display_mutex);
+    waterfall3dss_update(rx);
+    g_mutex_unlock(&rx->display_mutex);
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+void rx_display_attach(RECEIVER *rx) {
+  //
+  // The tick callback lives as long as the panel
+  //
+  rx->tick_id = gtk_widget_add_tick_callback(rx->panel, rx_display_tick, rx, NULL);
+}
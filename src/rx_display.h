@@ -0,0 +1,51 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#ifndef _RX_DISPLAY_H
+#define _RX_DISPLAY_H
+
+#include "receiver.h"
+
+//
+// RX display pipeline.
+//
+// One render thread serves all receivers. For each displaying receiver it
+// fetches the pixels from the analyzer and draws the panadapter and the 2D
+// waterfall into back buffers owned by the thread (rx->panadapter_surface,
+// rx->pixbuf), with a frame schedule of rx->fps frames per second. A frame
+// that misses its deadline is skipped, the schedule is not caught up.
+//
+// Completed frames are published to the front buffers (rx->panadapter_front,
+// rx->pixbuf_front) under rx->frame_mutex. A tick callback on the GTK frame
+// clock then queues a redraw, so the draw callbacks only blit the latest
+// frame. A frame that is overwritten before it has been painted is dropped.
+//
+// The OpenGL (3DSS) waterfall must be fed from the GTK thread, this is done
+// in the tick callback from the pixels of the latest frame.
+//
+enum _rx_frame_bits {
+  RX_FRAME_PANADAPTER = 1,
+  RX_FRAME_WATERFALL  = 2,
+  RX_FRAME_3DSS       = 4
+};
+
+extern void rx_display_start(void);
+extern void rx_display_attach(RECEIVER *rx);
+
+#endif
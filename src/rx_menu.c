@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "audio.h"
+#include "audio_mixer.h"
 #include "new_menu.h"
 #include "rx_menu.h"
 #include "band.h"
@@ -128,7 +129,7 @@ static void local_audio_cb(GtkWidget *widget, gpointer data) {
   t_print("local_audio_cb: rx=%d\n", active_receiver->id);
 
   if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget))) {
-    if (audio_open_output(active_receiver) == 0) {
+    if (audio_mixer_open_output(active_receiver) == 0) {
       active_receiver->local_audio = 1;
     } else {
       t_print("local_audio_cb: audio_open_output failed\n");
@@ -138,7 +139,7 @@ static void local_audio_cb(GtkWidget *widget, gpointer data) {
   } else {
     if (active_receiver->local_audio) {
       active_receiver->local_audio = 0;
-      audio_close_output(active_receiver);
+      audio_mixer_close_output(active_receiver);
     }
   }
 
@@ -177,7 +178,7 @@ static void local_output_changed_cb(GtkWidget *widget, gpointer data) {
   int i = gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
 
   if (active_receiver->local_audio) {
-    audio_close_output(active_receiver);                     // audio_close with OLD device
+    audio_mixer_close_output(active_receiver);               // audio_close with OLD device
   }
 
   if (i >= 0) {
@@ -186,7 +187,7 @@ static void local_output_changed_cb(GtkWidget *widget, gpointer data) {
   }
 
   if (active_receiver->local_audio) {
-    if (audio_open_output(active_receiver) < 0) {           // audio_open with NEW device
+    if (audio_mixer_open_output(active_receiver) < 0) {     // audio_open with NEW device
       active_receiver->local_audio = 0;
       gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON (local_audio_b), FALSE);
     }
@@ -195,6 +196,14 @@ static void local_output_changed_cb(GtkWidget *widget, gpointer data) {
   t_print("local_output_changed rx=%d local_audio=%d\n", active_receiver->id, active_receiver->local_audio);
 }
 
+static void mixer_gain_cb(GtkWidget *widget, gpointer data) {
+  active_receiver->mixer_gain = gtk_spin_button_get_value(GTK_SPIN_BUTTON(widget));
+}
+
+static void mixer_pan_cb(GtkWidget *widget, gpointer data) {
+  active_receiver->mixer_pan = 0.01 * gtk_spin_button_get_value(GTK_SPIN_BUTTON(widget));
+}
+
 static void audio_channel_cb(GtkWidget *widget, gpointer data) {
   int val = gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
 
@@ -489,6 +498,22 @@ void rx_menu(GtkWidget *parent) {
 
     my_combo_attach(GTK_GRID(grid), channel, 2, 3, 1, 1);
     g_signal_connect(channel, "changed", G_CALLBACK(audio_channel_cb), NULL);
+    GtkWidget *mixer_gain_label = gtk_label_new("Audio Gain (dB)");
+    gtk_widget_set_name(mixer_gain_label, "boldlabel");
+    gtk_widget_set_halign(mixer_gain_label, GTK_ALIGN_END);
+    gtk_grid_attach(GTK_GRID(grid), mixer_gain_label, 3, 2, 1, 1);
+    GtkWidget *mixer_gain_b = gtk_spin_button_new_with_range(-40.0, 12.0, 1.0);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(mixer_gain_b), active_receiver->mixer_gain);
+    gtk_grid_attach(GTK_GRID(grid), mixer_gain_b, 4, 2, 1, 1);
+    g_signal_connect(mixer_gain_b, "value_changed", G_CALLBACK(mixer_gain_cb), NULL);
+    GtkWidget *mixer_pan_label = gtk_label_new("Pan (L-100..R+100)");
+    gtk_widget_set_name(mixer_pan_label, "boldlabel");
+    gtk_widget_set_halign(mixer_pan_label, GTK_ALIGN_END);
+    gtk_grid_attach(GTK_GRID(grid), mixer_pan_label, 3, 3, 1, 1);
+    GtkWidget *mixer_pan_b = gtk_spin_button_new_with_range(-100.0, 100.0, 5.0);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(mixer_pan_b), 100.0 * active_receiver->mixer_pan);
+    gtk_grid_attach(GTK_GRID(grid), mixer_pan_b, 4, 3, 1, 1);
+    g_signal_connect(mixer_pan_b, "value_changed", G_CALLBACK(mixer_pan_cb), NULL);
   }
 
   gtk_container_add(GTK_CONTAINER(content), grid);
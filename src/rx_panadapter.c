@@ -33,6 +33,7 @@
 #include "appearance.h"
 #include "agc.h"
 #include "band.h"
+#include "band_activity.h"
 #include "discovered.h"
 #include "radio.h"
 #include "receiver.h"
@@ -157,6 +158,7 @@ typedef struct {
 
 static PAN_LABEL pan_labels[MAX_PAN_LABELS];
 static int pan_label_count = 0;
+static GMutex pan_label_mutex;  // labels are added from other threads and drawn by the render thread
 
 void panadapter_set_max_label_rows(int r) {
   if (r < 1) { r = 1; }
@@ -254,23 +256,18 @@ void pan_add_label(long long freq, const char *text) {
     return;
   }
 
+  g_mutex_lock(&pan_label_mutex);
   pl = pan_label_get_slot();
   pl->freq = freq;
   pl->enabled = TRUE;
   g_strlcpy(pl->label, text, sizeof(pl->label));
   pl->expire_time = 0;  /* 0 => kein automatisches Entfernen */
+  g_mutex_unlock(&pan_label_mutex);
 }
 
-// Example:
-// pan_add_label_timeout(7100000LL, "Spot", 5000);  // 5 Sekunden sichtbar
-
-void pan_add_label_timeout(long long freq, const char *text, int lifetime_ms) {
+/* wie pan_add_label_timeout, pan_label_mutex muss gehalten werden */
+static void pan_add_label_timeout_locked(long long freq, const char *text, int lifetime_ms) {
   PAN_LABEL *pl;
-
-  if (text == NULL) {
-    return;
-  }
-
   pl = pan_label_get_slot();
   pl->freq = freq;
   pl->enabled = TRUE;
@@ -284,8 +281,23 @@ void pan_add_label_timeout(long long freq, const char *text, int lifetime_ms) {
   }
 }
 
+// Example:
+// pan_add_label_timeout(7100000LL, "Spot", 5000);  // 5 Sekunden sichtbar
+
+void pan_add_label_timeout(long long freq, const char *text, int lifetime_ms) {
+  if (text == NULL) {
+    return;
+  }
+
+  g_mutex_lock(&pan_label_mutex);
+  pan_add_label_timeout_locked(freq, text, lifetime_ms);
+  g_mutex_unlock(&pan_label_mutex);
+}
+
 void pan_clear_labels(void) {
+  g_mutex_lock(&pan_label_mutex);
   pan_label_count = 0;
+  g_mutex_unlock(&pan_label_mutex);
 }
 
 void pan_add_dx_spot(double freq_khz, const char *dxcall) {
@@ -307,13 +319,15 @@ void pan_add_dx_spot(double freq_khz, const char *dxcall) {
   /* Label-Text – hier nur das Call, ggf. später erweitern */
   g_strlcpy(label, dxcall, sizeof(label));
 
+  g_mutex_lock(&pan_label_mutex);
+
   /* Doublet-Check: gleicher Call auf gleicher Frequenz? -> nur Timeout erneuern */
-  if (pan_dxspot_update_if_exists(freq_hz, label, lifetime_ms)) {
-    return;
+  if (!pan_dxspot_update_if_exists(freq_hz, label, lifetime_ms)) {
+    /* Kein bestehender Eintrag -> neues Label anlegen */
+    pan_add_label_timeout_locked(freq_hz, label, lifetime_ms);
   }
 
-  /* Kein bestehender Eintrag -> neues Label anlegen */
-  pan_add_label_timeout(freq_hz, label, lifetime_ms);
+  g_mutex_unlock(&pan_label_mutex);
 }
 
 //------------------------------------------------------------------------------
@@ -360,44 +374,49 @@ static void draw_image(cairo_t *cr, GdkPixbuf *pixbuf, int x_offset, int y_offse
 }
 //------------------------------------------------------------------------------
 
-/* Create a new surface of the appropriate size to store our scribbles */
+//
+// The back buffer is (re-)allocated by the render thread,
+// here we only record the new size and the HiDPI scale factor
+//
 static gboolean panadapter_configure_event_cb (GtkWidget *widget, GdkEventConfigure *event, gpointer data) {
   RECEIVER *rx = (RECEIVER *)data;
-  int mywidth = gtk_widget_get_allocated_width (widget);
-  int myheight = gtk_widget_get_allocated_height (widget);
-
-  if (rx->panadapter_surface) {
-    cairo_surface_destroy (rx->panadapter_surface);
-  }
-
-  rx->panadapter_surface = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
-                           CAIRO_CONTENT_COLOR,
-                           mywidth, myheight);
-  cairo_t *cr = cairo_create(rx->panadapter_surface);
-
-  if (display_wmap) {
-    cairo_set_source_rgba(cr, COLOUR_PAN_BG_MAP, 0.15); // 0.00..1.00 Transparenz abnehmend
-  } else {
-    cairo_set_source_rgba(cr, COLOUR_PAN_BACKGND);
-  }
-
-  cairo_paint(cr);
-  cairo_destroy(cr);
+  g_mutex_lock(&rx->frame_mutex);
+  rx->pan_width = gtk_widget_get_allocated_width (widget);
+  rx->pan_height = gtk_widget_get_allocated_height (widget);
+  rx->pan_scale = gtk_widget_get_scale_factor (widget);
+  g_mutex_unlock(&rx->frame_mutex);
   return TRUE;
 }
 
-/* Redraw the screen from the surface. Note that the ::draw
- * signal receives a ready-to-be-used cairo_t that is already
- * clipped to only draw the exposed areas of the widget
+//
+// The scale factor also changes without a new size, e.g. when
+// the window is moved to a monitor with a different resolution
+//
+static void panadapter_scale_factor_cb (GObject *object, GParamSpec *pspec, gpointer data) {
+  RECEIVER *rx = (RECEIVER *)data;
+  g_mutex_lock(&rx->frame_mutex);
+  rx->pan_scale = gtk_widget_get_scale_factor (GTK_WIDGET(object));
+  g_mutex_unlock(&rx->frame_mutex);
+}
+
+/* Redraw the screen from the last frame completed by the render thread.
+ * Note that the ::draw signal receives a ready-to-be-used cairo_t that is
+ * already clipped to only draw the exposed areas of the widget
  */
 static gboolean panadapter_draw_cb(GtkWidget *widget, cairo_t *cr, gpointer data) {
   RECEIVER *rx = (RECEIVER *)data;
+  g_mutex_lock(&rx->frame_mutex);
 
-  if (rx->panadapter_surface) {
-    cairo_set_source_surface (cr, rx->panadapter_surface, 0.0, 0.0);
-    cairo_paint (cr);
+  if (rx->panadapter_front) {
+    cairo_set_source_surface (cr, rx->panadapter_front, 0.0, 0.0);
+  } else if (display_wmap) {
+    cairo_set_source_rgba(cr, COLOUR_PAN_BG_MAP, 0.15); // 0.00..1.00 Transparenz abnehmend
+  } else {
+    cairo_set_source_rgba(cr, COLOUR_PAN_BACKGND);
   }
 
+  cairo_paint (cr);
+  g_mutex_unlock(&rx->frame_mutex);
   return FALSE;
 }
 
@@ -543,8 +562,14 @@ void rx_panadapter_update(RECEIVER *rx) {
   long long divisor;
   double soffset;
   gboolean active = active_receiver == rx;
-  int mywidth = gtk_widget_get_allocated_width (rx->panadapter);
-  int myheight = gtk_widget_get_allocated_height (rx->panadapter);
+  double scale_x, scale_y;
+  //
+  // On HiDPI screens the surface has a device scale, so draw in widget
+  // (logical) coordinates and let cairo render at the full resolution
+  //
+  cairo_surface_get_device_scale (rx->panadapter_surface, &scale_x, &scale_y);
+  int mywidth = (int)(cairo_image_surface_get_width (rx->panadapter_surface) / scale_x);
+  int myheight = (int)(cairo_image_surface_get_height (rx->panadapter_surface) / scale_y);
   samples = rx->pixel_samples;
   cairo_t *cr;
   cr = cairo_create (rx->panadapter_surface);
@@ -752,6 +777,8 @@ void rx_panadapter_update(RECEIVER *rx) {
 
   //--------------------------------------------------------------------------------------------
   /* Custom Labels auf exakten Frequenzen (nur Text, mit Timeout + Y-Staffelung) */
+  g_mutex_lock(&pan_label_mutex);
+
   if (pan_label_count > 0) {
     PAN_LABEL_POS pos[MAX_PAN_LABELS];
     int pos_count = 0;
@@ -844,7 +871,10 @@ void rx_panadapter_update(RECEIVER *rx) {
     }
   }
 
+  g_mutex_unlock(&pan_label_mutex);
+
   //--------------------------------------------------------------------------------------------
+  band_activity_draw(cr, rx, min_display, HzPerPixel, mywidth, myheight);
 
   // band edges
   if (band->frequencyMin != 0LL) {
@@ -1581,11 +1611,9 @@ void rx_panadapter_update(RECEIVER *rx) {
   }
 
   cairo_destroy (cr);
-  gtk_widget_queue_draw (rx->panadapter);
 }
 
 void rx_panadapter_init(RECEIVER * rx, int width, int height) {
-  rx->panadapter_surface = NULL;
   rx->panadapter = gtk_drawing_area_new ();
   gtk_widget_set_size_request (rx->panadapter, width, height);
   /* Signals used to handle the backing surface */
@@ -1593,6 +1621,8 @@ void rx_panadapter_init(RECEIVER * rx, int width, int height) {
                     G_CALLBACK (panadapter_draw_cb), rx);
   g_signal_connect (rx->panadapter, "configure-event",
                     G_CALLBACK (panadapter_configure_event_cb), rx);
+  g_signal_connect (rx->panadapter, "notify::scale-factor",
+                    G_CALLBACK (panadapter_scale_factor_cb), rx);
   /* Event signals */
   g_signal_connect (rx->panadapter, "motion-notify-event",
                     G_CALLBACK (panadapter_motion_notify_event_cb), rx);
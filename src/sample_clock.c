@@ -0,0 +1,97 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <math.h>
+#include <string.h>
+
+#include "sample_clock.h"
+
+void sample_clock_init(SAMPLE_CLOCK *c, double rate) {
+  memset(c, 0, sizeof(SAMPLE_CLOCK));
+  c->nominal = rate;
+  c->period = 1.0E6 / rate;
+}
+
+void sample_clock_update(SAMPLE_CLOCK *c, guint64 count, gint64 stamp) {
+  double t = (double) stamp;
+
+  if (c->nominal <= 0.0) { return; }
+
+  if (!c->valid) {
+    c->valid = 1;
+    c->count = count;
+    c->time = t;
+    c->start = t;
+    return;
+  }
+
+  if (count <= c->count) { return; }
+
+  double n = (double)(count - c->count);
+  double predicted = c->time + n * c->period;
+  double err = t - predicted;
+
+  if (fabs(err) > SC_MAX_ERROR) {
+    c->count = count;
+    c->time = t;
+    c->reanchors++;
+    return;
+  }
+
+  //
+  // Delay-locked loop. The coefficients depend on the time elapsed since
+  // the last update, since the packets need not be evenly spaced.
+  //
+  double bw = SC_BANDWIDTH_MIN + SC_BANDWIDTH_START * 1.0E6 / (1.0E6 + t - c->start);
+  double w = 2.0 * M_PI * bw * n * c->period * 1.0E-6;
+
+  if (w > 0.5) { w = 0.5; }
+
+  c->count = count;
+  c->time = predicted + M_SQRT2 * w * err;
+  c->period += w * w * err / n;
+
+  double nominal = 1.0E6 / c->nominal;
+  double limit = nominal * SC_MAX_PPM * 1.0E-6;
+
+  if (c->period > nominal + limit) { c->period = nominal + limit; }
+
+  if (c->period < nominal - limit) { c->period = nominal - limit; }
+
+  c->jitter += (fabs(err) - c->jitter) * 0.01;
+  c->updates++;
+}
+
+//
+// Model arrival time of sample number "count", 0 if not yet known
+//
+gint64 sample_clock_time(const SAMPLE_CLOCK *c, guint64 count) {
+  if (!c->valid) { return 0; }
+
+  return (gint64)(c->time + (double)(gint64)(count - c->count) * c->period);
+}
+
+//
+// Deviation of the actual from the nominal sample rate
+//
+double sample_clock_ppm(const SAMPLE_CLOCK *c) {
+  if (c->nominal <= 0.0 || c->updates == 0) { return 0.0; }
+
+  return 1.0E6 * (1.0E6 / (c->period * c->nominal) - 1.0);
+}
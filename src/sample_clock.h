@@ -0,0 +1,64 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _SAMPLE_CLOCK_H
+#define _SAMPLE_CLOCK_H
+
+#include <gtk/gtk.h>
+
+//
+// Clock model of an incoming sample stream: it maps the running sample
+// count of the stream to the (host) time at which the sample arrived.
+//
+// The arrival time of each packet (g_get_monotonic_time() right after the
+// packet has been received) is paired with the sample count at the end of
+// the packet and fed into a second-order delay-locked loop. This removes
+// the network/USB jitter from the time stamps, and the loop's estimate of
+// the sample period gives the true sample rate of the radio, measured
+// against the host clock.
+//
+// The loop bandwidth starts wide for a fast lock and narrows down to
+// SC_BANDWIDTH_MIN. If the arrival time is off by more than SC_MAX_ERROR
+// (e.g. no samples during TX, or a buffer overflow), the time reference is
+// re-anchored but the estimated period is kept.
+//
+// All times are in usec.
+//
+#define SC_BANDWIDTH_MIN   0.02    // Hz
+#define SC_BANDWIDTH_START 2.0     // Hz
+#define SC_MAX_ERROR       50000.0 // usec
+#define SC_MAX_PPM         1000.0  // limits the period estimate
+
+typedef struct _sample_clock {
+  double  nominal;        // nominal sample rate (Hz), 0 if not initialised
+  int     valid;
+  guint64 count;          // sample count of the reference point
+  double  time;           // filtered arrival time of the reference point
+  double  period;         // estimated time per sample
+  double  jitter;         // mean deviation of the arrival times from the model
+  double  start;          // time of the first update
+  long    updates;
+  long    reanchors;
+} SAMPLE_CLOCK;
+
+extern void   sample_clock_init(SAMPLE_CLOCK *c, double rate);
+extern void   sample_clock_update(SAMPLE_CLOCK *c, guint64 count, gint64 stamp);
+extern gint64 sample_clock_time(const SAMPLE_CLOCK *c, guint64 count);
+extern double sample_clock_ppm(const SAMPLE_CLOCK *c);
+
+#endif
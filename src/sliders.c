@@ -162,10 +162,9 @@ static const char *nr_labels[] = {
   "NR-OFF",
   "NR",
   "NR2",
-#ifdef EXTNR
   "NR3",
-  "NR4"
-#endif
+  "NR4",
+  "NR5"
 };
 
 //
@@ -1337,16 +1336,7 @@ void update_slider_nr_btn() {
 
 static void nr_btn_pressed_cb(GtkWidget *widget, gpointer data) {
   int id = active_receiver->id;
-  active_receiver->nr++;
-#ifdef EXTNR
-
-  if (active_receiver->nr > 4) { active_receiver->nr = 0; }
-
-#else
-
-  if (active_receiver->nr > 2) { active_receiver->nr = 0; }
-
-#endif
+  active_receiver->nr = rx_next_nr(active_receiver->nr);
 
   if (id == 0) {
     int mode = vfo[id].mode;
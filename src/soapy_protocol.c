@@ -368,6 +368,8 @@ static void *receive_thread(void *arg) {
       continue;
     }
 
+    rx_stamp_iq(rx, g_get_monotonic_time());
+
     for (i = 0; i < elements; i++) {
       rx->buffer[i * 2] = (double)buffer[i * 2];
       rx->buffer[(i * 2) + 1] = (double)buffer[(i * 2) + 1];
@@ -437,7 +439,7 @@ static void *receive_thread(void *arg) {
 void soapy_protocol_iq_samples(float isample, float qsample) {
   int flags = 0;
 
-  if (radio_is_transmitting()) {
+  if (radio_tx_active()) {
     //
     // The "iqswap" logic has now been removed  from transmitter.c
     // and moved here, because this is where it is also handled
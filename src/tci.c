@@ -42,12 +42,14 @@
 #include <openssl/sha.h>
 #include <openssl/evp.h>
 
+#include "actions.h"
 #include "radio.h"
 #include "vfo.h"
 #include "rigctl.h"
 #include "ext.h"
 #include "message.h"
 #include "toolset.h"
+#include "voice_keyer.h"
 #include "main.h"
 
 #define MAX_TCI_CLIENTS 5
@@ -1159,6 +1161,16 @@ static gpointer tci_listener(gpointer data) {
           tci_send_keyer_cwspeed(client);
         } else if (!strcmp(arg[0], "cw_macros_delay")) {
           tci_send_text(client, "cw_macros_delay:10;");
+        } else if (!strcmp(arg[0], "vk_play") && argc > 1) {
+          // deskHPSDR extension: send voice keyer message 1...4
+          int slot = atoi(arg[1]);
+
+          if (slot >= 1 && slot <= VK_SLOTS) {
+            schedule_action(VOICE_KEYER_1 + slot - 1, PRESSED, 0);
+          }
+        } else if (!strcmp(arg[0], "vk_stop")) {
+          // deskHPSDR extension: stop voice keyer playback
+          schedule_action(VOICE_KEYER_STOP, PRESSED, 0);
         } else if (!strcmp(arg[0], "stop")) {
           client->rxsensor = 0;
           client->txsensor = 0;
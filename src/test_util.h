@@ -0,0 +1,57 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _TEST_UTIL_H
+#define _TEST_UTIL_H
+
+//
+// Common part of the test programs run by "make check" (TEST_PROGRAMS in
+// the Makefile). Each of them is a single source file that includes this
+// header once: every check prints one line, and test_result() prints the
+// summary and yields the exit code.
+//
+
+#include <stdio.h>
+#include <time.h>
+
+static int failures = 0;
+
+static inline void check(int ok, const char *what) {
+  printf("%-64s %s\n", what, ok ? "ok" : "FAILED");
+
+  if (!ok) { failures++; }
+}
+
+//
+// Monotonic time in seconds, for timing reports
+//
+static inline double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+//
+// Print the summary line, return 0 if all checks passed and 1 otherwise
+//
+static inline int test_result(void) {
+  printf("%s: %d failure(s)\n", failures ? "FAIL" : "PASS", failures);
+  return failures ? 1 : 0;
+}
+
+#endif
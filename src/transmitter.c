@@ -38,6 +38,7 @@
 #include "radio.h"
 #include "vfo.h"
 #include "vox.h"
+#include "voice_keyer.h"
 #include "meter.h"
 #include "toolbar.h"
 #include "tx_panadapter.h"
@@ -52,6 +53,9 @@
   #include "soapy_protocol.h"
 #endif
 #include "audio.h"
+#include "audio_mixer.h"
+#include "dvr.h"
+#include "eq_update.h"
 #include "ext.h"
 #include "sliders.h"
 #ifdef USBOZY
@@ -1386,6 +1390,10 @@ TRANSMITTER *tx_create_transmitter(int id, int pixels, int width, int height) {
               1,                     // sample rate of antivox data
               1.0,                   // antivox gain
               1.0);                  // antivox tau
+  //
+  // VOX uses a DEXP of its own (number 1)
+  //
+  vox_create(tx);
   t_print("%s: OpenChannel id=%d buffer_size=%d dsp_size=%d fft_size=%d dspRate=%d outputRate=%d\n",
           __FUNCTION__,
           tx->id,
@@ -1530,7 +1538,11 @@ static void tx_full_buffer(TRANSMITTER *tx) {
     }
   } else {
     //
-    // Old VOX code, to be applied BEFORE FM preemphasis
+    // If a voice keyer message is being sent, it replaces the mic samples
+    //
+    voice_keyer_fill(tx->mic_input_buffer, tx->buffer_size);
+    //
+    // VOX (with look-ahead delay), to be applied BEFORE FM preemphasis
     // and the downward expander
     //
     update_vox(tx);
@@ -1564,9 +1576,8 @@ static void tx_full_buffer(TRANSMITTER *tx) {
 
     //
     // Note that the DownwardExpander is used *outside* of WDSP
-    // channels. We use a single DEXP and give it the id=0.
-    // For triggering VOX, we still use the old code, although
-    // the downward expander also offers VOX capabilities.
+    // channels. The expander has the id=0, VOX uses a
+    // second DEXP with id=1 (see update_vox).
     //
     xdexp(0);
     fexchange0(tx->id, tx->mic_input_buffer, tx->iq_output_buffer, &error);
@@ -1581,8 +1592,10 @@ static void tx_full_buffer(TRANSMITTER *tx) {
         float right = tx->mic_input_buffer[2 * i + 1];
         float mono  = 0.5f * (left + right);
         float filtered = fir_apply(gain * mono);
-        audio_write(receiver[0], filtered, filtered);  // Stereo out
+        audio_mixer_put_monitor(filtered, filtered);  // Stereo out
       }
+
+      audio_mixer_commit_monitor();
     }
 
     /*
@@ -1615,7 +1628,7 @@ static void tx_full_buffer(TRANSMITTER *tx) {
     g_mutex_unlock(&tx->display_mutex);
   }
 
-  if (radio_is_transmitting()) {
+  if (radio_tx_active()) {
     if (tx->do_scale) {
       gain = gain * tx->drive_scale;
     }
@@ -1743,7 +1756,7 @@ static void tx_full_buffer(TRANSMITTER *tx) {
         }
       }
     }
-  } else {   // radio_is_transmitting()
+  } else {   // radio_tx_active()
     if (txflag == 1 && protocol == NEW_PROTOCOL) {
       //
       // We arrive here ONCE after a TX -> RX transition
@@ -1794,7 +1807,7 @@ void tx_add_mic_sample(TRANSMITTER *tx, float mic_sample) {
   //
   // shape CW pulses when doing CW and transmitting, else nullify them
   //
-  if ((txmode == modeCWL || txmode == modeCWU) && radio_is_transmitting()) {
+  if ((txmode == modeCWL || txmode == modeCWU) && radio_tx_active()) {
     int updown;
     float cwsample;
     //
@@ -1893,7 +1906,7 @@ void tx_add_mic_sample(TRANSMITTER *tx, float mic_sample) {
     // cw_keyer_sidetone_volume is in the range 0...127 so cwsample is 0.00 ... 0.25
     //
     if (active_receiver->local_audio) {
-      cw_audio_write(active_receiver, cwsample);
+      cw_audio_write(audio_mixer_output(active_receiver), cwsample);
     }
 
     //
@@ -1958,8 +1971,10 @@ void tx_add_mic_sample(TRANSMITTER *tx, float mic_sample) {
   tx->mic_input_buffer[tx->samples * 2] = mic_sample_double;
   tx->mic_input_buffer[(tx->samples * 2) + 1] = 0.0; //mic_sample_double;
   tx->samples++;
+  dvr_put_mic((float)mic_sample_double);
 
   if (tx->samples == tx->buffer_size) {
+    dvr_commit_mic();
     tx_full_buffer(tx);
     tx->samples = 0;
   }
@@ -1985,7 +2000,7 @@ void tx_add_ps_iq_samples(const TRANSMITTER *tx, double i_sample_tx, double q_sa
   rx_feedback->samples = rx_feedback->samples + 1;
 
   if (rx_feedback->samples >= rx_feedback->buffer_size) {
-    if (radio_is_transmitting()) {
+    if (radio_tx_active()) {
       int txmode = vfo_get_tx_mode();
       int cwmode = (txmode == modeCWL || txmode == modeCWU) && !tune && !tx->twotone;
 #if 0
@@ -2164,6 +2179,7 @@ void tx_set_framerate(TRANSMITTER *tx) {
 ////////////////////////////////////////////////////////
 
 void tx_close(const TRANSMITTER *tx) {
+  eq_update_sync();
   CloseChannel(tx->id);
 }
 
@@ -2309,16 +2325,22 @@ static inline void tx_levels_hide(TRANSMITTER *tx) {
   tx->levels_area = NULL;
 }
 
+void tx_set_levels(TRANSMITTER *tx, int show) {
+  if (show) {
+    tx_levels_show(tx);
+  } else {
+    tx_levels_hide(tx);
+  }
+}
+
 void tx_off(const TRANSMITTER *tx) {
   // switch TX OFF, wait until slew-down completed
   SetChannelState(tx->id, 0, 1);
-  tx_levels_hide((TRANSMITTER*)tx);
 }
 
 void tx_on(const TRANSMITTER *tx) {
   // switch TX ON
   SetChannelState(tx->id, 1, 0);
-  tx_levels_show((TRANSMITTER*)tx);
 }
 
 void tx_ps_getinfo(const TRANSMITTER *tx, int *info) {
@@ -2374,7 +2396,7 @@ void tx_ps_onoff(TRANSMITTER *tx, int state) {
     // pscc after resetting.
     tx_ps_reset(tx);
 
-    if (radio_is_transmitting()) {
+    if (radio_tx_active()) {
       usleep(100000);
     } else {
       RECEIVER *rx_feedback = receiver[PS_RX_FEEDBACK];
@@ -2576,6 +2598,11 @@ void tx_set_compressor(TRANSMITTER *tx) {
 }
 
 void tx_set_eq_ctfmode(const TRANSMITTER *tx) {
+  //
+  // The equalizer worker updates the same filter core without
+  // holding the WDSP channel lock, so let it finish first.
+  //
+  eq_update_sync();
   SetTXAEQCtfmode(tx->id, tx->eq_ctfmode);
   t_print("%s: TX-EQ Ctfmode: %d\n", __FUNCTION__, tx->eq_ctfmode);
 }
@@ -2641,16 +2668,15 @@ void tx_set_dexp(const TRANSMITTER *tx) {
 }
 
 void tx_set_equalizer(TRANSMITTER *tx) {
-#if defined (__EQ12__)
-  SetTXAEQProfile(tx->id, 12, tx->eq_freq, tx->eq_gain);
-#else
-  SetTXAEQProfile(tx->id, 10, tx->eq_freq, tx->eq_gain);
-#endif
-  SetTXAEQRun(tx->id, tx->eq_enable);
+  //
+  // The filter design is done in the background
+  //
+  eq_update_tx(tx);
   t_print("%s: TX-EQ state: %d, Gain: %.1fdb\n", __FUNCTION__, tx->eq_enable, tx->eq_gain[0]);
 }
 
 void tx_set_fft_size(const TRANSMITTER *tx) {
+  eq_update_sync();
   TXASetNC(tx->id, tx->fft_size);
   t_print("%s: Set TX fft_size = %d\n", __FUNCTION__, tx->fft_size);
 }
@@ -2660,6 +2686,7 @@ void tx_set_latency(TRANSMITTER *tx) {
     tx->cessb_enable = 0;
   }
 
+  eq_update_sync();
   TXASetMP(tx->id, tx->low_latency);
   t_print("%s: Set TX low_latency = %d\n", __FUNCTION__, tx->low_latency);
 }
@@ -268,6 +268,7 @@ extern void   tx_set_dexp(const TRANSMITTER *tx);
 extern void   tx_set_displaying(TRANSMITTER *tx);
 extern void   tx_set_equalizer(TRANSMITTER *tx);
 extern void   tx_set_latency(TRANSMITTER *tx);
+extern void   tx_set_levels(TRANSMITTER *tx, int show);
 extern void   tx_set_fft_size(const TRANSMITTER *tx);
 extern void   tx_set_filter(TRANSMITTER *tx);
 extern void   tx_set_framerate(TRANSMITTER *tx);
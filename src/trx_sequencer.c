@@ -0,0 +1,401 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "discovered.h"
+#include "gpio.h"
+#include "message.h"
+#include "mode.h"
+#include "radio.h"
+#include "receiver.h"
+#include "transmitter.h"
+#include "trx_sequencer.h"
+#include "vfo.h"
+#ifdef SOAPYSDR
+  #include "soapy_protocol.h"
+#endif
+
+typedef struct _trx_history {
+  long       count;
+  TRX_TIMING last;
+  gint64     total[TRX_HISTORY];
+} TRX_HISTORY_BUF;
+
+static TRX_HISTORY_BUF history[2];       // index 0: TX->RX, index 1: RX->TX
+
+static GThread *trx_thread_id = NULL;
+static gint     trx_running = 0;
+static GMutex   trx_mutex;
+static GCond    trx_cond;
+static gsize    trx_inited = 0;
+
+static int      trx_request = -1;        // pending state, -1 if none
+static GSList  *trx_request_done = NULL; // main loop callbacks of the pending request
+static guint    trx_posted = 0;          // serial number of the last posted request
+static guint    trx_done = 0;            // serial number of the last completed request
+static gint64   trx_posted_time = 0;
+static gint     trx_state = 0;           // state of the last completed transition
+static int      trx_tune = 0;            // TUNE was on when going TX
+
+static void trx_init_once(void) {
+  if (g_once_init_enter(&trx_inited)) {
+    g_mutex_init(&trx_mutex);
+    g_cond_init(&trx_cond);
+    g_once_init_leave(&trx_inited, 1);
+  }
+}
+
+//
+// RX -> TX. Delivery of RX samples to WDSP via fexchange0() may come to an abrupt
+// stop (especially with PureSignal or DIVERSITY). Therefore, wait for *all*
+// receivers to complete their slew-down before going TX. The slew-downs are
+// started together and run in parallel, so this takes one slew time, not one
+// per receiver.
+//
+static void trx_to_tx(TRX_TIMING *t, gint64 start) {
+  RECEIVER *rx_feedback = receiver[PS_RX_FEEDBACK];
+  RECEIVER *tx_feedback = receiver[PS_TX_FEEDBACK];
+
+  if (rx_feedback) { rx_feedback->samples = 0; }
+
+  if (tx_feedback) { tx_feedback->samples = 0; }
+
+  trx_tune = tune;
+
+  if (!duplex) {
+    for (int i = 0; i < receivers; i++) {
+      rx_off_nowait(receiver[i]);
+    }
+
+    for (int i = 0; i < receivers; i++) {
+      if (!rx_off_wait(receiver[i])) {
+        t_print("%s: RX%d slew-down timed out\n", __FUNCTION__, i + 1);
+      }
+    }
+  }
+
+  gint64 now = g_get_monotonic_time();
+  t->slew = now - start;
+  start = now;
+
+  if (transmitter->puresignal) {
+    tx_ps_mox(transmitter, 1);
+  }
+
+  tx_on(transmitter);
+
+  switch (protocol) {
+#ifdef SOAPYSDR
+
+  case SOAPYSDR_PROTOCOL:
+    soapy_protocol_set_tx_frequency(transmitter);
+    //soapy_protocol_start_transmitter(transmitter);
+    break;
+#endif
+  }
+
+  now = g_get_monotonic_time();
+  t->dsp = now - start;
+  start = now;
+  gpio_set_ptt(1);
+  t->ptt = g_get_monotonic_time() - start;
+}
+
+//
+// TX -> RX. The TX channel is switched off first and its slew-down is
+// completed before the receivers are switched on and the PTT line is released.
+//
+static void trx_to_rx(TRX_TIMING *t, gint64 start) {
+  switch (protocol) {
+#ifdef SOAPYSDR
+
+  case SOAPYSDR_PROTOCOL:
+    //soapy_protocol_stop_transmitter(transmitter);
+    break;
+#endif
+  }
+
+  if (transmitter->puresignal) {
+    tx_ps_mox(transmitter, 0);
+  }
+
+  tx_off(transmitter);
+  gint64 now = g_get_monotonic_time();
+  t->slew = now - start;
+  start = now;
+
+  if (!duplex) {
+    //
+    // Set parameters for the "silence first RXIQ samples after TX/RX transition" feature
+    // the default is "no silence", that is, fastest turnaround.
+    // Seeing "tails" of the own TX signal (from crosstalk at the T/R relay) has been observed
+    // for RedPitayas (the identify themself as STEMlab or HERMES) and HermesLite2 devices,
+    // we also include the original HermesLite in this list (which can be enlarged if necessary).
+    //
+    int do_silence = 0;
+
+    if (device == DEVICE_HERMES_LITE2 || device == DEVICE_HERMES_LITE ||
+        device == DEVICE_HERMES || device == DEVICE_STEMLAB || device == DEVICE_STEMLAB_Z20) {
+      //
+      // These systems get a significant "tail" of the RX feedback signal into the RX after TX/RX,
+      // leading to AGC pumping. The problem is most severe if there is a carrier until the end of
+      // the TX phase (TUNE, AM, FM), the problem is virtually non-existent for CW, and of medium
+      // importance in SSB. On the other hand, one wants a very fast turnaround in CW.
+      // So there is no "muting" for CW, 31 msec "muting" for TUNE/AM/FM, and 16 msec for other modes.
+      //
+      // Note that for doing "TwoTone" the silence is built into tx_set_twotone().
+      //
+      switch (vfo_get_tx_mode()) {
+      case modeCWU:
+      case modeCWL:
+        do_silence = 0; // no "silence"
+        break;
+
+      case modeAM:
+      case modeFMN:
+        do_silence = 5; // leads to 31 ms "silence"
+        break;
+
+      default:
+        do_silence = 6; // leads to 16 ms "silence"
+        break;
+      }
+
+      //
+      // tune is already cleared when TUNE is switched off, so use the
+      // state it had when going TX
+      //
+      if (trx_tune) { do_silence = 5; } // 31 ms "silence" for TUNEing in any mode
+    }
+
+    for (int i = 0; i < receivers; i++) {
+      rx_on(receiver[i]);
+      //
+      // There might be some left-over samples in the RX buffer that were filled in
+      // *before* going TX, delete them
+      //
+      receiver[i]->samples = 0;
+
+      if (do_silence) {
+        receiver[i]->txrxmax = receiver[i]->sample_rate >> do_silence;
+      } else {
+        receiver[i]->txrxmax = 0;
+      }
+
+      receiver[i]->txrxcount = 0;
+    }
+  }
+
+  now = g_get_monotonic_time();
+  t->dsp = now - start;
+  start = now;
+  gpio_set_ptt(0);
+  t->ptt = g_get_monotonic_time() - start;
+}
+
+static void trx_transition(int state, gint64 start) {
+  TRX_TIMING t;
+  TRX_HISTORY_BUF *h = &history[state ? 1 : 0];
+
+  //
+  // A request that has been overtaken by its reverse before it was started
+  // leaves the radio where it is.
+  //
+  if (state == g_atomic_int_get(&trx_state)) { return; }
+
+  if (state) {
+    trx_to_tx(&t, g_get_monotonic_time());
+  } else {
+    trx_to_rx(&t, g_get_monotonic_time());
+  }
+
+  t.total = g_get_monotonic_time() - start;
+  g_atomic_int_set(&trx_state, state);
+  g_mutex_lock(&trx_mutex);
+  h->last = t;
+  h->total[h->count % TRX_HISTORY] = t.total;
+  h->count++;
+  g_mutex_unlock(&trx_mutex);
+}
+
+static void trx_set_priority(void) {
+  struct sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+  int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+  if (rc != 0) {
+    t_print("%s: no real-time priority (%s), running with normal priority\n", __FUNCTION__, g_strerror(rc));
+  }
+}
+
+static gpointer trx_thread(gpointer data) {
+  trx_set_priority();
+  g_mutex_lock(&trx_mutex);
+
+  //
+  // A pending request is always completed, even if the sequencer is being stopped.
+  //
+  while (trx_request >= 0 || g_atomic_int_get(&trx_running)) {
+    if (trx_request < 0) {
+      g_cond_wait(&trx_cond, &trx_mutex);
+      continue;
+    }
+
+    int state = trx_request;
+    GSList *done = trx_request_done;
+    guint serial = trx_posted;
+    gint64 start = trx_posted_time;
+    trx_request = -1;
+    trx_request_done = NULL;
+    g_mutex_unlock(&trx_mutex);
+    trx_transition(state, start);
+
+    for (GSList *l = done; l != NULL; l = l->next) {
+      g_idle_add_full(G_PRIORITY_HIGH, (GSourceFunc) l->data, NULL, NULL);
+    }
+
+    g_slist_free(done);
+    g_mutex_lock(&trx_mutex);
+    trx_done = serial;
+    g_cond_broadcast(&trx_cond);
+  }
+
+  g_mutex_unlock(&trx_mutex);
+  return NULL;
+}
+
+void trx_sequencer_start() {
+  trx_init_once();
+
+  if (trx_thread_id != NULL) { return; }
+
+  memset(history, 0, sizeof(history));
+  g_atomic_int_set(&trx_running, 1);
+  trx_thread_id = g_thread_new("T/R sequencer", trx_thread, NULL);
+}
+
+void trx_sequencer_stop() {
+  if (trx_thread_id == NULL) { return; }
+
+  g_mutex_lock(&trx_mutex);
+  g_atomic_int_set(&trx_running, 0);
+  g_cond_broadcast(&trx_cond);
+  g_mutex_unlock(&trx_mutex);
+  g_thread_join(trx_thread_id);
+  trx_thread_id = NULL;
+  trx_sequencer_report();
+}
+
+//
+// Request a RX/TX (state=1) or TX/RX (state=0) transition. This returns at once,
+// the transition is done by the sequencer thread and "done" (if not NULL) is
+// scheduled in the main loop when it has completed. A request that has not yet
+// been started is replaced by a newer one, so a fast MOX on/off sequence does
+// not pile up transitions. The callbacks of a replaced request are kept and
+// run (each one once, in the order of the requests) when the newer request
+// has completed, so no clean-up that waits for a transition is lost.
+//
+void trx_sequencer_switch(int state, GSourceFunc done) {
+  gint64 start = g_get_monotonic_time();
+
+  if (trx_thread_id == NULL) {
+    trx_transition(state, start);
+
+    if (done) { g_idle_add_full(G_PRIORITY_HIGH, done, NULL, NULL); }
+
+    return;
+  }
+
+  g_mutex_lock(&trx_mutex);
+
+  trx_request = state;
+
+  if (done && !g_slist_find(trx_request_done, (gpointer) done)) {
+    trx_request_done = g_slist_append(trx_request_done, (gpointer) done);
+  }
+
+  trx_posted_time = start;
+  trx_posted++;
+  g_cond_broadcast(&trx_cond);
+  g_mutex_unlock(&trx_mutex);
+}
+
+//
+// Wait until all transitions requested so far have completed.
+//
+void trx_sequencer_wait() {
+  if (trx_thread_id == NULL) { return; }
+
+  g_mutex_lock(&trx_mutex);
+  guint serial = trx_posted;
+
+  while (trx_done != serial) {
+    g_cond_wait(&trx_cond, &trx_mutex);
+  }
+
+  g_mutex_unlock(&trx_mutex);
+}
+
+int trx_sequencer_state() {
+  return g_atomic_int_get(&trx_state);
+}
+
+static int cmp_gint64(const void *a, const void *b) {
+  gint64 x = *(const gint64 *)a;
+  gint64 y = *(const gint64 *)b;
+  return (x > y) - (x < y);
+}
+
+void trx_sequencer_get_stats(int state, TRX_STATS *stats) {
+  gint64 sorted[TRX_HISTORY];
+  const TRX_HISTORY_BUF *h = &history[state ? 1 : 0];
+  trx_init_once();
+  memset(stats, 0, sizeof(TRX_STATS));
+  g_mutex_lock(&trx_mutex);
+  int n = h->count < TRX_HISTORY ? (int)h->count : TRX_HISTORY;
+  memcpy(sorted, h->total, n * sizeof(gint64));
+  stats->count = h->count;
+  stats->last = h->last;
+  g_mutex_unlock(&trx_mutex);
+
+  if (n == 0) { return; }
+
+  qsort(sorted, n, sizeof(gint64), cmp_gint64);
+  stats->p50 = sorted[(n * 50) / 100];
+  stats->p95 = sorted[(n * 95) / 100];
+  stats->p99 = sorted[(n * 99) / 100];
+  stats->max = sorted[n - 1];
+}
+
+void trx_sequencer_report() {
+  for (int state = 1; state >= 0; state--) {
+    TRX_STATS s;
+    trx_sequencer_get_stats(state, &s);
+
+    if (s.count == 0) { continue; }
+
+    t_print("%s: %s: n=%ld latency p50=%0.1f p95=%0.1f p99=%0.1f max=%0.1f ms\n", __FUNCTION__,
+            state ? "RX/TX" : "TX/RX", s.count, s.p50 * 1.0E-3, s.p95 * 1.0E-3, s.p99 * 1.0E-3, s.max * 1.0E-3);
+  }
+}
@@ -0,0 +1,68 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _TRX_SEQUENCER_H
+#define _TRX_SEQUENCER_H
+
+//
+// T/R sequencer.
+//
+// A dedicated (if possible real-time) thread owns the ordering of a
+// RX/TX or TX/RX transition:
+//
+// RX -> TX:  slew down all receivers in parallel, PureSignal MOX,
+//            TX channel on, TX frequency (SOAPY), PTT out
+// TX -> RX:  PureSignal MOX off, TX channel off (wait for slew-down),
+//            receivers on (with optional "silence"), PTT out
+//
+// trx_sequencer_switch() only posts the request, so the GTK main thread is
+// never blocked by a transition. When it has completed, the callback passed
+// along is run in the main loop, it does the GUI re-layout (panels, TX levels
+// window), see rxtx() in radio.c. trx_sequencer_state() is the state of the
+// last completed transition, this is what radio_tx_active() reports.
+//
+// The duration of each phase is measured and kept for the last
+// TRX_HISTORY transitions in either direction.
+//
+#define TRX_HISTORY 1024
+
+typedef struct _trx_timing {
+  gint64 slew;           // usec, slew-down of the channels being switched off
+  gint64 dsp;            // usec, switching on the other channels
+  gint64 ptt;            // usec, PTT output
+  gint64 total;          // usec, from the request to the completion
+} TRX_TIMING;
+
+typedef struct _trx_stats {
+  long       count;      // number of transitions in this direction
+  TRX_TIMING last;       // phases of the last transition
+  gint64     p50;        // percentiles of the total latency (usec)
+  gint64     p95;
+  gint64     p99;
+  gint64     max;
+} TRX_STATS;
+
+extern void trx_sequencer_start(void);
+extern void trx_sequencer_stop(void);
+extern void trx_sequencer_switch(int state, GSourceFunc done);
+extern void trx_sequencer_wait(void);
+extern int  trx_sequencer_state(void);
+extern void trx_sequencer_get_stats(int state, TRX_STATS *stats);
+extern void trx_sequencer_report(void);
+
+#endif
@@ -2093,6 +2093,11 @@ void vfo_update() {
       break;
 #endif
 
+    case 5:
+      cairo_set_source_rgba(cr, COLOUR_ATTN);
+      cairo_show_text(cr, "NR5");
+      break;
+
     default:
       cairo_set_source_rgba(cr, COLOUR_SHADE);
       cairo_show_text(cr, "NR");
@@ -0,0 +1,474 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <wdsp.h>
+
+#include "message.h"
+#include "mode.h"
+#include "property.h"
+#include "radio.h"
+#include "vfo.h"
+#include "voice_keyer.h"
+
+#define VK_RATE  48000           // mic sample rate of the TX engine
+#define VK_TAIL  2               // silent buffers sent after a message before MOX is released
+
+char   vk_file[VK_SLOTS][256];
+int    vk_repeat = 0;
+double vk_interval = 5.0;
+double vk_level = 0.0;
+
+//
+// The message data is only touched by the TX thread (playback) and when
+// loading a new message, vk_mutex protects against the latter.
+// All other state is owned by the GTK thread, except vk_active which is
+// cleared by the TX thread when the message is complete or aborted.
+//
+static GMutex vk_mutex;
+static float *vk_data[VK_SLOTS];
+static int    vk_len[VK_SLOTS];
+
+static gint   vk_active = 0;     // slot+1 of the message being sent, 0 if none
+static int    vk_pos = 0;        // TX thread: next sample to be sent
+static int    vk_tail = 0;       // TX thread: silent buffers sent after the message
+static int    vk_started = 0;    // TX thread: the message has been (partially) sent
+static int    vk_slot = -1;      // slot of the current message, including the repeat pause
+static int    vk_own_mox = 0;    // MOX has been set by the voice keyer
+static int    vk_playback = 0;   // radio_start_playback() is in effect
+static guint  vk_timer = 0;      // repeat timer
+
+static void vk_cancel_timer() {
+  if (vk_timer != 0) {
+    g_source_remove(vk_timer);
+    vk_timer = 0;
+  }
+}
+
+static void vk_end_playback() {
+  if (vk_playback) {
+    radio_end_playback();
+    vk_playback = 0;
+  }
+}
+
+static void vk_release_mox() {
+  if (vk_own_mox) {
+    vk_own_mox = 0;
+    radio_mox_update(0);
+  }
+}
+
+void voice_keyer_stop() {
+  vk_cancel_timer();
+  g_atomic_int_set(&vk_active, 0);
+  vk_end_playback();
+  vk_release_mox();
+  vk_slot = -1;
+}
+
+int voice_keyer_busy() {
+  return vk_slot >= 0;
+}
+
+int voice_keyer_playing() {
+  return vk_slot + 1;
+}
+
+double voice_keyer_length(int slot) {
+  if (slot < 0 || slot >= VK_SLOTS) { return 0.0; }
+
+  g_mutex_lock(&vk_mutex);
+  double len = (double) vk_len[slot] / (double) VK_RATE;
+  g_mutex_unlock(&vk_mutex);
+  return len;
+}
+
+//
+// Called (in the GTK thread) when the message has been aborted by the TX thread.
+// If PTT has been hit, the transmitter now belongs to the PTT and MOX must
+// not be released.
+//
+static gboolean vk_abort_cb(gpointer data) {
+  t_print("%s: voice keyer aborted\n", __FUNCTION__);
+
+  if (radio_ptt) { vk_own_mox = 0; }
+
+  voice_keyer_stop();
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean vk_repeat_cb(gpointer data) {
+  int slot = GPOINTER_TO_INT(data);
+  vk_timer = 0;
+
+  //
+  // Do not start the next repetition if someone else is transmitting
+  // or if the operator touched PTT or the paddle during the pause.
+  //
+  if (vk_slot != slot || radio_is_transmitting() || radio_ptt || cw_key_hit) {
+    voice_keyer_stop();
+  } else {
+    voice_keyer_play(slot);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+//
+// Called (in the GTK thread) when the message is complete
+//
+static gboolean vk_done_cb(gpointer data) {
+  int slot = GPOINTER_TO_INT(data);
+
+  if (vk_slot != slot) { return G_SOURCE_REMOVE; }
+
+  vk_end_playback();
+
+  if (vk_repeat && vk_own_mox) {
+    vk_release_mox();
+    vk_timer = g_timeout_add((guint)(vk_interval * 1000.0), vk_repeat_cb, GINT_TO_POINTER(slot));
+  } else {
+    voice_keyer_stop();
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+int voice_keyer_play(int slot) {
+  if (!can_transmit || slot < 0 || slot >= VK_SLOTS) { return 0; }
+
+  int txmode = vfo_get_tx_mode();
+
+  if (txmode == modeCWL || txmode == modeCWU || tune || capture_state == CAP_REPLAY) { return 0; }
+
+  if (voice_keyer_length(slot) <= 0.0) {
+    t_print("%s: no message in slot %d\n", __FUNCTION__, slot + 1);
+    return 0;
+  }
+
+  //
+  // A running message is replaced. The transmitter is left on if it
+  // has been keyed by the voice keyer.
+  //
+  vk_cancel_timer();
+  g_atomic_int_set(&vk_active, 0);
+  cw_key_hit = 0;
+
+  if (!radio_is_transmitting()) {
+    vk_own_mox = 0;
+    radio_mox_update(1);
+
+    if (!radio_get_mox()) {
+      voice_keyer_stop();
+      return 0;
+    }
+
+    vk_own_mox = 1;
+  }
+
+  if (!vk_playback) {
+    radio_start_playback();
+    vk_playback = 1;
+  }
+
+  g_mutex_lock(&vk_mutex);
+  vk_pos = 0;
+  vk_tail = 0;
+  vk_started = 0;
+  g_mutex_unlock(&vk_mutex);
+  vk_slot = slot;
+  g_atomic_int_set(&vk_active, slot + 1);
+  return 1;
+}
+
+//
+// Called by the TX thread with a full mic buffer (interleaved, 2*samples doubles).
+// If a message is active, the buffer is replaced by the next message block.
+// Returns 1 if the buffer has been replaced.
+//
+int voice_keyer_fill(double *buffer, int samples) {
+  int active = g_atomic_int_get(&vk_active);
+
+  if (active == 0) { return 0; }
+
+  int slot = active - 1;
+
+  if ((radio_ptt && vk_own_mox) || cw_key_hit) {
+    if (g_atomic_int_compare_and_exchange(&vk_active, active, 0)) {
+      g_idle_add(vk_abort_cb, NULL);
+    }
+
+    return 0;
+  }
+
+  g_mutex_lock(&vk_mutex);
+
+  if (!radio_is_transmitting()) {
+    //
+    // Not yet transmitting: wait. Transmission has been stopped by
+    // someone else in the middle of the message: abort.
+    //
+    if (vk_started && g_atomic_int_compare_and_exchange(&vk_active, active, 0)) {
+      g_idle_add(vk_abort_cb, NULL);
+    }
+
+    g_mutex_unlock(&vk_mutex);
+    return 0;
+  }
+
+  const float *data = vk_data[slot];
+  int len = vk_len[slot];
+  double gain = pow(10.0, 0.05 * vk_level);
+  int i = 0;
+  vk_started = 1;
+
+  if (data != NULL) {
+    for (; i < samples && vk_pos < len; i++) {
+      buffer[2 * i] = gain * data[vk_pos++];
+      buffer[2 * i + 1] = 0.0;
+    }
+  }
+
+  for (; i < samples; i++) {
+    buffer[2 * i] = 0.0;
+    buffer[2 * i + 1] = 0.0;
+  }
+
+  if (data == NULL || vk_pos >= len) {
+    //
+    // Send some silence to flush the TX filters before releasing MOX
+    //
+    if (++vk_tail > VK_TAIL && g_atomic_int_compare_and_exchange(&vk_active, active, 0)) {
+      g_idle_add(vk_done_cb, GINT_TO_POINTER(slot));
+    }
+  }
+
+  g_mutex_unlock(&vk_mutex);
+  return 1;
+}
+
+static unsigned int vk_u16(const unsigned char *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static unsigned int vk_u32(const unsigned char *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+//
+// Decode a sample with the given number of bytes (1: unsigned 8-bit, 2-4: signed
+// little-endian PCM) or a 32-bit IEEE float.
+//
+static float vk_sample(const unsigned char *p, int bytes, int is_float) {
+  if (is_float) {
+    union {
+      unsigned int u;
+      float f;
+    } v;
+    v.u = vk_u32(p);
+    return v.f;
+  }
+
+  switch (bytes) {
+  case 1:
+    return ((int)p[0] - 128) / 128.0F;
+
+  case 2:
+    return (gint16) vk_u16(p) / 32768.0F;
+
+  case 3:
+    return (gint32)(((unsigned int)p[0] << 8) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 24)) / 2147483648.0F;
+
+  default:
+    return (gint32) vk_u32(p) / 2147483648.0F;
+  }
+}
+
+//
+// Read a WAV file, mix it down to mono and resample it to VK_RATE.
+// Returns a g_new'ed buffer or NULL.
+//
+static float *vk_read_wav(const char *filename, int *length) {
+  gchar *contents;
+  gsize size;
+  GError *error = NULL;
+
+  if (!g_file_get_contents(filename, &contents, &size, &error)) {
+    t_print("%s: %s\n", __FUNCTION__, error->message);
+    g_error_free(error);
+    return NULL;
+  }
+
+  const unsigned char *p = (const unsigned char *) contents;
+
+  if (size < 12 || memcmp(p, "RIFF", 4) || memcmp(p + 8, "WAVE", 4)) {
+    t_print("%s: %s is not a WAV file\n", __FUNCTION__, filename);
+    g_free(contents);
+    return NULL;
+  }
+
+  int format = 0, channels = 0, rate = 0, bits = 0;
+  const unsigned char *pcm = NULL;
+  gsize pcm_size = 0;
+  gsize pos = 12;
+
+  while (pos + 8 <= size) {
+    gsize chunk = vk_u32(p + pos + 4);
+    const unsigned char *body = p + pos + 8;
+
+    if (chunk > size - pos - 8) { chunk = size - pos - 8; }  // truncated file
+
+    if (!memcmp(p + pos, "fmt ", 4) && chunk >= 16) {
+      format   = vk_u16(body);
+      channels = vk_u16(body + 2);
+      rate     = vk_u32(body + 4);
+      bits     = vk_u16(body + 14);
+
+      if (format == 0xFFFE && chunk >= 26) {
+        format = vk_u16(body + 24);  // WAVE_FORMAT_EXTENSIBLE: first two bytes of the sub-format GUID
+      }
+    } else if (!memcmp(p + pos, "data", 4)) {
+      pcm = body;
+      pcm_size = chunk;
+    }
+
+    pos += 8 + chunk + (chunk & 1);
+  }
+
+  int is_float = (format == 3);
+  int bytes = bits / 8;
+
+  if (pcm == NULL || channels < 1 || rate < 8000 || rate > 384000 || (format != 1 && !is_float)
+      || (is_float && bits != 32) || bytes < 1 || bytes > 4 || bits != 8 * bytes) {
+    t_print("%s: %s: unsupported format (fmt=%d ch=%d rate=%d bits=%d)\n", __FUNCTION__,
+            filename, format, channels, rate, bits);
+    g_free(contents);
+    return NULL;
+  }
+
+  int frames = pcm_size / (bytes * channels);
+  int pad = (rate == VK_RATE) ? 0 : rate / 20;    // zeroes to flush the resampler
+  float *mono = g_new0(float, frames + pad + 1);
+
+  for (int i = 0; i < frames; i++) {
+    float sum = 0.0F;
+
+    for (int c = 0; c < channels; c++) {
+      sum += vk_sample(pcm + (gsize)(i * channels + c) * bytes, bytes, is_float);
+    }
+
+    mono[i] = sum / channels;
+  }
+
+  g_free(contents);
+
+  if (rate != VK_RATE) {
+    int outmax = (int)(((gint64)(frames + pad) * VK_RATE) / rate) + 2;
+    float *out = g_new(float, outmax);
+    void *resampler = create_resampleFV(rate, VK_RATE);
+    int n;
+    xresampleFV(mono, out, frames + pad, &n, resampler);
+    destroy_resampleFV(resampler);
+    g_free(mono);
+    mono = out;
+    frames = n;
+  }
+
+  *length = frames;
+  return mono;
+}
+
+//
+// Load a message into a slot. The message is peak-normalised to full scale,
+// the level is applied during playback (vk_level).
+// An empty file name clears the slot.
+//
+int voice_keyer_load(int slot, const char *filename) {
+  float *data = NULL;
+  int len = 0;
+
+  if (slot < 0 || slot >= VK_SLOTS) { return 0; }
+
+  if (filename != NULL && *filename != 0) {
+    data = vk_read_wav(filename, &len);
+
+    if (data == NULL) { return 0; }
+
+    float peak = 0.0F;
+
+    for (int i = 0; i < len; i++) {
+      float a = fabsf(data[i]);
+
+      if (a > peak) { peak = a; }
+    }
+
+    if (peak > 1.0E-6F) {
+      for (int i = 0; i < len; i++) {
+        data[i] /= peak;
+      }
+    }
+
+    t_print("%s: slot %d: %s (%0.1f sec, peak %0.1f dBFS)\n", __FUNCTION__, slot + 1, filename,
+            (double) len / VK_RATE, 20.0 * log10(peak > 1.0E-6F ? peak : 1.0E-6F));
+  }
+
+  if (filename != &vk_file[slot][0]) {
+    g_strlcpy(vk_file[slot], filename ? filename : "", sizeof(vk_file[slot]));
+  }
+
+  //
+  // If this message is being sent, it is stopped by a zero length
+  //
+  g_mutex_lock(&vk_mutex);
+  float *old = vk_data[slot];
+  vk_data[slot] = data;
+  vk_len[slot] = len;
+  g_mutex_unlock(&vk_mutex);
+  g_free(old);
+  return 1;
+}
+
+void vkSaveState() {
+  for (int i = 0; i < VK_SLOTS; i++) {
+    SetPropS1("vk.%d.file", i, vk_file[i]);
+  }
+
+  SetPropI0("vk.repeat", vk_repeat);
+  SetPropF0("vk.interval", vk_interval);
+  SetPropF0("vk.level", vk_level);
+}
+
+void vkRestoreState() {
+  for (int i = 0; i < VK_SLOTS; i++) {
+    GetPropS1("vk.%d.file", i, vk_file[i]);
+  }
+
+  GetPropI0("vk.repeat", vk_repeat);
+  GetPropF0("vk.interval", vk_interval);
+  GetPropF0("vk.level", vk_level);
+
+  for (int i = 0; i < VK_SLOTS; i++) {
+    if (*vk_file[i] != 0) {
+      voice_keyer_load(i, vk_file[i]);
+    }
+  }
+}
@@ -0,0 +1,52 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#ifndef _VOICE_KEYER_H
+#define _VOICE_KEYER_H
+
+//
+// Voice keyer: VK_SLOTS message memories, each loaded from a WAV file.
+//
+// A message is decoded, mixed down to mono, resampled to the mic rate
+// (48 kHz) and peak-normalised once when it is loaded. Playback keys the
+// transmitter (MOX), and the TX engine then replaces whole mic buffers by
+// the message (voice_keyer_fill), so playback does not depend on the GUI.
+// Optionally the message is repeated after vk_interval seconds (CQ loop).
+//
+// Playback is aborted by PTT, by the paddle and by MOX.
+//
+#define VK_SLOTS 4
+
+extern char   vk_file[VK_SLOTS][256];
+extern int    vk_repeat;
+extern double vk_interval;       // seconds between repetitions
+extern double vk_level;          // dB relative to full scale
+
+extern void   vkSaveState(void);
+extern void   vkRestoreState(void);
+
+extern int    voice_keyer_load(int slot, const char *filename);
+extern double voice_keyer_length(int slot);
+extern int    voice_keyer_play(int slot);
+extern void   voice_keyer_stop(void);
+extern int    voice_keyer_busy(void);
+extern int    voice_keyer_playing(void);
+
+extern int    voice_keyer_fill(double *buffer, int samples);
+
+#endif
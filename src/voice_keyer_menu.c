@@ -0,0 +1,195 @@
+/* Copyright (C)
+* 2026 - Heiko Amft, DL1BZ (Project deskHPSDR)
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*/
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "appearance.h"
+#include "ext.h"
+#include "new_menu.h"
+#include "radio.h"
+#include "voice_keyer.h"
+#include "voice_keyer_menu.h"
+
+static GtkWidget *dialog = NULL;
+static GtkWidget *length_label[VK_SLOTS];
+
+static void cleanup() {
+  if (dialog != NULL) {
+    GtkWidget *tmp = dialog;
+    dialog = NULL;
+    gtk_widget_destroy(tmp);
+    sub_menu = NULL;
+    active_menu  = NO_MENU;
+    radio_save_state();
+  }
+}
+
+static gboolean close_cb () {
+  cleanup();
+  return TRUE;
+}
+
+static void show_length(int slot) {
+  char text[32];
+  double len = voice_keyer_length(slot);
+
+  if (len > 0.0) {
+    snprintf(text, sizeof(text), "%0.1f sec", len);
+  } else {
+    snprintf(text, sizeof(text), "empty");
+  }
+
+  gtk_label_set_text(GTK_LABEL(length_label[slot]), text);
+}
+
+static void file_set_cb(GtkWidget *widget, gpointer data) {
+  int slot = GPOINTER_TO_INT(data);
+  char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(widget));
+
+  if (!voice_keyer_load(slot, filename)) {
+    //
+    // Show the file that is still loaded
+    //
+    if (*vk_file[slot] != 0) {
+      gtk_file_chooser_set_filename(GTK_FILE_CHOOSER(widget), vk_file[slot]);
+    } else {
+      gtk_file_chooser_unselect_all(GTK_FILE_CHOOSER(widget));
+    }
+  }
+
+  g_free(filename);
+  show_length(slot);
+}
+
+static gboolean play_cb(GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  voice_keyer_play(GPOINTER_TO_INT(data));
+  g_idle_add(ext_vfo_update, NULL);
+  return TRUE;
+}
+
+static gboolean stop_cb(GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  voice_keyer_stop();
+  g_idle_add(ext_vfo_update, NULL);
+  return TRUE;
+}
+
+static void repeat_cb(GtkWidget *widget, gpointer data) {
+  vk_repeat = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+}
+
+static void interval_cb(GtkWidget *widget, gpointer data) {
+  vk_interval = gtk_range_get_value(GTK_RANGE(widget));
+}
+
+static void level_cb(GtkWidget *widget, gpointer data) {
+  vk_level = gtk_range_get_value(GTK_RANGE(widget));
+}
+
+void voice_keyer_menu(GtkWidget *parent) {
+  dialog = gtk_dialog_new();
+  gtk_window_set_transient_for(GTK_WINDOW(dialog), GTK_WINDOW(parent));
+  win_set_bgcolor(dialog, &mwin_bgcolor);
+  GtkWidget *headerbar = gtk_header_bar_new();
+  gtk_window_set_titlebar(GTK_WINDOW(dialog), headerbar);
+  gtk_header_bar_set_show_close_button(GTK_HEADER_BAR(headerbar), TRUE);
+  char _title[32];
+  snprintf(_title, 32, "%s - Voice Keyer", PGNAME);
+  gtk_header_bar_set_title(GTK_HEADER_BAR(headerbar), _title);
+  g_signal_connect (dialog, "delete_event", G_CALLBACK (close_cb), NULL);
+  g_signal_connect (dialog, "destroy", G_CALLBACK (close_cb), NULL);
+  GtkWidget *content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+  GtkWidget *grid = gtk_grid_new();
+  gtk_grid_set_column_spacing (GTK_GRID(grid), 10);
+  gtk_grid_set_row_spacing (GTK_GRID(grid), 10);
+  GtkWidget *close_b = gtk_button_new_with_label("Close");
+  gtk_widget_set_name(close_b, "close_button");
+  g_signal_connect (close_b, "button-press-event", G_CALLBACK(close_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), close_b, 0, 0, 1, 1);
+  GtkWidget *stop_b = gtk_button_new_with_label("Stop");
+  g_signal_connect (stop_b, "button-press-event", G_CALLBACK(stop_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), stop_b, 3, 0, 1, 1);
+  GtkFileFilter *filter = gtk_file_filter_new();
+  gtk_file_filter_set_name(filter, "WAV files");
+  gtk_file_filter_add_pattern(filter, "*.wav");
+  gtk_file_filter_add_pattern(filter, "*.WAV");
+  g_object_ref_sink(filter);
+
+  for (int i = 0; i < VK_SLOTS; i++) {
+    char text[32];
+    snprintf(text, sizeof(text), "Message %d", i + 1);
+    GtkWidget *label = gtk_label_new(text);
+    gtk_widget_set_name(label, "boldlabel");
+    gtk_widget_set_halign(label, GTK_ALIGN_END);
+    gtk_grid_attach(GTK_GRID(grid), label, 0, i + 1, 1, 1);
+    GtkWidget *chooser = gtk_file_chooser_button_new("Voice Keyer Message", GTK_FILE_CHOOSER_ACTION_OPEN);
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(chooser), filter);
+    gtk_file_chooser_button_set_width_chars(GTK_FILE_CHOOSER_BUTTON(chooser), 24);
+
+    if (*vk_file[i] != 0) {
+      gtk_file_chooser_set_filename(GTK_FILE_CHOOSER(chooser), vk_file[i]);
+    }
+
+    g_signal_connect(chooser, "file-set", G_CALLBACK(file_set_cb), GINT_TO_POINTER(i));
+    gtk_grid_attach(GTK_GRID(grid), chooser, 1, i + 1, 1, 1);
+    length_label[i] = gtk_label_new(NULL);
+    gtk_widget_set_halign(length_label[i], GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(grid), length_label[i], 2, i + 1, 1, 1);
+    show_length(i);
+    GtkWidget *play_b = gtk_button_new_with_label("Play");
+    g_signal_connect (play_b, "button-press-event", G_CALLBACK(play_cb), GINT_TO_POINTER(i));
+    gtk_grid_attach(GTK_GRID(grid), play_b, 3, i + 1, 1, 1);
+  }
+
+  g_object_unref(filter);
+  int row = VK_SLOTS + 1;
+  GtkWidget *repeat_b = gtk_check_button_new_with_label("Repeat");
+  gtk_widget_set_name(repeat_b, "boldlabel");
+  gtk_widget_set_halign(repeat_b, GTK_ALIGN_END);
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(repeat_b), vk_repeat);
+  gtk_widget_set_tooltip_text(repeat_b, "Send the message again after the interval,\n"
+                              "until stopped by PTT, MOX, the paddle or Stop");
+  g_signal_connect (repeat_b, "toggled", G_CALLBACK(repeat_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), repeat_b, 0, row, 1, 1);
+  GtkWidget *interval_label = gtk_label_new("Interval (sec):");
+  gtk_widget_set_name(interval_label, "boldlabel");
+  gtk_widget_set_halign(interval_label, GTK_ALIGN_END);
+  gtk_grid_attach(GTK_GRID(grid), interval_label, 0, row + 1, 1, 1);
+  GtkWidget *interval_scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 1.0, 60.0, 1.0);
+  gtk_widget_set_valign(interval_scale, GTK_ALIGN_CENTER);
+  gtk_range_set_increments (GTK_RANGE(interval_scale), 1.0, 1.0);
+  gtk_range_set_value(GTK_RANGE(interval_scale), vk_interval);
+  gtk_grid_attach(GTK_GRID(grid), interval_scale, 1, row + 1, 3, 1);
+  g_signal_connect(G_OBJECT(interval_scale), "value_changed", G_CALLBACK(interval_cb), NULL);
+  GtkWidget *level_label = gtk_label_new("Level (dB):");
+  gtk_widget_set_name(level_label, "boldlabel");
+  gtk_widget_set_halign(level_label, GTK_ALIGN_END);
+  gtk_grid_attach(GTK_GRID(grid), level_label, 0, row + 2, 1, 1);
+  GtkWidget *level_scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, -20.0, 0.0, 0.5);
+  gtk_widget_set_valign(level_scale, GTK_ALIGN_CENTER);
+  gtk_range_set_increments (GTK_RANGE(level_scale), 0.5, 0.5);
+  gtk_range_set_value(GTK_RANGE(level_scale), vk_level);
+  gtk_widget_set_tooltip_text(level_scale, "Messages are normalised to full scale when loaded,\n"
+                              "this is the level relative to full scale");
+  gtk_grid_attach(GTK_GRID(grid), level_scale, 1, row + 2, 3, 1);
+  g_signal_connect(G_OBJECT(level_scale), "value_changed", G_CALLBACK(level_cb), NULL);
+  gtk_container_add(GTK_CONTAINER(content), grid);
+  sub_menu = dialog;
+  gtk_widget_show_all(dialog);
+}
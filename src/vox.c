@@ -21,26 +21,141 @@
 
 #include <gtk/gtk.h>
 
+#include <wdsp.h>
+
+#include "audio_mixer.h"
 #include "radio.h"
 #include "transmitter.h"
 #include "vox.h"
 #include "vfo.h"
 #include "ext.h"
 
-static guint vox_timeout = 0;
+//
+// VOX runs on a second WDSP downward expander (DEXP 0 is the expander proper)
+// which sits in the TX mic path with its expander function switched off.
+// It decides per sample whether VOX is triggered, and its audio delay line
+// provides a look-ahead so that the first syllable is not clipped while the
+// RX/TX transition takes place. The anti-VOX side chain is fed with the local
+// RX audio mix, so that audio from the speaker does not trigger VOX.
+//
+#define VOX_DEXP 1
+
+static gint vox_ready = 0;      // VOX DEXP has been created
+static gint vox_active = 0;     // VOX state last reported by the DEXP
+static gint vox_reset = 0;      // reset the VOX detector with the next mic buffer
 
 static double peak = 0.0;
 
-static int vox_timeout_cb(gpointer data) {
+//
+// VOX settings last handed over to the DEXP. They are applied from the
+// TX thread (in update_vox), so the menus, CAT and MIDI need not care.
+//
+static int    cur_enabled = -1;
+static double cur_threshold = -1.0;
+static double cur_hang = -1.0;
+static double cur_delay = -1.0;
+static int    cur_antivox = -1;
+static double cur_antivox_gain = -1.0;
+
+static int vox_switch_cb(gpointer data) {
   //
-  // First set vox_timeout to zero (via vox_cancel())
-  // indicating no "hanging" timeout
-  // then, remove VOX and update display
+  // radio_set_vox() ignores VOX while MOX, TUNE or TxInhibit is active
   //
-  vox_cancel();
-  g_idle_add(ext_set_vox, GINT_TO_POINTER(0));
+  radio_set_vox(GPOINTER_TO_INT(data));
   g_idle_add(ext_vfo_update, NULL);
-  return FALSE;
+  return G_SOURCE_REMOVE;
+}
+
+//
+// Called by the DEXP from within the TX thread whenever VOX
+// goes on or off. The RX/TX transition itself is done from the GTK
+// thread, the look-ahead delay covers the time until it is scheduled.
+//
+static void vox_push(int id, int active) {
+  if (g_atomic_int_get(&vox_active) == active) { return; }
+
+  g_atomic_int_set(&vox_active, active);
+  g_idle_add_full(G_PRIORITY_HIGH, vox_switch_cb, GINT_TO_POINTER(active), NULL);
+}
+
+void vox_create(const TRANSMITTER *tx) {
+  create_dexp(VOX_DEXP,              // dexp channel, BETWEEN 0 and 3
+              0,                     // run flag: no expansion, VOX only
+              tx->buffer_size,       // TX input buffer size (number of complex samples)
+              tx->mic_input_buffer,  // input buffer for DEXP
+              tx->mic_input_buffer,  // output buffer for DEXP
+              48000,                 // mic sample rate
+              0.005,                 // tau
+              0.002,                 // attack
+              0.010,                 // release
+              0.250,                 // hold, set from vox_hang
+              1.0,                   // Expansion ratio (not used)
+              0.75,                  // Hysteresis ratio
+              0.001,                 // Trigger level, set from vox_threshold
+              tx->buffer_size,       // filter size for the side filter
+              0,                     // window type for side filter
+              300.0,                 // low-cut of side filter
+              3000.0,                // high-cut of side filter
+              0,                     // side filter run flag
+              0,                     // vox, set from vox_enabled
+              0,                     // delay, set from vox_delay
+              0.050,                 // look-ahead delay, set from vox_delay
+              vox_push,              // function to call upon VOX status change
+              0,                     // anti-vox, set from vox_antivox
+              MIXER_BLOCK,           // chunk size of antivox data
+              48000,                 // sample rate of antivox data
+              1.0,                   // antivox gain, set from vox_antivox_gain
+              0.010);                // antivox tau
+  cur_enabled = -1;
+  cur_threshold = cur_hang = cur_delay = cur_antivox_gain = -1.0;
+  cur_antivox = -1;
+  g_atomic_int_set(&vox_ready, 1);
+}
+
+static void vox_apply_settings(void) {
+  int enabled = vox_enabled;
+
+  if (vox_threshold != cur_threshold) {
+    cur_threshold = vox_threshold;
+    SetDEXPAttackThreshold(VOX_DEXP, cur_threshold);
+  }
+
+  if (vox_hang != cur_hang) {
+    cur_hang = vox_hang;
+    SetDEXPHoldTime(VOX_DEXP, 0.001 * cur_hang);
+  }
+
+  if (vox_delay != cur_delay) {
+    cur_delay = vox_delay;
+
+    if (cur_delay > 0.0) {
+      SetDEXPAudioDelay(VOX_DEXP, 0.001 * cur_delay);
+    }
+
+    cur_enabled = -1;
+  }
+
+  if (vox_antivox_gain != cur_antivox_gain) {
+    cur_antivox_gain = vox_antivox_gain;
+    SetAntiVOXGain(VOX_DEXP, cur_antivox_gain);
+  }
+
+  if (vox_antivox != cur_antivox) {
+    cur_antivox = vox_antivox;
+    SetAntiVOXRun(VOX_DEXP, cur_antivox);
+  }
+
+  if (enabled != cur_enabled) {
+    cur_enabled = enabled;
+    SetDEXPRunVox(VOX_DEXP, enabled);
+    SetDEXPRunAudioDelay(VOX_DEXP, enabled && cur_delay > 0.0);
+
+    //
+    // VOX switched off while triggered: there will be no more
+    // "off" event from the DEXP, so release it here
+    //
+    if (!enabled) { vox_push(VOX_DEXP, 0); }
+  }
 }
 
 double vox_get_peak() {
@@ -52,55 +167,49 @@ void clear_vox() {
   peak = 0.0;
 }
 
+int vox_get_state() {
+  return g_atomic_int_get(&vox_active);
+}
+
+//
+// Called from the TX thread for each mic buffer, before the FM mic
+// gain, the downward expander and the TX channel
+//
 void update_vox(TRANSMITTER *tx) {
-  // calculate peak microphone input
-  // assumes it is interleaved left and right channel with length samples
-  peak = 0.0;
+  vox_apply_settings();
 
-  for (int i = 0; i < tx->buffer_size; i++) {
-    double sample = tx->mic_input_buffer[i * 2];
+  if (g_atomic_int_compare_and_exchange(&vox_reset, 1, 0)) {
+    ResetDEXPDetector(VOX_DEXP);
+  }
 
-    if (sample < 0.0) {
-      sample = -sample;
-    }
+  xdexp(VOX_DEXP);
+  GetDEXPPeakSignal(VOX_DEXP, &peak);
+}
 
-    if (sample > peak) {
-      peak = sample;
-    }
-  }
+//
+// Feed the anti-VOX side chain with the local RX audio (from the audio mixer).
+// Called with MIXER_BLOCK interleaved stereo frames.
+//
+void vox_antivox_data(const float *buffer) {
+  static double data[2 * MIXER_BLOCK];
 
-  if (vox_enabled && !mox && !tune && !TxInhibit) {
-    if (peak > vox_threshold) {
-      // we use the value of vox_timeout to determine whether
-      // the time-out is "hanging". We cannot use the value of vox
-      // since this may be set with a delay, and we MUST NOT miss
-      // a "hanging" timeout. Note that if a time-out fires, vox_timeout
-      // is set to zero.
-      if (vox_timeout > 0) {
-        g_source_remove(vox_timeout);
-        vox_timeout = 0;
-      } else {
-        //
-        // no hanging time-out, assume that we just fired VOX
-        //
-        g_idle_add(ext_set_vox, GINT_TO_POINTER(1));
-        g_idle_add(ext_vfo_update, NULL);
-      }
-
-      // re-init "vox hang" time
-      vox_timeout = g_timeout_add((int)vox_hang, vox_timeout_cb, NULL);
-    }
+  if (!g_atomic_int_get(&vox_ready) || !vox_antivox) { return; }
 
-    // if peak is not above threshold, do nothing (this shall be done later in the timeout event
+  for (int i = 0; i < 2 * MIXER_BLOCK; i++) {
+    data[i] = buffer[i];
   }
+
+  SendAntiVOXData(VOX_DEXP, MIXER_BLOCK, data);
 }
 
 //
-// If no vox time-out is hanging, this function is a no-op
+// MOX or TUNE take over: forget the current VOX state, such that
+// the next VOX attack triggers again. The DEXP detector is reset as well,
+// otherwise its envelope and hold timer from before the MOX/TUNE would still
+// be around and re-trigger VOX (or let it time out late) afterwards.
+// The reset is done from the TX thread, with the next mic buffer.
 //
 void vox_cancel() {
-  if (vox_timeout) {
-    g_source_remove(vox_timeout);
-    vox_timeout = 0;
-  }
+  g_atomic_int_set(&vox_active, 0);
+  g_atomic_int_set(&vox_reset, 1);
 }
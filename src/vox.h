@@ -23,3 +23,6 @@ extern void update_vox(TRANSMITTER *tx);
 extern void vox_cancel(void);
 extern void clear_vox(void);
 extern double vox_get_peak(void);
+extern int vox_get_state(void);
+extern void vox_create(const TRANSMITTER *tx);
+extern void vox_antivox_data(const float *buffer);
@@ -48,37 +48,16 @@ static GdkRGBA led_green = {COLOUR_OK};
 static GThread *level_thread_id;
 static int run_level = 0;
 static double peak = 0.0;
-static guint vox_timeout;
-static int hold = 0;
-
-static int vox_timeout_cb(gpointer data) {
-  hold = 0;
-  return FALSE;
-}
 
 static int level_update(void *data) {
   if (run_level) {
     gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(level), peak);
-
-    if (peak > vox_threshold) {
-      // red indicator
-      led_color = led_red;
-      led_set_color(led);
-
-      if (hold == 0) {
-        hold = 1;
-      } else {
-        g_source_remove(vox_timeout);
-      }
-
-      vox_timeout = g_timeout_add((int)vox_hang, vox_timeout_cb, NULL);
-    } else {
-      // green indicator
-      if (hold == 0) {
-        led_color = led_green;
-        led_set_color(led);
-      }
-    }
+    //
+    // The LED shows the VOX decision of the DEXP:
+    // red if triggered (including the hang time), green otherwise
+    //
+    led_color = vox_get_state() ? led_red : led_green;
+    led_set_color(led);
   }
 
   return 0;
@@ -135,6 +114,18 @@ static void vox_hang_value_changed_cb(GtkWidget *widget, gpointer data) {
   vox_hang = gtk_range_get_value(GTK_RANGE(widget));
 }
 
+static void vox_delay_value_changed_cb(GtkWidget *widget, gpointer data) {
+  vox_delay = gtk_range_get_value(GTK_RANGE(widget));
+}
+
+static void antivox_cb(GtkWidget *widget, gpointer data) {
+  vox_antivox = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget));
+}
+
+static void antivox_gain_value_changed_cb(GtkWidget *widget, gpointer data) {
+  vox_antivox_gain = gtk_range_get_value(GTK_RANGE(widget));
+}
+
 void vox_menu(GtkWidget *parent) {
   dialog = gtk_dialog_new();
   g_signal_connect (dialog, "destroy", G_CALLBACK(destroy_cb), NULL);
@@ -197,6 +188,34 @@ void vox_menu(GtkWidget *parent) {
   gtk_widget_show(vox_hang_scale);
   gtk_grid_attach(GTK_GRID(grid), vox_hang_scale, 1, 4, 3, 1);
   g_signal_connect(G_OBJECT(vox_hang_scale), "value_changed", G_CALLBACK(vox_hang_value_changed_cb), NULL);
+  GtkWidget *delay_label = gtk_label_new("Look-ahead (ms):");
+  gtk_widget_set_name(delay_label, "boldlabel");
+  gtk_widget_set_halign(delay_label, GTK_ALIGN_END);
+  gtk_widget_show(delay_label);
+  gtk_grid_attach(GTK_GRID(grid), delay_label, 0, 5, 1, 1);
+  GtkWidget *vox_delay_scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0.0, 300.0, 1.0);
+  gtk_widget_set_valign(vox_delay_scale, GTK_ALIGN_CENTER);
+  gtk_range_set_increments (GTK_RANGE(vox_delay_scale), 1.0, 1.0);
+  gtk_range_set_value(GTK_RANGE(vox_delay_scale), vox_delay);
+  gtk_widget_set_tooltip_text(vox_delay_scale, "Delays the TX audio while VOX is enabled,\n"
+                              "such that the first syllable is not clipped");
+  gtk_widget_show(vox_delay_scale);
+  gtk_grid_attach(GTK_GRID(grid), vox_delay_scale, 1, 5, 3, 1);
+  g_signal_connect(G_OBJECT(vox_delay_scale), "value_changed", G_CALLBACK(vox_delay_value_changed_cb), NULL);
+  GtkWidget *antivox_b = gtk_check_button_new_with_label("Anti-VOX");
+  gtk_widget_set_name(antivox_b, "boldlabel");
+  gtk_widget_set_halign(antivox_b, GTK_ALIGN_END);
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(antivox_b), vox_antivox);
+  gtk_widget_set_tooltip_text(antivox_b, "Do not trigger VOX on RX audio from the local speakers");
+  g_signal_connect (antivox_b, "toggled", G_CALLBACK(antivox_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid), antivox_b, 0, 6, 1, 1);
+  GtkWidget *antivox_scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0.0, 5.0, 0.1);
+  gtk_widget_set_valign(antivox_scale, GTK_ALIGN_CENTER);
+  gtk_range_set_increments (GTK_RANGE(antivox_scale), 0.1, 0.1);
+  gtk_range_set_value(GTK_RANGE(antivox_scale), vox_antivox_gain);
+  gtk_widget_show(antivox_scale);
+  gtk_grid_attach(GTK_GRID(grid), antivox_scale, 1, 6, 3, 1);
+  g_signal_connect(G_OBJECT(antivox_scale), "value_changed", G_CALLBACK(antivox_gain_value_changed_cb), NULL);
   gtk_container_add(GTK_CONTAINER(content), grid);
   sub_menu = dialog;
   gtk_widget_show_all(dialog);
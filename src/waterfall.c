@@ -49,32 +49,31 @@ static int colorHighB = 0;
 
 static double hz_per_pixel;
 
-static int my_width;
-static int my_height;
-
-/* Create a new surface of the appropriate size to store our scribbles */
+//
+// The pixbuf is (re-)allocated by the render thread,
+// here we only record the new size
+//
 static gboolean
 waterfall_configure_event_cb (GtkWidget         *widget,
                               GdkEventConfigure *event,
                               gpointer           data) {
   RECEIVER *rx = (RECEIVER *)data;
-  my_width = gtk_widget_get_allocated_width (widget);
-  my_height = gtk_widget_get_allocated_height (widget);
-  rx->pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, my_width, my_height);
-  unsigned char *pixels = gdk_pixbuf_get_pixels (rx->pixbuf);
-  memset(pixels, 0, my_width * my_height * 3);
+  g_mutex_lock(&rx->frame_mutex);
+  rx->wf_width = gtk_widget_get_allocated_width (widget);
+  rx->wf_height = gtk_widget_get_allocated_height (widget);
+  g_mutex_unlock(&rx->frame_mutex);
   return TRUE;
 }
 
-/* Redraw the screen from the surface. Note that the ::draw
- * signal receives a ready-to-be-used cairo_t that is already
- * clipped to only draw the exposed areas of the widget
+/* Redraw the screen from the last frame completed by the render thread.
+ * Note that the ::draw signal receives a ready-to-be-used cairo_t that is
+ * already clipped to only draw the exposed areas of the widget
  */
 static gboolean
 waterfall_draw_cb (GtkWidget *widget,
                    cairo_t   *cr,
                    gpointer   data) {
-  const RECEIVER *rx = (RECEIVER *)data;
+  RECEIVER *rx = (RECEIVER *)data;
   //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
   GtkAllocation allocation;
   gtk_widget_get_allocation(rx->waterfall, &allocation);
@@ -82,8 +81,16 @@ waterfall_draw_cb (GtkWidget *widget,
   int b_height = allocation.height;
   int box_height = 30;
   //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-  gdk_cairo_set_source_pixbuf (cr, rx->pixbuf, 0, 0);
+  g_mutex_lock(&rx->frame_mutex);
+
+  if (rx->pixbuf_front) {
+    gdk_cairo_set_source_pixbuf (cr, rx->pixbuf_front, 0, 0);
+  } else {
+    cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+  }
+
   cairo_paint (cr); // call before drawing the box, otherwise pixbuf will be overwritten!
+  g_mutex_unlock(&rx->frame_mutex);
 
   //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
   if (display_info_bar && active_receiver->display_waterfall && (active_receiver->display_panadapter == 0
@@ -207,14 +214,11 @@ static gboolean waterfall_scroll_event_cb (GtkWidget *widget, GdkEventScroll *ev
   return rx_scroll_event(widget, event, data);
 }
 
+//
+// 2D mode (Cairo) only, called by the render thread. The 3DSS (OpenGL)
+// waterfall is updated from the GTK thread, see rx_display.c
+//
 void waterfall_update(RECEIVER *rx) {
-  // Choose between 2D (Cairo) and 3DSS (OpenGL) based on mode
-  if (rx->waterfall_mode == 1) {
-    waterfall3dss_update(rx);
-    return;
-  }
-  
-  // Original 2D mode (Cairo)
   if (rx->pixbuf) {
     const float *samples;
     long long vfofreq = vfo[rx->id].frequency; // access only once to be thread-safe
@@ -225,7 +229,7 @@ void waterfall_update(RECEIVER *rx) {
     int width = gdk_pixbuf_get_width(rx->pixbuf);
     int height = gdk_pixbuf_get_height(rx->pixbuf);
     int rowstride = gdk_pixbuf_get_rowstride(rx->pixbuf);
-    hz_per_pixel = (double)rx->sample_rate / ((double)my_width * rx->zoom);
+    hz_per_pixel = (double)rx->sample_rate / ((double)width * rx->zoom);
 
     //
     // The existing waterfall corresponds to a VFO frequency rx->waterfall_frequency, a zoom value rx->waterfall_zoom and
@@ -247,11 +251,11 @@ void waterfall_update(RECEIVER *rx) {
         int rotpan  = rx->waterfall_pan - pan;                                        // shift due to pan   change
         int rotate_pixels = rotfreq + rotpan;
 
-        if (rotate_pixels >= my_width || rotate_pixels <= -my_width) {
+        if (rotate_pixels >= width || rotate_pixels <= -width) {
           //
           // If horizontal shift is too large, re-init waterfall
           //
-          memset(pixels, 0, my_width * my_height * 3);
+          memset(pixels, 0, width * height * 3);
           rx->waterfall_frequency = vfofreq;
           rx->waterfall_pan = pan;
         } else {
@@ -262,17 +266,17 @@ void waterfall_update(RECEIVER *rx) {
           //
           if (rotate_pixels < 0) {
             // shift left, and clear the right-most part
-            memmove(pixels, &pixels[-rotate_pixels * 3], ((my_width * my_height) + rotate_pixels) * 3);
+            memmove(pixels, &pixels[-rotate_pixels * 3], ((width * height) + rotate_pixels) * 3);
 
-            for (int i = 0; i < my_height; i++) {
-              memset(&pixels[((i * my_width) + (width + rotate_pixels)) * 3], 0, -rotate_pixels * 3);
+            for (int i = 0; i < height; i++) {
+              memset(&pixels[((i * width) + (width + rotate_pixels)) * 3], 0, -rotate_pixels * 3);
             }
           } else if (rotate_pixels > 0) {
             // shift right, and clear left-most part
-            memmove(&pixels[rotate_pixels * 3], pixels, ((my_width * my_height) - rotate_pixels) * 3);
+            memmove(&pixels[rotate_pixels * 3], pixels, ((width * height) - rotate_pixels) * 3);
 
-            for (int i = 0; i < my_height; i++) {
-              memset(&pixels[(i * my_width) * 3], 0, rotate_pixels * 3);
+            for (int i = 0; i < height; i++) {
+              memset(&pixels[(i * width) * 3], 0, rotate_pixels * 3);
             }
           }
 
@@ -289,7 +293,7 @@ void waterfall_update(RECEIVER *rx) {
       // waterfall frequency not (yet) set, sample rate changed, or zoom value changed:
       // (re-) init waterfall
       //
-      memset(pixels, 0, my_width * my_height * 3);
+      memset(pixels, 0, width * height * 3);
       rx->waterfall_frequency = vfofreq;
       rx->waterfall_pan = pan;
       rx->waterfall_zoom = zoom;
@@ -410,15 +414,10 @@ void waterfall_update(RECEIVER *rx) {
         }
       }
     }
-
-    gtk_widget_queue_draw (rx->waterfall);
   }
 }
 
 static void waterfall_init_2d(RECEIVER *rx, int width, int height) {
-  my_width = width;
-  my_height = height;
-  rx->pixbuf = NULL;
   rx->waterfall_frequency = 0;
   rx->waterfall_sample_rate = 0;
   rx->waterfall = gtk_drawing_area_new ();
@@ -33,6 +33,14 @@ void create_rxa (int channel) {
   rxa[channel].inbuff  = (double *) malloc0 (1 * ch[channel].dsp_insize  * sizeof (complex));
   rxa[channel].outbuff = (double *) malloc0 (1 * ch[channel].dsp_outsize * sizeof (complex));
   rxa[channel].midbuff = (double *) malloc0 (2 * ch[channel].dsp_size    * sizeof (complex));
+  rxa[channel].tapbuff = (double *) malloc0 (1 * ch[channel].dsp_insize  * sizeof (complex));
+  // half-band decimation towards the dsp rate, RXADecimCheck() selects the tap
+  rxa[channel].decim.p = create_decim (
+                           1,                        // run
+                           ch[channel].dsp_insize,             // input buffer size
+                           rxa[channel].inbuff,              // pointer to input buffer
+                           ch[channel].in_rate,              // input samplerate
+                           ch[channel].dsp_rate);            // lowest output samplerate
   // shift to select a slice of spectrum
   rxa[channel].shift.p = create_shift (
                            1,                        // run
@@ -310,6 +318,15 @@ void create_rxa (int channel) {
                           2,                        // gain method
                           0,                        // npe_method
                           1);                       // ae_run
+  // SSNR
+  rxa[channel].ssnr.p = create_ssnr (
+                          0,                        // run
+                          0,                        // position
+                          ch[channel].dsp_size,             // buffer size
+                          rxa[channel].midbuff,             // input buffer
+                          rxa[channel].midbuff,             // output buffer
+                          ch[channel].dsp_rate,             // samplerate
+                          15.0);                    // maximum reduction, dB
   // AGC
   rxa[channel].agc.p = create_wcpagc (
                          1,                        // run
@@ -469,6 +486,7 @@ void destroy_rxa (int channel) {
   destroy_bandpass (rxa[channel].bp1.p);
   destroy_meter (rxa[channel].agcmeter.p);
   destroy_wcpagc (rxa[channel].agc.p);
+  destroy_ssnr (rxa[channel].ssnr.p);
   destroy_emnr (rxa[channel].emnr.p);
   destroy_anr (rxa[channel].anr.p);
   destroy_anf (rxa[channel].anf.p);
@@ -487,6 +505,8 @@ void destroy_rxa (int channel) {
   destroy_gen (rxa[channel].gen0.p);
   destroy_resample (rxa[channel].rsmpin.p);
   destroy_shift (rxa[channel].shift.p);
+  destroy_decim (rxa[channel].decim.p);
+  _aligned_free (rxa[channel].tapbuff);
   _aligned_free (rxa[channel].midbuff);
   _aligned_free (rxa[channel].outbuff);
   _aligned_free (rxa[channel].inbuff);
@@ -496,6 +516,8 @@ void flush_rxa (int channel) {
   memset (rxa[channel].inbuff,  0, 1 * ch[channel].dsp_insize  * sizeof (complex));
   memset (rxa[channel].outbuff, 0, 1 * ch[channel].dsp_outsize * sizeof (complex));
   memset (rxa[channel].midbuff, 0, 2 * ch[channel].dsp_size    * sizeof (complex));
+  memset (rxa[channel].tapbuff, 0, 1 * ch[channel].dsp_insize  * sizeof (complex));
+  flush_decim (rxa[channel].decim.p);
   flush_shift (rxa[channel].shift.p);
   flush_resample (rxa[channel].rsmpin.p);
   flush_gen (rxa[channel].gen0.p);
@@ -513,6 +535,7 @@ void flush_rxa (int channel) {
   flush_anf (rxa[channel].anf.p);
   flush_anr (rxa[channel].anr.p);
   flush_emnr (rxa[channel].emnr.p);
+  flush_ssnr (rxa[channel].ssnr.p);
   flush_wcpagc (rxa[channel].agc.p);
   flush_meter (rxa[channel].agcmeter.p);
   flush_bandpass (rxa[channel].bp1.p);
@@ -526,6 +549,7 @@ void flush_rxa (int channel) {
 }
 
 void xrxa (int channel) {
+  xdecim (rxa[channel].decim.p);
   xshift (rxa[channel].shift.p);
   xresample (rxa[channel].rsmpin.p);
   xgen (rxa[channel].gen0.p);
@@ -546,11 +570,13 @@ void xrxa (int channel) {
   xanf (rxa[channel].anf.p, 0);
   xanr (rxa[channel].anr.p, 0);
   xemnr (rxa[channel].emnr.p, 0);
+  xssnr (rxa[channel].ssnr.p, 0);
   xbandpass (rxa[channel].bp1.p, 0);
   xwcpagc (rxa[channel].agc.p);
   xanf (rxa[channel].anf.p, 1);
   xanr (rxa[channel].anr.p, 1);
   xemnr (rxa[channel].emnr.p, 1);
+  xssnr (rxa[channel].ssnr.p, 1);
   xbandpass (rxa[channel].bp1.p, 1);
   xmeter (rxa[channel].agcmeter.p);
   xsiphon (rxa[channel].sip1.p, 0);
@@ -567,14 +593,12 @@ void setInputSamplerate_rxa (int channel) {
   // buffers
   _aligned_free (rxa[channel].inbuff);
   rxa[channel].inbuff = (double *)malloc0(1 * ch[channel].dsp_insize  * sizeof(complex));
-  // shift
-  setBuffers_shift (rxa[channel].shift.p, rxa[channel].inbuff, rxa[channel].inbuff);
-  setSize_shift (rxa[channel].shift.p, ch[channel].dsp_insize);
-  setSamplerate_shift (rxa[channel].shift.p, ch[channel].in_rate);
-  // input resampler
-  setBuffers_resample (rxa[channel].rsmpin.p, rxa[channel].inbuff, rxa[channel].midbuff);
-  setSize_resample (rxa[channel].rsmpin.p, ch[channel].dsp_insize);
-  setInRate_resample (rxa[channel].rsmpin.p, ch[channel].in_rate);
+  _aligned_free (rxa[channel].tapbuff);
+  rxa[channel].tapbuff = (double *)malloc0(1 * ch[channel].dsp_insize  * sizeof(complex));
+  // decimation, shift and input resampler follow in RXAResCheck()
+  setBuffers_decim (rxa[channel].decim.p, rxa[channel].inbuff);
+  setSize_decim (rxa[channel].decim.p, ch[channel].dsp_insize);
+  setInRate_decim (rxa[channel].decim.p, ch[channel].in_rate);
   RXAResCheck (channel);
 }
 
@@ -594,12 +618,12 @@ void setDSPSamplerate_rxa (int channel) {
   rxa[channel].inbuff = (double *)malloc0(1 * ch[channel].dsp_insize  * sizeof(complex));
   _aligned_free (rxa[channel].outbuff);
   rxa[channel].outbuff = (double *)malloc0(1 * ch[channel].dsp_outsize * sizeof(complex));
-  // shift
-  setBuffers_shift (rxa[channel].shift.p, rxa[channel].inbuff, rxa[channel].inbuff);
-  setSize_shift (rxa[channel].shift.p, ch[channel].dsp_insize);
-  // input resampler
-  setBuffers_resample (rxa[channel].rsmpin.p, rxa[channel].inbuff, rxa[channel].midbuff);
-  setSize_resample (rxa[channel].rsmpin.p, ch[channel].dsp_insize);
+  _aligned_free (rxa[channel].tapbuff);
+  rxa[channel].tapbuff = (double *)malloc0(1 * ch[channel].dsp_insize  * sizeof(complex));
+  // decimation, shift and input resampler follow in RXAResCheck()
+  setBuffers_decim (rxa[channel].decim.p, rxa[channel].inbuff);
+  setSize_decim (rxa[channel].decim.p, ch[channel].dsp_insize);
+  setOutRate_decim (rxa[channel].decim.p, ch[channel].dsp_rate);
   setOutRate_resample (rxa[channel].rsmpin.p, ch[channel].dsp_rate);
   // dsp_rate blocks
   setSamplerate_gen (rxa[channel].gen0.p, ch[channel].dsp_rate);
@@ -618,6 +642,7 @@ void setDSPSamplerate_rxa (int channel) {
   setSamplerate_anf (rxa[channel].anf.p, ch[channel].dsp_rate);
   setSamplerate_anr (rxa[channel].anr.p, ch[channel].dsp_rate);
   setSamplerate_emnr (rxa[channel].emnr.p, ch[channel].dsp_rate);
+  setSamplerate_ssnr (rxa[channel].ssnr.p, ch[channel].dsp_rate);
   setSamplerate_bandpass (rxa[channel].bp1.p, ch[channel].dsp_rate);
   setSamplerate_wcpagc (rxa[channel].agc.p, ch[channel].dsp_rate);
   setSamplerate_meter (rxa[channel].agcmeter.p, ch[channel].dsp_rate);
@@ -641,12 +666,12 @@ void setDSPBuffsize_rxa (int channel) {
   rxa[channel].midbuff = (double *)malloc0(2 * ch[channel].dsp_size * sizeof(complex));
   _aligned_free (rxa[channel].outbuff);
   rxa[channel].outbuff = (double *)malloc0(1 * ch[channel].dsp_outsize * sizeof(complex));
-  // shift
-  setBuffers_shift (rxa[channel].shift.p, rxa[channel].inbuff, rxa[channel].inbuff);
-  setSize_shift (rxa[channel].shift.p, ch[channel].dsp_insize);
-  // input resampler
-  setBuffers_resample (rxa[channel].rsmpin.p, rxa[channel].inbuff, rxa[channel].midbuff);
-  setSize_resample (rxa[channel].rsmpin.p, ch[channel].dsp_insize);
+  _aligned_free (rxa[channel].tapbuff);
+  rxa[channel].tapbuff = (double *)malloc0(1 * ch[channel].dsp_insize  * sizeof(complex));
+  // decimation, shift and input resampler
+  setBuffers_decim (rxa[channel].decim.p, rxa[channel].inbuff);
+  setSize_decim (rxa[channel].decim.p, ch[channel].dsp_insize);
+  RXADecimCheck (channel);
   // dsp_size blocks
   setBuffers_gen (rxa[channel].gen0.p, rxa[channel].midbuff, rxa[channel].midbuff);
   setSize_gen (rxa[channel].gen0.p, ch[channel].dsp_size);
@@ -678,6 +703,8 @@ void setDSPBuffsize_rxa (int channel) {
   setSize_anr (rxa[channel].anr.p, ch[channel].dsp_size);
   setBuffers_emnr (rxa[channel].emnr.p, rxa[channel].midbuff, rxa[channel].midbuff);
   setSize_emnr (rxa[channel].emnr.p, ch[channel].dsp_size);
+  setBuffers_ssnr (rxa[channel].ssnr.p, rxa[channel].midbuff, rxa[channel].midbuff);
+  setSize_ssnr (rxa[channel].ssnr.p, ch[channel].dsp_size);
   setBuffers_bandpass (rxa[channel].bp1.p, rxa[channel].midbuff, rxa[channel].midbuff);
   setSize_bandpass (rxa[channel].bp1.p, ch[channel].dsp_size);
   setBuffers_wcpagc (rxa[channel].agc.p, rxa[channel].midbuff, rxa[channel].midbuff);
@@ -713,7 +740,7 @@ void SetRXAMode (int channel, int mode) {
     int amd_run = (mode == RXA_AM) || (mode == RXA_SAM);
     RXAbpsnbaCheck (channel, mode, rxa[channel].ndb.p->master_run);
     RXAbp1Check (channel, amd_run, rxa[channel].snba.p->run, rxa[channel].emnr.p->run,
-                 rxa[channel].anf.p->run, rxa[channel].anr.p->run);
+                 rxa[channel].ssnr.p->run, rxa[channel].anf.p->run, rxa[channel].anr.p->run);
     EnterCriticalSection (&ch[channel].csDSP);
     rxa[channel].mode = mode;
     rxa[channel].amd.p->run  = 0;
@@ -751,25 +778,54 @@ void SetRXAMode (int channel, int mode) {
 
 void RXAResCheck (int channel) {
   // turn OFF/ON resamplers depending upon whether they're needed
-  RESAMPLE a = rxa[channel].rsmpin.p;
-
-  if (ch[channel].in_rate  != ch[channel].dsp_rate) { a->run = 1; }
-  else { a->run = 0; }
-
+  RESAMPLE a;
+  // the input resampler runs from the decimation tap
+  RXADecimCheck (channel);
   a = rxa[channel].rsmpout.p;
 
   if (ch[channel].dsp_rate != ch[channel].out_rate) { a->run = 1; }
   else { a->run = 0; }
 }
 
+void RXADecimCheck (int channel) {
+  // Pick the deepest decimation stage that still holds the shifted passband and
+  // hang the shift and the input resampler onto it.  Shift phase and resampler
+  // history are only reset when the tap actually moves.
+  DECIM d = rxa[channel].decim.p;
+  SHIFT s = rxa[channel].shift.p;
+  RESAMPLE r = rxa[channel].rsmpin.p;
+  int stage = stage_decim (d, s->run ? s->shift : 0.0, 0.45 * (double)ch[channel].dsp_rate);
+  setTap_decim (d, 0, stage);
+
+  if (stage == 0) {
+    setBuffers_shift (s, rxa[channel].inbuff, rxa[channel].inbuff);
+  } else {
+    setBuffers_shift (s, d->sout[stage], rxa[channel].tapbuff);
+  }
+
+  if (s->size != d->ssize[stage]) { setSize_shift (s, d->ssize[stage]); }
+
+  if (s->rate != (double)d->srate[stage]) { setSamplerate_shift (s, d->srate[stage]); }
+
+  setBuffers_resample (r, s->out, rxa[channel].midbuff);
+
+  if (r->in_rate != d->srate[stage]) { setInRate_resample (r, d->srate[stage]); }
+
+  if (r->size != d->ssize[stage]) { setSize_resample (r, d->ssize[stage]); }
+
+  if (d->srate[stage] != ch[channel].dsp_rate) { r->run = 1; }
+  else { r->run = 0; }
+}
+
 void RXAbp1Check (int channel, int amd_run, int snba_run,
-                  int emnr_run, int anf_run, int anr_run) {
+                  int emnr_run, int ssnr_run, int anf_run, int anr_run) {
   BANDPASS a = rxa[channel].bp1.p;
   double gain;
 
   if (amd_run  ||
       snba_run ||
       emnr_run ||
+      ssnr_run ||
       anf_run  ||
       anr_run) { gain = 2.0; }
   else { gain = 1.0; }
@@ -786,6 +842,7 @@ void RXAbp1Set (int channel) {
   if ((rxa[channel].amd.p->run  == 1) ||
       (rxa[channel].snba.p->run == 1) ||
       (rxa[channel].emnr.p->run == 1) ||
+      (rxa[channel].ssnr.p->run == 1) ||
       (rxa[channel].anf.p->run  == 1) ||
       (rxa[channel].anr.p->run  == 1)) { a->run = 1; }
   else { a->run = 0; }
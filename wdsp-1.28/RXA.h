@@ -58,12 +58,16 @@ struct _rxa {
   double* inbuff;
   double* outbuff;
   double* midbuff;
+  double* tapbuff;
   int mode;
   double meter[RXA_METERTYPE_LAST];
   CRITICAL_SECTION* pmtupdate[RXA_METERTYPE_LAST];
   struct {
     METER p;
   } smeter, adcmeter, agcmeter;
+  struct {
+    DECIM p;
+  } decim;
   struct {
     SHIFT p;
   } shift;
@@ -115,6 +119,9 @@ struct _rxa {
   struct {
     EMNR p;
   } emnr;
+  struct {
+    SSNR p;
+  } ssnr;
   struct {
     WCPAGC p;
   } agc;
@@ -162,7 +169,10 @@ extern __declspec (dllexport) void SetRXAMode (int channel, int mode);
 
 extern void RXAResCheck (int channel);
 
-extern void RXAbp1Check (int channel, int amd_run, int snba_run, int emnr_run, int anf_run, int anr_run);
+extern void RXADecimCheck (int channel);
+
+extern void RXAbp1Check (int channel, int amd_run, int snba_run, int emnr_run, int ssnr_run, int anf_run,
+                         int anr_run);
 
 extern void RXAbp1Set (int channel);
 
@@ -67,13 +67,14 @@ void destroy_amd(AMD a) {
 }
 
 void init_amd(AMD a) {
+  int i;
   //pll
   a->omega_min = TWOPI * a->fmin / a->sample_rate;
   a->omega_max = TWOPI * a->fmax / a->sample_rate;
   a->g1 = 1.0 - exp(-2.0 * a->omegaN * a->zeta / a->sample_rate);
   a->g2 = -a->g1 + 2.0 * (1 - exp(-a->omegaN * a->zeta / a->sample_rate) * cos(a->omegaN / a->sample_rate * sqrt(
                             1.0 - a->zeta * a->zeta)));
-  a->phs = 0.0;
+  a->phs = 0;
   a->fil_out = 0.0;
   a->omega = 0.0;
   //fade leveler
@@ -98,6 +99,19 @@ void init_amd(AMD a) {
   a->c1[4] = -0.988739372718090;
   a->c1[5] = -0.996959189310611;
   a->c1[6] = -0.999282492800792;
+
+  for (i = 0; i < STAGES; i++) {
+    a->ap_c[i][0] = a->c0[i];
+    a->ap_c[i][1] = a->c1[i];
+    a->ap_c[i][2] = a->c0[i];
+    a->ap_c[i][3] = a->c1[i];
+  }
+
+  //nco
+  for (i = 0; i < AMD_NCO_SIZE; i++) {
+    a->nco_cos[i] = cos (TWOPI * (double)i / (double)AMD_NCO_SIZE);
+    a->nco_sin[i] = sin (TWOPI * (double)i / (double)AMD_NCO_SIZE);
+  }
 }
 
 void flush_amd (AMD a) {
@@ -114,6 +128,10 @@ void xamd (AMD a) {
   double del_out;
   double ai, bi, aq, bq;
   double ai_ps, bi_ps, aq_ps, bq_ps;
+  double ap[AMD_LANES], y;
+  double (*z)[AMD_LANES];
+  double d, cosd, sind;
+  uint32_t idx;
   int j, k;
 
   if (a->run) {
@@ -137,40 +155,48 @@ void xamd (AMD a) {
 
     case 1: { //Synchronous AM Demodulator with Sideband Separation
       for (i = 0; i < a->buff_size; i++) {
-        vco[0] = cos(a->phs);
-        vco[1] = sin(a->phs);
+        // table NCO: nearest entry, rotated by the remaining phase d (|d| <= pi / AMD_NCO_SIZE)
+        idx = (a->phs + (1u << (31 - AMD_NCO_BITS))) >> (32 - AMD_NCO_BITS);
+        d = (double)(int32_t)(a->phs - (idx << (32 - AMD_NCO_BITS))) * (TWOPI / 4294967296.0);
+        idx &= AMD_NCO_SIZE - 1;
+        cosd = 1.0 - 0.5 * d * d;
+        sind = d * (1.0 - d * d / 6.0);
+        vco[0] = a->nco_cos[idx] * cosd - a->nco_sin[idx] * sind;
+        vco[1] = a->nco_sin[idx] * cosd + a->nco_cos[idx] * sind;
         ai = a->in_buff[2 * i + 0] * vco[0];
         bi = a->in_buff[2 * i + 0] * vco[1];
         aq = a->in_buff[2 * i + 1] * vco[0];
         bq = a->in_buff[2 * i + 1] * vco[1];
 
         if (a->sbmode != 0) {
-          a->a[0] = a->dsI;
-          a->b[0] = bi;
-          a->c[0] = a->dsQ;
-          a->d[0] = aq;
+          // four all-pass chains, stage j: y(n) = c * (u(n) - y(n-2)) + u(n-2)
+          // the inner loop over the lanes is independent and vectorises;
+          // z holds the stage inputs of sample n-2 and is overwritten with those of sample n
+          z = a->ap_z[a->ap_p];
+          a->ap_p ^= 1;
+          ap[0] = a->dsI;
+          ap[1] = bi;
+          ap[2] = a->dsQ;
+          ap[3] = aq;
           a->dsI = ai;
           a->dsQ = bq;
 
           for (j = 0; j < STAGES; j++) {
-            k = 3 * j;
-            a->a[k + 3] = a->c0[j] * (a->a[k] - a->a[k + 5]) + a->a[k + 2];
-            a->b[k + 3] = a->c1[j] * (a->b[k] - a->b[k + 5]) + a->b[k + 2];
-            a->c[k + 3] = a->c0[j] * (a->c[k] - a->c[k + 5]) + a->c[k + 2];
-            a->d[k + 3] = a->c1[j] * (a->d[k] - a->d[k + 5]) + a->d[k + 2];
+            for (k = 0; k < AMD_LANES; k++) {
+              y = a->ap_c[j][k] * (ap[k] - z[j + 1][k]) + z[j][k];
+              z[j][k] = ap[k];
+              ap[k] = y;
+            }
           }
 
-          ai_ps = a->a[OUT_IDX];
-          bi_ps = a->b[OUT_IDX];
-          bq_ps = a->c[OUT_IDX];
-          aq_ps = a->d[OUT_IDX];
-
-          for (j = OUT_IDX + 2; j > 0; j--) {
-            a->a[j] = a->a[j - 1];
-            a->b[j] = a->b[j - 1];
-            a->c[j] = a->c[j - 1];
-            a->d[j] = a->d[j - 1];
+          for (k = 0; k < AMD_LANES; k++) {
+            z[STAGES][k] = ap[k];
           }
+
+          ai_ps = ap[0];
+          bi_ps = ap[1];
+          bq_ps = ap[2];
+          aq_ps = ap[3];
         }
 
         corr[0] = +ai + bq;
@@ -213,11 +239,8 @@ void xamd (AMD a) {
         if (a->omega > a->omega_max) { a->omega = a->omega_max; }
 
         a->fil_out = a->g1 * det + a->omega;
-        a->phs += del_out;
-
-        while (a->phs >= TWOPI) { a->phs -= TWOPI; }
-
-        while (a->phs < 0.0) { a->phs += TWOPI; }
+        // |del_out| < pi, the accumulator wraps around at 2 pi by itself
+        a->phs += (uint32_t)(int32_t)(del_out * (4294967296.0 / TWOPI));
       }
 
       break;
@@ -254,7 +277,7 @@ SetRXAAMDRun(int channel, int run) {
 
   if (a->run != run) {
     RXAbp1Check (channel, run, rxa[channel].snba.p->run, rxa[channel].emnr.p->run,
-                 rxa[channel].anf.p->run, rxa[channel].anr.p->run);
+                 rxa[channel].ssnr.p->run, rxa[channel].anf.p->run, rxa[channel].anr.p->run);
     EnterCriticalSection (&ch[channel].csDSP);
     a->run = run;
     RXAbp1Set (channel);
@@ -32,9 +32,12 @@ warren@wpratt.com
   #define STAGES    7
 #endif
 
-#ifndef OUT_IDX
-  #define OUT_IDX   (3 * STAGES)
-#endif
+// the four all-pass networks (I*cos, I*sin, Q*cos, Q*sin) run side by side
+#define AMD_LANES     4
+
+// table NCO: 2^AMD_NCO_BITS entries per cycle, phase accumulator 2^32 = 2 pi
+#define AMD_NCO_BITS  10
+#define AMD_NCO_SIZE  (1 << AMD_NCO_BITS)
 
 typedef struct _amd {
   int run;
@@ -50,7 +53,7 @@ typedef struct _amd {
   double omega_max;         // pll - maximum lock check parameter
   double zeta;            // pll - damping factor; as coded, must be <=1.0
   double omegaN;            // pll - natural frequency
-  double phs;             // pll - phase accumulator
+  uint32_t phs;           // pll - phase accumulator, 2^32 = 2 pi
   double omega;           // pll - locked pll frequency
   double fil_out;           // pll - filter output
   double g1, g2;            // pll - filter gain parameters
@@ -60,12 +63,13 @@ typedef struct _amd {
   double onem_mtauR;          // 1.0 - carrier_removal_multiplier
   double mtauI;           // carrier insertion multiplier
   double onem_mtauI;          // 1.0 - carrier_insertion_multiplier
-  double a[3 * STAGES + 3];     // Filter a variables
-  double b[3 * STAGES + 3];     // Filter b variables
-  double c[3 * STAGES + 3];     // Filter c variables
-  double d[3 * STAGES + 3];     // Filter d variables
   double c0[STAGES];          // Filter coefficients - path 0
   double c1[STAGES];          // Filter coefficients - path 1
+  double ap_c[STAGES][AMD_LANES];     // Filter coefficients, per lane
+  double ap_z[2][STAGES + 1][AMD_LANES];  // Filter states, stage inputs of the last two samples
+  int ap_p;             // Filter states, index of the older sample
+  double nco_cos[AMD_NCO_SIZE];     // NCO cosine table
+  double nco_sin[AMD_NCO_SIZE];     // NCO sine table
   double dsI;             // delayed sample, I path
   double dsQ;             // delayed sample, Q path
   double dc_insert;         // dc component to insert in output
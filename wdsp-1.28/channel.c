@@ -25,9 +25,18 @@ warren@wpratt.com
 */
 
 #include "comm.h"
+#if defined(linux) || defined(__APPLE__)
+  #include <errno.h>
+#endif
 
 struct _ch ch[MAX_CHANNELS];
 
+#if defined(linux) || defined(__APPLE__)
+// signalled by the flush threads whenever a channel flush has completed
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flush_done = PTHREAD_COND_INITIALIZER;
+#endif
+
 void start_thread (int channel) {
   HANDLE handle = (HANDLE) _beginthread(wdspmain, 0, (void *)(uintptr_t)channel);
   //SetThreadPriority(handle, THREAD_PRIORITY_HIGHEST);
@@ -141,6 +150,11 @@ void flushChannel (void* p) {
       LeaveCriticalSection(&ch[channel].csEXCH);
       LeaveCriticalSection(&ch[channel].csDSP);
       InterlockedBitTestAndReset(&ch[channel].flushflag, 0);
+#if defined(linux) || defined(__APPLE__)
+      pthread_mutex_lock(&flush_lock);
+      pthread_cond_broadcast(&flush_done);
+      pthread_mutex_unlock(&flush_lock);
+#endif
     }
   }
 
@@ -245,11 +259,57 @@ void SetAllRates (int channel, int in_rate, int dsp_rate, int out_rate) {
   }
 }
 
+PORT
+int WaitChannelFlush (int channel, int timeout) {
+  // Wait (at most timeout msec) until a slew-down initiated with
+  // SetChannelState(channel, 0, 0) has completed and the channel is flushed.
+  // Returns 1 if the flush completed, 0 on time-out.
+  IOB a = ch[channel].iob.pc;
+  int flushed;
+#if defined(linux) || defined(__APPLE__)
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += timeout / 1000;
+  ts.tv_nsec += (long)(timeout % 1000) * 1000000L;
+
+  if (ts.tv_nsec >= 1000000000L) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&flush_lock);
+
+  while (!(flushed = !_InterlockedAnd (&ch[channel].flushflag, 1))) {
+    if (pthread_cond_timedwait(&flush_done, &flush_lock, &ts) == ETIMEDOUT) {
+      flushed = !_InterlockedAnd (&ch[channel].flushflag, 1);
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&flush_lock);
+#else
+  int count = 0;
+
+  while (!(flushed = !_InterlockedAnd (&ch[channel].flushflag, 1)) && count < timeout) {
+    Sleep(1);
+    count++;
+  }
+
+#endif
+
+  if (!flushed) {
+    InterlockedBitTestAndReset (&ch[channel].exchange, 0);
+    InterlockedBitTestAndReset (&ch[channel].flushflag, 0);
+    InterlockedBitTestAndReset (&a->slew.downflag, 0);
+  }
+
+  return flushed;
+}
+
 PORT
 int SetChannelState (int channel, int state, int dmode) {
   IOB a = ch[channel].iob.pc;
   int prior_state = ch[channel].state;
-  int count = 0;
   const int timeout = 100;
 
   if (ch[channel].state != state) {
@@ -261,16 +321,7 @@ int SetChannelState (int channel, int state, int dmode) {
       InterlockedBitTestAndSet (&ch[channel].flushflag, 0);
 
       if (dmode) {
-        while (_InterlockedAnd (&ch[channel].flushflag, 1) && count < timeout) {
-          Sleep(1);
-          count++;
-        }
-      }
-
-      if (count >= timeout) {
-        InterlockedBitTestAndReset (&ch[channel].exchange, 0);
-        InterlockedBitTestAndReset (&ch[channel].flushflag, 0);
-        InterlockedBitTestAndReset (&a->slew.downflag, 0);
+        WaitChannelFlush (channel, timeout);
       }
 
       break;
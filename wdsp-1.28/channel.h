@@ -81,4 +81,6 @@ PORT void SetAllRates (int channel, int in_rate, int dsp_rate, int out_rate);
 
 PORT int SetChannelState (int channel, int state, int dmode);
 
+PORT int WaitChannelFlush (int channel, int timeout);
+
 #endif
\ No newline at end of file
@@ -58,6 +58,7 @@ warren@wpratt.com
 #include "cfir.h"
 #include "channel.h"
 #include "compress.h"
+#include "decim.h"
 #include "delay.h"
 #include "dexp.h"
 #include "div.h"
@@ -95,6 +96,7 @@ warren@wpratt.com
 #include "siphon.h"
 #include "slew.h"
 #include "snb.h"
+#include "ssnr.h"
 #include "ssql.h"
 #include "syncbuffs.h"
 #include "TXA.h"
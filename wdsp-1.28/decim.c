@@ -0,0 +1,240 @@
+/*  decim.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+//
+// Going from a wide input rate straight to the DSP rate with one polyphase FIR
+// costs 140 * in_rate / dsp_rate taps per output sample.  Halving the rate in
+// steps with half-band filters is much cheaper: every other tap of a half-band
+// filter is zero and the rest are symmetric, so a 131-tap stage needs 33 real
+// multiplies per output sample and component, and each stage runs at half the
+// rate of the one before.
+//
+// All stages share one filter.  The passband is 0.45 * output rate, the stopband
+// starts at 0.55 * output rate and is ~100 dB down, so the band +/- 0.45 * rate
+// of every stage output is free of aliases.
+//
+
+#define DECIM_ATTEN   100.0                     // stopband attenuation, dB
+#define DECIM_TRANS   0.05                      // transition width / input rate
+
+static double decim_I0 (double x) {
+  // power series of the modified Bessel function, plenty for a window
+  double sum = 1.0, term = 1.0, q = 0.25 * x * x;
+  int k;
+
+  for (k = 1; k < 64; k++) {
+    term *= q / ((double)k * (double)k);
+    sum += term;
+
+    if (term < 1.0e-12 * sum) { break; }
+  }
+
+  return sum;
+}
+
+static void calc_halfband (DECIM a) {
+  // Kaiser-windowed half-band filter of length 4 * m + 3, the end taps are non-zero
+  int i, m;
+  double beta = 0.1102 * (DECIM_ATTEN - 8.7);
+  double i0b = decim_I0 (beta);
+  double c, sum = 0.0;
+  m = (int)ceil (((DECIM_ATTEN - 8.0) / (2.285 * TWOPI * DECIM_TRANS) - 3.0) / 4.0);
+  a->nc = 4 * m + 3;
+  a->nh = m + 1;
+  c = (double)(a->nc / 2);
+  a->h = (double *)malloc0 (a->nh * sizeof (double));
+
+  for (i = 0; i < a->nh; i++) {
+    double k = (double)(2 * i + 1);
+    double r = k / c;
+    double w = decim_I0 (beta * sqrt (1.0 - r * r)) / i0b;
+    a->h[i] = w * sin (0.5 * PI * k) / (PI * k);
+    sum += a->h[i];
+  }
+
+  // unity gain at DC: centre tap 0.5 plus both wings
+  for (i = 0; i < a->nh; i++) {
+    a->h[i] *= 0.25 / sum;
+  }
+}
+
+static void calc_decim (DECIM a) {
+  int k;
+  calc_halfband (a);
+  a->srate[0] = a->rate;
+  a->ssize[0] = a->size;
+  a->sout[0] = a->in;
+  a->hist[0] = 0;
+  a->nstages = 0;
+
+  for (k = 1; k <= DECIM_MAX_STAGES; k++) {
+    if ((a->rate % (1 << k)) != 0 || (a->size % (1 << k)) != 0) { break; }
+
+    if ((a->rate >> k) < a->min_rate) { break; }
+
+    a->srate[k] = a->rate >> k;
+    a->ssize[k] = a->size >> k;
+    a->sout[k] = (double *)malloc0 (a->ssize[k] * sizeof (complex));
+    a->hist[k] = (double *)malloc0 ((a->nc - 1 + a->ssize[k - 1]) * sizeof (complex));
+    a->nstages = k;
+  }
+
+  a->depth = 0;
+
+  for (k = 0; k < DECIM_MAX_TAPS; k++) {
+    if (a->tap[k] > a->nstages) { a->tap[k] = a->nstages; }
+
+    if (a->tap[k] > a->depth) { a->depth = a->tap[k]; }
+  }
+}
+
+static void decalc_decim (DECIM a) {
+  int k;
+
+  for (k = 1; k <= a->nstages; k++) {
+    _aligned_free (a->hist[k]);
+    _aligned_free (a->sout[k]);
+  }
+
+  a->nstages = 0;
+  _aligned_free (a->h);
+}
+
+DECIM create_decim (int run, int size, double* in, int rate, int min_rate) {
+  int k;
+  DECIM a = (DECIM) malloc0 (sizeof (decim));
+  a->run = run;
+  a->size = size;
+  a->in = in;
+  a->rate = rate;
+  a->min_rate = min_rate;
+
+  for (k = 0; k < DECIM_MAX_TAPS; k++) {
+    a->tap[k] = -1;
+  }
+
+  calc_decim (a);
+  return a;
+}
+
+void destroy_decim (DECIM a) {
+  decalc_decim (a);
+  _aligned_free (a);
+}
+
+void flush_decim (DECIM a) {
+  int k;
+
+  for (k = 1; k <= a->nstages; k++) {
+    memset (a->hist[k], 0, (a->nc - 1 + a->ssize[k - 1]) * sizeof (complex));
+    memset (a->sout[k], 0, a->ssize[k] * sizeof (complex));
+  }
+}
+
+void xdecim (DECIM a) {
+  if (a->run) {
+    int i, k, n;
+    int nh = a->nh;
+    double* h = a->h;
+
+    for (k = 1; k <= a->depth; k++) {
+      int nin = a->ssize[k - 1];
+      double* x = a->hist[k];
+      double* y = a->sout[k];
+      memcpy (x + 2 * (a->nc - 1), a->sout[k - 1], nin * sizeof (complex));
+
+      for (n = 0; n < a->ssize[k]; n++) {
+        double* xc = x + 2 * (2 * n + a->nc / 2);
+        double I = 0.5 * xc[0];
+        double Q = 0.5 * xc[1];
+
+        for (i = 0; i < nh; i++) {
+          int d = 2 * (2 * i + 1);
+          I += h[i] * (xc[0 - d] + xc[0 + d]);
+          Q += h[i] * (xc[1 - d] + xc[1 + d]);
+        }
+
+        y[2 * n + 0] = I;
+        y[2 * n + 1] = Q;
+      }
+
+      memmove (x, x + 2 * nin, (a->nc - 1) * sizeof (complex));
+    }
+  }
+}
+
+void setBuffers_decim (DECIM a, double* in) {
+  a->in = in;
+  a->sout[0] = in;
+}
+
+void setSize_decim (DECIM a, int size) {
+  decalc_decim (a);
+  a->size = size;
+  calc_decim (a);
+}
+
+void setInRate_decim (DECIM a, int rate) {
+  decalc_decim (a);
+  a->rate = rate;
+  calc_decim (a);
+}
+
+void setOutRate_decim (DECIM a, int min_rate) {
+  decalc_decim (a);
+  a->min_rate = min_rate;
+  calc_decim (a);
+}
+
+int stage_decim (DECIM a, double fshift, double bw) {
+  // deepest stage whose alias-free band still holds fshift +/- bw
+  int k;
+
+  if (!a->run) { return 0; }
+
+  for (k = a->nstages; k > 0; k--) {
+    if (fabs (fshift) + bw <= 0.45 * (double)a->srate[k]) { break; }
+  }
+
+  return k;
+}
+
+void setTap_decim (DECIM a, int tap, int stage) {
+  int k, depth = 0;
+
+  if (stage > a->nstages) { stage = a->nstages; }
+
+  a->tap[tap] = stage;
+
+  for (k = 0; k < DECIM_MAX_TAPS; k++) {
+    if (a->tap[k] > depth) { depth = a->tap[k]; }
+  }
+
+  // stages that were idle hold stale history
+  for (k = a->depth + 1; k <= depth; k++) {
+    memset (a->hist[k], 0, (a->nc - 1 + a->ssize[k - 1]) * sizeof (complex));
+  }
+
+  a->depth = depth;
+}
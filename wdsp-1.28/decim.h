@@ -0,0 +1,74 @@
+/*  decim.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef _decim_h
+#define _decim_h
+
+//
+// Decimation tree: a cascade of half-band decimate-by-2 stages.
+// Stage 0 is the input itself, stage k runs at rate / 2^k.  Every stage
+// output is kept, so any number of taps can pick the stage they need and
+// the cascade is only computed once, down to the deepest requested stage.
+//
+
+#define DECIM_MAX_STAGES 8
+#define DECIM_MAX_TAPS   4
+
+typedef struct _decim {
+  int run;
+  int size;                                     // input samples per block
+  double* in;
+  int rate;                                     // input rate
+  int min_rate;                                 // never decimate below this rate
+  int nc;                                       // half-band length, 4 * m + 3
+  int nh;                                       // non-zero odd taps per side, m + 1
+  double* h;                                    // odd taps, nearest to the centre first
+  int nstages;
+  int srate[DECIM_MAX_STAGES + 1];              // rate of stage k
+  int ssize[DECIM_MAX_STAGES + 1];              // samples per block of stage k
+  double* sout[DECIM_MAX_STAGES + 1];           // output of stage k, sout[0] = in
+  double* hist[DECIM_MAX_STAGES + 1];           // (nc - 1) history + input block of stage k
+  int tap[DECIM_MAX_TAPS];                      // stage requested by each tap, -1 = unused
+  int depth;                                    // deepest requested stage
+} decim, *DECIM;
+
+extern DECIM create_decim (int run, int size, double* in, int rate, int min_rate);
+
+extern void destroy_decim (DECIM a);
+
+extern void flush_decim (DECIM a);
+
+extern void xdecim (DECIM a);
+
+extern void setBuffers_decim (DECIM a, double* in);
+
+extern void setSize_decim (DECIM a, int size);
+
+extern void setInRate_decim (DECIM a, int rate);
+
+extern void setOutRate_decim (DECIM a, int min_rate);
+
+extern int  stage_decim (DECIM a, double fshift, double bw);
+
+extern void setTap_decim (DECIM a, int tap, int stage);
+
+#endif
@@ -635,6 +635,19 @@ void GetDEXPPeakSignal (int id, double* peak) {
   LeaveCriticalSection (&a->cs_update);
 }
 
+PORT
+void ResetDEXPDetector (int id) {
+  // Forget the detector envelope and the attack/hold/decay state, including a pending
+  // VOX turn-off, without touching the audio delay line. No VOX event is pushed.
+  DEXP a = pdexp[id];
+  EnterCriticalSection (&a->cs_update);
+  a->avsig = 0.0;
+  a->state = DEXP_LOW;
+  a->count = 0;
+  a->vox_count = 0;
+  LeaveCriticalSection (&a->cs_update);
+}
+
 PORT
 void SetAntiVOXRun (int id, int run) {
   DEXP a = pdexp[id];
@@ -1370,7 +1370,7 @@ void SetRXAEMNRRun (int channel, int run) {
 
   if (a->run != run) {
     RXAbp1Check (channel, rxa[channel].amd.p->run, rxa[channel].snba.p->run,
-                 run, rxa[channel].anf.p->run, rxa[channel].anr.p->run);
+                 run, rxa[channel].ssnr.p->run, rxa[channel].anf.p->run, rxa[channel].anr.p->run);
     EnterCriticalSection (&ch[channel].csDSP);
     a->run = run;
     RXAbp1Set (channel);
@@ -329,7 +329,7 @@ void SetRXAEQProfile (int channel, int nfreqs, double* F, double* G) {
   memcpy (a->G, G, (nfreqs + 1) * sizeof (double));
   impulse = eq_impulse (a->nc, a->nfreqs, a->F, a->G,
                         a->samplerate, 1.0 / (2.0 * a->size), a->ctfmode, a->wintype);
-  setImpulse_fircore (a->p, impulse, 1);
+  setImpulseXfade_fircore (a->p, impulse);
   _aligned_free (impulse);
 }
 
@@ -469,7 +469,7 @@ void SetTXAEQProfile (int channel, int nfreqs, double* F, double* G) {
   memcpy (a->F, F, (nfreqs + 1) * sizeof (double));
   memcpy (a->G, G, (nfreqs + 1) * sizeof (double));
   impulse = eq_impulse (a->nc, a->nfreqs, a->F, a->G, a->samplerate, 1.0 / (2.0 * a->size), a->ctfmode, a->wintype);
-  setImpulse_fircore (a->p, impulse, 1);
+  setImpulseXfade_fircore (a->p, impulse);
   _aligned_free (impulse);
 }
 
@@ -310,6 +310,14 @@ void plan_fircore (FIRCORE a) {
   a->accum = (double *) malloc0 (2 * a->size * sizeof (complex));
   a->crev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->accum, (fftw_complex *)a->out, FFTW_BACKWARD, FFTW_PATIENT);
   a->masks_ready = 0;
+  a->xfade = 0;
+  a->xaccum = (double *) malloc0 (2 * a->size * sizeof (complex));
+  a->xbuf   = (double *) malloc0 (2 * a->size * sizeof (complex));
+  a->xwin   = (double *) malloc0 (a->size * sizeof (double));
+
+  for (i = 0; i < a->size; i++) {
+    a->xwin[i] = 0.5 * (1.0 - cos (PI * ((double)i + 0.5) / (double)a->size));
+  }
 }
 
 void calc_fircore (FIRCORE a, int flip) {
@@ -358,6 +366,9 @@ FIRCORE create_fircore (int size, double* in, double* out, int nc, int mp, doubl
 
 void deplan_fircore (FIRCORE a) {
   int i;
+  _aligned_free (a->xwin);
+  _aligned_free (a->xbuf);
+  _aligned_free (a->xaccum);
   fftw_destroy_plan (a->crev);
   _aligned_free (a->accum);
 
@@ -416,6 +427,7 @@ void xfircore (FIRCORE a) {
   int idxmask = a->idxmask;
   int sz = a->size;
   int nfor = a->nfor;
+  int xfade = a->xfade;
 
   for (j = 0; j < nfor; j++) {
     for (i = 0; i < 2 * sz; i++) {
@@ -426,9 +438,38 @@ void xfircore (FIRCORE a) {
     k = (k + idxmask) & idxmask;
   }
 
+  if (xfade) {
+    // first block after setImpulseXfade_fircore(): also filter with the previous masks
+    double* xaccum = a->xaccum;
+    int xset = 1 - cset;
+    k = a->buffidx;
+    memset (xaccum, 0, 2 * sz * sizeof (complex));
+
+    for (j = 0; j < nfor; j++) {
+      for (i = 0; i < 2 * sz; i++) {
+        xaccum[2 * i + 0] += fftout[k][2 * i + 0] * fmask[xset][j][2 * i + 0] - fftout[k][2 * i + 1] * fmask[xset][j][2 * i + 1];
+        xaccum[2 * i + 1] += fftout[k][2 * i + 0] * fmask[xset][j][2 * i + 1] + fftout[k][2 * i + 1] * fmask[xset][j][2 * i + 0];
+      }
+
+      k = (k + idxmask) & idxmask;
+    }
+
+    a->xfade = 0;
+  }
+
   LeaveCriticalSection (&a->update);
   a->buffidx = (a->buffidx + 1) & idxmask;
   fftw_execute (a->crev);
+
+  if (xfade) {
+    fftw_execute_dft (a->crev, (fftw_complex *)a->xaccum, (fftw_complex *)a->xbuf);
+
+    for (i = 0; i < sz; i++) {
+      a->out[2 * i + 0] = a->xbuf[2 * i + 0] + a->xwin[i] * (a->out[2 * i + 0] - a->xbuf[2 * i + 0]);
+      a->out[2 * i + 1] = a->xbuf[2 * i + 1] + a->xwin[i] * (a->out[2 * i + 1] - a->xbuf[2 * i + 1]);
+    }
+  }
+
   memcpy (a->fftin, &(a->fftin[2 * a->size]), a->size * sizeof(complex));
 }
 
@@ -452,6 +493,22 @@ void setImpulse_fircore (FIRCORE a, double* impulse, int update) {
   calc_fircore (a, update);
 }
 
+void setImpulseXfade_fircore (FIRCORE a, double* impulse) {
+  // like setImpulse_fircore (a, impulse, 1), but the first block filtered with
+  // the new masks is crossfaded from the output of the previous masks
+  memcpy (a->impulse, impulse, a->nc * sizeof (complex));
+  // a pending crossfade still reads the masks that are about to be overwritten
+  EnterCriticalSection (&a->update);
+  a->xfade = 0;
+  LeaveCriticalSection (&a->update);
+  calc_fircore (a, 0);
+  EnterCriticalSection (&a->update);
+  a->cset = 1 - a->cset;
+  a->xfade = 1;
+  LeaveCriticalSection (&a->update);
+  a->masks_ready = 0;
+}
+
 void setNc_fircore (FIRCORE a, int nc, double* impulse) {
   // because of FFT planning, this will probably cause a glitch in audio if done during dataflow
   deplan_fircore (a);
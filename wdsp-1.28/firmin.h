@@ -155,6 +155,10 @@ typedef struct _fircore {
   int cset;
   int mp;
   int masks_ready;
+  int xfade;        // crossfade from the previous mask set in the next block
+  double* xaccum;     // frequency domain accumulator, previous mask set
+  double* xbuf;       // output buffer, previous mask set
+  double* xwin;       // crossfade ramp
 } fircore, *FIRCORE;
 
 extern FIRCORE create_fircore (int size, double* in, double* out,
@@ -172,6 +176,8 @@ extern void setSize_fircore (FIRCORE a, int size);
 
 extern void setImpulse_fircore (FIRCORE a, double* impulse, int update);
 
+extern void setImpulseXfade_fircore (FIRCORE a, double* impulse);
+
 extern void setNc_fircore (FIRCORE a, int nc, double* impulse);
 
 extern void setMp_fircore (FIRCORE a, int mp);
@@ -41,12 +41,14 @@ void size_iqc (IQC a) {
   }
 
   a->dog.cpi = (int *) malloc0 (a->ints * sizeof (int));
+  a->dog.hist = (int *) malloc0 (a->ints * sizeof (int));
   a->dog.count = 0;
   a->dog.full_ints = 0;
 }
 
 void desize_iqc (IQC a) {
   int i;
+  _aligned_free (a->dog.hist);
   _aligned_free (a->dog.cpi);
 
   for (i = 0; i < 2; i++) {
@@ -75,6 +77,8 @@ void calc_iqc (IQC a) {
     theta += delta;
   }
 
+  a->kx = (int *) malloc0 (a->size * sizeof (int));
+  a->dx = (double *) malloc0 (a->size * sizeof (double));
   InitializeCriticalSectionAndSpinCount (&a->dog.cs, 2500);
   size_iqc (a);
 }
@@ -82,6 +86,8 @@ void calc_iqc (IQC a) {
 void decalc_iqc (IQC a) {
   desize_iqc (a);
   DeleteCriticalSection (&a->dog.cs);
+  _aligned_free (a->dx);
+  _aligned_free (a->kx);
   _aligned_free (a->cup);
 }
 
@@ -115,8 +121,85 @@ enum _iqcstate {
   DONE
 };
 
+// RUN state for a whole block, split into passes that vectorise: envelopes and
+// intervals, then the three polynomials (with gathers), then the watchdog.
+// The passes take restrict pointers, in and out may be the same buffer.
+static void iqc_intervals (int size, int ints, const double* in, const double* restrict t,
+                           int* restrict kx, double* restrict dx) {
+  int i, k;
+  double I, Q, env;
+
+  for (i = 0; i < size; i++) {
+    I = in[2 * i + 0];
+    Q = in[2 * i + 1];
+    dx[i] = sqrt (I * I + Q * Q);
+  }
+
+  for (i = 0; i < size; i++) {
+    env = dx[i];
+    k = (int)(env * ints);
+    k = k > ints - 1 ? ints - 1 : k;
+    kx[i] = k;
+    dx[i] = env - t[k];
+  }
+}
+
+static void iqc_correct (int size, const int* restrict kx, const double* restrict dx, const double* restrict cm,
+                         const double* restrict cc, const double* restrict cs, const double* in, double* out) {
+  int i, k;
+  double I, Q, ym, yc, ys;
+
+  for (i = 0; i < size; i++) {
+    k = 4 * kx[i];
+    ym = cm[k + 0] + dx[i] * (cm[k + 1] + dx[i] * (cm[k + 2] + dx[i] * cm[k + 3]));
+    yc = cc[k + 0] + dx[i] * (cc[k + 1] + dx[i] * (cc[k + 2] + dx[i] * cc[k + 3]));
+    ys = cs[k + 0] + dx[i] * (cs[k + 1] + dx[i] * (cs[k + 2] + dx[i] * cs[k + 3]));
+    I = in[2 * i + 0];
+    Q = in[2 * i + 1];
+    out[2 * i + 0] = ym * (I * yc - Q * ys);
+    out[2 * i + 1] = ym * (I * ys + Q * yc);
+  }
+}
+
+static void xiqc_run (IQC a) {
+  int i, k;
+  int cset = a->cset;
+  iqc_intervals (a->size, a->ints, a->in, a->t, a->kx, a->dx);
+  iqc_correct (a->size, a->kx, a->dx, a->cm[cset], a->cc[cset], a->cs[cset], a->in, a->out);
+  // watchdog: count the samples per interval once per block; samples that
+  // arrive in a block after the last interval has filled up are not carried
+  // over into the next round
+  memset (a->dog.hist, 0, a->ints * sizeof (int));
+
+  for (i = 0; i < a->size; i++) {
+    a->dog.hist[a->kx[i]]++;
+  }
+
+  for (k = 0; k < a->ints; k++) {
+    if (a->dog.hist[k] != 0 && a->dog.cpi[k] != a->dog.spi) {
+      a->dog.cpi[k] += a->dog.hist[k];
+
+      if (a->dog.cpi[k] >= a->dog.spi) {
+        a->dog.cpi[k] = a->dog.spi;
+        a->dog.full_ints++;
+      }
+    }
+  }
+
+  if (a->dog.full_ints == a->ints) {
+    EnterCriticalSection (&a->dog.cs);
+    ++a->dog.count;
+    LeaveCriticalSection (&a->dog.cs);
+    a->dog.full_ints = 0;
+    memset (a->dog.cpi, 0, a->ints * sizeof (int));
+  }
+}
+
 void xiqc (IQC a) {
-  if (_InterlockedAnd(&a->run, 1)) {
+  if (_InterlockedAnd(&a->run, 1) && a->state == RUN) {
+    // the state only changes under csDSP, i.e. between blocks
+    xiqc_run (a);
+  } else if (_InterlockedAnd(&a->run, 1)) {
     int i, k, cset, mset;
     double I, Q, env, dx, ym, yc, ys, PRE0, PRE1;
 
@@ -225,7 +308,11 @@ void setSamplerate_iqc (IQC a, int rate) {
 }
 
 void setSize_iqc (IQC a, int size) {
+  _aligned_free (a->dx);
+  _aligned_free (a->kx);
   a->size = size;
+  a->kx = (int *) malloc0 (a->size * sizeof (int));
+  a->dx = (double *) malloc0 (a->size * sizeof (double));
 }
 
 /********************************************************************************************************
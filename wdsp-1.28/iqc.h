@@ -45,9 +45,12 @@ typedef struct _iqc {
   int count;
   int ntup;
   int state;
+  int* kx;          // per-sample interval index (RUN block processing)
+  double* dx;         // per-sample offset into the interval (RUN block processing)
   struct {
     int spi;
     int* cpi;
+    int* hist;        // samples per interval in the current block
     int full_ints;
     int count;
     CRITICAL_SECTION cs;
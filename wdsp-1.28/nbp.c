@@ -171,6 +171,109 @@ int make_nbp (int nn, int* active, double* center, double* width, double* nlow,
   return nbp;
 }
 
+static void calc_nbp_tkern (NBP a) {
+  // window and sinc denominator of fir_bandpass(), these do not depend on the band edges
+  int i;
+  double m = 0.5 * (double)(a->nc - 1);
+  double delta = PI / m;
+  double scale = a->gain / (double)(2 * a->size);
+  double cosphi, window, posi;
+  _aligned_free (a->tkern);
+  a->tkern = (double *) malloc0 (a->nc * sizeof (double));
+
+  for (i = 0; i < a->nc; i++) {
+    posi = (double)i - m;
+
+    if (posi == 0.0) { continue; }    // centre tap of odd nc, see fir_mbandpass_tuned()
+
+    cosphi = cos (delta * i);
+
+    switch (a->wintype) {
+    case 0: // Blackman-Harris 4-term
+      window  =             + 0.21747
+                            + cosphi *  ( - 0.45325
+                                          + cosphi *  ( + 0.28256
+                                            + cosphi *  ( - 0.04672 )));
+      break;
+
+    case 1: // Blackman-Harris 7-term
+    default:
+      window  =       + 6.3964424114390378e-02
+                      + cosphi *  ( - 2.3993864599352804e-01
+                                    + cosphi *  ( + 3.5015956323820469e-01
+                                      + cosphi *  ( - 2.4774111897080783e-01
+                                        + cosphi *  ( + 8.5438256055858031e-02
+                                          + cosphi *  ( - 1.2320203369293225e-02
+                                            + cosphi *  ( + 4.3778825791773474e-04 ))))));
+      break;
+    }
+
+    a->tkern[i] = scale * window / (PI * posi);
+  }
+
+  a->tkern_nc = a->nc;
+  a->tkern_wintype = a->wintype;
+  a->tkern_rate = a->rate;
+  a->tkern_scale = scale;
+}
+
+static double* fir_mbandpass_tuned (NBP a) {
+  // Same impulse response as fir_mbandpass(), built from the cached window.
+  // With p = i - m, a passband [fl, fh] contributes
+  //   tkern[i] * (exp(-j*wl*p) - exp(-j*wh*p)) / 2j
+  // so each band edge costs one complex rotation per tap instead of sin/cos
+  // and window evaluations, and the impulse cache is not filled with
+  // responses that are only used once while tuning.
+  int i, k, e;
+  int N = a->nc;
+  double m = 0.5 * (double)(N - 1);
+  double* impulse = (double *) malloc0 (N * sizeof (complex));
+  double w, pr, pi, sr, si, tmp, sign, re;
+
+  if (a->tkern == NULL || a->tkern_nc != N || a->tkern_wintype != a->wintype
+      || a->tkern_rate != a->rate || a->tkern_scale != a->gain / (double)(2 * a->size)) {
+    calc_nbp_tkern (a);
+  }
+
+  for (k = 0; k < a->numpb; k++) {
+    for (e = 0; e < 2; e++) {
+      sign = e ? -1.0 : +1.0;
+      w = TWOPI * (e ? a->bphigh[k] : a->bplow[k]) / a->rate;
+      pr = cos (w * m);           // exp(-j*w*p) at i = 0
+      pi = sin (w * m);
+      sr = cos (w);               // rotation by exp(-j*w) per tap
+      si = -sin (w);
+
+      for (i = 0; i < N; i++) {
+        impulse[2 * i + 0] += sign * pr;
+        impulse[2 * i + 1] += sign * pi;
+        tmp = pr * sr - pi * si;
+        pi  = pr * si + pi * sr;
+        pr  = tmp;
+      }
+    }
+  }
+
+  for (i = 0; i < N; i++) {
+    re = impulse[2 * i + 0];
+    impulse[2 * i + 0] = +0.5 * a->tkern[i] * impulse[2 * i + 1];
+    impulse[2 * i + 1] = -0.5 * a->tkern[i] * re;
+  }
+
+  if (N & 1) {
+    re = 0.0;
+
+    for (k = 0; k < a->numpb; k++) {
+      re += (a->bphigh[k] - a->bplow[k]) / a->rate;
+    }
+
+    impulse[N - 1] = a->tkern_scale * re;
+    impulse[N] = 0.0;
+  }
+
+  return impulse;
+}
+
 void calc_nbp_lightweight (NBP a) {
   // calculate and set new impulse response; used when changing tune freq or shift freq
   int i;
@@ -192,8 +295,7 @@ void calc_nbp_lightweight (NBP a) {
         a->bphigh[i] -= offset;
       }
 
-      a->impulse = fir_mbandpass (a->nc, a->numpb, a->bplow, a->bphigh,
-                                  a->rate, a->gain / (double)(2 * a->size), a->wintype);
+      a->impulse = fir_mbandpass_tuned (a);
       setImpulse_fircore (a->p, a->impulse, 1);
       // print_impulse ("nbp.txt", a->size + 1, impulse, 1, 0);
       _aligned_free(a->impulse);
@@ -261,6 +363,7 @@ NBP create_nbp(int run, int fnfrun, int position, int size, int nc, int mp, doub
 
 void destroy_nbp (NBP a) {
   destroy_fircore (a->p);
+  _aligned_free (a->tkern);
   _aligned_free (a->bphigh);
   _aligned_free (a->bplow);
   _aligned_free (a);
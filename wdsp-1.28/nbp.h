@@ -68,6 +68,11 @@ typedef struct _nbp {
   FIRCORE p;
   int havnotch;
   int hadnotch;
+  double* tkern;      // window / sinc denominator for tuning updates
+  int tkern_nc;       // parameters tkern has been computed for
+  int tkern_wintype;
+  double tkern_rate;
+  double tkern_scale;
 } nbp, *NBP;
 
 extern NBP create_nbp(int run, int fnfrun, int position, int size, int nc, int mp, double* in, double* out,
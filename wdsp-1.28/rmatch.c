@@ -127,23 +127,47 @@ void xaamav (AAMAV a, int input, double* output) {
   a->i = (a->i + 1) & a->mask;
 }
 
+//
+// The ring is a single-producer / single-consumer queue: xrmatchIN() is the only
+// writer of iin, wcount and incount, xrmatchOUT() is the only writer of iout and rcount.
+// Each side publishes its running sample count with release semantics and picks up
+// the other side's count with acquire semantics, so no lock is needed for the data path.
+// The control loop runs on the consumer side only and hands the resulting ratio
+// to the producer through the atomically published var.
+//
+#define RM_LOAD(p)      __atomic_load_n (p, __ATOMIC_ACQUIRE)
+#define RM_STORE(p,v)   __atomic_store_n (p, v, __ATOMIC_RELEASE)
+
+static inline double rm_load_double (volatile double* p) {
+  double d;
+  __atomic_load (p, &d, __ATOMIC_ACQUIRE);
+  return d;
+}
+
+static inline void rm_store_double (volatile double* p, double d) {
+  __atomic_store (p, &d, __ATOMIC_RELEASE);
+}
+
 void calc_rmatch (RMATCH a) {
   int m;
   double theta, dtheta;
-  int max_ring_insize;
   a->nom_ratio = (double)a->nom_outrate / (double)a->nom_inrate;
-  max_ring_insize = (int)(1.0 + (double)a->insize * (1.05 * a->nom_ratio));
+  a->max_ring_insize = (int)(1.0 + (double)a->insize * (1.05 * a->nom_ratio));
 
-  if (a->ringsize < 2 * max_ring_insize) { a->ringsize = 2 * max_ring_insize; }
+  if (a->ringsize < 2 * a->max_ring_insize) { a->ringsize = 2 * a->max_ring_insize; }
 
   if (a->ringsize < 2 * a->outsize) { a->ringsize = 2 * a->outsize; }
 
-  a->ring = (double *) malloc0 (a->ringsize * sizeof (complex));
+  a->ring = (double *) malloc0 ((a->ringsize + a->max_ring_insize) * sizeof (complex));
   a->rsize = a->ringsize;
-  a->n_ring = a->rsize / 2;
   a->iin = a->rsize / 2;
   a->iout = 0;
-  a->resout = (double *) malloc0 (max_ring_insize * sizeof (complex));
+  a->wcount = a->rsize / 2;
+  a->rcount = 0;
+  a->incount = 0;
+  a->last_incount = 0;
+  a->n_ring = a->rsize / 2;
+  a->resout = (double *) malloc0 (a->max_ring_insize * sizeof (complex));
   a->v = create_varsamp (1, a->insize, a->in, a->resout, a->nom_inrate, a->nom_outrate,
                          a->fc_high, a->fc_low, a->R, a->gain, a->var, a->varmode);
   a->ffmav = create_aamav (a->ff_ringmin, a->ff_ringmax, a->nom_ratio);
@@ -152,8 +176,6 @@ void calc_rmatch (RMATCH a) {
   a->inv_nom_ratio = (double)a->nom_inrate / (double)a->nom_outrate;
   a->feed_forward = 1.0;
   a->av_deviation = 0.0;
-  InitializeCriticalSectionAndSpinCount (&a->cs_ring, 2500);
-  InitializeCriticalSectionAndSpinCount (&a->cs_var,  2500);
   a->ntslew = (int)(a->tslew * a->nom_outrate);
 
   if (a->ntslew + 1 > a->rsize / 2) { a->ntslew = a->rsize / 2 - 1; }
@@ -167,9 +189,9 @@ void calc_rmatch (RMATCH a) {
     theta += dtheta;
   }
 
-  a->baux = (double *) malloc0 (a->ringsize / 2 * sizeof (complex));
+  a->ucnt_in = -1;
+  a->ucnt_out = -1;
   a->readsamps = 0;
-  a->writesamps = 0;
   a->read_startup = (unsigned int)((double)a->nom_outrate * a->startup_delay);
   a->write_startup = (unsigned int)((double)a->nom_inrate * a->startup_delay);
   a->control_flag = 0;
@@ -179,10 +201,7 @@ void calc_rmatch (RMATCH a) {
 }
 
 void decalc_rmatch (RMATCH a) {
-  _aligned_free (a->baux);
   _aligned_free (a->cslew);
-  DeleteCriticalSection (&a->cs_var);
-  DeleteCriticalSection (&a->cs_ring);
   destroy_mav (a->propmav);
   destroy_aamav (a->ffmav);
   destroy_varsamp (a->v);
@@ -256,47 +275,68 @@ void reset_rmatch (RMATCH a) {
   InterlockedBitTestAndSet (&a->run, 0);
 }
 
-void control (RMATCH a, int change) {
+//
+// consumer side only: n_ring is the fill level just after the read,
+// the producer's contribution is taken from the published input count
+//
+void control (RMATCH a, int n_ring) {
+  double var;
   {
     double current_ratio;
-    xaamav (a->ffmav, change, &current_ratio);
+    unsigned long incount = RM_LOAD (&a->incount);
+    int change = (int)(incount - a->last_incount);
+    a->last_incount = incount;
+
+    if (change > 0) { xaamav (a->ffmav, change, &current_ratio); }
+
+    xaamav (a->ffmav, -(a->outsize), &current_ratio);
     current_ratio *= a->inv_nom_ratio;
     a->feed_forward = a->ff_alpha * current_ratio + (1.0 - a->ff_alpha) * a->feed_forward;
   }
   {
-    int deviation = a->n_ring - a->rsize / 2;
+    int deviation = n_ring - a->rsize / 2;
     xmav (a->propmav, deviation, &a->av_deviation);
   }
-  EnterCriticalSection (&a->cs_var);
-  a->var = a->feed_forward - a->pr_gain * a->av_deviation;
+  var = a->feed_forward - rm_load_double (&a->pr_gain) * a->av_deviation;
 
-  if (a->var > 1.04) { a->var = 1.04; }
+  if (var > 1.04) { var = 1.04; }
 
-  if (a->var < 0.96) { a->var = 0.96; }
+  if (var < 0.96) { var = 0.96; }
 
-  LeaveCriticalSection (&a->cs_var);
+  rm_store_double (&a->var, var);
 }
 
-void blend (RMATCH a) {
-  int i, j;
+//
+// fade in n samples of a ring buffer of the given size, starting at index i
+//
+static void upslew (RMATCH a, double* buff, int size, int i, int n, int* ucnt) {
+  while (*ucnt >= 0 && n > 0) {
+    buff[2 * i + 0] *= a->cslew[a->ntslew - *ucnt];
+    buff[2 * i + 1] *= a->cslew[a->ntslew - *ucnt];
+    (*ucnt)--;
+    n--;
 
-  for (i = 0, j = a->iout; i <= a->ntslew; i++, j = (j + 1) % a->rsize) {
-    a->ring[2 * j + 0] = a->cslew[i] * a->ring[2 * j + 0] + (1.0 - a->cslew[i]) * a->baux[2 * i + 0];
-    a->ring[2 * j + 1] = a->cslew[i] * a->ring[2 * j + 1] + (1.0 - a->cslew[i]) * a->baux[2 * i + 1];
+    if (++i == size) { i = 0; }
   }
 }
 
-void upslew (RMATCH a, int newsamps) {
-  int i, j;
-  i = 0;
-  j = a->iin;
+//
+// fade out the last n samples before index i (exclusive) of a ring buffer of the
+// given size such that the last sample reaches zero
+//
+static void downslew (RMATCH a, double* buff, int size, int i, int n) {
+  int m, j;
+
+  if (n <= 0) { return; }
+
+  if ((i -= n) < 0) { i += size; }
+
+  for (m = 0; m < n; m++) {
+    j = (n > 1) ? ((n - 1 - m) * a->ntslew) / (n - 1) : 0;
+    buff[2 * i + 0] *= a->cslew[j];
+    buff[2 * i + 1] *= a->cslew[j];
 
-  while (a->ucnt >= 0 && i < newsamps) {
-    a->ring[2 * j + 0] *= a->cslew[a->ntslew - a->ucnt];
-    a->ring[2 * j + 1] *= a->cslew[a->ntslew - a->ucnt];
-    a->ucnt--;
-    i++;
-    j = (j + 1) % a->rsize;
+    if (++i == size) { i = 0; }
   }
 }
 
@@ -305,130 +345,115 @@ void xrmatchIN (void* b, double* in) {
   RMATCH a = (RMATCH)b;
 
   if (InterlockedAnd (&a->run, 1)) {
-    int newsamps, first, second, ovfl;
+    int newsamps, nwrite, space, first, second;
     double var;
     a->v->in = a->in = in;
-    EnterCriticalSection (&a->cs_var);
 
-    if (!a->force) {
-      var = a->var;
+    if (!RM_LOAD (&a->force)) {
+      var = rm_load_double (&a->var);
     } else {
-      var = a->fvar;
+      var = rm_load_double (&a->fvar);
     }
 
-    LeaveCriticalSection (&a->cs_var);
-    newsamps = xvarsamp (a->v, var);
-    EnterCriticalSection (&a->cs_ring);
-    a->n_ring += newsamps;
+    space = a->rsize - (int)(a->wcount - RM_LOAD (&a->rcount));
 
-    if ((ovfl = a->n_ring - a->rsize) > 0) {
-      InterlockedIncrement (&a->overflows);
-      // a->n_ring = a->rsize / 2;
-      a->n_ring = a->rsize; //
+    if (space >= a->max_ring_insize) {
+      //
+      // regular case: varsamp writes directly into the ring, anything running
+      // past the end lands in the overhang and is folded back to the start
+      //
+      a->v->out = a->ring + 2 * a->iin;
+      newsamps = xvarsamp (a->v, var);
+      nwrite = newsamps;
 
-      if ((a->ntslew + 1) > (a->rsize - a->iout)) {
-        first = a->rsize - a->iout;
-        second = (a->ntslew + 1) - first;
+      if ((second = a->iin + newsamps - a->rsize) > 0) {
+        memcpy (a->ring, a->ring + 2 * a->rsize, second * sizeof (complex));
+      }
+    } else {
+      //
+      // the ring is (nearly) full: only store what fits, fade out the tail of
+      // what has been stored (it is not yet visible to the consumer) and fade in
+      // the data that follows
+      //
+      a->v->out = a->resout;
+      newsamps = xvarsamp (a->v, var);
+      nwrite = newsamps > space ? space : newsamps;
+
+      if (nwrite > (a->rsize - a->iin)) {
+        first = a->rsize - a->iin;
+        second = nwrite - first;
       } else {
-        first = a->ntslew + 1;
+        first = nwrite;
         second = 0;
       }
 
-      memcpy (a->baux, a->ring + 2 * a->iout, first * sizeof (complex));
-      memcpy (a->baux + 2 * first, a->ring, second * sizeof (complex));
-      // a->iout = (a->iout + ovfl + a->rsize / 2) % a->rsize;
-      a->iout = (a->iout + ovfl) % a->rsize; //
+      memcpy (a->ring + 2 * a->iin, a->resout, first * sizeof (complex));
+      memcpy (a->ring, a->resout + 2 * first, second * sizeof (complex));
     }
 
-    if (newsamps > (a->rsize - a->iin)) {
-      first = a->rsize - a->iin;
-      second = newsamps - first;
-    } else {
-      first = newsamps;
-      second = 0;
-    }
+    if (a->ucnt_in >= 0) { upslew (a, a->ring, a->rsize, a->iin, nwrite, &a->ucnt_in); }
 
-    memcpy (a->ring + 2 * a->iin, a->resout, first * sizeof (complex));
-    memcpy (a->ring, a->resout + 2 * first, second * sizeof (complex));
+    a->iin = (a->iin + nwrite) % a->rsize;
 
-    if (a->ucnt >= 0) { upslew(a, newsamps); }
+    if (nwrite < newsamps) {
+      downslew (a, a->ring, a->rsize, a->iin, nwrite < a->ntslew + 1 ? nwrite : a->ntslew + 1);
+      a->ucnt_in = a->ntslew;
+      InterlockedIncrement (&a->overflows);
+    }
 
-    a->iin = (a->iin + newsamps) % a->rsize;
+    RM_STORE (&a->incount, a->incount + a->insize);
+    RM_STORE (&a->wcount, a->wcount + nwrite);
+  }
+}
 
-    if (ovfl > 0) { blend (a); }
+//
+// underflow: deliver what is available with a fade-out applied in the output
+// buffer, continue the fade from the last sample if the data is too short,
+// and zero-fill the remainder of the output buffer
+//
+static void dslew (RMATCH a, int avail) {
+  int i, j, first, second;
 
-    if (!a->control_flag) {
-      a->writesamps += a->insize;
+  if (avail > (a->rsize - a->iout)) {
+    first = a->rsize - a->iout;
+    second = avail - first;
+  } else {
+    first = avail;
+    second = 0;
+  }
 
-      if ((a->readsamps >= a->read_startup) && (a->writesamps >= a->write_startup)) {
-        a->control_flag = 1;
-      }
-    }
+  memcpy (a->out, a->ring + 2 * a->iout, first * sizeof (complex));
+  memcpy (a->out + 2 * first, a->ring, second * sizeof (complex));
 
-    if (a->control_flag) { control (a, a->insize); }
+  if (a->ucnt_out >= 0) { upslew (a, a->out, a->outsize, 0, avail, &a->ucnt_out); }
 
-    LeaveCriticalSection (&a->cs_ring);
+  if (avail > 0) {
+    a->dlast[0] = a->out[2 * (avail - 1) + 0];
+    a->dlast[1] = a->out[2 * (avail - 1) + 1];
   }
-}
-
-void dslew (RMATCH a) {
-  int i, j, k, n;
-  int zeros, first, second;
 
-  if (a->n_ring > a->ntslew + 1) {
-    i = (a->iout + (a->n_ring - (a->ntslew + 1))) % a->rsize;
+  if (avail > a->ntslew + 1) {
+    i = avail - (a->ntslew + 1);
     j = a->ntslew;
-    k = a->ntslew + 1;
-    n = a->n_ring - (a->ntslew + 1);
   } else {
-    i = a->iout;
+    i = 0;
     j = a->ntslew;
-    k = a->n_ring;
-    n = 0;
   }
 
-  while (k > 0 && j >= 0) {
-    if (k == 1) {
-      a->dlast[0] = a->ring[2 * i + 0];
-      a->dlast[1] = a->ring[2 * i + 1];
-    }
-
-    a->ring[2 * i + 0] *= a->cslew[j];
-    a->ring[2 * i + 1] *= a->cslew[j];
-    i = (i + 1) % a->rsize;
-    j--;
-    k--;
-    n++;
+  for (; i < avail; i++, j--) {
+    a->out[2 * i + 0] *= a->cslew[j];
+    a->out[2 * i + 1] *= a->cslew[j];
   }
 
-  while (j >= 0) {
-    a->ring[2 * i + 0] = a->dlast[0] * a->cslew[j];
-    a->ring[2 * i + 1] = a->dlast[1] * a->cslew[j];
-    i = (i + 1) % a->rsize;
-    j--;
-    n++;
+  for (; j >= 0 && i < a->outsize; i++, j--) {
+    a->out[2 * i + 0] = a->dlast[0] * a->cslew[j];
+    a->out[2 * i + 1] = a->dlast[1] * a->cslew[j];
   }
 
-  // zeros = a->outsize + a->rsize / 2 - n;
-  if ((zeros = a->outsize - n) > 0) { //
-    //
-    if (zeros > a->rsize - i) {
-      first = a->rsize - i;
-      second = zeros - first;
-    } else {
-      first = zeros;
-      second = 0;
-    }
-
-    memset (a->ring + 2 * i, 0, first  * sizeof (complex));
-    memset (a->ring,         0, second * sizeof (complex));
-    n += zeros; //
-  } //
+  if (i < a->outsize) { memset (a->out + 2 * i, 0, (a->outsize - i) * sizeof (complex)); }
 
-  // a->n_ring = a->outsize + a->rsize / 2;
-  a->n_ring = n; //
-  // a->iin = (a->iout + a->outsize + a->rsize/2) % a->rsize;
-  a->iin = (a->iout + a->n_ring) % a->rsize; //
+  a->dlast[0] = 0.0;
+  a->dlast[1] = 0.0;
 }
 
 PORT
@@ -436,42 +461,50 @@ void xrmatchOUT (void* b, double* out) {
   RMATCH a = (RMATCH)b;
 
   if (InterlockedAnd (&a->run, 1)) {
-    int first, second;
+    int first, second, n_ring, nread;
     a->out = out;
-    EnterCriticalSection (&a->cs_ring);
+    n_ring = (int)(RM_LOAD (&a->wcount) - a->rcount);
 
-    if (a->n_ring < a->outsize) {
-      dslew (a);
-      a->ucnt = a->ntslew;
+    if (n_ring < a->outsize) {
+      dslew (a, n_ring);
+      nread = n_ring;
+      a->ucnt_out = a->ntslew;
       InterlockedIncrement (&a->underflows);
-    }
-
-    if (a->outsize > (a->rsize - a->iout)) {
-      first = a->rsize - a->iout;
-      second = a->outsize - first;
     } else {
-      first = a->outsize;
-      second = 0;
+      if (a->outsize > (a->rsize - a->iout)) {
+        first = a->rsize - a->iout;
+        second = a->outsize - first;
+      } else {
+        first = a->outsize;
+        second = 0;
+      }
+
+      memcpy (a->out, a->ring + 2 * a->iout, first * sizeof (complex));
+      memcpy (a->out + 2 * first, a->ring, second * sizeof (complex));
+
+      if (a->ucnt_out >= 0) { upslew (a, a->out, a->outsize, 0, a->outsize, &a->ucnt_out); }
+
+      nread = a->outsize;
+      a->dlast[0] = a->out[2 * (a->outsize - 1) + 0];
+      a->dlast[1] = a->out[2 * (a->outsize - 1) + 1];
     }
 
-    memcpy (a->out, a->ring + 2 * a->iout, first * sizeof (complex));
-    memcpy (a->out + 2 * first, a->ring, second * sizeof (complex));
-    a->iout = (a->iout + a->outsize) % a->rsize;
-    a->n_ring -= a->outsize;
-    a->dlast[0] = a->out[2 * (a->outsize - 1) + 0];
-    a->dlast[1] = a->out[2 * (a->outsize - 1) + 1];
+    a->iout = (a->iout + nread) % a->rsize;
+    RM_STORE (&a->rcount, a->rcount + nread);
+    n_ring -= nread;
+    a->n_ring = n_ring;
 
     if (!a->control_flag) {
+      unsigned long incount = RM_LOAD (&a->incount);
       a->readsamps += a->outsize;
 
-      if ((a->readsamps >= a->read_startup) && (a->writesamps >= a->write_startup)) {
-        a->control_flag = 1;
+      if ((a->readsamps >= a->read_startup) && (incount >= a->write_startup)) {
+        a->last_incount = incount;
+        RM_STORE (&a->control_flag, 1);
       }
+    } else {
+      control (a, n_ring);
     }
-
-    if (a->control_flag) { control (a, -(a->outsize)); }
-
-    LeaveCriticalSection (&a->cs_ring);
   }
 }
 
@@ -480,11 +513,9 @@ void getRMatchDiags (void* b, int* underflows, int* overflows, double* var, int*
   RMATCH a = (RMATCH)b;
   *underflows = InterlockedAnd (&a->underflows, 0xFFFFFFFF);
   *overflows  = InterlockedAnd (&a->overflows,  0xFFFFFFFF);
-  EnterCriticalSection (&a->cs_var);
-  *var = a->var;
+  *var = rm_load_double (&a->var);
   *ringsize = a->ringsize;
-  *nring = a->n_ring;
-  LeaveCriticalSection (&a->cs_var);
+  *nring = RM_LOAD (&a->n_ring);
 }
 
 PORT
@@ -497,10 +528,8 @@ void resetRMatchDiags (void* b) {
 PORT
 void forceRMatchVar (void* b, int force, double fvar) {
   RMATCH a = (RMATCH)b;
-  EnterCriticalSection (&a->cs_var);
-  a->force = force;
-  a->fvar = fvar;
-  LeaveCriticalSection (&a->cs_var);
+  rm_store_double (&a->fvar, fvar);
+  RM_STORE (&a->force, force);
 }
 
 PORT
@@ -595,10 +624,8 @@ void setRMatchRingsize (void* ptr, int ringsize) {
 PORT
 void setRMatchFeedbackGain (void* b, double feedback_gain) {
   RMATCH a = (RMATCH)b;
-  EnterCriticalSection(&a->cs_var);
   a->prop_gain = feedback_gain;
-  a->pr_gain = a->prop_gain * 48000.0 / (double)a->nom_outrate;
-  LeaveCriticalSection(&a->cs_var);
+  rm_store_double (&a->pr_gain, a->prop_gain * 48000.0 / (double)a->nom_outrate);
 }
 
 PORT
@@ -693,9 +720,7 @@ void setRMatchFFAlpha(void* ptr, double ff_alpha) {
 PORT
 void getControlFlag(void* ptr, int* control_flag) {
   RMATCH a = (RMATCH)ptr;
-  EnterCriticalSection(&a->cs_ring);
-  *control_flag = a->control_flag;
-  LeaveCriticalSection(&a->cs_ring);
+  *control_flag = RM_LOAD (&a->control_flag);
 }
 
 // the following function is DEPRECATED
@@ -58,7 +58,7 @@ typedef struct _rmatch {
   double* out;
   int insize;
   int outsize;
-  double* resout;
+  double* resout;     // only used if the ring lacks room for a full varsamp output block
   int nom_inrate;
   int nom_outrate;
   double nom_ratio;
@@ -70,11 +70,17 @@ typedef struct _rmatch {
   int auto_ringsize;
   int ringsize;
   int rsize;
-  double* ring;
-  int n_ring;
+  int max_ring_insize;
+  double* ring;       // rsize complex samples plus an overhang of max_ring_insize for direct writes
+  // single-producer / single-consumer ring, the producer owns iin, the consumer owns iout
   int iin;
   int iout;
-  double var;
+  volatile unsigned long wcount;    // total samples written to the ring, published by xrmatchIN()
+  volatile unsigned long rcount;    // total samples read from the ring, published by xrmatchOUT()
+  volatile unsigned long incount;   // total input samples accepted, published by xrmatchIN()
+  unsigned long last_incount;       // consumer side copy of incount at the last control() call
+  volatile int n_ring;              // fill level seen by the consumer, for diagnostics only
+  volatile double var;
   int R;
   AAMAV ffmav;
   MAV propmav;
@@ -85,30 +91,27 @@ typedef struct _rmatch {
   int prop_ringmin;
   int prop_ringmax;   // must be a power of two
   double prop_gain;
-  double pr_gain;
+  volatile double pr_gain;
   double av_deviation;
   VARSAMP v;
   int varmode;
-  CRITICAL_SECTION cs_ring;
-  CRITICAL_SECTION cs_var;
   // blend / slew
   double tslew;
   int ntslew;
   double* cslew;
-  double* baux;
   double dlast[2];
-  int ucnt;
+  int ucnt_in;        // producer side up-slew after an overflow
+  int ucnt_out;       // consumer side up-slew after an underflow
   // variables to check start-up time for control to become active
   unsigned int readsamps;
-  unsigned int writesamps;
   unsigned int read_startup;
   unsigned int write_startup;
-  int control_flag;
+  volatile int control_flag;
   // diagnostics
   volatile long underflows;
   volatile long overflows;
-  int force;
-  double fvar;
+  volatile int force;
+  volatile double fvar;
 } rmatch, *RMATCH;
 
 extern __declspec (dllexport) void* create_rmatchV(int in_size, int out_size, int nom_inrate, int nom_outrate,
@@ -106,6 +106,7 @@ PORT
 void SetRXAShiftRun (int channel, int run) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].shift.p->run = run;
+  RXADecimCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
 
@@ -114,5 +115,6 @@ void SetRXAShiftFreq (int channel, double fshift) {
   EnterCriticalSection (&ch[channel].csDSP);
   rxa[channel].shift.p->shift = fshift;
   calc_shift (rxa[channel].shift.p);
+  RXADecimCheck (channel);
   LeaveCriticalSection (&ch[channel].csDSP);
 }
\ No newline at end of file
@@ -585,7 +585,7 @@ PORT void SetRXASNBARun (int channel, int run) {
   if (a->run != run) {
     RXAbpsnbaCheck (channel, rxa[channel].mode, rxa[channel].ndb.p->master_run);
     RXAbp1Check (channel, rxa[channel].amd.p->run, run, rxa[channel].emnr.p->run,
-                 rxa[channel].anf.p->run, rxa[channel].anr.p->run);
+                 rxa[channel].ssnr.p->run, rxa[channel].anf.p->run, rxa[channel].anr.p->run);
     EnterCriticalSection (&ch[channel].csDSP);
     a->run = run;
     RXAbp1Set (channel);
@@ -0,0 +1,414 @@
+/*  ssnr.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+//
+// The spectral-subtraction NR is meant as a cheap alternative to EMNR on small hosts.
+// It uses a ~10 msec frame with 50% overlap instead of 4096 points with 75% overlap,
+// a minimum-statistics noise floor instead of the MMSE noise estimator, and takes the
+// Wiener gain from a table instead of evaluating Bessel functions per bin.
+//
+
+static void calc_lut (SSNR a) {
+  // table is indexed by the a-priori SNR in steps of 1/SSNR_LUT_STEP octave
+  int i;
+  double gmin = pow (10.0, -a->reduction / 20.0);
+
+  for (i = 0; i < SSNR_LUT_SIZE; i++) {
+    double m = 0.5 + ((double)(i % SSNR_LUT_STEP) + 0.5) / (double)(2 * SSNR_LUT_STEP);
+    double xi = ldexp (m, i / SSNR_LUT_STEP - SSNR_LUT_OCT / 2 + 1);
+    double g = xi / (1.0 + xi);
+    a->lut[i] = g > gmin ? g : gmin;
+  }
+}
+
+static inline double lut_gain (SSNR a, double xi) {
+  int e, i;
+  double m;
+
+  if (xi <= 0.0) { return a->lut[0]; }
+
+  m = frexp (xi, &e);
+  i = (e - 1 + SSNR_LUT_OCT / 2) * SSNR_LUT_STEP + (int)((m - 0.5) * (double)(2 * SSNR_LUT_STEP));
+
+  if (i < 0) { i = 0; }
+
+  if (i >= SSNR_LUT_SIZE) { i = SSNR_LUT_SIZE - 1; }
+
+  return a->lut[i];
+}
+
+static void calc_ssnr (SSNR a) {
+  int i;
+  double frate;
+  a->fsize = 128;
+
+  while (a->fsize < 0.008 * a->rate) { a->fsize *= 2; }
+
+  a->ovrlp = 2;
+  a->incr = a->fsize / a->ovrlp;
+  a->msize = a->fsize / 2 + 1;
+  // sqrt-Hann analysis and synthesis windows sum to unity at 50% overlap
+  a->gain = 1.0 / (double)a->fsize;
+
+  if (a->fsize > a->bsize) {
+    a->iasize = a->fsize;
+  } else {
+    a->iasize = a->bsize + a->fsize - a->incr;
+  }
+
+  a->iainidx = 0;
+  a->iaoutidx = 0;
+
+  if (a->fsize > a->bsize) {
+    if (a->bsize > a->incr) { a->oasize = a->bsize; }
+    else { a->oasize = a->incr; }
+
+    a->oainidx = (a->fsize - a->bsize - a->incr) % a->oasize;
+  } else {
+    a->oasize = a->bsize;
+    a->oainidx = a->fsize - a->incr;
+  }
+
+  a->init_oainidx = a->oainidx;
+  a->oaoutidx = 0;
+  a->window = (double *)malloc0(a->fsize * sizeof(double));
+
+  for (i = 0; i < a->fsize; i++) {
+    a->window[i] = sin (PI * (double)i / (double)a->fsize);
+  }
+
+  a->inaccum = (double *)malloc0(a->iasize * sizeof(double));
+  a->forfftin = (double *)malloc0(a->fsize * sizeof(double));
+  a->forfftout = (double *)malloc0(a->msize * sizeof(complex));
+  a->revfftout = (double *)malloc0(a->fsize * sizeof(double));
+  a->save = (double **)malloc0(a->ovrlp * sizeof(double *));
+
+  for (i = 0; i < a->ovrlp; i++) {
+    a->save[i] = (double *)malloc0(a->fsize * sizeof(double));
+  }
+
+  a->outaccum = (double *)malloc0(a->oasize * sizeof(double));
+  a->nsamps = 0;
+  a->saveidx = 0;
+  a->Rfor = fftw_plan_dft_r2c_1d(a->fsize, a->forfftin, (fftw_complex *)a->forfftout, FFTW_ESTIMATE);
+  a->Rrev = fftw_plan_dft_c2r_1d(a->fsize, (fftw_complex *)a->forfftout, a->revfftout, FFTW_ESTIMATE);
+  //
+  // noise estimation: 30 msec power smoothing, minimum searched over 1.2 sec
+  //
+  frate = a->rate / (double)a->incr;
+  a->alpha = exp (-1.0 / (0.030 * frate));
+  a->bias = 1.6;
+  a->subwin_len = (int)(1.2 * frate / SSNR_SUBWIN + 0.5);
+
+  if (a->subwin_len < 1) { a->subwin_len = 1; }
+
+  a->P = (double *)malloc0(a->msize * sizeof(double));
+  a->curmin = (double *)malloc0(a->msize * sizeof(double));
+  a->winmin = (double *)malloc0(a->msize * sizeof(double));
+
+  for (i = 0; i < SSNR_SUBWIN; i++) {
+    a->submin[i] = (double *)malloc0(a->msize * sizeof(double));
+  }
+
+  a->noise = (double *)malloc0(a->msize * sizeof(double));
+  //
+  // gain: decision-directed SNR, gate releases with 60 msec
+  //
+  a->dd = 0.96;
+  a->release = exp (-1.0 / (0.060 * frate));
+  a->prev_snr = (double *)malloc0(a->msize * sizeof(double));
+  a->gate = (double *)malloc0(a->msize * sizeof(double));
+  a->mask = (double *)malloc0(a->msize * sizeof(double));
+  calc_lut (a);
+  flush_ssnr (a);
+}
+
+static void decalc_ssnr (SSNR a) {
+  int i;
+  _aligned_free (a->mask);
+  _aligned_free (a->gate);
+  _aligned_free (a->prev_snr);
+  _aligned_free (a->noise);
+
+  for (i = 0; i < SSNR_SUBWIN; i++) {
+    _aligned_free (a->submin[i]);
+  }
+
+  _aligned_free (a->winmin);
+  _aligned_free (a->curmin);
+  _aligned_free (a->P);
+  fftw_destroy_plan (a->Rrev);
+  fftw_destroy_plan (a->Rfor);
+  _aligned_free (a->outaccum);
+
+  for (i = 0; i < a->ovrlp; i++) {
+    _aligned_free (a->save[i]);
+  }
+
+  _aligned_free (a->save);
+  _aligned_free (a->revfftout);
+  _aligned_free (a->forfftout);
+  _aligned_free (a->forfftin);
+  _aligned_free (a->inaccum);
+  _aligned_free (a->window);
+}
+
+SSNR create_ssnr (int run, int position, int size, double* in, double* out, int rate, double reduction) {
+  SSNR a = (SSNR) malloc0 (sizeof (ssnr));
+  a->run = run;
+  a->position = position;
+  a->bsize = size;
+  a->in = in;
+  a->out = out;
+  a->rate = rate;
+  a->reduction = reduction;
+  calc_ssnr (a);
+  return a;
+}
+
+void flush_ssnr (SSNR a) {
+  int i, k;
+  memset (a->inaccum, 0, a->iasize * sizeof (double));
+
+  for (i = 0; i < a->ovrlp; i++) {
+    memset (a->save[i], 0, a->fsize * sizeof (double));
+  }
+
+  memset (a->outaccum, 0, a->oasize * sizeof (double));
+  a->nsamps   = 0;
+  a->iainidx  = 0;
+  a->iaoutidx = 0;
+  a->oainidx  = a->init_oainidx;
+  a->oaoutidx = 0;
+  a->saveidx  = 0;
+  a->nframes  = 0;
+  a->subwin_cnt = 0;
+  a->subwin_idx = 0;
+
+  for (k = 0; k < a->msize; k++) {
+    a->curmin[k] = 1.0e300;
+    a->winmin[k] = 1.0e300;
+
+    for (i = 0; i < SSNR_SUBWIN; i++) {
+      a->submin[i][k] = 1.0e300;
+    }
+
+    a->prev_snr[k] = 0.0;
+    a->gate[k] = 1.0;
+  }
+}
+
+void destroy_ssnr (SSNR a) {
+  decalc_ssnr (a);
+  _aligned_free (a);
+}
+
+static void calc_noise (SSNR a) {
+  int i, k;
+  double* restrict P = a->P;
+  double* restrict curmin = a->curmin;
+  double* restrict winmin = a->winmin;
+  double* restrict noise = a->noise;
+  const double* restrict X = a->forfftout;
+
+  if (a->nframes++ == 0) {
+    for (k = 0; k < a->msize; k++) {
+      P[k] = X[2 * k + 0] * X[2 * k + 0] + X[2 * k + 1] * X[2 * k + 1];
+    }
+  }
+
+  for (k = 0; k < a->msize; k++) {
+    double y = X[2 * k + 0] * X[2 * k + 0] + X[2 * k + 1] * X[2 * k + 1];
+    P[k] = a->alpha * P[k] + (1.0 - a->alpha) * y;
+
+    if (P[k] < curmin[k]) { curmin[k] = P[k]; }
+
+    noise[k] = a->bias * (curmin[k] < winmin[k] ? curmin[k] : winmin[k]) + 1.0e-30;
+  }
+
+  if (++a->subwin_cnt >= a->subwin_len) {
+    // close the running sub-window, the oldest one drops out of the search
+    memcpy (a->submin[a->subwin_idx], curmin, a->msize * sizeof (double));
+    a->subwin_idx = (a->subwin_idx + 1) % SSNR_SUBWIN;
+    a->subwin_cnt = 0;
+
+    for (k = 0; k < a->msize; k++) {
+      double m = a->submin[0][k];
+
+      for (i = 1; i < SSNR_SUBWIN; i++) {
+        if (a->submin[i][k] < m) { m = a->submin[i][k]; }
+      }
+
+      winmin[k] = m;
+      curmin[k] = P[k];
+    }
+  }
+}
+
+static void calc_mask (SSNR a) {
+  int k;
+  const int msize = a->msize;
+  const double* X = a->forfftout;
+  double* gate = a->gate;
+  double* mask = a->mask;
+
+  for (k = 0; k < msize; k++) {
+    double y = X[2 * k + 0] * X[2 * k + 0] + X[2 * k + 1] * X[2 * k + 1];
+    double gamma = y / a->noise[k];
+    double xi = a->dd * a->prev_snr[k] + (1.0 - a->dd) * (gamma > 1.0 ? gamma - 1.0 : 0.0);
+    double g = lut_gain (a, xi);
+    a->prev_snr[k] = g * g * gamma;
+
+    // open instantly, close slowly
+    if (g > gate[k]) { gate[k] = g; }
+    else { gate[k] = a->release * gate[k] + (1.0 - a->release) * g; }
+  }
+
+  // light smoothing across frequency to suppress isolated "musical" bins
+  mask[0] = 0.75 * gate[0] + 0.25 * gate[1];
+
+  for (k = 1; k < msize - 1; k++) {
+    mask[k] = 0.25 * (gate[k - 1] + gate[k + 1]) + 0.5 * gate[k];
+  }
+
+  mask[msize - 1] = 0.25 * gate[msize - 2] + 0.75 * gate[msize - 1];
+}
+
+void xssnr (SSNR a, int pos) {
+  if (a->run && pos == a->position) {
+    int i, j, k, sbuff, sbegin;
+    double g1;
+
+    for (i = 0; i < 2 * a->bsize; i += 2) {
+      a->inaccum[a->iainidx] = a->in[i];
+      a->iainidx = (a->iainidx + 1) % a->iasize;
+    }
+
+    a->nsamps += a->bsize;
+
+    while (a->nsamps >= a->fsize) {
+      for (i = 0, j = a->iaoutidx; i < a->fsize; i++, j = (j + 1) % a->iasize) {
+        a->forfftin[i] = a->window[i] * a->inaccum[j];
+      }
+
+      a->iaoutidx = (a->iaoutidx + a->incr) % a->iasize;
+      a->nsamps -= a->incr;
+      fftw_execute (a->Rfor);
+      calc_noise (a);
+      calc_mask (a);
+
+      for (i = 0; i < a->msize; i++) {
+        g1 = a->gain * a->mask[i];
+        a->forfftout[2 * i + 0] *= g1;
+        a->forfftout[2 * i + 1] *= g1;
+      }
+
+      fftw_execute (a->Rrev);
+
+      for (i = 0; i < a->fsize; i++) {
+        a->save[a->saveidx][i] = a->window[i] * a->revfftout[i];
+      }
+
+      for (i = a->ovrlp; i > 0; i--) {
+        sbuff = (a->saveidx + i) % a->ovrlp;
+        sbegin = a->incr * (a->ovrlp - i);
+
+        for (j = sbegin, k = a->oainidx; j < a->incr + sbegin; j++, k = (k + 1) % a->oasize) {
+          if ( i == a->ovrlp) {
+            a->outaccum[k]  = a->save[sbuff][j];
+          } else {
+            a->outaccum[k] += a->save[sbuff][j];
+          }
+        }
+      }
+
+      a->saveidx = (a->saveidx + 1) % a->ovrlp;
+      a->oainidx = (a->oainidx + a->incr) % a->oasize;
+    }
+
+    for (i = 0; i < a->bsize; i++) {
+      a->out[2 * i + 0] = a->outaccum[a->oaoutidx];
+      a->out[2 * i + 1] = 0.0;
+      a->oaoutidx = (a->oaoutidx + 1) % a->oasize;
+    }
+  } else if (a->out != a->in) {
+    memcpy (a->out, a->in, a->bsize * sizeof (complex));
+  }
+}
+
+void setBuffers_ssnr (SSNR a, double* in, double* out) {
+  a->in = in;
+  a->out = out;
+}
+
+void setSamplerate_ssnr (SSNR a, int rate) {
+  decalc_ssnr (a);
+  a->rate = rate;
+  calc_ssnr (a);
+}
+
+void setSize_ssnr (SSNR a, int size) {
+  decalc_ssnr (a);
+  a->bsize = size;
+  calc_ssnr (a);
+}
+
+/********************************************************************************************************
+*                                                                                                       *
+*                                           RXA Properties                                              *
+*                                                                                                       *
+********************************************************************************************************/
+
+PORT
+void SetRXASSNRRun (int channel, int run) {
+  SSNR a = rxa[channel].ssnr.p;
+
+  if (a->run != run) {
+    RXAbp1Check (channel, rxa[channel].amd.p->run, rxa[channel].snba.p->run, rxa[channel].emnr.p->run,
+                 run, rxa[channel].anf.p->run, rxa[channel].anr.p->run);
+    EnterCriticalSection (&ch[channel].csDSP);
+    a->run = run;
+    RXAbp1Set (channel);
+    LeaveCriticalSection (&ch[channel].csDSP);
+  }
+}
+
+PORT
+void SetRXASSNRPosition (int channel, int position) {
+  SSNR a = rxa[channel].ssnr.p;
+  EnterCriticalSection (&ch[channel].csDSP);
+  a->position = position;
+  rxa[channel].bp1.p->position  = position;
+  flush_ssnr (a);
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
+
+PORT
+void SetRXASSNRReduction (int channel, double reduction) {
+  SSNR a = rxa[channel].ssnr.p;
+  EnterCriticalSection (&ch[channel].csDSP);
+  a->reduction = reduction;
+  calc_lut (a);
+  LeaveCriticalSection (&ch[channel].csDSP);
+}
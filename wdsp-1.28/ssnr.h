@@ -0,0 +1,103 @@
+/*  ssnr.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 Heiko Amft, DL1BZ
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef _ssnr_h
+#define _ssnr_h
+
+//
+// Light-weight spectral subtraction noise reduction.
+// Short real FFT, minimum-statistics noise floor, Wiener gain from a table
+// and a per-bin noise gate with fast attack / slow release.
+//
+
+#define SSNR_SUBWIN      8                      // sub-windows of the minimum search
+#define SSNR_LUT_OCT     32                     // table covers 2^-16 ... 2^+16
+#define SSNR_LUT_STEP    16                     // table entries per octave
+#define SSNR_LUT_SIZE    (SSNR_LUT_OCT * SSNR_LUT_STEP)
+
+typedef struct _ssnr {
+  int run;
+  int position;
+  int bsize;
+  double* in;
+  double* out;
+  double rate;
+  int fsize;
+  int ovrlp;
+  int incr;
+  int msize;
+  double* window;
+  int iasize;
+  double* inaccum;
+  double* forfftin;
+  double* forfftout;
+  double* revfftout;
+  double** save;
+  int oasize;
+  double* outaccum;
+  double gain;
+  int nsamps;
+  int iainidx;
+  int iaoutidx;
+  int init_oainidx;
+  int oainidx;
+  int oaoutidx;
+  int saveidx;
+  fftw_plan Rfor;
+  fftw_plan Rrev;
+  // noise estimation
+  double alpha;                                 // power smoothing
+  double bias;                                  // minimum-to-mean correction
+  int subwin_len;                               // frames per sub-window
+  int subwin_cnt;
+  int subwin_idx;
+  int nframes;
+  double* P;                                    // smoothed power
+  double* curmin;                               // minimum of the running sub-window
+  double* winmin;                               // minimum of the completed sub-windows
+  double* submin[SSNR_SUBWIN];
+  double* noise;
+  // gain
+  double reduction;                             // maximum attenuation, dB
+  double dd;                                    // decision-directed weight
+  double release;                               // gate release coefficient
+  double* prev_snr;                             // |S|^2 / N of the previous frame
+  double* gate;
+  double* mask;
+  double lut[SSNR_LUT_SIZE];
+} ssnr, *SSNR;
+
+extern SSNR create_ssnr (int run, int position, int size, double* in, double* out, int rate, double reduction);
+
+extern void destroy_ssnr (SSNR a);
+
+extern void flush_ssnr (SSNR a);
+
+extern void xssnr (SSNR a, int pos);
+
+extern void setBuffers_ssnr (SSNR a, double* in, double* out);
+
+extern void setSamplerate_ssnr (SSNR a, int rate);
+
+extern void setSize_ssnr (SSNR a, int size);
+
+#endif
@@ -318,6 +318,7 @@ extern void SetDSPSamplerate (int channel, int dsp_rate);
 extern void SetOutputSamplerate (int channel, int out_rate);
 extern void SetAllRates (int channel, int in_rate, int dsp_rate, int out_rate);
 extern int SetChannelState (int channel, int state, int dmode);
+extern int WaitChannelFlush (int channel, int timeout);
 extern void SetChannelTDelayUp (int channel, double time);
 extern void SetChannelTSlewUp (int channel, double time);
 extern void SetChannelTDelayDown (int channel, double time);
@@ -364,6 +365,7 @@ extern void SetDEXPRunVox (int id, int run);
 extern void SetDEXPRunAudioDelay (int id, int run);
 extern void SetDEXPAudioDelay (int id, double delay);
 extern void GetDEXPPeakSignal (int id, double* peak);
+extern void ResetDEXPDetector (int id);
 extern void SetAntiVOXRun (int id, int run);
 extern void SetAntiVOXSize (int id, int size);
 extern void SetAntiVOXRate (int id, double rate);
@@ -883,6 +885,14 @@ extern  void SetRXASNBAOutputBandwidth (int channel, double flow, double fhigh)
 extern void RXABPSNBASetNC (int channel, int nc);
 extern void RXABPSNBASetMP (int channel, int mp);
 
+//
+// Interfaces from ssnr.c
+//
+
+extern void SetRXASSNRRun (int channel, int run);
+extern void SetRXASSNRPosition (int channel, int position);
+extern void SetRXASSNRReduction (int channel, double reduction);
+
 //
 // Interfaces from ssql.c
 //